@@ -23,11 +23,20 @@ extern "C" {
 #include "boxing/platform/types.h"
 #include "boxing/codecs/syncpointinserter.h"
 
+typedef enum
+{
+    BOXING_PAM2D_LLR_EXACT = 0,
+    BOXING_PAM2D_LLR_MAX_LOG
+} boxing_pam2d_llr;
+
 typedef struct boxing_codec_2dpam_s
 {
     boxing_codec base;
     unsigned int num_data_pixels_per_frame;
     boxing_codec_syncpointinserter *syncpointinserter;
+    boxing_pam2d_llr llr;
+    int thread_count;
+    unsigned int *row_symbols;
 } boxing_codec_2dpam;
 
 static const char codec_2dpam_name[] = "2DPAM";
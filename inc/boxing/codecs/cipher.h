@@ -22,12 +22,17 @@ extern "C" {
 #include "boxing/codecs/codecbase.h"
 #include "boxing/platform/types.h"
 
+typedef struct boxing_cipher_keystream_s boxing_cipher_keystream;
+
 typedef struct boxing_codec_cipher_s
 {
     boxing_codec base;
     DBOOL        auto_key;
     int          ones[256];
     uint32_t     key;
+    uint32_t     jump_state[4][256];
+    uint64_t     jump_stream[4][256];
+    boxing_cipher_keystream * keystream;
 } boxing_codec_cipher;
 
 boxing_codec * boxing_codec_cipher_create(GHashTable * properties, const boxing_config * config);
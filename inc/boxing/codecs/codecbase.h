@@ -39,6 +39,16 @@ extern "C" {
 #define PARAM_NAME_SYMBOL_TYPE                      "symboltype"
 #define PARAM_NAME_SYMBOL_TYPE_BIT                  "bit"
 #define PARAM_NAME_SYMBOL_TYPE_BYTE                 "byte"
+#define PARAM_NAME_BUFFER_DIRECTORY                 "bufferDirectory"
+#define PARAM_NAME_DECODER                          "decoder"
+#define PARAM_NAME_DECODER_PROBABILITY_PROPAGATION  "probabilityPropagation"
+#define PARAM_NAME_DECODER_MIN_SUM                  "minSum"
+#define PARAM_NAME_DECODER_LAYERED_MIN_SUM          "layeredMinSum"
+#define PARAM_NAME_THREAD_COUNT                     "threadCount"
+#define PARAM_NAME_MATRIX_CACHE                     "matrixCache"
+#define PARAM_NAME_LLR                              "llr"
+#define PARAM_NAME_LLR_EXACT                        "exact"
+#define PARAM_NAME_LLR_MAX_LOG                      "maxLog"
 
 struct boxing_codec_s;
 
@@ -65,6 +75,7 @@ typedef struct boxing_codec_s
     unsigned int                  encoded_symbol_size;
     unsigned int                  decoded_symbol_size;
     unsigned int                  reentrant;
+    unsigned int                  supports_erasures;
     codec_decode_cb               decode_cb;
     codec_encode_cb               encode_cb;
     reset_callback                reset;
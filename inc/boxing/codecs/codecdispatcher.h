@@ -74,6 +74,7 @@ typedef struct boxing_codecdispatcher_s
     const boxing_config *           config;
     boxing_codecdispatcher_version  version;
     int                             multi_frame_size;
+    boxing_stats_stage_cb           on_decode_stage;
 } boxing_codecdispatcher;
 
 int boxing_codecdispatcher_get_stripe_size(const boxing_config * config);
@@ -90,6 +91,7 @@ DBOOL boxing_codecdispatcher_decode_step(boxing_codecdispatcher *dispatcher, gve
 DBOOL boxing_codecdispatcher_decode_step_codec(boxing_codec * codec, gvector * data, gvector * erasures, boxing_stats_decode *stats, void* user_data);
 
 void  boxing_codecdispatcher_reset(boxing_codecdispatcher *dispatcher);
+void  boxing_codecdispatcher_set_property(boxing_codecdispatcher *dispatcher, const char * name, const g_variant * value);
 
 unsigned int boxing_codecdispatcher_get_coding_steps(boxing_codecdispatcher *dispatcher);
 boxing_codec * boxing_codecdispatcher_get_encode_codec(boxing_codecdispatcher *dispatcher, int step);
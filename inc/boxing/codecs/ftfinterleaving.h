@@ -22,13 +22,17 @@ extern "C" {
 #include "boxing/codecs/codecbase.h"
 #include "boxing/platform/types.h"
 
+typedef struct boxing_ftf_ring_s boxing_ftf_ring;
+
 typedef struct boxing_codec_ftf_interleaving_s
 {
     boxing_codec                     base;
     uint32_t                         distance;
     uint32_t                         preload_frames;
-    GList *                          encode_buffer;
-    GList *                          decode_buffer;
+    char *                           buffer_directory;
+    boxing_ftf_ring *                encode_buffer;
+    boxing_ftf_ring *                decode_buffer;
+    boxing_ftf_ring *                erasures_buffer;
 } boxing_codec_ftf_interleaving;
 
 boxing_codec * boxing_ftf_interleaving_create(GHashTable * properties, const boxing_config * config);
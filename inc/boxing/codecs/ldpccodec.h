@@ -24,11 +24,32 @@ extern "C" {
 
 static const char codec_ldpc_name[] = "LDPC";
 
+typedef enum
+{
+    BOXING_LDPC_DECODER_PROBABILITY_PROPAGATION,
+    BOXING_LDPC_DECODER_MIN_SUM,
+    BOXING_LDPC_DECODER_LAYERED_MIN_SUM
+} boxing_ldpc_decoder;
+
+typedef struct boxing_ldpc_graph_s
+{
+    int   rows;
+    int   cols;
+    int   max_row_degree;
+    int * row_start;
+    int * row_cols;
+    int * col_start;
+    int * col_edges;
+} boxing_ldpc_graph;
+
 typedef struct boxing_codec_ldpc_s
 {
-    boxing_codec       base;
-    unsigned int       iterations;
-    generator_matrix * gen_matrix;
+    boxing_codec        base;
+    unsigned int        iterations;
+    generator_matrix *  gen_matrix;
+    boxing_ldpc_decoder decoder;
+    int                 thread_count;
+    boxing_ldpc_graph   graph;
 } boxing_codec_ldpc;
 
 boxing_codec * boxing_codec_ldpc_create(GHashTable * properties, const boxing_config * config);
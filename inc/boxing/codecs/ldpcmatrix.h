@@ -0,0 +1,57 @@
+#ifndef BOXING_LDPCMATRIX_H
+#define BOXING_LDPCMATRIX_H
+
+/*****************************************************************************
+**
+**  Definition of the LDPC matrix cache interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "boxing/bool.h"
+#include "boxing/platform/types.h"
+#include "gvector.h"
+#include <stddef.h>
+
+// Version of the serialized matrix format and of the matrix construction,
+// serialized matrices of other versions are rebuilt
+#define BOXING_LDPC_MATRIX_VERSION 2
+
+struct ldpc_generator_s;
+
+typedef enum
+{
+    BOXING_LDPC_MATRIX_EVENBOTH_3_NO4CYCLE_DENSE = 1
+} boxing_ldpc_matrix_method;
+
+typedef struct boxing_ldpc_matrix_key_s
+{
+    uint32_t message_bits;
+    uint32_t parity_bits;
+    int32_t  seed;
+    uint32_t method;
+} boxing_ldpc_matrix_key;
+
+struct ldpc_generator_s * boxing_ldpc_matrix_acquire(const boxing_ldpc_matrix_key * key, const char * cache_directory);
+void                      boxing_ldpc_matrix_release(struct ldpc_generator_s * matrix);
+gvector *                 boxing_ldpc_matrix_serialize(const boxing_ldpc_matrix_key * key, const struct ldpc_generator_s * matrix);
+DBOOL                     boxing_ldpc_matrix_register(const void * data, size_t size);
+uint32_t                  boxing_ldpc_matrix_random_source(void);
+void                      boxing_ldpc_matrix_cache_clear(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
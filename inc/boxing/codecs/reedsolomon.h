@@ -21,15 +21,18 @@ extern "C" {
 
 #include "boxing/codecs/codecbase.h"
 #include "boxing/platform/types.h"
+#include "boxing/platform/thread.h"
 #include "rs.h"
 
 
 typedef struct boxing_codec_reedsolomon_s
 {
-    boxing_codec    base;
-    rs_codec *      rs;
-    unsigned int    message_size;
-    unsigned int    parity_size;
+    boxing_codec        base;
+    rs_codec *          rs;
+    rs_decode_context * decode_context;
+    boxing_mutex *      decode_context_mutex;
+    unsigned int        message_size;
+    unsigned int        parity_size;
 
 } boxing_codec_reedsolomon;
 
@@ -31,6 +31,12 @@ enum boxing_filter_callback_result
     BOXING_FILTER_CALLBACK_ABORT
 };
 
+typedef enum
+{
+    BOXING_FILTER_PRECISION_FLOAT = 0,
+    BOXING_FILTER_PRECISION_FIXED_POINT
+} boxing_filter_precision;
+
 typedef struct boxing_filter_coeff_2d_s
 {
     int rows;
@@ -44,11 +50,14 @@ typedef struct boxing_filter_s
 {
     boxing_filter_callback    process;
     boxing_filter_coeff_2d *  coeff;
+    boxing_filter_precision   precision;
 } boxing_filter;
 
 
 void               boxing_filter_init(boxing_filter * filter);
 void               boxing_filter_free(boxing_filter * filter);
+int                boxing_filter_apply(boxing_image8 * image, const boxing_filter_coeff_2d * coeff, int thread_count);
+int                boxing_filter_apply_fixed_point(boxing_image8 * image, const boxing_filter_coeff_2d * coeff, int thread_count);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -24,6 +24,7 @@ extern "C" {
 #include "boxing/unboxer/sampler.h"
 
 boxing_sampler * boxing_2polinomialsampler_create(int width, int height);
+void             boxing_2polinomialsampler_sample_line(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -24,6 +24,7 @@ extern "C" {
 #include "boxing/image8.h"
 #include "boxing/unboxer/sampler.h"
 #include "boxing/unboxer/cornermark.h"
+#include "boxing/unboxer/integralimage.h"
 #include "ghash.h"
 
 struct boxing_tracker_s;
@@ -42,6 +43,7 @@ typedef enum
     BOXING_TRACK_SYSTEM_HUMAN_READABLE = 0x0080,
     BOXING_TRACK_USER_HUMAN_READABLE   = 0x0100,
     BOXING_TRACK_SYNC_POINTS           = 0x0200,
+    BOXING_TRACK_PREDICT_CORNER_MARKS  = 0x0400,
 } Mode;
 
 typedef int  (*boxing_tracker_frame_callback)(struct boxing_tracker_s * tracker, const boxing_image8 * frame);
@@ -59,6 +61,8 @@ typedef struct boxing_tracker_s
     boxing_container_sampler_list   container_sampler_list; // Output from track_frame
     boxing_float                    x_sampling_rate; // Output from track_frame
     boxing_float                    y_sampling_rate; // Output from track_frame
+    boxing_integral_image *         integral_image;  // Summed area tables of the tracked frame
+    int                             thread_count;    // Worker threads used while tracking
     const char*                     type;
 #ifdef BOXINGLIB_CALLBACK
     boxing_corner_mark_complete_cb  on_corner_mark_complete;
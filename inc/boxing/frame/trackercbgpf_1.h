@@ -31,6 +31,7 @@ typedef struct correct_frame_geometry_properties_s
     boxing_float sync_point_search_radius;
     DBOOL        sync_point_center_is_bright;
     boxing_float sync_point_max_allowed_variation;
+    int          thread_count;
 } correct_frame_geometry_properties;
 
 
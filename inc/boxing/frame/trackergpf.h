@@ -51,5 +51,9 @@ typedef struct boxing_tracker_gpf_s
 void    boxing_tracker_gpf_init(boxing_tracker_gpf * tracker, boxing_frame * generic_frame);
 int     boxing_tracker_gpf_track_frame(boxing_tracker * tracker, const boxing_image8 * frame);
 void    boxing_tracker_gpf_free(boxing_tracker * tracker);
+int     boxing_tracker_gpf_track_corner_marks(void * user, const boxing_image8 * image, boxing_corner_mark_definition * definition,
+                                              boxing_float sampling_rate_x, boxing_float sampling_rate_y, frame_corner_marks * corner_marks);
+int     boxing_tracker_gpf_validate_corner_marks(const boxing_image8 * image, const boxing_corner_mark_definition * definition,
+                                                 boxing_float sampling_rate_x, boxing_float sampling_rate_y, frame_corner_marks * corner_marks);
 
 #endif
@@ -73,6 +73,12 @@ typedef struct boxing_tracker_gpf_1_s
     int                    x_offset;
     int                    y_offset;
     boxing_coordmapper     coordinate_mapper;
+
+    // corner marks of the previous frame, used to predict the next
+    frame_corner_marks     previous_corner_marks;
+    boxing_pointi          previous_image_size;
+    DBOOL                  previous_corner_marks_valid;
+
     boxing_calculate_sampling_locations_cb calculate_sampling_location;
     boxing_track_vertical_shift_cb         track_vertical_shift;
     boxing_correct_frame_geometry_cb       correct_frame_geometry;
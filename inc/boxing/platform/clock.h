@@ -0,0 +1,32 @@
+#ifndef BOXING_CLOCK_H
+#define BOXING_CLOCK_H
+
+/*****************************************************************************
+**
+**  Definition of the monotonic clock interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  PROJECT INCLUDES
+//
+#include "boxing/platform/types.h"
+
+boxing_double boxing_clock_milliseconds(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef BOXING_CPU_H
+#define BOXING_CPU_H
+
+/*****************************************************************************
+**
+**  Definition of the CPU feature detection interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  PROJECT INCLUDES
+//
+#include "boxing/platform/types.h"
+#include "boxing/bool.h"
+
+//  ARCHITECTURE
+//
+#if defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)
+#   define BOXING_CPU_X86
+#elif defined (__aarch64__) || defined (_M_ARM64)
+#   define BOXING_CPU_ARM
+#endif
+
+// Functions using instruction set extensions beyond the compiler baseline
+// must be tagged with a target attribute on GCC and Clang.
+#if defined (__GNUC__) || defined (__clang__)
+#   define BOXING_CPU_TARGET(isa) __attribute__((target(isa)))
+#else
+#   define BOXING_CPU_TARGET(isa)
+#endif
+
+enum boxing_cpu_feature
+{
+    BOXING_CPU_FEATURE_SSE2   = 0x0001,
+    BOXING_CPU_FEATURE_SSSE3  = 0x0002,
+    BOXING_CPU_FEATURE_SSE41  = 0x0004,
+    BOXING_CPU_FEATURE_AVX2   = 0x0008,
+    BOXING_CPU_FEATURE_PCLMUL = 0x0010,
+    BOXING_CPU_FEATURE_NEON   = 0x0100,
+    BOXING_CPU_FEATURE_PMULL  = 0x0200
+};
+
+unsigned int boxing_cpu_features(void);
+DBOOL        boxing_cpu_has_feature(unsigned int feature);
+void         boxing_cpu_set_feature_mask(unsigned int mask);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
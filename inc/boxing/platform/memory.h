@@ -23,17 +23,29 @@ extern "C" {
 //
 #include "boxing/platform/platform.h"
 
-#define BOXING_MEMORY_ALLOCATE_TYPE( type ) (type*)malloc( sizeof( type ) )
-#define BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( type, count ) (type*)malloc( sizeof( type ) * (count) )
+#define BOXING_MEMORY_ALLOCATE_TYPE( type ) (type*)boxing_memory_allocate( sizeof( type ) )
+#define BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( type, count ) (type*)boxing_memory_allocate( sizeof( type ) * (count) )
 #define BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR( type, count ) (type*)boxing_memory_allocate_and_clear( sizeof( type ) * (count) )
 #define BOXING_STACK_ALLOCATE_TYPE_ARRAY( type, count ) (type*)alloca( sizeof( type ) * (count) )
 #define BOXING_NULL_POINTER NULL
 
 void*   boxing_memory_allocate(size_t size_in_bytes);
 void*   boxing_memory_allocate_and_clear( size_t size_in_bytes );
+void*   boxing_memory_reallocate(void* pointer_to_memory, size_t size_in_bytes);
 void    boxing_memory_free(void* pointer_to_memory);
 void    boxing_memory_clear(void* pointer_to_memory, size_t size_in_bytes);
 void    boxing_memory_copy(void* pointer_to_memory_destination, const void* pointer_to_memory_source, size_t size_in_bytes);
+void*   boxing_memory_map_temporary_file(const char* directory, size_t size_in_bytes);
+void    boxing_memory_unmap_temporary_file(void* pointer_to_memory, size_t size_in_bytes);
+
+typedef struct boxing_memory_scope_s
+{
+    boxing_int64 base;
+    boxing_int64 outer_peak;
+} boxing_memory_scope;
+
+void    boxing_memory_scope_begin(boxing_memory_scope* scope);
+size_t  boxing_memory_scope_end(boxing_memory_scope* scope);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,84 @@
+#ifndef BOXING_THREAD_H
+#define BOXING_THREAD_H
+
+/*****************************************************************************
+**
+**  Definition of the thread interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  PROJECT INCLUDES
+//
+#include "boxing/platform/platform.h"
+#include "boxing/bool.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (D_OS_LINUX)
+#   include <pthread.h>
+#endif
+
+typedef struct boxing_thread_s    boxing_thread;
+typedef struct boxing_mutex_s     boxing_mutex;
+typedef struct boxing_condition_s boxing_condition;
+
+typedef void (*boxing_thread_function)(void * user);
+typedef void (*boxing_parallel_function)(void * user, int index);
+typedef void (*boxing_once_function)(void * user);
+
+// One time initialization guard, must be initialized with BOXING_THREAD_ONCE_INIT
+#if defined (D_OS_WIN32)
+typedef struct boxing_once_s
+{
+    void * volatile once; // INIT_ONCE, which only holds a pointer
+} boxing_once;
+#   define BOXING_THREAD_ONCE_INIT { NULL }
+#elif defined (D_OS_LINUX)
+typedef struct boxing_once_s
+{
+    pthread_once_t once;
+} boxing_once;
+#   define BOXING_THREAD_ONCE_INIT { PTHREAD_ONCE_INIT }
+#else
+typedef struct boxing_once_s
+{
+    int done;
+} boxing_once;
+#   define BOXING_THREAD_ONCE_INIT { 0 }
+#endif
+
+boxing_thread *    boxing_thread_create(boxing_thread_function function, void * user);
+void               boxing_thread_join(boxing_thread * thread);
+int                boxing_thread_hardware_concurrency(void);
+int                boxing_thread_resolve_count(int thread_count, int job_count);
+void               boxing_thread_parallel_for(int count, int thread_count, boxing_parallel_function function, void * user);
+void               boxing_thread_once(boxing_once * once, boxing_once_function function, void * user);
+
+boxing_mutex *     boxing_mutex_create(void);
+void               boxing_mutex_free(boxing_mutex * mutex);
+void               boxing_mutex_lock(boxing_mutex * mutex);
+void               boxing_mutex_unlock(boxing_mutex * mutex);
+
+boxing_condition * boxing_condition_create(void);
+void               boxing_condition_free(boxing_condition * condition);
+void               boxing_condition_wait(boxing_condition * condition, boxing_mutex * mutex);
+void               boxing_condition_signal(boxing_condition * condition);
+void               boxing_condition_broadcast(boxing_condition * condition);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
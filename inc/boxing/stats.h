@@ -22,6 +22,7 @@ extern "C" {
 //  PROJECT INCLUDES
 //
 #include "boxing/platform/types.h"
+#include "boxing/platform/memory.h"
 
 
 typedef struct boxing_stats_decode_s
@@ -30,6 +31,10 @@ typedef struct boxing_stats_decode_s
     unsigned int unresolved_errors;
     boxing_float fec_accumulated_amount;
     boxing_float fec_accumulated_weight;
+    // Codewords of iterative decoders and the decoding iterations they needed
+    unsigned int decoded_codewords;
+    unsigned int decode_iterations;
+    unsigned int max_decode_iterations;
 } boxing_stats_decode;
 
 typedef struct boxing_stats_mtf_s
@@ -48,6 +53,26 @@ typedef struct boxing_reference_bar_stats_s
     boxing_float right_mtf;
 } boxing_reference_bar_stats;
 
+typedef struct boxing_stats_stage_s
+{
+    const char *  name;
+    const char *  coding_scheme;
+    int           step;
+    boxing_double time;
+    size_t        peak_allocation;
+} boxing_stats_stage;
+
+typedef void (*boxing_stats_stage_cb)(void * user, const boxing_stats_stage * stage);
+
+typedef struct boxing_stats_stage_timer_s
+{
+    boxing_double       start;
+    boxing_memory_scope memory;
+} boxing_stats_stage_timer;
+
+void boxing_stats_stage_begin(boxing_stats_stage_timer * timer);
+void boxing_stats_stage_end(boxing_stats_stage_timer * timer, boxing_stats_stage * stage);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
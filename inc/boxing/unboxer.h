@@ -52,6 +52,8 @@ struct boxing_config_s;
 
 typedef boxing_image8* (*boxing_sample_cb)(void* user, const boxing_image8 * frame, const boxing_matrixf* location_matrix, DBOOL* state);
 typedef gvector*       (*boxing_quantize_cb)(void* user, const boxing_image8 * image, int block_width, int block_height, int bins);
+typedef gvector*       (*boxing_sample_quantize_cb)(void* user, const boxing_image8 * frame, const boxing_matrixf* location_matrix,
+                                                    int block_width, int block_height, int bins, gvector * erasures);
 
 #ifdef BOXINGLIB_CALLBACK
 
@@ -83,6 +85,9 @@ typedef struct boxing_unboxer_parameters_s
     boxing_filter                       pre_filter;
     boxing_sample_cb                    sample_contents;
     boxing_quantize_cb                  quantize_contents;
+    boxing_sample_quantize_cb           sample_quantize_contents;
+    int                                 thread_count;
+    int                                 pipeline_queue_depth;
 #ifdef BOXINGLIB_CALLBACK
     boxing_tracker_created_cb           on_tracker_created;
     boxing_content_sampled_cb           on_content_sampled;
@@ -93,12 +98,23 @@ typedef struct boxing_unboxer_parameters_s
     boxing_training_complete_cb         on_training_complete;
     boxing_decode_step_cb               on_decode_step;
     boxing_all_complete_cb              on_all_complete;
+    boxing_stats_stage_cb               on_stage_timing;
     boxing_image8 *                     orig_image;
 #endif
 } boxing_unboxer_parameters;
 
 typedef struct boxing_unboxer_s boxing_unboxer;
 
+typedef struct boxing_unboxer_frame_s
+{
+    boxing_image8 *        image;
+    gvector *              data;
+    boxing_metadata_list * metadata;
+    int                    extract_result;
+    int                    result;
+    void *                 user_data;
+} boxing_unboxer_frame;
+
 typedef struct boxing_unboxing_codec_info_s
 {
     const char * name;
@@ -132,9 +148,16 @@ enum boxing_unboxer_result boxing_unboxer_unbox(
                     boxing_unboxer * unboxer,
                     int * extract_result, 
                     void *user_data);
+enum boxing_unboxer_result boxing_unboxer_unbox_batch(
+                    boxing_unboxer_frame * frames,
+                    int frame_count,
+                    boxing_unboxer * unboxer,
+                    int worker_count);
 boxing_codecdispatcher *  boxing_unboxer_dispatcher(boxing_unboxer * unboxer, const char * coding_scheme);
 void                boxing_unboxer_parameters_init(boxing_unboxer_parameters * parameters);
 void                boxing_unboxer_parameters_free(boxing_unboxer_parameters * parameters);
+gvector *           boxing_unboxer_sample_quantize(void * user, const boxing_image8 * frame, const boxing_matrixf * location_matrix,
+                                                   int block_width, int block_height, int bins, gvector * erasures);
 
 #ifdef __cplusplus
 } /* extern "C" */
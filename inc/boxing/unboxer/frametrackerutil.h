@@ -25,6 +25,7 @@ extern "C" {
 #include "boxing/matrix.h"
 #include "boxing/utils.h"
 #include "boxing/unboxer/cornermark.h"
+#include "boxing/unboxer/integralimage.h"
 
 enum BOXING_TRACKERUTIL_SCAN_DIRECTION 
 {
@@ -40,9 +41,24 @@ DBOOL         boxing_frame_tracker_util_track_reference_bar(const boxing_image8
 DBOOL         boxing_frame_tracker_util_find_vertical_border(const boxing_image8 * image, const boxing_pointi *from, int lenght, boxing_pointi *border);
 DBOOL         boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * image, const boxing_pointi *from, int lenght, boxing_pointi *border);
 boxing_pointi boxing_frame_tracker_util_find_corner_mark(const boxing_image8 * image, boxing_pointi location, boxing_pointi dimension, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+boxing_pointi boxing_frame_tracker_util_find_corner_mark_exhaustive(const boxing_image8 * image, boxing_pointi location, boxing_pointi dimension, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
 DBOOL         boxing_frame_tracker_util_validate_corner_mark(boxing_pointi * location, boxing_pointi * dimension, const boxing_image8 * image);
 void          boxing_frame_tracker_util_add_displacement(const boxing_matrixf * displacement_matrix, boxing_matrixf * point_model);
 DBOOL         boxing_frame_tracker_util_find_frame(const boxing_image8 * image, frame_corner_marks * corner_marks, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+DBOOL         boxing_frame_tracker_util_find_frame_near(const boxing_image8 * image, const frame_corner_marks * previous, frame_corner_marks * corner_marks,
+                                int search_radius, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+
+// Variants sharing the summed area tables of the image between calls, a NULL integral_image calculates them per call
+boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi start, const boxing_pointi stop, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+void          boxing_frame_tracker_util_track_vertical_border_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi * from, const boxing_pointi * to, boxing_float * border_location, int scan_direction, boxing_float x_sampling_rate);
+void          boxing_frame_tracker_util_calculate_average_maxmin_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi *const * corner_marks, int corner_marks_size, boxing_float x_sampling_rate, boxing_float y_sampling_rate, boxing_float * avg_max, boxing_float * avg_min);
+DBOOL         boxing_frame_tracker_util_find_vertical_border_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi *from, int lenght, boxing_pointi *border);
+DBOOL         boxing_frame_tracker_util_find_horizontal_border_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi *from, int lenght, boxing_pointi *border);
+boxing_pointi boxing_frame_tracker_util_find_corner_mark_integral(const boxing_image8 * image, boxing_integral_image * integral_image, boxing_pointi location, boxing_pointi dimension, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+boxing_pointi boxing_frame_tracker_util_find_corner_mark_exhaustive_integral(const boxing_image8 * image, boxing_integral_image * integral_image, boxing_pointi location, boxing_pointi dimension, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+DBOOL         boxing_frame_tracker_util_find_frame_integral(const boxing_image8 * image, boxing_integral_image * integral_image, frame_corner_marks * corner_marks, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+DBOOL         boxing_frame_tracker_util_find_frame_near_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const frame_corner_marks * previous, frame_corner_marks * corner_marks,
+                                int search_radius, boxing_float x_sampling_rate, boxing_float y_sampling_rate);
 
 #ifdef __cplusplus
 } /* extern "C" */
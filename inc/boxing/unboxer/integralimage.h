@@ -0,0 +1,55 @@
+#ifndef BOXING_INTEGRALIMAGE_H
+#define BOXING_INTEGRALIMAGE_H
+
+/*****************************************************************************
+**
+**  Definition of the integral image interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  PROJECT INCLUDES
+//
+#include "boxing/image8.h"
+#include "boxing/utils.h"
+#include "boxing/platform/types.h"
+
+#define BOXING_INTEGRAL_IMAGE_TILE_SHIFT 6
+#define BOXING_INTEGRAL_IMAGE_TILE_SIZE  (1 << BOXING_INTEGRAL_IMAGE_TILE_SHIFT)
+
+//============================================================================
+//  STRUCT:  boxing_integral_image
+
+typedef struct boxing_integral_image_s
+{
+    const boxing_image8 * image;
+    int                   tiles_x;
+    int                   tiles_y;
+    boxing_uint32 **      tiles;
+    unsigned char *       built;
+} boxing_integral_image;
+
+boxing_integral_image * boxing_integral_image_create(const boxing_image8 * image);
+void                    boxing_integral_image_free(boxing_integral_image * integral_image);
+void                    boxing_integral_image_reset(boxing_integral_image * integral_image, const boxing_image8 * image);
+void                    boxing_integral_image_sums(boxing_integral_image * integral_image, int x, int y, int width, int height,
+                                                   boxing_uint64 * sum, boxing_uint64 * squared_sum);
+boxing_uint64           boxing_integral_image_sum(boxing_integral_image * integral_image, int x, int y, int width, int height);
+boxing_float            boxing_integral_image_average(boxing_integral_image * integral_image, const boxing_pointi * point, const boxing_pointi * dimension);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -41,6 +41,7 @@ typedef struct boxing_sampler_s
 
     boxing_matrixf     location_matrix;
     DBOOL              state;
+    int                thread_count; // Worker threads used while sampling
 } boxing_sampler;
 
 void boxing_sampler_init(boxing_sampler * sampler, int width, int height);
@@ -17,11 +17,45 @@
 #include "boxing/math/crc32.h"
 #include "boxing/log.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/thread.h"
+#include "math_crcfold.h"
+
+//  PRIVATE INTERFACE
+//
+
+// Tables of a polynom, CRCTable[k] advances a byte followed by k zero bytes
+typedef struct crc32_tables_s
+{
+    boxing_uint32             polynom;
+    boxing_uint32             CRCTable[8][256];
+    boxing_crc_fold_constants fold;
+} crc32_tables;
 
 struct dcrc32_s
 {
-    boxing_uint32 crc;
-    boxing_uint32 CRCTable[256];
+    boxing_uint32        crc;
+    const crc32_tables * tables;
+    crc32_tables *       own_tables;
+};
+
+static void          init_tables(crc32_tables * tables, boxing_uint32 polynom);
+static void          init_shared_tables(void * user);
+static boxing_uint32 calc_crc_tables(const crc32_tables * tables, boxing_uint32 crc, const unsigned char * data, unsigned int size);
+
+// The tables of the named polynoms are calculated once and shared
+static crc32_tables shared_tables[] =
+{
+    { .polynom = POLY_CRC_32 },
+    { .polynom = POLY_CRC_32C },
+    { .polynom = POLY_CRC_32K },
+    { .polynom = POLY_CRC_32Q }
+};
+static boxing_once  shared_tables_once[] =
+{
+    BOXING_THREAD_ONCE_INIT,
+    BOXING_THREAD_ONCE_INIT,
+    BOXING_THREAD_ONCE_INIT,
+    BOXING_THREAD_ONCE_INIT
 };
 
 
@@ -119,20 +153,24 @@ dcrc32 * boxing_math_crc32_create(boxing_uint32 seed, boxing_uint32 polynom)
     DFATAL(dcrc, "Out of memory");
 
     dcrc->crc = seed;
+    dcrc->tables = NULL;
+    dcrc->own_tables = NULL;
 
-    // precalculate crc32 for 8 bit data
-    for (unsigned int i = 0; i < 256; i++) 
+    for (unsigned int i = 0; i < sizeof(shared_tables) / sizeof(shared_tables[0]); i++)
     {
-        int j;
-        boxing_uint32 part = ((unsigned long long)i << 24);
-        for (j = 0; j < 8; j++) 
+        if (shared_tables[i].polynom == polynom)
         {
-            if ((part) & 1UL<<31)
-                part = (part << 1) ^ polynom;
-            else
-                part <<= 1;
+            boxing_thread_once(&shared_tables_once[i], init_shared_tables, &shared_tables[i]);
+            dcrc->tables = &shared_tables[i];
         }
-        dcrc->CRCTable[i] = part;
+    }
+
+    if (dcrc->tables == NULL)
+    {
+        dcrc->own_tables = BOXING_MEMORY_ALLOCATE_TYPE(crc32_tables);
+        DFATAL(dcrc->own_tables, "Out of memory");
+        init_tables(dcrc->own_tables, polynom);
+        dcrc->tables = dcrc->own_tables;
     }
 
     return dcrc;
@@ -150,6 +188,11 @@ dcrc32 * boxing_math_crc32_create(boxing_uint32 seed, boxing_uint32 polynom)
 
 void boxing_math_crc32_free(dcrc32 * dcrc32)
 {
+    if (dcrc32 == NULL)
+    {
+        return;
+    }
+    boxing_memory_free(dcrc32->own_tables);
     boxing_memory_free(dcrc32);
 }
 
@@ -187,14 +230,16 @@ boxing_uint32 boxing_math_crc32_calc_crc(dcrc32 * dcrc32, const char * data, uns
 
 boxing_uint32 boxing_math_crc32_calc_crc_re(const dcrc32 * dcrc32, boxing_uint32 seed, const char * data, unsigned int size)
 {
+    // Fold the bulk of the data with carry-less multiplication when the CPU supports it
+    unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE];
+    unsigned int folded = boxing_math_crc_fold(&dcrc32->tables->fold, seed, 32, data, size, remainder);
     boxing_uint32 crc = seed;
-    while(size)
+    if (folded)
     {
-        crc = (crc << 8) ^ dcrc32->CRCTable[((crc >> 24) ^ *data) & 0xff];
-        data++;
-        size--;
+        crc = calc_crc_tables(dcrc32->tables, 0, remainder, BOXING_CRC_FOLD_BLOCK_SIZE);
     }
-    return crc;
+
+    return calc_crc_tables(dcrc32->tables, crc, (const unsigned char *)data + folded, size - folded);
 }
 
 
@@ -235,4 +280,72 @@ void boxing_math_crc32_reset(dcrc32 * dcrc32, boxing_uint32 seed)
   * \} end of math group
   */
 
+
+// PRIVATE MATH CRC32 FUNCTIONS
+//
+
+static void init_tables(crc32_tables * tables, boxing_uint32 polynom)
+{
+    tables->polynom = polynom;
+
+    // precalculate crc32 for 8 bit data
+    for (unsigned int i = 0; i < 256; i++) 
+    {
+        int j;
+        boxing_uint32 part = ((unsigned long long)i << 24);
+        for (j = 0; j < 8; j++) 
+        {
+            if ((part) & 1UL<<31)
+                part = (part << 1) ^ polynom;
+            else
+                part <<= 1;
+        }
+        tables->CRCTable[0][i] = part;
+    }
+
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        for (int k = 1; k < 8; k++)
+        {
+            boxing_uint32 part = tables->CRCTable[k - 1][i];
+            tables->CRCTable[k][i] = (part << 8) ^ tables->CRCTable[0][part >> 24];
+        }
+    }
+
+    boxing_math_crc_fold_init(&tables->fold, polynom, 32);
+}
+
+static void init_shared_tables(void * user)
+{
+    crc32_tables * tables = (crc32_tables *)user;
+    init_tables(tables, tables->polynom);
+}
+
+static boxing_uint32 calc_crc_tables(const crc32_tables * tables, boxing_uint32 crc, const unsigned char * data, unsigned int size)
+{
+    // 8 bytes at a time, the bytes are read one by one so the byte order of the CPU does not matter
+    while (size >= 8)
+    {
+        boxing_uint32 high = crc ^ ((boxing_uint32)data[0] << 24 | (boxing_uint32)data[1] << 16 | (boxing_uint32)data[2] << 8 | data[3]);
+        crc = tables->CRCTable[7][high >> 24] ^
+            tables->CRCTable[6][(high >> 16) & 0xff] ^
+            tables->CRCTable[5][(high >> 8) & 0xff] ^
+            tables->CRCTable[4][high & 0xff] ^
+            tables->CRCTable[3][data[4]] ^
+            tables->CRCTable[2][data[5]] ^
+            tables->CRCTable[1][data[6]] ^
+            tables->CRCTable[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+
+    while(size)
+    {
+        crc = (crc << 8) ^ tables->CRCTable[0][((crc >> 24) ^ *data) & 0xff];
+        data++;
+        size--;
+    }
+    return crc;
+}
+
 /********************************** EOF *************************************/
@@ -18,20 +18,36 @@
 #include "boxing/math/crc64.h"
 #include "boxing/log.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/thread.h"
+#include "math_crcfold.h"
 
 //  PRIVATE INTERFACE
 //
 
-//per byte reverse for the 64 bit data
-static inline uint64_t rev8(uint64_t a);
+// Tables of a polynom, shared by all instances using the default polynom
+typedef struct crc64_tables_s
+{
+    boxing_uint64             crc_table[256];
+    boxing_uint64             crc_table_reversed[8][256];
+    boxing_crc_fold_constants fold;
+} crc64_tables;
 
 struct dcrc64_s
 {
-    boxing_uint64 crc;
-    boxing_uint64 crc_table[256];
-    boxing_uint64 crc_table_reversed[8][256];
+    boxing_uint64        crc;
+    const crc64_tables * tables;
+    crc64_tables *       own_tables;
 };
 
+//per byte reverse for the 64 bit data
+static inline uint64_t rev8(uint64_t a);
+static void            init_tables(crc64_tables * tables, boxing_uint64 polynom);
+static void            init_default_tables(void * user);
+static boxing_uint64   calc_crc_tables(const crc64_tables * tables, boxing_uint64 crc, const unsigned char * next, unsigned int size);
+
+static crc64_tables default_tables;
+static boxing_once  default_tables_once = BOXING_THREAD_ONCE_INIT;
+
 
 /*! 
   * \addtogroup math
@@ -99,31 +115,19 @@ dcrc64 * boxing_math_crc64_create(boxing_uint64 seed, boxing_uint64 polynom)
 
     dcrc->crc = seed;
 
-    // precalculate crc64 for 8 bit data
-    for (unsigned int i = 0; i < 256; i++)
+    // The tables of the default polynom are calculated once and shared
+    if (polynom == POLY_CRC_64)
     {
-        int j;
-        unsigned long long part = ((unsigned long long)i << 56);
-        for (j = 0; j < 8; j++)
-        {
-            if ((part)& 1ULL << 63)
-                part = (part << 1) ^ polynom;
-            else
-                part <<= 1;
-        }
-        dcrc->crc_table[i] = (part);
+        boxing_thread_once(&default_tables_once, init_default_tables, NULL);
+        dcrc->tables = &default_tables;
+        dcrc->own_tables = NULL;
     }
-
-
-    for (int n = 0; n < 256; n++) {
-        boxing_uint64 temp_crc;
-        temp_crc = dcrc->crc_table[n];
-        dcrc->crc_table_reversed[0][n] = rev8(temp_crc);
-
-        for (int k = 1; k < 8; k++) {
-            temp_crc = dcrc->crc_table[(temp_crc >> 56) & 0xff] ^ (temp_crc << 8);
-            dcrc->crc_table_reversed[k][n] = rev8(temp_crc);
-        }
+    else
+    {
+        dcrc->own_tables = BOXING_MEMORY_ALLOCATE_TYPE(crc64_tables);
+        DFATAL(dcrc->own_tables, "Out of memory");
+        init_tables(dcrc->own_tables, polynom);
+        dcrc->tables = dcrc->own_tables;
     }
 
     return dcrc;
@@ -141,6 +145,11 @@ dcrc64 * boxing_math_crc64_create(boxing_uint64 seed, boxing_uint64 polynom)
 
 void boxing_math_crc64_free(dcrc64 * dcrc64)
 {
+    if (dcrc64 == NULL)
+    {
+        return;
+    }
+    boxing_memory_free(dcrc64->own_tables);
     boxing_memory_free(dcrc64);
 }
 
@@ -178,35 +187,16 @@ boxing_uint64 boxing_math_crc64_calc_crc(dcrc64 * dcrc64, const char *data, unsi
 
 boxing_uint64 boxing_math_crc64_calc_crc_re(const dcrc64 * dcrc64, boxing_uint64 seed, const char * data, unsigned int size)
 {
-    unsigned char *next = (unsigned char *)data;
+    // Fold the bulk of the data with carry-less multiplication when the CPU supports it
+    unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE];
+    unsigned int folded = boxing_math_crc_fold(&dcrc64->tables->fold, seed, 64, data, size, remainder);
     boxing_uint64 crc = seed;
-
-    while (size && ((uintptr_t)next & 7) != 0) {
-        crc = (dcrc64->crc_table[((crc >> 56) ^ *next++) & 0xff]) ^ (crc << 8);
-        size--;
-    }
-
-    crc = rev8(dcrc64->crc);
-    while (size >= 8) {
-        crc ^= (*(uint64_t *)next);//8 byte aligned and 8 bytes at a time processed
-        crc = dcrc64->crc_table_reversed[0][(crc >> 56) & 0xff] ^
-            dcrc64->crc_table_reversed[1][(crc >> 48) & 0xff] ^
-            dcrc64->crc_table_reversed[2][(crc >> 40) & 0xff] ^
-            dcrc64->crc_table_reversed[3][(crc >> 32) & 0xff] ^
-            dcrc64->crc_table_reversed[4][(crc >> 24) & 0xff] ^
-            dcrc64->crc_table_reversed[5][(crc >> 16) & 0xff] ^
-            dcrc64->crc_table_reversed[6][(crc >> 8) & 0xff] ^
-            dcrc64->crc_table_reversed[7][(crc)& 0xff];
-        next += 8;
-        size -= 8;
+    if (folded)
+    {
+        crc = calc_crc_tables(dcrc64->tables, 0, remainder, BOXING_CRC_FOLD_BLOCK_SIZE);
     }
-    crc = rev8(crc);
 
-    while (size) {//no more than 8
-        crc = dcrc64->crc_table[((crc >> 56) ^ *next++) & 0xff] ^ (crc << 8);
-        size--;
-    }
-    return crc;
+    return calc_crc_tables(dcrc64->tables, crc, (const unsigned char *)data + folded, size - folded);
 }
 
 
@@ -251,6 +241,75 @@ void boxing_math_crc64_reset(dcrc64 * dcrc64, boxing_uint64 seed)
 // PRIVATE MATH CRC64 FUNCTIONS
 //
 
+static void init_tables(crc64_tables * tables, boxing_uint64 polynom)
+{
+    // precalculate crc64 for 8 bit data
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        int j;
+        unsigned long long part = ((unsigned long long)i << 56);
+        for (j = 0; j < 8; j++)
+        {
+            if ((part)& 1ULL << 63)
+                part = (part << 1) ^ polynom;
+            else
+                part <<= 1;
+        }
+        tables->crc_table[i] = (part);
+    }
+
+
+    for (int n = 0; n < 256; n++) {
+        boxing_uint64 temp_crc;
+        temp_crc = tables->crc_table[n];
+        tables->crc_table_reversed[0][n] = rev8(temp_crc);
+
+        for (int k = 1; k < 8; k++) {
+            temp_crc = tables->crc_table[(temp_crc >> 56) & 0xff] ^ (temp_crc << 8);
+            tables->crc_table_reversed[k][n] = rev8(temp_crc);
+        }
+    }
+
+    boxing_math_crc_fold_init(&tables->fold, polynom, 64);
+}
+
+static void init_default_tables(void * user)
+{
+    (void)user;
+    init_tables(&default_tables, POLY_CRC_64);
+}
+
+static boxing_uint64 calc_crc_tables(const crc64_tables * tables, boxing_uint64 crc, const unsigned char * next, unsigned int size)
+{
+    while (size && ((uintptr_t)next & 7) != 0) {
+        crc = (tables->crc_table[((crc >> 56) ^ *next++) & 0xff]) ^ (crc << 8);
+        size--;
+    }
+
+    // continue from the crc of the unaligned head
+    crc = rev8(crc);
+    while (size >= 8) {
+        crc ^= (*(uint64_t *)next);//8 byte aligned and 8 bytes at a time processed
+        crc = tables->crc_table_reversed[0][(crc >> 56) & 0xff] ^
+            tables->crc_table_reversed[1][(crc >> 48) & 0xff] ^
+            tables->crc_table_reversed[2][(crc >> 40) & 0xff] ^
+            tables->crc_table_reversed[3][(crc >> 32) & 0xff] ^
+            tables->crc_table_reversed[4][(crc >> 24) & 0xff] ^
+            tables->crc_table_reversed[5][(crc >> 16) & 0xff] ^
+            tables->crc_table_reversed[6][(crc >> 8) & 0xff] ^
+            tables->crc_table_reversed[7][(crc)& 0xff];
+        next += 8;
+        size -= 8;
+    }
+    crc = rev8(crc);
+
+    while (size) {//no more than 8
+        crc = tables->crc_table[((crc >> 56) ^ *next++) & 0xff] ^ (crc << 8);
+        size--;
+    }
+    return crc;
+}
+
 static inline uint64_t rev8(uint64_t a)
 {
 #if defined(__GNUC__) || defined(__clang__)
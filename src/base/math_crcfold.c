@@ -0,0 +1,273 @@
+/*****************************************************************************
+**
+**  Implementation of the carry-less multiply CRC folding interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "math_crcfold.h"
+#include "boxing/platform/cpu.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
+
+//  DEFINES
+//
+
+// Blocks folded in parallel, shorter data is left to the tables
+#define FOLD_LANES 4
+
+//  PRIVATE INTERFACE
+//
+
+static boxing_uint64 x_pow_mod(unsigned int power, boxing_uint64 polynom, int width);
+#if defined (BOXING_CPU_X86)
+static unsigned int  fold_pclmul(const boxing_crc_fold_constants * constants, boxing_uint64 seed, int width,
+                         const char * data, unsigned int size, unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE]);
+#elif defined (BOXING_CPU_ARM)
+static unsigned int  fold_pmull(const boxing_crc_fold_constants * constants, boxing_uint64 seed, int width,
+                         const char * data, unsigned int size, unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE]);
+#endif
+
+
+/*! 
+  * \addtogroup math
+  * \{
+  */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \struct  boxing_crc_fold_constants_s  math_crcfold.h
+ *  \brief   Folding constants of a CRC polynomial.
+ *
+ *  \param k  Remainders of x^(128*n) and x^(128*n+64) divided by the polynomial, for n = 1..4.
+ */
+
+
+// PUBLIC MATH CRC FOLD FUNCTIONS
+//
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Calculate the folding constants of a CRC polynomial.
+ *
+ *  \param[out] constants  Folding constants.
+ *  \param[in]  polynom    Polynom without the leading term.
+ *  \param[in]  width      CRC width in bits, 64 or less.
+ */
+
+void boxing_math_crc_fold_init(boxing_crc_fold_constants * constants, boxing_uint64 polynom, int width)
+{
+    for (int n = 0; n < 4; n++)
+    {
+        constants->k[n][0] = x_pow_mod(128 * (n + 1), polynom, width);
+        constants->k[n][1] = x_pow_mod(128 * (n + 1) + 64, polynom, width);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Fold data into a 128 bit remainder with carry-less multiplication.
+ *
+ *  Folds the leading 16 byte blocks of the data, with the seed added to the first
+ *  block, into 16 bytes with the same CRC. The CRC of the data is the CRC of the
+ *  remainder with seed 0, continued over the bytes that were not folded. The
+ *  CRC is the non reflected one of the table driven code, most significant bit
+ *  first. Nothing is folded if the CPU has no carry-less multiply or the data is
+ *  shorter than four blocks.
+ *
+ *  \param[in]  constants  Folding constants of the polynomial.
+ *  \param[in]  seed       Seed value.
+ *  \param[in]  width      CRC width in bits, 64 or less.
+ *  \param[in]  data       Data to fold.
+ *  \param[in]  size       Data size.
+ *  \param[out] remainder  Folded remainder in message byte order.
+ *  \return Number of bytes folded, a multiple of 16.
+ */
+
+unsigned int boxing_math_crc_fold(const boxing_crc_fold_constants * constants, boxing_uint64 seed, int width,
+    const char * data, unsigned int size, unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE])
+{
+    if (size < FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE)
+    {
+        return 0;
+    }
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_PCLMUL | BOXING_CPU_FEATURE_SSSE3))
+    {
+        return fold_pclmul(constants, seed, width, data, size, remainder);
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_PMULL))
+    {
+        return fold_pmull(constants, seed, width, data, size, remainder);
+    }
+#else
+    (void)constants;
+    (void)seed;
+    (void)width;
+    (void)data;
+    (void)remainder;
+#endif
+    return 0;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of math group
+  */
+
+
+// PRIVATE MATH CRC FOLD FUNCTIONS
+//
+
+static boxing_uint64 x_pow_mod(unsigned int power, boxing_uint64 polynom, int width)
+{
+    const boxing_uint64 top_bit = (boxing_uint64)1 << (width - 1);
+    const boxing_uint64 mask = width == 64 ? ~(boxing_uint64)0 : ((boxing_uint64)1 << width) - 1;
+    boxing_uint64 remainder = 1;
+    for (unsigned int i = 0; i < power; i++)
+    {
+        const DBOOL carry = (remainder & top_bit) != 0;
+        remainder = (remainder << 1) & mask;
+        if (carry)
+        {
+            remainder ^= polynom;
+        }
+    }
+    return remainder;
+}
+
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("pclmul,ssse3")
+static __m128i load_reversed_sse(const char * data)
+{
+    // The first byte of the message is the most significant
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), reverse);
+}
+
+BOXING_CPU_TARGET("pclmul,ssse3")
+static __m128i fold_sse(__m128i value, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(value, k, 0x00), _mm_clmulepi64_si128(value, k, 0x11));
+}
+
+BOXING_CPU_TARGET("pclmul,ssse3")
+static unsigned int fold_pclmul(const boxing_crc_fold_constants * constants, boxing_uint64 seed, int width,
+    const char * data, unsigned int size, unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE])
+{
+    __m128i lane[FOLD_LANES];
+    for (int i = 0; i < FOLD_LANES; i++)
+    {
+        lane[i] = load_reversed_sse(data + i * BOXING_CRC_FOLD_BLOCK_SIZE);
+    }
+    lane[0] = _mm_xor_si128(lane[0], _mm_set_epi64x((long long)(seed << (64 - width)), 0));
+
+    unsigned int done = FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE;
+    const __m128i k4 = _mm_set_epi64x((long long)constants->k[3][1], (long long)constants->k[3][0]);
+    for (; done + FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE <= size; done += FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE)
+    {
+        for (int i = 0; i < FOLD_LANES; i++)
+        {
+            lane[i] = _mm_xor_si128(fold_sse(lane[i], k4), load_reversed_sse(data + done + i * BOXING_CRC_FOLD_BLOCK_SIZE));
+        }
+    }
+
+    // Lane i is followed by FOLD_LANES - 1 - i blocks
+    __m128i value = lane[FOLD_LANES - 1];
+    for (int i = 0; i < FOLD_LANES - 1; i++)
+    {
+        const int n = FOLD_LANES - 2 - i;
+        value = _mm_xor_si128(value, fold_sse(lane[i], _mm_set_epi64x((long long)constants->k[n][1], (long long)constants->k[n][0])));
+    }
+
+    const __m128i k1 = _mm_set_epi64x((long long)constants->k[0][1], (long long)constants->k[0][0]);
+    for (; done + BOXING_CRC_FOLD_BLOCK_SIZE <= size; done += BOXING_CRC_FOLD_BLOCK_SIZE)
+    {
+        value = _mm_xor_si128(fold_sse(value, k1), load_reversed_sse(data + done));
+    }
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    _mm_storeu_si128((__m128i *)remainder, _mm_shuffle_epi8(value, reverse));
+    return done;
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+BOXING_CPU_TARGET("+crypto")
+static uint64x2_t load_reversed_neon(const char * data)
+{
+    // The first byte of the message is the most significant
+    uint8x16_t bytes = vrev64q_u8(vld1q_u8((const uint8_t *)data));
+    return vreinterpretq_u64_u8(vextq_u8(bytes, bytes, 8));
+}
+
+BOXING_CPU_TARGET("+crypto")
+static uint64x2_t fold_neon(uint64x2_t value, boxing_uint64 k_low, boxing_uint64 k_high)
+{
+    uint64x2_t low = vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(value, 0), (poly64_t)k_low));
+    uint64x2_t high = vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(value, 1), (poly64_t)k_high));
+    return veorq_u64(low, high);
+}
+
+BOXING_CPU_TARGET("+crypto")
+static unsigned int fold_pmull(const boxing_crc_fold_constants * constants, boxing_uint64 seed, int width,
+    const char * data, unsigned int size, unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE])
+{
+    uint64x2_t lane[FOLD_LANES];
+    for (int i = 0; i < FOLD_LANES; i++)
+    {
+        lane[i] = load_reversed_neon(data + i * BOXING_CRC_FOLD_BLOCK_SIZE);
+    }
+    lane[0] = veorq_u64(lane[0], vcombine_u64(vcreate_u64(0), vcreate_u64(seed << (64 - width))));
+
+    unsigned int done = FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE;
+    for (; done + FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE <= size; done += FOLD_LANES * BOXING_CRC_FOLD_BLOCK_SIZE)
+    {
+        for (int i = 0; i < FOLD_LANES; i++)
+        {
+            lane[i] = veorq_u64(fold_neon(lane[i], constants->k[3][0], constants->k[3][1]),
+                load_reversed_neon(data + done + i * BOXING_CRC_FOLD_BLOCK_SIZE));
+        }
+    }
+
+    // Lane i is followed by FOLD_LANES - 1 - i blocks
+    uint64x2_t value = lane[FOLD_LANES - 1];
+    for (int i = 0; i < FOLD_LANES - 1; i++)
+    {
+        const int n = FOLD_LANES - 2 - i;
+        value = veorq_u64(value, fold_neon(lane[i], constants->k[n][0], constants->k[n][1]));
+    }
+
+    for (; done + BOXING_CRC_FOLD_BLOCK_SIZE <= size; done += BOXING_CRC_FOLD_BLOCK_SIZE)
+    {
+        value = veorq_u64(fold_neon(value, constants->k[0][0], constants->k[0][1]), load_reversed_neon(data + done));
+    }
+
+    uint8x16_t bytes = vrev64q_u8(vreinterpretq_u8_u64(value));
+    vst1q_u8(remainder, vextq_u8(bytes, bytes, 8));
+    return done;
+}
+
+#endif
+
+/********************************** EOF *************************************/
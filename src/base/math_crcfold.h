@@ -0,0 +1,44 @@
+#ifndef BOXING_MATH_CRCFOLD_H
+#define BOXING_MATH_CRCFOLD_H
+
+/*****************************************************************************
+**
+**  Definition of the carry-less multiply CRC folding interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  BASE INCLUDES
+#include "boxing/platform/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOXING_CRC_FOLD_BLOCK_SIZE 16
+
+// x^(128*n) mod P and x^(128*n+64) mod P for n = 1..4
+typedef struct boxing_crc_fold_constants_s
+{
+    boxing_uint64 k[4][2];
+} boxing_crc_fold_constants;
+
+void         boxing_math_crc_fold_init(boxing_crc_fold_constants * constants, boxing_uint64 polynom, int width);
+unsigned int boxing_math_crc_fold(const boxing_crc_fold_constants * constants, boxing_uint64 seed, int width,
+                 const char * data, unsigned int size, unsigned char remainder[BOXING_CRC_FOLD_BLOCK_SIZE]);
+
+//
+//===================================EOF======================================
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -18,13 +18,36 @@
 #include "boxing/log.h"
 #include "boxing/platform/memory.h"
 #include "boxing/image8.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/platform/thread.h"
+#include "boxing/math/math.h"
+#include "boxing/string.h"
 #include "horizontalmeasures.h"
+#include <math.h>
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
 
 //  DEFINES
 //
 
-#define CODEC_MEMBER(name) (((boxing_codec_modulator *)codec)->name)
-#define CODEC_BASE_MEMBER(name) (((boxing_codec_modulator *)codec)->base.name)
+#define CODEC_MEMBER(name) (((boxing_codec_2dpam *)codec)->name)
+#define CODEC_BASE_MEMBER(name) (((boxing_codec_2dpam *)codec)->base.name)
+
+#define PAM_LEVELS        6
+#define PAM_POINTS        (PAM_LEVELS * PAM_LEVELS)
+#define PAM_BITS          5
+#define PAM_GRAY_LEVELS   256
+// Distances of a gray level to the levels of a block, padded to 16 bytes
+#define PAM_TABLE_STRIDE  8
+// Largest quantized distance, the sum of two distances fits in 16 bits
+#define PAM_DISTANCE_MAX  8191
+// The distances are in the unit of the LLR, a tenth of a nat
+#define PAM_LLR_SCALE     10
+// Symbol pairs demodulated at once by the max-log path
+#define PAM_BATCH_SIZE    64
 
 //  CONSTANTS
 //
@@ -38,7 +61,7 @@ typedef struct pam2d_symboli_s
     pam_symboli s1;
 }pam2d_symboli;
 
-char bit_map[5][2][6][6] = {
+static const char bit_map[5][2][6][6] = {
     {
         {
             { 1, 1, 1, 1, 1, 1 },
@@ -168,9 +191,62 @@ static const pam2d_symboli map_32_2dPam[32] =
 //  PRIVATE INTERFACE
 //
 
+// Constellation points, row * PAM_LEVELS + col, where a bit is zero and one
+typedef struct pam_bit_points_s
+{
+    unsigned char points[PAM_BITS][2][PAM_POINTS];
+    int           count[PAM_BITS][2];
+} pam_bit_points;
+
+// Quantized distances of every gray level to the levels of each block in a block row
+typedef struct pam_distance_tables_s
+{
+    int       block_row;
+    int16_t * distances;
+} pam_distance_tables;
+
+// Symbol pairs waiting for the max-log kernel, the distances and the LLRs are
+// stored level by level and bit by bit so the kernel works across pairs
+typedef struct pam_batch_s
+{
+    int16_t     distances0[PAM_LEVELS * PAM_BATCH_SIZE];
+    int16_t     distances1[PAM_LEVELS * PAM_BATCH_SIZE];
+    signed char llr[PAM_BITS * PAM_BATCH_SIZE];
+    int         count;
+} pam_batch;
+
+typedef int (*pam_llr_kernel)(const int16_t * distances0, const int16_t * distances1, int count, const pam_bit_points * points, signed char * llr);
+
+// Demodulation of one frame, split in ranges of block rows decoded by separate threads
+typedef struct pam_decode_job_s
+{
+    const boxing_codec_2dpam *  codec;
+    const boxing_matrix_float * means;
+    boxing_pointi               block_size;
+    char *                      src;
+    unsigned char *             dst;
+    int                         block_rows;
+    int                         range_count;
+    unsigned int                pairs;
+} pam_decode_job;
+
+struct symbol_tracker;
+
+// Bit points of the constellation, built once and shared read only by all codecs
+static pam_bit_points bit_points;
+static boxing_once    bit_points_once = BOXING_THREAD_ONCE_INIT;
+
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data);
 static DBOOL codec_encode(void * codec, gvector * data);
 static boxing_codec_syncpointinserter * create_syncpointinserter(GHashTable * properties, const boxing_config * config);
+static DBOOL codec_set_property(void * codec, const char * name, const g_variant * value);
+static unsigned int * count_row_symbols(const boxing_codec_syncpointinserter * codec);
+static void  demodulate_exact(struct symbol_tracker * tracker, const boxing_matrix_float * means, boxing_pointi block_size, unsigned int pairs, unsigned char * dst);
+static void  demodulate_max_log(struct symbol_tracker * tracker, const boxing_matrix_float * means, boxing_pointi block_size, unsigned int pairs, unsigned char * dst);
+static void  init_bit_points(void * user);
+static void  build_distance_tables(pam_distance_tables * tables, const boxing_matrix_float * means, int block_row);
+static void  llr_max_log(const int16_t * distances0, const int16_t * distances1, int index, const pam_bit_points * points, signed char * llr);
+static pam_llr_kernel select_llr_kernel(void);
 
 
 /*! 
@@ -190,11 +266,27 @@ static boxing_codec_syncpointinserter * create_syncpointinserter(GHashTable * pr
  *  \param base                       Pointer to the boxing_codec structure.
  *  \param num_data_pixels_per_frame  Number of data pixels per frame.
  *  \param syncpointinserter          Pointer to the boxing_codec_syncpointinserter structure.
+ *  \param llr                        LLR computation.
+ *  \param thread_count               Number of threads demodulating a frame, less than 1 uses all cores.
+ *  \param row_symbols                Number of data symbols before each image row, one more than the image height.
  *
  *  Structure for storing codec 2dpam data.
  */
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \enum       boxing_pam2d_llr  2dpam.h
+ *  \brief      LLR computation of the 2dpam demodulation.
+ *
+ *  \param BOXING_PAM2D_LLR_EXACT    (0) Sum of the gaussian likelihoods of all constellation points.
+ *  \param BOXING_PAM2D_LLR_MAX_LOG  (1) Difference of the nearest points with the bit zero and one,
+ *                                   from quantized distance tables of each block.
+ *
+ *  Selected by the codec property 'llr', the exact computation is the default.
+ */
+
+
 //----------------------------------------------------------------------------
 /*!
  *  \brief Create an boxing_codec_2dpam instance.
@@ -216,12 +308,42 @@ boxing_codec * boxing_codec_2dpam_create(GHashTable * properties, const boxing_c
 
     codec->syncpointinserter = create_syncpointinserter(properties, config);
     codec->syncpointinserter->property_value_sync_point_foreground_m = 5;
+    codec->row_symbols = count_row_symbols(codec->syncpointinserter);
+
+    codec->llr = BOXING_PAM2D_LLR_EXACT;
+    g_variant * var_llr = g_hash_table_lookup(properties, PARAM_NAME_LLR);
+    if (var_llr != NULL)
+    {
+        const char * llr_str = g_variant_if_string(var_llr);
+        if (boxing_string_equal(llr_str, PARAM_NAME_LLR_MAX_LOG))
+        {
+            codec->llr = BOXING_PAM2D_LLR_MAX_LOG;
+        }
+        else if (!boxing_string_equal(llr_str, PARAM_NAME_LLR_EXACT))
+        {
+            DLOG_ERROR2("Unsupported '%s' : %s", PARAM_NAME_LLR, llr_str);
+            boxing_codec_2dpam_free((boxing_codec *)codec);
+            return NULL;
+        }
+    }
+
+    codec->thread_count = 1;
+    g_variant * var_thread_count = g_hash_table_lookup(properties, PARAM_NAME_THREAD_COUNT);
+    if (var_thread_count != NULL)
+    {
+        codec_set_property(codec, PARAM_NAME_THREAD_COUNT, var_thread_count);
+    }
+
+    boxing_thread_once(&bit_points_once, init_bit_points, &bit_points);
 
     codec->base.free = boxing_codec_2dpam_free;
     codec->base.is_error_correcting = DFALSE;
     codec->base.name = codec_2dpam_name;
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
+    codec->base.set_property = codec_set_property;
+    // Decoding only reads the codec and the shared tables, all scratch is local
+    codec->base.reentrant = DTRUE;
 
     codec->base.encoded_symbol_size = codec->syncpointinserter->base.encoded_symbol_size;
     codec->base.decoded_symbol_size = 1;
@@ -245,6 +367,7 @@ boxing_codec * boxing_codec_2dpam_create(GHashTable * properties, const boxing_c
 void boxing_codec_2dpam_free(boxing_codec * codec)
 {
     boxing_codec_syncpointinserter_free((boxing_codec *)(((boxing_codec_2dpam *)codec)->syncpointinserter));
+    boxing_memory_free(((boxing_codec_2dpam *)codec)->row_symbols);
     boxing_codec_release_base(codec);
     boxing_memory_free(codec);
 }
@@ -327,21 +450,50 @@ static DBOOL get_next_symbol(struct symbol_tracker * tracker)
 }
 
 
-static void init_tracker(struct symbol_tracker *tracker, boxing_codec_syncpointinserter * codec, char *img)
+// Starts the symbol walk at the first pixel of the given row
+static void init_tracker(struct symbol_tracker *tracker, boxing_codec_syncpointinserter * codec, char *img, int row)
 {
+    const ptrdiff_t offset = (ptrdiff_t)row * codec->property_image_size_m.x;
     tracker->map_bg = codec->bitarray_sync_point_background;
-    tracker->map_bg_cur = codec->bitarray_sync_point_background-1;
-    tracker->map_fg_cur = codec->bitarray_sync_point_foreground-1;
+    tracker->map_bg_cur = codec->bitarray_sync_point_background + offset - 1;
+    tracker->map_fg_cur = codec->bitarray_sync_point_foreground + offset - 1;
     tracker->width = codec->property_image_size_m.x;
     tracker->height = codec->property_image_size_m.y;
 
     tracker->map_bg_end = tracker->map_bg + (tracker->width * tracker->height);
     tracker->x = -1;
     tracker->y = -1;
-    tracker->img_cur = img-1;
+    tracker->img_cur = img + offset - 1;
 }
 
-static char calc_llr(char b[2][6][6], double v[6][6])
+
+// Data symbols are the pixels outside the sync points, the counts let each
+// thread find the symbol pair its rows start at without walking the frame
+static unsigned int * count_row_symbols(const boxing_codec_syncpointinserter * codec)
+{
+    const int width = codec->property_image_size_m.x;
+    const int height = codec->property_image_size_m.y;
+    unsigned int * row_symbols = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(unsigned int, height + 1);
+    const char * map_bg = codec->bitarray_sync_point_background;
+    const char * map_fg = codec->bitarray_sync_point_foreground;
+
+    row_symbols[0] = 0;
+    for (int y = 0; y < height; y++)
+    {
+        unsigned int count = 0;
+        for (int x = 0; x < width; x++, map_bg++, map_fg++)
+        {
+            if (!(*map_bg || *map_fg))
+            {
+                count++;
+            }
+        }
+        row_symbols[y + 1] = row_symbols[y] + count;
+    }
+    return row_symbols;
+}
+
+static char calc_llr(const char b[2][6][6], double v[6][6])
 {
     double p0 = 0;
     double p1 = 0;
@@ -365,57 +517,119 @@ static char calc_llr(char b[2][6][6], double v[6][6])
 }
 
 
+// Demodulates the symbol pairs starting in one contiguous range of block rows,
+// the pair crossing into the next range is finished by this range
+static void decode_rows(void * user, int index)
+{
+    pam_decode_job * job = (pam_decode_job *)user;
+    const boxing_codec_2dpam * codec = job->codec;
+    const int height = codec->syncpointinserter->property_image_size_m.y;
+    const int first = (int)((long long)job->block_rows * index / job->range_count);
+    const int last = (int)((long long)job->block_rows * (index + 1) / job->range_count);
+    const int row_begin = first * job->block_size.y;
+    const int row_end = BOXING_MATH_MIN(last * job->block_size.y, height);
+
+    const unsigned int symbol_begin = codec->row_symbols[row_begin];
+    const unsigned int first_pair = (symbol_begin + 1) / 2;
+    const unsigned int end_pair = BOXING_MATH_MIN((codec->row_symbols[row_end] + 1) / 2, job->pairs);
+    if (first_pair >= end_pair)
+    {
+        return;
+    }
+
+    struct symbol_tracker tracker;
+    init_tracker(&tracker, codec->syncpointinserter, job->src, row_begin);
+    if (symbol_begin % 2)
+    {
+        // The first symbol belongs to the pair of the previous range
+        get_next_symbol(&tracker);
+    }
+
+    unsigned char * dst = job->dst + (size_t)first_pair * PAM_BITS;
+    if (codec->llr == BOXING_PAM2D_LLR_MAX_LOG)
+    {
+        demodulate_max_log(&tracker, job->means, job->block_size, end_pair - first_pair, dst);
+    }
+    else
+    {
+        demodulate_exact(&tracker, job->means, job->block_size, end_pair - first_pair, dst);
+    }
+}
+
+
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
     BOXING_UNUSED_PARAMETER(stats);
     BOXING_UNUSED_PARAMETER(erasures);
     BOXING_UNUSED_PARAMETER(user_data);
+    const boxing_codec_2dpam * pam_codec = (const boxing_codec_2dpam *)codec;
     boxing_image8 image;
     
-    image.width = ((boxing_codec_2dpam *)codec)->syncpointinserter->property_image_size_m.x;
-    image.height = ((boxing_codec_2dpam *)codec)->syncpointinserter->property_image_size_m.y;
+    image.width = pam_codec->syncpointinserter->property_image_size_m.x;
+    image.height = pam_codec->syncpointinserter->property_image_size_m.y;
     image.is_owning_data = DFALSE;
     image.data = data->buffer;
     unsigned int h_block_size_scale = 1;
     unsigned int v_block_size_scale = 4;
     unsigned int block_size_base = 16;
     boxing_pointi block_size = { block_size_base * h_block_size_scale, block_size_base * v_block_size_scale };
-    boxing_matrix_float * means = boxing_calculate_means(&image, block_size.x, block_size.y, 6);
-
-    // demodulate
-    struct symbol_tracker tracker;
-
-    init_tracker(&tracker, ((boxing_codec_2dpam *)codec)->syncpointinserter, data->buffer);
-
-    gvector * decoded_data = gvector_create(data->item_size, ((boxing_codec_2dpam *)codec)->base.decoded_block_size);
+    boxing_matrix_float * means = boxing_calculate_means(&image, block_size.x, block_size.y, PAM_LEVELS, pam_codec->thread_count);
+
+    gvector * decoded_data = gvector_create(data->item_size, pam_codec->base.decoded_block_size);
+
+    // demodulate, each thread walks its own range of block rows
+    pam_decode_job job;
+    job.codec = pam_codec;
+    job.means = means;
+    job.block_size = block_size;
+    job.src = data->buffer;
+    job.dst = (unsigned char *)decoded_data->buffer;
+    job.block_rows = (int)((image.height + block_size.y - 1) / block_size.y);
+    job.range_count = boxing_thread_resolve_count(pam_codec->thread_count, job.block_rows);
+    job.pairs = BOXING_MATH_MIN(pam_codec->row_symbols[image.height] / 2, pam_codec->base.decoded_block_size / PAM_BITS);
+    boxing_thread_parallel_for(job.range_count, job.range_count, decode_rows, &job);
+
+    boxing_matrix_float_free(means);
+    gvector_swap(data, decoded_data);
+    gvector_free(decoded_data);
+    return DTRUE;
+}
 
-    unsigned char * dst = (unsigned char *)decoded_data->buffer;
 
-    while (1)
+static void demodulate_exact(struct symbol_tracker * tracker, const boxing_matrix_float * means, boxing_pointi block_size, unsigned int pairs, unsigned char * dst)
+{
+    for (unsigned int pair = 0; pair < pairs; pair++)
     {
-        if (DTRUE != get_next_symbol(&tracker))
+        if (DTRUE != get_next_symbol(tracker))
             break;
-        int s0 = *(unsigned char*)tracker.img_cur;
-        boxing_float *mean0 = MATRIX_MULTIPAGE_ROW_PTR(means, tracker.x/block_size.x, tracker.y/block_size.y);
-        boxing_float *var0 = mean0 + 6;
+        int s0 = *(unsigned char*)tracker->img_cur;
+        const boxing_float *mean0 = MATRIX_MULTIPAGE_ROW_PTR(means, tracker->x / block_size.x, tracker->y / block_size.y);
+        const boxing_float *var0 = mean0 + PAM_LEVELS;
 
-        if (DTRUE != get_next_symbol(&tracker))
+        if (DTRUE != get_next_symbol(tracker))
             break;
-        int s1 = *(unsigned char*)tracker.img_cur;
-        boxing_float *mean1 = MATRIX_MULTIPAGE_ROW_PTR(means, tracker.x / block_size.x, tracker.y / block_size.y);
-        boxing_float *var1 = mean1 + 6;
+        int s1 = *(unsigned char*)tracker->img_cur;
+        const boxing_float *mean1 = MATRIX_MULTIPAGE_ROW_PTR(means, tracker->x / block_size.x, tracker->y / block_size.y);
+        const boxing_float *var1 = mean1 + PAM_LEVELS;
+
+        // The likelihood of a point is the product of the likelihoods of its
+        // two levels, so 12 exponentials give all 36 points
+        double p0[PAM_LEVELS];
+        double p1[PAM_LEVELS];
+        for (int level = 0; level < PAM_LEVELS; level++)
+        {
+            double dS0 = s0 - mean0[level];
+            double dS1 = s1 - mean1[level];
+            p0[level] = exp(-(dS0 * dS0) / (var0[level]));
+            p1[level] = exp(-(dS1 * dS1) / (var1[level]));
+        }
 
-        //double std_dev = 6.9;
         double r[6][6];
         for (int row = 0; row < 6; row++)
         {
             for (int col = 0; col < 6; col++)
             {
-                //double std_dev_pow = 2 * std_dev*std_dev;
-                double dS0 = s0 - mean0[col];
-                double dS1 = s1 - mean1[row];
-                //r[row][col] = exp(-(dS0 * dS0) / (std_dev_pow)) * exp(-(dS1 * dS1) / (std_dev_pow));
-                r[row][col] = exp(-(dS0 * dS0) / (var0[col])) * exp(-(dS1 * dS1) / (var1[row]));
+                r[row][col] = p0[col] * p1[row];
             }
         }
 
@@ -425,12 +639,345 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
         *dst++ = calc_llr(bit_map[3], r);
         *dst++ = calc_llr(bit_map[4], r);
     }
+}
+
+
+// Appends the distances of the symbol at the tracker to a batch, building the
+// tables when the symbol walk enters a new block row
+static void add_symbol_distances(int16_t * distances, int index, pam_distance_tables * tables, const struct symbol_tracker * tracker, const boxing_matrix_float * means, boxing_pointi block_size)
+{
+    const int block_row = tracker->y / block_size.y;
+    if (tables->block_row != block_row)
+    {
+        build_distance_tables(tables, means, block_row);
+    }
+
+    const int16_t * table = tables->distances + ((tracker->x / block_size.x) * PAM_GRAY_LEVELS + *(unsigned char *)tracker->img_cur) * PAM_TABLE_STRIDE;
+    for (int level = 0; level < PAM_LEVELS; level++)
+    {
+        distances[level * PAM_BATCH_SIZE + index] = table[level];
+    }
+}
+
+
+static void flush_batch(pam_batch * batch, pam_llr_kernel kernel, const pam_bit_points * points, unsigned char * dst)
+{
+    int n = kernel ? kernel(batch->distances0, batch->distances1, batch->count, points, batch->llr) : 0;
+    for (; n < batch->count; n++)
+    {
+        llr_max_log(batch->distances0, batch->distances1, n, points, batch->llr);
+    }
+
+    for (int pair = 0; pair < batch->count; pair++)
+    {
+        for (int bit = 0; bit < PAM_BITS; bit++)
+        {
+            *dst++ = (unsigned char)batch->llr[bit * PAM_BATCH_SIZE + pair];
+        }
+    }
+    batch->count = 0;
+}
+
+
+// The log of the sum of the likelihoods is approximated by the log of the
+// largest one. The LLR is then the difference of the distances to the nearest
+// points with the bit zero and one, which only takes table reads, adds and
+// minimums
+static void demodulate_max_log(struct symbol_tracker * tracker, const boxing_matrix_float * means, boxing_pointi block_size, unsigned int pairs, unsigned char * dst)
+{
+    const pam_bit_points * points = &bit_points;
+    const pam_llr_kernel kernel = select_llr_kernel();
+
+    // The symbol walk is row by row, so each block row is built once
+    pam_distance_tables tables;
+    tables.block_row = -1;
+    tables.distances = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int16_t, means->rows * PAM_GRAY_LEVELS * PAM_TABLE_STRIDE);
+
+    pam_batch * batch = BOXING_MEMORY_ALLOCATE_TYPE(pam_batch);
+    batch->count = 0;
+
+    for (unsigned int pair = 0; pair < pairs; pair++)
+    {
+        if (DTRUE != get_next_symbol(tracker))
+            break;
+        add_symbol_distances(batch->distances0, batch->count, &tables, tracker, means, block_size);
+
+        if (DTRUE != get_next_symbol(tracker))
+            break;
+        add_symbol_distances(batch->distances1, batch->count, &tables, tracker, means, block_size);
+
+        if (++batch->count == PAM_BATCH_SIZE)
+        {
+            flush_batch(batch, kernel, points, dst);
+            dst += PAM_BATCH_SIZE * PAM_BITS;
+        }
+    }
+    flush_batch(batch, kernel, points, dst);
+
+    boxing_memory_free(batch);
+    boxing_memory_free(tables.distances);
+}
+
+
+static DBOOL codec_set_property(void * codec, const char * name, const g_variant * value)
+{
+    if (boxing_string_equal(name, PARAM_NAME_THREAD_COUNT))
+    {
+        CODEC_MEMBER(thread_count) = (int)g_variant_to_int(value);
+    }
 
-    gvector_swap(data, decoded_data);
-    gvector_free(decoded_data);
     return DTRUE;
 }
 
+
+static void init_bit_points(void * user)
+{
+    pam_bit_points * points = (pam_bit_points *)user;
+    for (int bit = 0; bit < PAM_BITS; bit++)
+    {
+        for (int value = 0; value < 2; value++)
+        {
+            int count = 0;
+            for (int point = 0; point < PAM_POINTS; point++)
+            {
+                if (bit_map[bit][value][point / PAM_LEVELS][point % PAM_LEVELS])
+                {
+                    points->points[bit][value][count++] = (unsigned char)point;
+                }
+            }
+            points->count[bit][value] = count;
+        }
+    }
+}
+
+
+static void build_distance_tables(pam_distance_tables * tables, const boxing_matrix_float * means, int block_row)
+{
+    int16_t * table = tables->distances;
+    for (unsigned int block = 0; block < means->rows; block++)
+    {
+        const boxing_float * mean = MATRIX_MULTIPAGE_ROW_PTR(means, block, block_row);
+        const boxing_float * variance = mean + PAM_LEVELS;
+        boxing_float scale[PAM_LEVELS];
+        for (int level = 0; level < PAM_LEVELS; level++)
+        {
+            scale[level] = PAM_LLR_SCALE / variance[level];
+        }
+
+        for (int value = 0; value < PAM_GRAY_LEVELS; value++, table += PAM_TABLE_STRIDE)
+        {
+            for (int level = 0; level < PAM_LEVELS; level++)
+            {
+                const boxing_float d = value - mean[level];
+                const boxing_float distance = d * d * scale[level];
+                // Also catches a variance that is not a number
+                table[level] = distance < PAM_DISTANCE_MAX ? (int16_t)(distance + 0.5f) : PAM_DISTANCE_MAX;
+            }
+            for (int level = PAM_LEVELS; level < PAM_TABLE_STRIDE; level++)
+            {
+                table[level] = PAM_DISTANCE_MAX;
+            }
+        }
+    }
+    tables->block_row = block_row;
+}
+
+
+static void llr_max_log(const int16_t * distances0, const int16_t * distances1, int index, const pam_bit_points * points, signed char * llr)
+{
+    int sums[PAM_POINTS];
+    for (int row = 0; row < PAM_LEVELS; row++)
+    {
+        for (int col = 0; col < PAM_LEVELS; col++)
+        {
+            sums[row * PAM_LEVELS + col] = distances1[row * PAM_BATCH_SIZE + index] + distances0[col * PAM_BATCH_SIZE + index];
+        }
+    }
+
+    for (int bit = 0; bit < PAM_BITS; bit++)
+    {
+        int minimum[2];
+        for (int value = 0; value < 2; value++)
+        {
+            const unsigned char * point = points->points[bit][value];
+            int m = sums[point[0]];
+            for (int k = 1; k < points->count[bit][value]; k++)
+            {
+                m = BOXING_MATH_MIN(m, sums[point[k]]);
+            }
+            minimum[value] = m;
+        }
+
+        int difference = minimum[0] - minimum[1];
+        if (difference > 127)
+            difference = 127;
+        else if (difference < -128)
+            difference = -128;
+        llr[bit * PAM_BATCH_SIZE + index] = (signed char)difference;
+    }
+}
+
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("sse2")
+static int llr_max_log_sse2(const int16_t * distances0, const int16_t * distances1, int count, const pam_bit_points * points, signed char * llr)
+{
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        __m128i level0[PAM_LEVELS];
+        __m128i level1[PAM_LEVELS];
+        for (int level = 0; level < PAM_LEVELS; level++)
+        {
+            level0[level] = _mm_loadu_si128((const __m128i *)(distances0 + level * PAM_BATCH_SIZE + n));
+            level1[level] = _mm_loadu_si128((const __m128i *)(distances1 + level * PAM_BATCH_SIZE + n));
+        }
+
+        __m128i sums[PAM_POINTS];
+        for (int row = 0; row < PAM_LEVELS; row++)
+        {
+            for (int col = 0; col < PAM_LEVELS; col++)
+            {
+                sums[row * PAM_LEVELS + col] = _mm_add_epi16(level1[row], level0[col]);
+            }
+        }
+
+        for (int bit = 0; bit < PAM_BITS; bit++)
+        {
+            __m128i minimum[2];
+            for (int value = 0; value < 2; value++)
+            {
+                const unsigned char * point = points->points[bit][value];
+                __m128i m = sums[point[0]];
+                for (int k = 1; k < points->count[bit][value]; k++)
+                {
+                    m = _mm_min_epi16(m, sums[point[k]]);
+                }
+                minimum[value] = m;
+            }
+
+            // The signed saturation clamps the LLR to a char
+            const __m128i difference = _mm_sub_epi16(minimum[0], minimum[1]);
+            _mm_storel_epi64((__m128i *)(llr + bit * PAM_BATCH_SIZE + n), _mm_packs_epi16(difference, difference));
+        }
+    }
+    return n;
+}
+
+// The AVX2 kernel leaves the tail to the portable code, see the LDPC min-sum kernels
+
+BOXING_CPU_TARGET("avx2")
+static int llr_max_log_avx2(const int16_t * distances0, const int16_t * distances1, int count, const pam_bit_points * points, signed char * llr)
+{
+    int n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        __m256i level0[PAM_LEVELS];
+        __m256i level1[PAM_LEVELS];
+        for (int level = 0; level < PAM_LEVELS; level++)
+        {
+            level0[level] = _mm256_loadu_si256((const __m256i *)(distances0 + level * PAM_BATCH_SIZE + n));
+            level1[level] = _mm256_loadu_si256((const __m256i *)(distances1 + level * PAM_BATCH_SIZE + n));
+        }
+
+        __m256i sums[PAM_POINTS];
+        for (int row = 0; row < PAM_LEVELS; row++)
+        {
+            for (int col = 0; col < PAM_LEVELS; col++)
+            {
+                sums[row * PAM_LEVELS + col] = _mm256_add_epi16(level1[row], level0[col]);
+            }
+        }
+
+        for (int bit = 0; bit < PAM_BITS; bit++)
+        {
+            __m256i minimum[2];
+            for (int value = 0; value < 2; value++)
+            {
+                const unsigned char * point = points->points[bit][value];
+                __m256i m = sums[point[0]];
+                for (int k = 1; k < points->count[bit][value]; k++)
+                {
+                    m = _mm256_min_epi16(m, sums[point[k]]);
+                }
+                minimum[value] = m;
+            }
+
+            // The pack works within the 128 bit lanes, the permute joins the low halves
+            const __m256i difference = _mm256_sub_epi16(minimum[0], minimum[1]);
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(difference, difference), 0x08);
+            _mm_storeu_si128((__m128i *)(llr + bit * PAM_BATCH_SIZE + n), _mm256_castsi256_si128(packed));
+        }
+    }
+    return n;
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static int llr_max_log_neon(const int16_t * distances0, const int16_t * distances1, int count, const pam_bit_points * points, signed char * llr)
+{
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        int16x8_t level0[PAM_LEVELS];
+        int16x8_t level1[PAM_LEVELS];
+        for (int level = 0; level < PAM_LEVELS; level++)
+        {
+            level0[level] = vld1q_s16(distances0 + level * PAM_BATCH_SIZE + n);
+            level1[level] = vld1q_s16(distances1 + level * PAM_BATCH_SIZE + n);
+        }
+
+        int16x8_t sums[PAM_POINTS];
+        for (int row = 0; row < PAM_LEVELS; row++)
+        {
+            for (int col = 0; col < PAM_LEVELS; col++)
+            {
+                sums[row * PAM_LEVELS + col] = vaddq_s16(level1[row], level0[col]);
+            }
+        }
+
+        for (int bit = 0; bit < PAM_BITS; bit++)
+        {
+            int16x8_t minimum[2];
+            for (int value = 0; value < 2; value++)
+            {
+                const unsigned char * point = points->points[bit][value];
+                int16x8_t m = sums[point[0]];
+                for (int k = 1; k < points->count[bit][value]; k++)
+                {
+                    m = vminq_s16(m, sums[point[k]]);
+                }
+                minimum[value] = m;
+            }
+
+            vst1_s8(llr + bit * PAM_BATCH_SIZE + n, vqmovn_s16(vsubq_s16(minimum[0], minimum[1])));
+        }
+    }
+    return n;
+}
+
+#endif
+
+static pam_llr_kernel select_llr_kernel(void)
+{
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_AVX2))
+    {
+        return llr_max_log_avx2;
+    }
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        return llr_max_log_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        return llr_max_log_neon;
+    }
+#endif
+    return NULL;
+}
+
 static DBOOL codec_encode(void * codec, gvector * data)
 {
     gvector * encoded_data = gvector_create(data->item_size, ((boxing_codec*)codec)->encoded_block_size);
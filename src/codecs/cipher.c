@@ -18,6 +18,11 @@
 #include "boxing/codecs/cipher.h"
 #include "boxing/log.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/thread.h"
+
+//  SYSTEM INCLUDES
+//
+#include <string.h>
 
 //  DEFINES
 //
@@ -31,12 +36,27 @@
 static const char *PARAM_NAME_KEY = "key";
 static const char codec_name[] = "Cipher";
 static const uint32_t LFSR32_TAPS = 0xD0000001u;// Linear Feedback Shift Register
+static const int LFSR32_JUMP_BITS = 64;
+
+// The keystream of the last key, the key is the same for every frame on a reel.
+// The unboxer decodes with copies of the codec, they all share the cache.
+struct boxing_cipher_keystream_s
+{
+    boxing_mutex * mutex;
+    uint32_t       key;
+    gvector *      stream;
+};
 
 //  PRIVATE INTERFACE
 //
 
 static DBOOL codec_encode(void * codec, gvector * data);
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data);
+static void  init_jump_tables(boxing_codec_cipher * codec);
+static gvector * keystream_acquire(boxing_codec_cipher * codec, uint32_t key, size_t size);
+static void      keystream_release(boxing_codec_cipher * codec, uint32_t key, gvector * stream);
+static void      generate_keystream(const boxing_codec_cipher * codec, uint32_t key, unsigned char * stream_pointer, size_t size);
+static void  xor_keystream(unsigned char * data, const unsigned char * keystream, size_t size);
 
 
 /*! 
@@ -50,10 +70,13 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
  *  \struct  boxing_codec_cipher_s  cipher.h
  *  \brief   Structure for storing codec cipher data.
  *
- *  \param base      boxing_codec base structure instance.
- *  \param auto_key  Sign to use auto key.
- *  \param ones      Integer array.
- *  \param key       Codec key.
+ *  \param base           boxing_codec base structure instance.
+ *  \param auto_key       Sign to use auto key.
+ *  \param ones           Integer array.
+ *  \param key            Codec key.
+ *  \param jump_state     LFSR state 64 steps ahead, split on the bytes of the current state.
+ *  \param jump_stream    Keystream of the next 64 steps, split on the bytes of the current state.
+ *  \param keystream      Cached keystream, shared with the copies of the codec.
  *
  *  Structure for storing codec cipher data.
  */
@@ -84,6 +107,14 @@ boxing_codec * boxing_codec_cipher_create(GHashTable * properties, const boxing_
     codec->base.name = codec_name;
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
+    // The cipher does not move data, so the erasures are still valid after decoding
+    codec->base.supports_erasures = DTRUE;
+
+    init_jump_tables(codec);
+    codec->keystream = BOXING_MEMORY_ALLOCATE_TYPE(boxing_cipher_keystream);
+    codec->keystream->mutex = boxing_mutex_create();
+    codec->keystream->key = 0;
+    codec->keystream->stream = NULL;
 
     if (!boxing_config_is_set(config, "FrameFormat", "type")) // DGenericFrameGpf_b1
     {
@@ -92,6 +123,7 @@ boxing_codec * boxing_codec_cipher_create(GHashTable * properties, const boxing_
 
         if (!has_point)
         {
+            boxing_codec_cipher_free((boxing_codec *)codec);
             return NULL;
         }
         else
@@ -151,6 +183,9 @@ boxing_codec * boxing_codec_cipher_create(GHashTable * properties, const boxing_
 
 void boxing_codec_cipher_free(boxing_codec *codec)
 {
+    gvector_free(CODEC_MEMBER(keystream)->stream);
+    boxing_mutex_free(CODEC_MEMBER(keystream)->mutex);
+    boxing_memory_free(CODEC_MEMBER(keystream));
     boxing_codec_release_base(codec);
     boxing_memory_free(codec);
 }
@@ -167,14 +202,15 @@ void boxing_codec_cipher_free(boxing_codec *codec)
 
 static DBOOL codec_encode_key(void * codec, gvector * data, uint32_t key)
 {
-    uint32_t lfsr = key;
-    
     int block_size = 64;
     int data_size = (int)data->size;
     gvector * encoded_data = gvector_create(1, data_size);
+    memcpy(encoded_data->buffer, data->buffer, data_size);
 
-    unsigned char * data_pointer = (unsigned char *)data->buffer;
     unsigned char * encoded_data_pointer = (unsigned char *)encoded_data->buffer;
+    gvector * stream = keystream_acquire((boxing_codec_cipher *)codec, key, data_size);
+    xor_keystream(encoded_data_pointer, (const unsigned char *)stream->buffer, data_size);
+    keystream_release((boxing_codec_cipher *)codec, key, stream);
 
     for(int i = 0; i < data_size;)
     {
@@ -182,15 +218,7 @@ static DBOOL codec_encode_key(void * codec, gvector * data, uint32_t key)
         int block_end = (i + block_size > data_size) ? data_size : i + block_size;
         for(; i < block_end; i++)
         {
-            int bits = 8;
-            char cipher_byte = 0;
-            while(bits--)
-            {
-                lfsr = (lfsr >> 1) ^ ((~(lfsr & 1u)+1) & LFSR32_TAPS);
-                cipher_byte = (cipher_byte << 1) | (0x1 & (lfsr >> 31));
-            }
-            encoded_data_pointer[i] = data_pointer[i] ^ cipher_byte;
-            ones += CODEC_MEMBER(ones)[(unsigned char)encoded_data_pointer[i]];
+            ones += CODEC_MEMBER(ones)[encoded_data_pointer[i]];
         }
         if(ones < 8 || ones > (block_size - 1)*8)
         {
@@ -228,24 +256,150 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
 {
     BOXING_UNUSED_PARAMETER( erasures );
     BOXING_UNUSED_PARAMETER( user_data );
-    uint32_t m_lfsr = CODEC_MEMBER(key);
+    gvector * stream = keystream_acquire((boxing_codec_cipher *)codec, CODEC_MEMBER(key), data->size);
+    xor_keystream((unsigned char *)data->buffer, (const unsigned char *)stream->buffer, data->size);
+    keystream_release((boxing_codec_cipher *)codec, CODEC_MEMBER(key), stream);
+
+    stats->resolved_errors = 0;
+    stats->unresolved_errors = 0;
+    stats->fec_accumulated_amount = 0;
+    stats->fec_accumulated_weight = 0;
+    return DTRUE;
+}
+
+// The LFSR is linear, so the state and keystream 64 steps ahead are the xor of
+// the contributions of each bit of the current state. The contributions are
+// tabulated per byte of the state.
+static void init_jump_tables(boxing_codec_cipher * codec)
+{
+    uint32_t bit_state[32];
+    uint64_t bit_stream[32];
+    for (int bit = 0; bit < 32; bit++)
+    {
+        uint32_t lfsr = 1u << bit;
+        uint64_t stream = 0;
+        for (int step = 0; step < LFSR32_JUMP_BITS; step++)
+        {
+            lfsr = (lfsr >> 1) ^ ((~(lfsr & 1u)+1) & LFSR32_TAPS);
+            // Keystream bytes are filled from the most significant bit, the first byte is the lowest
+            stream |= (uint64_t)(0x1 & (lfsr >> 31)) << ((step / 8) * 8 + 7 - step % 8);
+        }
+        bit_state[bit] = lfsr;
+        bit_stream[bit] = stream;
+    }
+
+    for (int byte = 0; byte < 4; byte++)
+    {
+        for (int value = 0; value < 256; value++)
+        {
+            uint32_t state = 0;
+            uint64_t stream = 0;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                if (value & (1 << bit))
+                {
+                    state ^= bit_state[byte * 8 + bit];
+                    stream ^= bit_stream[byte * 8 + bit];
+                }
+            }
+            codec->jump_state[byte][value] = state;
+            codec->jump_stream[byte][value] = stream;
+        }
+    }
+}
+
+// A copy of the codec decoding while the cached keystream is in use by another
+// copy generates its own keystream.
+static gvector * keystream_acquire(boxing_codec_cipher * codec, uint32_t key, size_t size)
+{
+    boxing_cipher_keystream * cache = codec->keystream;
+    boxing_mutex_lock(cache->mutex);
+    gvector * stream = cache->stream;
+    // The keystream does not depend on the length, a longer cached one is reused
+    DBOOL cached = stream != NULL && cache->key == key && stream->size >= size;
+    cache->stream = NULL;
+    boxing_mutex_unlock(cache->mutex);
+
+    if (cached)
+    {
+        return stream;
+    }
 
-    for(unsigned int i = 0; i < data->size; i++)
+    if (stream == NULL)
+    {
+        stream = gvector_create(1, size);
+    }
+    else
+    {
+        gvector_resize(stream, size);
+    }
+    generate_keystream(codec, key, (unsigned char *)stream->buffer, size);
+    return stream;
+}
+
+static void keystream_release(boxing_codec_cipher * codec, uint32_t key, gvector * stream)
+{
+    boxing_cipher_keystream * cache = codec->keystream;
+    boxing_mutex_lock(cache->mutex);
+    if (cache->stream == NULL)
+    {
+        cache->stream = stream;
+        cache->key = key;
+        stream = NULL;
+    }
+    boxing_mutex_unlock(cache->mutex);
+
+    gvector_free(stream);
+}
+
+static void generate_keystream(const boxing_codec_cipher * codec, uint32_t key, unsigned char * stream_pointer, size_t size)
+{
+    uint32_t lfsr = key;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint32_t state = 0;
+        uint64_t stream = 0;
+        for (int byte = 0; byte < 4; byte++)
+        {
+            const unsigned int value = (lfsr >> (byte * 8)) & 0xff;
+            state ^= codec->jump_state[byte][value];
+            stream ^= codec->jump_stream[byte][value];
+        }
+        for (int byte = 0; byte < 8; byte++)
+        {
+            stream_pointer[i + byte] = (unsigned char)(stream >> (byte * 8));
+        }
+        lfsr = state;
+    }
+
+    for (; i < size; i++)
     {
         int bits = 8;
-        char cipher_byte = 0;
+        unsigned char cipher_byte = 0;
         while(bits--)
         {
-            m_lfsr = (m_lfsr >> 1) ^ ((~(m_lfsr & 1u)+1) & LFSR32_TAPS);
-            cipher_byte = (cipher_byte << 1) | (0x1 & (m_lfsr >> 31));
+            lfsr = (lfsr >> 1) ^ ((~(lfsr & 1u)+1) & LFSR32_TAPS);
+            cipher_byte = (cipher_byte << 1) | (0x1 & (lfsr >> 31));
         }
-        GVECTORN(data, unsigned char, i) = GVECTORN(data, unsigned char, i) ^ cipher_byte;
+        stream_pointer[i] = cipher_byte;
     }
-
-    stats->resolved_errors = 0;
-    stats->unresolved_errors = 0;
-    stats->fec_accumulated_amount = 0;
-    stats->fec_accumulated_weight = 0;
-    return DTRUE;
 }
 
+static void xor_keystream(unsigned char * data, const unsigned char * keystream, size_t size)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t data_word;
+        uint64_t stream_word;
+        memcpy(&data_word, data + i, sizeof(uint64_t));
+        memcpy(&stream_word, keystream + i, sizeof(uint64_t));
+        data_word ^= stream_word;
+        memcpy(data + i, &data_word, sizeof(uint64_t));
+    }
+    for (; i < size; i++)
+    {
+        data[i] ^= keystream[i];
+    }
+}
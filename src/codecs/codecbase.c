@@ -238,6 +238,7 @@
  *  \param encoded_symbol_size  Encoded symbol size.
  *  \param decoded_symbol_size  Decoded symbol size.
  *  \param reentrant            Reentrant value.
+ *  \param supports_erasures    Decode function keeps the erasures aligned with the decoded data.
  *  \param decode_cb            Decode callback function.
  *  \param encode_cb            Encode callback function.
  *  \param reset                Codec reset function.
@@ -358,7 +359,9 @@ void boxing_codec_init_base(boxing_codec *codec)
     codec->decoded_symbol_size = 8;
     codec->decode_cb = NULL;
     codec->reset = NULL;
+    codec->set_property = NULL;
     codec->reentrant = 1;
+    codec->supports_erasures = DFALSE;
     codec->init_capacity = init_capacity;
     codec->decoded_data_size = 1;
     codec->encoded_data_size = 1;
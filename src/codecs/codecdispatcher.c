@@ -20,6 +20,7 @@
 #include "boxing/platform/memory.h"
 #include "boxing/config.h"
 #include "boxing/utils.h"
+#include "boxing/math/math.h"
 
 //  DEFINES
 //
@@ -191,6 +192,7 @@ static DBOOL boxing_codecdispatcher_decode_er( boxing_codecdispatcher *dispatche
  *  \param config           Boxing xonfig
  *  \param version          Codec versions
  *  \param multi_frame_size Multi frame size
+ *  \param on_decode_stage  Optional callback receiving the time and memory used by each decoding step
  *
  *  This struct serves as an interface to encode and decode procedures within 
  *  the box and unbox of archivator. Formally is a dispatcher, similar to a 
@@ -290,6 +292,7 @@ boxing_codecdispatcher * boxing_codecdispatcher_create(uint32_t packet_size, uin
     }
     dispatcher->order = BOXING_CODEC_ORDER_ENCODE;
     dispatcher->symbol_alignment = BOXING_CODEC_SYMBOL_ALIGNMENT_BIT;
+    dispatcher->on_decode_stage = NULL;
 
     gvector_create_inplace(&dispatcher->encode_codecs, sizeof(boxing_codec *), 0);
     gvector_create_inplace(&dispatcher->decode_codecs, sizeof(boxing_codec *), 0);
@@ -453,7 +456,7 @@ DBOOL boxing_codecdispatcher_encode_step_codec(boxing_codec * codec, gvector * d
 
 DBOOL boxing_codecdispatcher_decode(boxing_codecdispatcher *dispatcher, gvector * data, boxing_stats_decode *stats, void* user_data)
 {
-    /// \todo Currently erasures are not used.
+    // All data is reliable, erasures are only introduced by decoders that fail
     gvector * erasures = gvector_create_char(data->size, 0);
     DBOOL return_value = boxing_codecdispatcher_decode_er(dispatcher, data, erasures, stats, user_data);
     gvector_free(erasures);
@@ -495,9 +498,13 @@ DBOOL boxing_codecdispatcher_decode_step(boxing_codecdispatcher *dispatcher, gve
  *
  *  Interface to launch codec decode procedure.
  *
+ *  The erasures hold one byte per data symbol, 0 for reliable symbols and higher
+ *  values for less reliable ones. After decoding they describe the decoded data.
+ *  Codecs not supporting erasures get their output marked as reliable.
+ *
  *  \param[in]  codec      Pointer to the boxing_codec structure.
  *  \param[in]  data       Array of bytes to encode.
- *  \param[in]  erasures   Array of erasures data bytes.
+ *  \param[in,out] erasures Array of erasures data bytes, may be NULL.
  *  \param[in]  stats      Pointer to the boxing_stats_decode structure.
  *  \param[in]  user_data  Array of user data bytes.
  *  \return DTRUE if success.
@@ -522,13 +529,25 @@ DBOOL boxing_codecdispatcher_decode_step_codec(boxing_codec * codec, gvector * d
     {
         gvector_resize(data, codec->encoded_data_size);
     }
+    if (erasures && erasures->size > data->size)
+    {
+        gvector_resize(erasures, data->size);
+    }
 
     boxing_stats_decode decode_stats;
     decode_stats.fec_accumulated_amount = 0;
     decode_stats.fec_accumulated_weight = 0;
     decode_stats.resolved_errors = 0;
     decode_stats.unresolved_errors = 0;
+    decode_stats.decoded_codewords = 0;
+    decode_stats.decode_iterations = 0;
+    decode_stats.max_decode_iterations = 0;
     retval = codec->decode(codec, data, erasures, &decode_stats, user_data);
+    if (erasures && (!codec->supports_erasures || erasures->size != data->size))
+    {
+        gvector_resize(erasures, data->size);
+        memset(erasures->buffer, 0, erasures->size);
+    }
     if (codec->is_error_correcting)
     {
         stats->unresolved_errors = 0;
@@ -537,6 +556,9 @@ DBOOL boxing_codecdispatcher_decode_step_codec(boxing_codec * codec, gvector * d
     stats->fec_accumulated_weight += decode_stats.fec_accumulated_weight;
     stats->resolved_errors += decode_stats.resolved_errors;
     stats->unresolved_errors += decode_stats.unresolved_errors;
+    stats->decoded_codewords += decode_stats.decoded_codewords;
+    stats->decode_iterations += decode_stats.decode_iterations;
+    stats->max_decode_iterations = BOXING_MATH_MAX(stats->max_decode_iterations, decode_stats.max_decode_iterations);
 
     return retval;
 }
@@ -564,6 +586,31 @@ void boxing_codecdispatcher_reset(boxing_codecdispatcher *dispatcher)
 }
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Set a property of every codec in the codec dispatcher.
+ *
+ *  Codecs without the property ignore it, e.g. PARAM_NAME_THREAD_COUNT is only
+ *  used by the codecs that decode in parallel.
+ *
+ *  \param[in]  dispatcher  Pointer to the boxing_codecdispatcher structure.
+ *  \param[in]  name        Property name.
+ *  \param[in]  value       Property value.
+ */
+
+void boxing_codecdispatcher_set_property(boxing_codecdispatcher *dispatcher, const char * name, const g_variant * value)
+{
+    for (int i = 0; i < (int)dispatcher->decode_codecs.size; i++)
+    {
+        boxing_codec * codec = GVECTORN(&dispatcher->decode_codecs, boxing_codec *, i);
+        if (codec->set_property)
+        {
+            codec->set_property(codec, name, value);
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 /*!
  *  \brief Get coding steps value from the given codec dispatcher instance.
@@ -809,7 +856,22 @@ static DBOOL boxing_codecdispatcher_decode_er(boxing_codecdispatcher *dispatcher
     DBOOL retval = DTRUE;
     for (unsigned int step = 0; step < dispatcher->decode_codecs.size; step++)
     {
+        if (dispatcher->on_decode_stage == NULL)
+        {
+            retval &= boxing_codecdispatcher_decode_step(dispatcher, data, erasures, step, stats, user_data);
+            continue;
+        }
+
+        boxing_stats_stage_timer timer;
+        boxing_stats_stage_begin(&timer);
         retval &= boxing_codecdispatcher_decode_step(dispatcher, data, erasures, step, stats, user_data);
+
+        boxing_stats_stage stage;
+        boxing_stats_stage_end(&timer, &stage);
+        stage.name = boxing_codecdispatcher_get_decode_codec(dispatcher, step)->name;
+        stage.coding_scheme = dispatcher->codeing_scheme;
+        stage.step = (int)step;
+        dispatcher->on_decode_stage(user_data, &stage);
     }
     return retval;
 }
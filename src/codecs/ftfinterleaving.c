@@ -17,22 +17,55 @@
 #include "boxing/codecs/ftfinterleaving.h"
 #include "boxing/log.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/cpu.h"
 #include "boxing/utils.h"
 
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
+
 //  DEFINES
 //
 
 #define CODEC_MEMBER(name) (((boxing_codec_ftf_interleaving *)codec)->name)
 #define CODEC_BASE_MEMBER(name) (((boxing_codec_ftf_interleaving *)codec)->base.name)
 
+// Size of the square tiles used when transposing between frames and runs
+#define FTF_TILE_SIZE 16
+
 //  PRIVATE INTERFACE
 //
 
-static GList * malloc_ftf_buffer(int blocks, size_t block_size);
-static void    free_ftf_buffer(GList *buf);
-static void    ftf_buffer_destroy_notify(gpointer data);
+// The frames in the interleaving window are stored in one contiguous buffer of
+// distance slots. Byte n of a frame goes to the frame n % distance positions
+// away in the window, so each slot stores its frame as distance runs, run r
+// holding the bytes r, r + distance, r + 2 * distance, ... A frame is then put
+// together from one contiguous run of each slot.
+typedef void (*ftf_transpose_kernel)(const char * const * source, char * const * destination);
+
+struct boxing_ftf_ring_s
+{
+    char *   buffer;
+    size_t   buffer_size;
+    DBOOL    file_backed;
+    size_t   frame_size;
+    size_t   run_size;
+    size_t   slot_size;
+    uint32_t distance;
+    uint32_t head;
+    ftf_transpose_kernel transpose;
+};
+
+static boxing_ftf_ring * ftf_ring_create(uint32_t distance, size_t frame_size, const char * directory);
+static void    ftf_ring_free(boxing_ftf_ring * ring);
+static char *  ftf_ring_run(const boxing_ftf_ring * ring, uint32_t slot_offset, uint32_t run);
+static ftf_transpose_kernel ftf_select_transpose_kernel(void);
+static void    ftf_transpose_runs(const boxing_ftf_ring * ring, uint32_t slot_step, char * frame, DBOOL to_frame);
 static void    ftf_interleave(boxing_codec_ftf_interleaving * codec, gvector * data);
-static void    ftf_deinterleave(boxing_codec_ftf_interleaving * codec, gvector * data);
+static void    ftf_deinterleave(boxing_ftf_ring * ring, gvector * data, DBOOL preload);
+static void    ftf_ensure_ring(boxing_codec_ftf_interleaving * codec, boxing_ftf_ring ** ring, size_t frame_size);
 static DBOOL   ftf_encode(void * codec, gvector * data);
 static DBOOL   ftf_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data);
 static DBOOL   ftf_set_property(void * codec, const char * name, const g_variant * value);
@@ -51,11 +84,13 @@ static DBOOL   init_capacity(struct boxing_codec_s *codec, int size);
  *  \struct     boxing_codec_ftf_interleaving_s  ftfinterleaving.h
  *  \brief      Codec ftf interleaving data storage structure.
  *  
- *  \param base            Base boxing_codec structure instance.
- *  \param distance        Distance.
- *  \param preload_frames  Preload frames.
- *  \param encode_buffer   Encode buffer (GList).
- *  \param decode_buffer   Decode buffer (GList).
+ *  \param base             Base boxing_codec structure instance.
+ *  \param distance         Distance.
+ *  \param preload_frames   Preload frames.
+ *  \param buffer_directory Directory of the files backing the buffers, NULL to keep the buffers in memory.
+ *  \param encode_buffer    Encode buffer.
+ *  \param decode_buffer    Decode buffer.
+ *  \param erasures_buffer  Decode buffer for the erasures, allocated when erasures are first decoded.
  *
  *  Codec ftf interleaving data storage structure description.
  */
@@ -91,8 +126,11 @@ boxing_codec * boxing_ftf_interleaving_create(GHashTable * properties, const box
     codec->base.init_capacity = init_capacity;
     codec->base.reset = ftf_reset;
     codec->base.reentrant = 0;
+    codec->base.supports_erasures = DTRUE;
+    codec->buffer_directory = NULL;
     codec->encode_buffer = NULL;
     codec->decode_buffer = NULL;
+    codec->erasures_buffer = NULL;
 
     // interleaving distance
     g_variant * distance = g_hash_table_lookup(properties, PARAM_NAME_CODEC_MULTI_FRAME_STRIPE_SIZE);
@@ -103,6 +141,14 @@ boxing_codec * boxing_ftf_interleaving_create(GHashTable * properties, const box
         return NULL;
     }
     CODEC_MEMBER(distance) = g_variant_to_uint(distance);
+    CODEC_MEMBER(preload_frames) = CODEC_MEMBER(distance) - 1;
+
+    // The interleaving window may be hundreds of megabytes, it can be kept in a file instead of memory
+    g_variant * buffer_directory = g_hash_table_lookup(properties, PARAM_NAME_BUFFER_DIRECTORY);
+    if (buffer_directory)
+    {
+        codec->base.set_property(codec, PARAM_NAME_BUFFER_DIRECTORY, buffer_directory);
+    }
 
     g_variant * message_size = g_hash_table_lookup(properties, PARAM_NAME_MESSAGE_SIZE);
     if (message_size)
@@ -127,8 +173,10 @@ void boxing_ftf_interleaving_free(boxing_codec * codec)
 {
     boxing_codec_ftf_interleaving * ftf_codec = (boxing_codec_ftf_interleaving *)codec;
     boxing_codec_release_base(codec);
-    free_ftf_buffer(ftf_codec->encode_buffer);
-    free_ftf_buffer(ftf_codec->decode_buffer);
+    ftf_ring_free(ftf_codec->encode_buffer);
+    ftf_ring_free(ftf_codec->decode_buffer);
+    ftf_ring_free(ftf_codec->erasures_buffer);
+    boxing_memory_free(ftf_codec->buffer_directory);
     boxing_memory_free(codec);
 }
 
@@ -149,48 +197,59 @@ static void ftf_reset(void * codec)
 }
 
 
-static void ftf_deinterleave(boxing_codec_ftf_interleaving * codec, gvector * data)
+static void ftf_deinterleave(boxing_ftf_ring * ring, gvector * data, DBOOL preload)
 {
-    GList *element;
-
-    char *ptr;
-    size_t size = data->item_size*data->size;
-    size_t n;
-
     // advance to the next start position
-    codec->decode_buffer = codec->decode_buffer->prev;
+    ring->head = (ring->head + ring->distance - 1) % ring->distance;
 
-    // swap buffers
-    gvector_swap((gvector *)codec->decode_buffer->data, data);
+    ftf_transpose_runs(ring, 0, (char *)data->buffer, DFALSE);
 
-    if (codec->preload_frames)
+    if (preload)
     {
-        codec->preload_frames--;
         gvector_resize(data, 0);
         return;
     }
 
-    // interleave data
-    element = codec->decode_buffer;
-    ptr = (char *)data->buffer;
-    for (n = 0; n < size; n++, ptr++, element = element->next)
-    {
-        *ptr = GVECTORN8((gvector *)element->data, n);
-    }
-
+    // interleave data, run r is taken from the frame r positions away
+    ftf_transpose_runs(ring, 1, (char *)data->buffer, DTRUE);
 }
 
 static DBOOL ftf_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
-    BOXING_UNUSED_PARAMETER(erasures);
     BOXING_UNUSED_PARAMETER(user_data);
 
     boxing_codec_ftf_interleaving *ftf_codec = (boxing_codec_ftf_interleaving *)codec;
+    size_t size = data->size * data->item_size;
+    DBOOL has_erasures = erasures && erasures->size == size;
 
-    if (!ftf_codec->decode_buffer)
-        ftf_codec->decode_buffer = malloc_ftf_buffer(ftf_codec->distance, data->size * data->item_size);
+    ftf_ensure_ring(ftf_codec, &ftf_codec->decode_buffer, size);
 
-    ftf_deinterleave(ftf_codec, data);
+    // Once erasures are seen they are interleaved along with every following frame,
+    // frames without erasures are treated as reliable
+    if (has_erasures || ftf_codec->erasures_buffer)
+        ftf_ensure_ring(ftf_codec, &ftf_codec->erasures_buffer, size);
+
+    DBOOL preload = ftf_codec->preload_frames != 0;
+    if (preload)
+    {
+        ftf_codec->preload_frames--;
+    }
+
+    ftf_deinterleave(ftf_codec->decode_buffer, data, preload);
+
+    if (ftf_codec->erasures_buffer)
+    {
+        if (has_erasures)
+        {
+            ftf_deinterleave(ftf_codec->erasures_buffer, erasures, preload);
+        }
+        else
+        {
+            gvector * reliable = gvector_create_char(size, 0);
+            ftf_deinterleave(ftf_codec->erasures_buffer, reliable, preload);
+            gvector_free(reliable);
+        }
+    }
 
     stats->fec_accumulated_amount = 0;
     stats->fec_accumulated_weight = 0;
@@ -201,71 +260,236 @@ static DBOOL ftf_decode(void * codec, gvector * data, gvector * erasures, boxing
 
 static void ftf_interleave(boxing_codec_ftf_interleaving * codec, gvector * data)
 {
-    GList *element;
+    boxing_ftf_ring * ring = codec->encode_buffer;
+
+    // interleave data, run r is added to the frame r positions away
+    ftf_transpose_runs(ring, 1, (char *)data->buffer, DFALSE);
 
-    char *ptr;
-    size_t size = data->item_size * data->size;
-    size_t n;
+    // advance to the next start position, the frame there is complete
+    ring->head = (ring->head + ring->distance - 1) % ring->distance;
 
-    // interleave data
-    element = codec->encode_buffer;
-    ptr = (char *)data->buffer;
-    for (n = 0; n < size; n++, ptr++, element = element->next)
+    ftf_transpose_runs(ring, 0, (char *)data->buffer, DTRUE);
+}
+
+static void ftf_ensure_ring(boxing_codec_ftf_interleaving * codec, boxing_ftf_ring ** ring, size_t frame_size)
+{
+    if (*ring && (*ring)->frame_size == frame_size)
     {
-        GVECTORN8((gvector *)element->data, n) = *ptr;
+        return;
     }
 
-    // advance to the next start position
-    codec->encode_buffer = codec->encode_buffer->prev;
+    // The window only holds frames of one size
+    if (*ring)
+    {
+        DLOG_WARNING2("Frame size changed from %u to %u, restarting the interleaving window", (unsigned int)(*ring)->frame_size, (unsigned int)frame_size);
+        ftf_ring_free(*ring);
+    }
+    *ring = ftf_ring_create(codec->distance, frame_size, codec->buffer_directory);
+}
 
-    // swap buffers
-    gvector_swap((gvector *)codec->encode_buffer->data, data);
+static boxing_ftf_ring * ftf_ring_create(uint32_t distance, size_t frame_size, const char * directory)
+{
+    boxing_ftf_ring * ring = BOXING_MEMORY_ALLOCATE_TYPE(boxing_ftf_ring);
+    ring->distance = distance ? distance : 1;
+    ring->head = 0;
+    ring->frame_size = frame_size;
+    ring->run_size = (frame_size + ring->distance - 1) / ring->distance;
+    ring->slot_size = ring->run_size * ring->distance;
+    ring->buffer_size = ring->slot_size * ring->distance;
+    ring->file_backed = DFALSE;
+    ring->buffer = NULL;
+    ring->transpose = ftf_select_transpose_kernel();
+
+    if (directory)
+    {
+        ring->buffer = (char *)boxing_memory_map_temporary_file(directory, ring->buffer_size);
+        ring->file_backed = ring->buffer != NULL;
+        if (!ring->file_backed)
+        {
+            DLOG_WARNING1("Failed to create the interleaving buffer file in '%s', using memory", directory);
+        }
+    }
+    if (!ring->buffer)
+    {
+        ring->buffer = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(char, ring->buffer_size);
+    }
 
+    return ring;
+}
 
+static void ftf_ring_free(boxing_ftf_ring * ring)
+{
+    if (!ring)
+        return;
+
+    if (ring->file_backed)
+    {
+        boxing_memory_unmap_temporary_file(ring->buffer, ring->buffer_size);
+    }
+    else
+    {
+        boxing_memory_free(ring->buffer);
+    }
+    boxing_memory_free(ring);
 }
 
-static GList * malloc_ftf_buffer(int blocks, size_t block_size)
+static char * ftf_ring_run(const boxing_ftf_ring * ring, uint32_t slot_offset, uint32_t run)
 {
-    int n;
-    GList *list = NULL;
+    uint32_t slot = (ring->head + slot_offset) % ring->distance;
+    return ring->buffer + slot * ring->slot_size + run * ring->run_size;
+}
 
-    for (n = 0; n < blocks; n++)
+static void ftf_transpose_tile(const char * const * source, char * const * destination)
+{
+    for (int row = 0; row < FTF_TILE_SIZE; row++)
     {
-        gvector * data = gvector_create_char(block_size, 0);
-        list = g_list_prepend(list, (gpointer *)data);
+        for (int column = 0; column < FTF_TILE_SIZE; column++)
+        {
+            destination[column][row] = source[row][column];
+        }
     }
+}
+
+// The SIMD kernels transpose a 16x16 tile by interleaving row k with row k + 8
+// four times, after the fourth round row k holds column k of the tile.
 
-    // close the buffer loop
-    GList * last = g_list_last(list);
-    list->prev = last;
-    last->next = list;
+#if defined (BOXING_CPU_X86)
 
-    return list;
+BOXING_CPU_TARGET("sse2")
+static void ftf_transpose_tile_sse2(const char * const * source, char * const * destination)
+{
+    __m128i rows[16];
+    __m128i interleaved[16];
+    for (int k = 0; k < 16; k++)
+    {
+        rows[k] = _mm_loadu_si128((const __m128i *)source[k]);
+    }
+    for (int round = 0; round < 4; round++)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            interleaved[2 * k] = _mm_unpacklo_epi8(rows[k], rows[k + 8]);
+            interleaved[2 * k + 1] = _mm_unpackhi_epi8(rows[k], rows[k + 8]);
+        }
+        for (int k = 0; k < 16; k++)
+        {
+            rows[k] = interleaved[k];
+        }
+    }
+    for (int k = 0; k < 16; k++)
+    {
+        _mm_storeu_si128((__m128i *)destination[k], rows[k]);
+    }
 }
 
-static void ftf_buffer_destroy_notify(gpointer data)
+#elif defined (BOXING_CPU_ARM)
+
+static void ftf_transpose_tile_neon(const char * const * source, char * const * destination)
 {
-    gvector_free((gvector*)data);
+    uint8x16_t rows[16];
+    uint8x16_t interleaved[16];
+    for (int k = 0; k < 16; k++)
+    {
+        rows[k] = vld1q_u8((const uint8_t *)source[k]);
+    }
+    for (int round = 0; round < 4; round++)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            interleaved[2 * k] = vzip1q_u8(rows[k], rows[k + 8]);
+            interleaved[2 * k + 1] = vzip2q_u8(rows[k], rows[k + 8]);
+        }
+        for (int k = 0; k < 16; k++)
+        {
+            rows[k] = interleaved[k];
+        }
+    }
+    for (int k = 0; k < 16; k++)
+    {
+        vst1q_u8((uint8_t *)destination[k], rows[k]);
+    }
 }
 
-static void free_ftf_buffer(GList *buf)
+#endif
+
+static ftf_transpose_kernel ftf_select_transpose_kernel(void)
 {
-    if (!buf)
-        return;
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        return ftf_transpose_tile_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        return ftf_transpose_tile_neon;
+    }
+#endif
+    return ftf_transpose_tile;
+}
 
-    // break buffer loop
-    buf->prev->next = NULL;
-    buf->prev = NULL;
+// Moves the bytes between a frame and its runs, run r is stored in the slot r * slot_step positions
+// from the head. The frame is processed in square tiles, so both the frame and the runs are
+// accessed a cache line at a time. Tiles with all rows inside the frame are transposed by the kernel.
+static void ftf_transpose_runs(const boxing_ftf_ring * ring, uint32_t slot_step, char * frame, DBOOL to_frame)
+{
+    size_t distance = ring->distance;
+    size_t full_rows = ring->frame_size / distance;
+    const char * frame_rows[FTF_TILE_SIZE];
+    char * runs[FTF_TILE_SIZE];
 
-    g_list_free_full(buf, ftf_buffer_destroy_notify);
+    for (size_t row = 0; row < ring->run_size; row += FTF_TILE_SIZE)
+    {
+        for (uint32_t run = 0; run < distance; run += FTF_TILE_SIZE)
+        {
+            if (row + FTF_TILE_SIZE <= full_rows && run + FTF_TILE_SIZE <= distance)
+            {
+                for (int k = 0; k < FTF_TILE_SIZE; k++)
+                {
+                    frame_rows[k] = frame + (row + k) * distance + run;
+                    runs[k] = ftf_ring_run(ring, (run + k) * slot_step, run + k) + row;
+                }
+                if (to_frame)
+                {
+                    ring->transpose((const char * const *)runs, (char * const *)frame_rows);
+                }
+                else
+                {
+                    ring->transpose(frame_rows, runs);
+                }
+                continue;
+            }
+
+            uint32_t run_end = (run + FTF_TILE_SIZE < distance) ? run + FTF_TILE_SIZE : (uint32_t)distance;
+            for (uint32_t r = run; r < run_end; r++)
+            {
+                char * run_data = ftf_ring_run(ring, r * slot_step, r);
+                size_t row_end = (r < ring->frame_size) ? (ring->frame_size - r + distance - 1) / distance : 0;
+                if (row_end > row + FTF_TILE_SIZE)
+                {
+                    row_end = row + FTF_TILE_SIZE;
+                }
+                for (size_t i = row; i < row_end; i++)
+                {
+                    if (to_frame)
+                    {
+                        frame[i * distance + r] = run_data[i];
+                    }
+                    else
+                    {
+                        run_data[i] = frame[i * distance + r];
+                    }
+                }
+            }
+        }
+    }
 }
 
 static DBOOL ftf_encode(void * codec, gvector * data)
 {
     boxing_codec_ftf_interleaving *ftf_codec = (boxing_codec_ftf_interleaving *)codec;
 
-    if (!ftf_codec->encode_buffer)
-        ftf_codec->encode_buffer = malloc_ftf_buffer(ftf_codec->distance, data->size * data->item_size);
+    ftf_ensure_ring(ftf_codec, &ftf_codec->encode_buffer, data->size * data->item_size);
 
     ftf_interleave(ftf_codec, data);
     return DTRUE;
@@ -273,9 +497,12 @@ static DBOOL ftf_encode(void * codec, gvector * data)
 
 static DBOOL ftf_set_property(void * codec, const char * name, const g_variant * value)
 {
-    BOXING_UNUSED_PARAMETER(codec);
-    BOXING_UNUSED_PARAMETER(name);
-    BOXING_UNUSED_PARAMETER(value);
+    if (boxing_string_equal(name, PARAM_NAME_BUFFER_DIRECTORY))
+    {
+        // Only buffers created after this call are affected
+        boxing_memory_free(CODEC_MEMBER(buffer_directory));
+        CODEC_MEMBER(buffer_directory) = g_variant_to_string(value);
+    }
 
     return DTRUE;
 }
@@ -95,6 +95,7 @@ boxing_codec * boxing_interleaving_create(GHashTable * properties, const boxing_
     codec->base.name = codec_name;
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
+    codec->base.supports_erasures = DTRUE;
 
     // interleaving distance
     g_variant * distance = g_hash_table_lookup(properties, PARAM_NAME_DISTANCE);
@@ -160,46 +161,61 @@ void boxing_interleaving_free(boxing_codec * codec)
 // PRIVATE INTERLEAVING FUNCTIONS
 //
 
-static void decode_byte_interleaving(boxing_codec_interleaving * codec, gvector * data, void * user_data)
+static void deinterleave(uint32_t distance, gvector * data)
+{
+    gvector * data_interleaved = gvector_create_char_no_init(data->size);
+
+    uint32_t data_size = (uint32_t)data->size;
+    char * data_pointer = (char *)data->buffer;
+    char * data_interleaved_pointer_end = (char *)data_interleaved->buffer + data_size;
+    for (uint32_t i = 0; i < distance; i++)
+    {
+        char * data_interleaved_pointer = (char *)data_interleaved->buffer + i;
+        while (data_interleaved_pointer < data_interleaved_pointer_end)
+        {
+            *data_interleaved_pointer = *data_pointer;
+            data_pointer++;
+            data_interleaved_pointer += distance;
+        }
+    }
+    gvector_swap(data, data_interleaved);
+    gvector_free(data_interleaved);
+}
+
+static void decode_byte_interleaving(boxing_codec_interleaving * codec, gvector * data, gvector * erasures, void * user_data)
 {
     uint32_t distance = CODEC_MEMBER(distance);
+    DBOOL has_erasures = erasures && erasures->size == data->size;
 
     if (CODEC_BASE_MEMBER(decode_cb))
     {
         CODEC_BASE_MEMBER(decode_cb)(user_data, data, NULL, distance, NULL, NULL, NULL, NULL, NULL, NULL);
+
+        // The callback does not report how the data was moved
+        if (has_erasures)
+        {
+            memset(erasures->buffer, 0, erasures->size);
+        }
     }
     else
     {
-        gvector * data_interleaved = gvector_create_char_no_init(data->size);
-
-        uint32_t data_size = (uint32_t)data->size;
-        char * data_pointer = (char *)data->buffer;
-        char * data_interleaved_pointer_end = (char *)data_interleaved->buffer + data_size;
-        for (uint32_t i = 0; i < distance; i++)
+        deinterleave(distance, data);
+        if (has_erasures)
         {
-            char * data_interleaved_pointer = (char *)data_interleaved->buffer + i;
-            while (data_interleaved_pointer < data_interleaved_pointer_end)
-            {
-                *data_interleaved_pointer = *data_pointer;
-                data_pointer++;
-                data_interleaved_pointer += distance;
-            }
+            deinterleave(distance, erasures);
         }
-        gvector_swap(data, data_interleaved);
-        gvector_free(data_interleaved);
     }
 }
 
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
-    BOXING_UNUSED_PARAMETER( erasures ); 
     switch (CODEC_MEMBER(interleaving_symbol))
     {
     case BOXING_INTERLEAVING_SYMBOL_BIT:
-        decode_byte_interleaving(codec, data, user_data);
+        decode_byte_interleaving(codec, data, erasures, user_data);
         break;
     case BOXING_INTERLEAVING_SYMBOL_BYTE:
-        decode_byte_interleaving(codec, data, user_data);
+        decode_byte_interleaving(codec, data, erasures, user_data);
         break;
     default:
         return DFALSE;
@@ -21,9 +21,24 @@
 #include "mod2dense.h"
 #include "rcode.h"
 #include "boxing/codecs/ldpccodec.h"
+#include "boxing/codecs/ldpcmatrix.h"
 #include "enc.h"
 #include "dec.h"
 #include "boxing/utils.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/platform/thread.h"
+#include "boxing/math/math.h"
+
+//  SYSTEM INCLUDES
+//
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
 
 //  DEFINES
 //
@@ -32,6 +47,73 @@
 #define CODEC_MEMBER(name) (((boxing_codec_ldpc *)codec)->name)
 #define CODEC_BASE_MEMBER(name) (((boxing_codec_ldpc *)codec)->base.name)
 
+// Normalization of the min-sum check messages, compensates for min-sum
+// overestimating the reliability compared to probability propagation
+#define MINSUM_SCALE 0.75f
+#define SIGN_BIT     0x80000000u
+
+// Minimum, second minimum and sign parity of the magnitudes of the variable
+// to check messages of one check node
+typedef struct minsum_check_s
+{
+    float    min1;
+    float    min2;
+    uint32_t sign;
+} minsum_check;
+
+// Message buffers of the min-sum decoder. The log likelihood ratios are
+// positive for bit value zero.
+typedef struct minsum_buffers_s
+{
+    float * llr;
+    float * posterior;
+    float * checks;
+    float * row;
+} minsum_buffers;
+
+// Folds the leading messages of a check node into check with SIMD, returns the
+// number of messages folded. The remaining messages are folded by the portable code.
+typedef int (*minsum_reduce_kernel)(const float * messages, int count, minsum_check * check);
+// Computes the leading check to variable messages of a check node with SIMD,
+// returns the number of messages computed. The portable code does the rest.
+typedef int (*minsum_update_kernel)(const float * messages, int count, const minsum_check * check, float * updates);
+
+typedef struct minsum_kernels_s
+{
+    minsum_reduce_kernel reduce;
+    minsum_update_kernel update;
+} minsum_kernels;
+
+typedef struct ldpc_workspace_s
+{
+    mod2sparse *   H;
+    double *       lratio;
+    double *       bitpr;
+    char *         pchk;
+    char *         recoverd_block_sd;
+    char *         recoverd_block_hd;
+    char *         data_block;
+    minsum_buffers minsum;
+} ldpc_workspace;
+
+typedef struct ldpc_codeword_result_s
+{
+    unsigned int iterations;
+    int          bit_alterations;
+    DBOOL        parity_failed;
+} ldpc_codeword_result;
+
+typedef struct ldpc_decode_job_s
+{
+    const boxing_codec_ldpc * codec;
+    minsum_kernels            kernels;
+    const char *              src;
+    char *                    dst;
+    int                       blocks;
+    int                       range_count;
+    ldpc_codeword_result *    results;
+} ldpc_decode_job;
+
 
 //  CONSTANTS
 //
@@ -42,6 +124,12 @@
 
 static DBOOL codec_encode(void * codec, gvector * data);
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data);
+static DBOOL codec_set_property(void * codec, const char * name, const g_variant * value);
+static void  build_graph(boxing_ldpc_graph * graph, mod2sparse * H);
+static void  free_graph(boxing_ldpc_graph * graph);
+static unsigned int decode_min_sum(const boxing_ldpc_graph * graph, const minsum_kernels * kernels, minsum_buffers * buffers,
+                         char * dblk, char * pchk, int max_iter, DBOOL layered);
+static minsum_kernels select_minsum_kernels(void);
 
 
 /*! 
@@ -66,12 +154,47 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
  *
  *  \param base        Base boxing_codec instance.
  *  \param iterations  Iteration.
- *  \param gen_matrix  Generator matrix.
+ *  \param gen_matrix  Generator matrix, shared with other codecs through the matrix cache.
+ *  \param decoder       Decoding algorithm.
+ *  \param thread_count  Number of threads decoding codewords, less than 1 uses all cores.
+ *  \param graph         Parity check matrix in flat row and column order.
  *
  *  Structure for storing ldpc codec data.
  */
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \enum       boxing_ldpc_decoder  ldpccodec.h
+ *  \brief      Ldpc decoding algorithm.
+ *
+ *  \param BOXING_LDPC_DECODER_PROBABILITY_PROPAGATION  (0) Probability propagation in double precision.
+ *  \param BOXING_LDPC_DECODER_MIN_SUM                  (1) Normalized min-sum in the log likelihood domain.
+ *  \param BOXING_LDPC_DECODER_LAYERED_MIN_SUM          (2) Min-sum updating the posteriors after every check node,
+ *                                                       converges in about half the iterations.
+ *
+ *  Selected by the codec property 'decoder', probability propagation is the default.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \struct     boxing_ldpc_graph_s  ldpccodec.h
+ *  \brief      Parity check matrix in compressed row (CSR) and column (CSC) order.
+ *
+ *  \param rows            Number of check nodes.
+ *  \param cols            Number of variable nodes.
+ *  \param max_row_degree  Largest number of edges of a check node.
+ *  \param row_start       Offset of the first edge of each row, rows + 1 entries.
+ *  \param row_cols        Column of each edge in row order.
+ *  \param col_start       Offset into col_edges of each column, cols + 1 entries.
+ *  \param col_edges       Row order index of each edge in column order.
+ *
+ *  Messages are stored in row order, so check node updates read and write
+ *  contiguous memory.
+ */
+
+
 // PUBLIC LDPC FUNCTIONS
 //
 
@@ -107,6 +230,27 @@ boxing_codec * boxing_codec_ldpc_create(GHashTable * properties, const boxing_co
         return NULL;
     }
 
+    codec->decoder = BOXING_LDPC_DECODER_PROBABILITY_PROPAGATION;
+    g_variant * var_decoder = g_hash_table_lookup(properties, PARAM_NAME_DECODER);
+    if (var_decoder != NULL)
+    {
+        const char * decoder_str = g_variant_if_string(var_decoder);
+        if (boxing_string_equal(decoder_str, PARAM_NAME_DECODER_MIN_SUM))
+        {
+            codec->decoder = BOXING_LDPC_DECODER_MIN_SUM;
+        }
+        else if (boxing_string_equal(decoder_str, PARAM_NAME_DECODER_LAYERED_MIN_SUM))
+        {
+            codec->decoder = BOXING_LDPC_DECODER_LAYERED_MIN_SUM;
+        }
+        else if (!boxing_string_equal(decoder_str, PARAM_NAME_DECODER_PROBABILITY_PROPAGATION))
+        {
+            DLOG_ERROR2("Unsupported '%s' : %s", PARAM_NAME_DECODER, decoder_str);
+            boxing_memory_free(codec);
+            return NULL;
+        }
+    }
+
     boxing_codec_init_base((boxing_codec *)codec);
     codec->base.free = boxing_codec_ldpc_free;
     codec->base.is_error_correcting = DTRUE;
@@ -120,12 +264,17 @@ boxing_codec * boxing_codec_ldpc_create(GHashTable * properties, const boxing_co
     // configure ldpc
     // ex-ldpc36-1000a.pchk 1600 16000 1 evenboth 3 no4cycle
     codec->iterations = 25;
-    int seed = 1;
-    int no4cycle = 1;
-    distrib *d = distrib_create("3");
-    mod2sparse * H = ldcp_pchk_make(seed, pchk_evenboth, d, no4cycle, parity_size, parity_size + message_size);
-    codec->gen_matrix = ldpc_generator_make_dense_mixed(H, gen_dense);
-    mod2sparse_free(H);
+    boxing_ldpc_matrix_key matrix_key = { (uint32_t)message_size, (uint32_t)parity_size, 1, BOXING_LDPC_MATRIX_EVENBOTH_3_NO4CYCLE_DENSE };
+    g_variant * var_matrix_cache = g_hash_table_lookup(properties, PARAM_NAME_MATRIX_CACHE);
+    codec->gen_matrix = boxing_ldpc_matrix_acquire(&matrix_key, var_matrix_cache != NULL ? g_variant_if_string(var_matrix_cache) : NULL);
+    if (codec->gen_matrix == NULL)
+    {
+        DLOG_ERROR2("Failed to create the LDPC matrices of %d message bits and %d parity bits", message_size, parity_size);
+        boxing_codec_release_base((boxing_codec *)codec);
+        boxing_memory_free(codec);
+        return NULL;
+    }
+    build_graph(&codec->graph, codec->gen_matrix->H);
 
     codec->base.decoded_symbol_size = 8;
     codec->base.decoded_block_size = message_size / 8;
@@ -135,6 +284,14 @@ boxing_codec * boxing_codec_ldpc_create(GHashTable * properties, const boxing_co
 
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
+    codec->base.set_property = codec_set_property;
+
+    codec->thread_count = 1;
+    g_variant * var_thread_count = g_hash_table_lookup(properties, PARAM_NAME_THREAD_COUNT);
+    if (var_thread_count != NULL)
+    {
+        codec_set_property(codec, PARAM_NAME_THREAD_COUNT, var_thread_count);
+    }
 
     return (boxing_codec *)codec;
 }
@@ -151,7 +308,8 @@ boxing_codec * boxing_codec_ldpc_create(GHashTable * properties, const boxing_co
 
 void boxing_codec_ldpc_free(boxing_codec * codec)
 {
-    ldpc_generator_free(CODEC_MEMBER(gen_matrix));
+    boxing_ldpc_matrix_release(CODEC_MEMBER(gen_matrix));
+    free_graph(&CODEC_MEMBER(graph));
     boxing_codec_release_base(codec);
     boxing_memory_free(codec);
 }
@@ -238,84 +396,572 @@ static DBOOL codec_encode(void * codec, gvector * data)
     return DTRUE;
 }
 
+// Private buffers of one decoding thread, probability propagation keeps its
+// messages in the parity check matrix so every thread has its own copy
+static ldpc_workspace * workspace_create(const boxing_codec_ldpc * codec)
+{
+    const generator_matrix * gen_matrix = codec->gen_matrix;
+    const boxing_ldpc_graph * graph = &codec->graph;
+    ldpc_workspace * workspace = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(ldpc_workspace, 1);
+
+    workspace->pchk = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->M);
+    workspace->recoverd_block_sd = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->N);
+    workspace->recoverd_block_hd = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->N);
+    workspace->data_block = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->N - gen_matrix->M);
+    if (codec->decoder == BOXING_LDPC_DECODER_PROBABILITY_PROPAGATION)
+    {
+        workspace->H = mod2sparse_clone(gen_matrix->H);
+        workspace->lratio = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(double, gen_matrix->N);
+        workspace->bitpr = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(double, gen_matrix->N);
+    }
+    else
+    {
+        workspace->minsum.llr = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(float, graph->cols);
+        workspace->minsum.posterior = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(float, graph->cols);
+        workspace->minsum.checks = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(float, graph->row_start[graph->rows]);
+        workspace->minsum.row = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(float, graph->max_row_degree);
+    }
+    return workspace;
+}
+
+static void workspace_free(ldpc_workspace * workspace)
+{
+    if (workspace->H)
+    {
+        mod2sparse_free(workspace->H);
+    }
+    boxing_memory_free(workspace->lratio);
+    boxing_memory_free(workspace->bitpr);
+    boxing_memory_free(workspace->pchk);
+    boxing_memory_free(workspace->recoverd_block_sd);
+    boxing_memory_free(workspace->recoverd_block_hd);
+    boxing_memory_free(workspace->data_block);
+    boxing_memory_free(workspace->minsum.llr);
+    boxing_memory_free(workspace->minsum.posterior);
+    boxing_memory_free(workspace->minsum.checks);
+    boxing_memory_free(workspace->minsum.row);
+    boxing_memory_free(workspace);
+}
+
+static void decode_codeword(const boxing_codec_ldpc * ldpc_codec, ldpc_workspace * workspace, const minsum_kernels * kernels,
+    const char * src, char * dst, ldpc_codeword_result * result)
+{
+    const generator_matrix * gen_matrix = ldpc_codec->gen_matrix;
+    char * recoverd_block_sd = workspace->recoverd_block_sd;
+    char * recoverd_block_hd = workspace->recoverd_block_hd;
+
+    if (ldpc_codec->decoder == BOXING_LDPC_DECODER_PROBABILITY_PROPAGATION)
+    {
+        /* convert from packed log likelyhood ratio (char)
+         * to likelyhood ratio (double)
+         */
+        for (int bit = 0; bit < gen_matrix->N; bit++)
+        {
+            workspace->lratio[bit] = exp(src[bit]/10.0f);
+            recoverd_block_hd[bit] = (workspace->lratio[bit] > 1.0f) ? 1 : 0;
+        }
+        result->iterations = ldpc_decode_prprp(workspace->H, workspace->lratio, recoverd_block_sd, workspace->pchk, workspace->bitpr, ldpc_codec->iterations);
+    }
+    else
+    {
+        /* the packed log likelyhood ratio (char) is used as is, min-sum
+         * does not depend on its scale
+         */
+        for (int bit = 0; bit < gen_matrix->N; bit++)
+        {
+            workspace->minsum.llr[bit] = (float)(-src[bit]);
+            recoverd_block_hd[bit] = (src[bit] > 0) ? 1 : 0;
+        }
+        result->iterations = decode_min_sum(&ldpc_codec->graph, kernels, &workspace->minsum, recoverd_block_sd, workspace->pchk,
+            ldpc_codec->iterations, ldpc_codec->decoder == BOXING_LDPC_DECODER_LAYERED_MIN_SUM);
+    }
+
+    int bit_alterations = 0;
+    for (int bit = 0; bit < gen_matrix->N; bit++)
+    {
+        bit_alterations += (recoverd_block_hd[bit] != recoverd_block_sd[bit]) ? 1 : 0;
+    }
+    result->bit_alterations = bit_alterations;
+
+    //extract data
+    char * data_block_ptr = workspace->data_block;
+    for (int i = gen_matrix->M; i < gen_matrix->N; i++)
+    {
+        *data_block_ptr++ = recoverd_block_sd[(int)gen_matrix->cols[i]];
+    }
+
+    int c = 0;
+    for (int i = 0; i < gen_matrix->M; i++)
+    {
+        c += workspace->pchk[i];
+    }
+    result->parity_failed = c ? DTRUE : DFALSE;
+
+    // convert data from bit to byte stream
+    pack_data(workspace->data_block, dst, gen_matrix->N - gen_matrix->M);
+}
+
+// Decodes one contiguous range of codewords with private buffers
+static void decode_codewords(void * user, int index)
+{
+    ldpc_decode_job * job = (ldpc_decode_job *)user;
+    const boxing_codec_ldpc * ldpc_codec = job->codec;
+    const int first = (int)((long long)job->blocks * index / job->range_count);
+    const int last = (int)((long long)job->blocks * (index + 1) / job->range_count);
+
+    ldpc_workspace * workspace = workspace_create(ldpc_codec);
+    for (int i = first; i < last; i++)
+    {
+        decode_codeword(ldpc_codec, workspace, &job->kernels,
+            job->src + (size_t)i * ldpc_codec->base.encoded_block_size,
+            job->dst + (size_t)i * ldpc_codec->base.decoded_block_size,
+            job->results + i);
+    }
+    workspace_free(workspace);
+}
+
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
     BOXING_UNUSED_PARAMETER(erasures);
     BOXING_UNUSED_PARAMETER(user_data);
 
+    boxing_codec_ldpc * ldpc_codec = (boxing_codec_ldpc*)codec;
+    gvector * decoded_data = gvector_create(data->item_size, ldpc_codec->base.decoded_data_size);
 
-    BOXING_UNUSED_PARAMETER(stats); // not shure how to do this
+    // Codewords are independent, each thread decodes its own range of them
+    ldpc_decode_job job;
+    job.codec = ldpc_codec;
+    job.kernels = select_minsum_kernels();
+    job.src = data->buffer;
+    job.dst = decoded_data->buffer;
+    job.blocks = (int)decoded_data->size / ldpc_codec->base.decoded_block_size;
+    job.range_count = boxing_thread_resolve_count(ldpc_codec->thread_count, job.blocks);
+    job.results = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(ldpc_codeword_result, BOXING_MATH_MAX(job.blocks, 1));
+    boxing_thread_parallel_for(job.range_count, job.range_count, decode_codewords, &job);
+
+    for (int i = 0; i < job.blocks; i++)
+    {
+        const ldpc_codeword_result * result = job.results + i;
+        if (result->parity_failed)
+        {
+            stats->unresolved_errors += result->bit_alterations;
+        }
+        else
+        {
+            stats->resolved_errors += result->bit_alterations;
+        }
+        stats->decoded_codewords++;
+        stats->decode_iterations += result->iterations;
+        stats->max_decode_iterations = BOXING_MATH_MAX(stats->max_decode_iterations, result->iterations);
+    }
+    boxing_memory_free(job.results);
 
-    boxing_codec_ldpc * ldpc_codec = (boxing_codec_ldpc*)codec;
+    gvector_swap(data, decoded_data);
+    gvector_free(decoded_data);
+    return DTRUE;
+}
 
-    generator_matrix *gen_matrix = ldpc_codec->gen_matrix;
-    gvector * decoded_data = gvector_create(data->item_size, ldpc_codec->base.decoded_data_size);
+static void build_graph(boxing_ldpc_graph * graph, mod2sparse * H)
+{
+    graph->rows = mod2sparse_rows(H);
+    graph->cols = mod2sparse_cols(H);
+    graph->row_start = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(int, graph->rows + 1);
+    graph->col_start = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int, graph->cols + 1);
+
+    int edges = 0;
+    graph->max_row_degree = 0;
+    for (int i = 0; i < graph->rows; i++)
+    {
+        int degree = 0;
+        for (mod2entry * e = mod2sparse_first_in_row(H, i); !mod2sparse_at_end(e); e = mod2sparse_next_in_row(e))
+        {
+            degree++;
+        }
+        graph->row_start[i] = edges;
+        graph->max_row_degree = BOXING_MATH_MAX(graph->max_row_degree, degree);
+        edges += degree;
+    }
+    graph->row_start[graph->rows] = edges;
 
-    char *src = data->buffer;
-    char *dst = decoded_data->buffer;
-    int blocks = (int)decoded_data->size / ldpc_codec->base.decoded_block_size;
-    double *lratio = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(double, gen_matrix->N);
-    char   *pchk   = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char,   gen_matrix->M);
-    double *bitpr  = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(double, gen_matrix->N);
-    char *recoverd_block_sd = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->N);
-    char *recoverd_block_hd = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->N);
-    char *data_block = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, gen_matrix->N - gen_matrix->M);
-    char *data_block_ptr;
+    // Walking the columns in order fills every row in column order
+    graph->row_cols = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int, edges);
+    graph->col_edges = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int, edges);
+    int * row_fill = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int, graph->rows);
+    for (int i = 0; i < graph->rows; i++)
+    {
+        row_fill[i] = graph->row_start[i];
+    }
 
-    for (int i = 0; i < blocks; i++)
+    int col_edge = 0;
+    for (int j = 0; j < graph->cols; j++)
     {
-        /* convert from packed log likelyhood ratio (char)
-         * to likelyhood ratio (double)
-         */
-        for (int bit = 0; bit < gen_matrix->N; bit++)
+        graph->col_start[j] = col_edge;
+        for (mod2entry * e = mod2sparse_first_in_col(H, j); !mod2sparse_at_end(e); e = mod2sparse_next_in_col(e))
         {
-            lratio[bit] = exp(src[bit]/10.0f);
-            recoverd_block_hd[bit] = (lratio[bit] > 1.0f) ? 1 : 0;
+            const int edge = row_fill[mod2sparse_row(e)]++;
+            graph->row_cols[edge] = j;
+            graph->col_edges[col_edge++] = edge;
         }
-        (void)ldpc_decode_prprp(gen_matrix->H, lratio, recoverd_block_sd, pchk, bitpr, ldpc_codec->iterations);
+    }
+    graph->col_start[graph->cols] = col_edge;
+    boxing_memory_free(row_fill);
+}
 
-        int bit_alterations = 0;
-        for (int bit = 0; bit < gen_matrix->N; bit++)
+static DBOOL codec_set_property(void * codec, const char * name, const g_variant * value)
+{
+    if (boxing_string_equal(name, PARAM_NAME_THREAD_COUNT))
+    {
+        CODEC_MEMBER(thread_count) = (int)g_variant_to_int(value);
+    }
+
+    return DTRUE;
+}
+
+static void free_graph(boxing_ldpc_graph * graph)
+{
+    boxing_memory_free(graph->row_start);
+    boxing_memory_free(graph->row_cols);
+    boxing_memory_free(graph->col_start);
+    boxing_memory_free(graph->col_edges);
+}
+
+static uint32_t float_sign(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits & SIGN_BIT;
+}
+
+static float float_xor_sign(float value, uint32_t sign)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits ^= sign;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Min and max are exact, so folding the messages in any order or in SIMD
+// lanes that are merged later gives identical results
+static void minsum_fold(minsum_check * check, float min1, float min2, uint32_t sign)
+{
+    check->min2 = BOXING_MATH_MIN(check->min2, BOXING_MATH_MIN(BOXING_MATH_MAX(check->min1, min1), min2));
+    check->min1 = BOXING_MATH_MIN(check->min1, min1);
+    check->sign ^= sign;
+}
+
+static float minsum_message(const minsum_check * check, float message)
+{
+    const float magnitude = (fabsf(message) == check->min1) ? check->min2 : check->min1;
+    return float_xor_sign(magnitude * MINSUM_SCALE, check->sign ^ float_sign(message));
+}
+
+// Parity of every check node for the hard decisions in dblk, returns the number of failing checks
+static int syndrome(const boxing_ldpc_graph * graph, const char * dblk, char * pchk)
+{
+    int failed = 0;
+    for (int i = 0; i < graph->rows; i++)
+    {
+        char parity = 0;
+        for (int e = graph->row_start[i]; e < graph->row_start[i + 1]; e++)
         {
-            bit_alterations += (recoverd_block_hd[bit] != recoverd_block_sd[bit]) ? 1 : 0;
+            parity ^= dblk[graph->row_cols[e]];
         }
-        //extract data
-        data_block_ptr = data_block;
-        for (int i = gen_matrix->M; i < gen_matrix->N; i++)
+        pchk[i] = parity;
+        failed += parity;
+    }
+    return failed;
+}
+
+// Updates the check to variable messages of check node i from the posteriors,
+// the variable to check messages are left in buffers->row
+static void minsum_update_check(const boxing_ldpc_graph * graph, const minsum_kernels * kernels, minsum_buffers * buffers, int i)
+{
+    const int start = graph->row_start[i];
+    const int degree = graph->row_start[i + 1] - start;
+    const int * cols = graph->row_cols + start;
+    float * checks = buffers->checks + start;
+    float * row = buffers->row;
+
+    // Variable to check messages, the posterior without this check's own contribution
+    for (int k = 0; k < degree; k++)
+    {
+        row[k] = buffers->posterior[cols[k]] - checks[k];
+    }
+
+    minsum_check check = { FLT_MAX, FLT_MAX, 0 };
+    int k = kernels->reduce ? kernels->reduce(row, degree, &check) : 0;
+    for (; k < degree; k++)
+    {
+        minsum_fold(&check, fabsf(row[k]), FLT_MAX, float_sign(row[k]));
+    }
+
+    k = kernels->update ? kernels->update(row, degree, &check, checks) : 0;
+    for (; k < degree; k++)
+    {
+        checks[k] = minsum_message(&check, row[k]);
+    }
+}
+
+// Flooding schedule, every check node is updated from the posteriors of the
+// previous iteration before the posteriors are updated
+static void minsum_update_checks(const boxing_ldpc_graph * graph, const minsum_kernels * kernels, minsum_buffers * buffers)
+{
+    for (int i = 0; i < graph->rows; i++)
+    {
+        minsum_update_check(graph, kernels, buffers, i);
+    }
+}
+
+static void minsum_update_posteriors(const boxing_ldpc_graph * graph, minsum_buffers * buffers, char * dblk)
+{
+    for (int j = 0; j < graph->cols; j++)
+    {
+        float posterior = buffers->llr[j];
+        for (int k = graph->col_start[j]; k < graph->col_start[j + 1]; k++)
         {
-            *data_block_ptr++ = recoverd_block_sd[(int)gen_matrix->cols[i]];
+            posterior += buffers->checks[graph->col_edges[k]];
         }
+        buffers->posterior[j] = posterior;
+        dblk[j] = posterior <= 0.0f;
+    }
+}
 
-        int c = 0;
-        for (int i = 0; i < gen_matrix->M; i++)
+// Layered schedule, the posteriors are updated after every check node so later
+// check nodes of the same iteration already see the new messages
+static void minsum_update_layers(const boxing_ldpc_graph * graph, const minsum_kernels * kernels, minsum_buffers * buffers, char * dblk)
+{
+    for (int i = 0; i < graph->rows; i++)
+    {
+        minsum_update_check(graph, kernels, buffers, i);
+
+        const int start = graph->row_start[i];
+        const int degree = graph->row_start[i + 1] - start;
+        const int * cols = graph->row_cols + start;
+        const float * checks = buffers->checks + start;
+        for (int k = 0; k < degree; k++)
         {
-            c += pchk[i];
+            buffers->posterior[cols[k]] = buffers->row[k] + checks[k];
         }
+    }
+
+    for (int j = 0; j < graph->cols; j++)
+    {
+        dblk[j] = buffers->posterior[j] <= 0.0f;
+    }
+}
+
+/* Decodes with normalized min-sum in the log likelihood domain. Stops as soon
+   as the hard decisions are a valid codeword, like ldpc_decode_prprp with a
+   positive max_iter. The hard decisions are stored in dblk and the parity
+   checks in pchk. Returns the number of iterations done. */
+static unsigned int decode_min_sum(const boxing_ldpc_graph * graph, const minsum_kernels * kernels, minsum_buffers * buffers,
+    char * dblk, char * pchk, int max_iter, DBOOL layered)
+{
+    for (int j = 0; j < graph->cols; j++)
+    {
+        buffers->posterior[j] = buffers->llr[j];
+        dblk[j] = buffers->llr[j] <= 0.0f;
+    }
+    for (int e = 0; e < graph->row_start[graph->rows]; e++)
+    {
+        buffers->checks[e] = 0.0f;
+    }
 
-        if (c)
+    int n;
+    for (n = 0;; n++)
+    {
+        if (syndrome(graph, dblk, pchk) == 0 || n == max_iter)
         {
-            stats->unresolved_errors += bit_alterations;
+            break;
+        }
+        if (layered)
+        {
+            minsum_update_layers(graph, kernels, buffers, dblk);
         }
         else
         {
-            stats->resolved_errors += bit_alterations;
+            minsum_update_checks(graph, kernels, buffers);
+            minsum_update_posteriors(graph, buffers, dblk);
         }
-        // convert data from bit to byte stream 
-        pack_data(data_block, dst, gen_matrix->N - gen_matrix->M);
+    }
+    return (unsigned int)n;
+}
 
-        dst += ldpc_codec->base.decoded_block_size;
-        src += ldpc_codec->base.encoded_block_size;
-        //dst += ldpc_codec->base.decoded_block_size; 
+#if defined (BOXING_CPU_X86) || defined (BOXING_CPU_ARM)
+
+static void minsum_merge_lanes(minsum_check * check, const float * min1, const float * min2, const uint32_t * sign, int lanes)
+{
+    for (int lane = 0; lane < lanes; lane++)
+    {
+        minsum_fold(check, min1[lane], min2[lane], sign[lane]);
     }
+}
 
-    boxing_memory_free(lratio);
-    boxing_memory_free(pchk);
-    boxing_memory_free(bitpr);
-    boxing_memory_free(recoverd_block_sd);
-    boxing_memory_free(recoverd_block_hd);
-    boxing_memory_free(data_block);
+#endif
 
-    gvector_swap(data, decoded_data);
-    gvector_free(decoded_data);
-    return DTRUE;
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("sse2")
+static int minsum_reduce_sse2(const float * messages, int count, minsum_check * check)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    __m128 min1 = _mm_set1_ps(FLT_MAX);
+    __m128 min2 = _mm_set1_ps(FLT_MAX);
+    __m128 sign = _mm_setzero_ps();
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const __m128 value = _mm_loadu_ps(messages + n);
+        const __m128 magnitude = _mm_andnot_ps(sign_mask, value);
+        sign = _mm_xor_ps(sign, _mm_and_ps(sign_mask, value));
+        min2 = _mm_min_ps(min2, _mm_max_ps(min1, magnitude));
+        min1 = _mm_min_ps(min1, magnitude);
+    }
+
+    float lane_min1[4], lane_min2[4];
+    uint32_t lane_sign[4];
+    _mm_storeu_ps(lane_min1, min1);
+    _mm_storeu_ps(lane_min2, min2);
+    _mm_storeu_si128((__m128i *)lane_sign, _mm_castps_si128(sign));
+    minsum_merge_lanes(check, lane_min1, lane_min2, lane_sign, 4);
+    return n;
+}
+
+BOXING_CPU_TARGET("sse2")
+static int minsum_update_sse2(const float * messages, int count, const minsum_check * check, float * updates)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 min1 = _mm_set1_ps(check->min1);
+    const __m128 scaled1 = _mm_set1_ps(check->min1 * MINSUM_SCALE);
+    const __m128 scaled2 = _mm_set1_ps(check->min2 * MINSUM_SCALE);
+    const __m128 sign = _mm_castsi128_ps(_mm_set1_epi32((int)check->sign));
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const __m128 value = _mm_loadu_ps(messages + n);
+        const __m128 is_min = _mm_cmpeq_ps(_mm_andnot_ps(sign_mask, value), min1);
+        const __m128 magnitude = _mm_or_ps(_mm_and_ps(is_min, scaled2), _mm_andnot_ps(is_min, scaled1));
+        _mm_storeu_ps(updates + n, _mm_xor_ps(magnitude, _mm_xor_ps(sign, _mm_and_ps(sign_mask, value))));
+    }
+    return n;
+}
+
+// The AVX2 kernels leave the short tail of a row to the portable code, mixing
+// in the SSE2 kernels costs more than it saves
+
+BOXING_CPU_TARGET("avx2")
+static int minsum_reduce_avx2(const float * messages, int count, minsum_check * check)
+{
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    __m256 min1 = _mm256_set1_ps(FLT_MAX);
+    __m256 min2 = _mm256_set1_ps(FLT_MAX);
+    __m256 sign = _mm256_setzero_ps();
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        const __m256 value = _mm256_loadu_ps(messages + n);
+        const __m256 magnitude = _mm256_andnot_ps(sign_mask, value);
+        sign = _mm256_xor_ps(sign, _mm256_and_ps(sign_mask, value));
+        min2 = _mm256_min_ps(min2, _mm256_max_ps(min1, magnitude));
+        min1 = _mm256_min_ps(min1, magnitude);
+    }
+
+    float lane_min1[8], lane_min2[8];
+    uint32_t lane_sign[8];
+    _mm256_storeu_ps(lane_min1, min1);
+    _mm256_storeu_ps(lane_min2, min2);
+    _mm256_storeu_si256((__m256i *)lane_sign, _mm256_castps_si256(sign));
+    minsum_merge_lanes(check, lane_min1, lane_min2, lane_sign, 8);
+    return n;
+}
+
+BOXING_CPU_TARGET("avx2")
+static int minsum_update_avx2(const float * messages, int count, const minsum_check * check, float * updates)
+{
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 min1 = _mm256_set1_ps(check->min1);
+    const __m256 scaled1 = _mm256_set1_ps(check->min1 * MINSUM_SCALE);
+    const __m256 scaled2 = _mm256_set1_ps(check->min2 * MINSUM_SCALE);
+    const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32((int)check->sign));
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        const __m256 value = _mm256_loadu_ps(messages + n);
+        const __m256 is_min = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, value), min1, _CMP_EQ_OQ);
+        const __m256 magnitude = _mm256_blendv_ps(scaled1, scaled2, is_min);
+        _mm256_storeu_ps(updates + n, _mm256_xor_ps(magnitude, _mm256_xor_ps(sign, _mm256_and_ps(sign_mask, value))));
+    }
+    return n;
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static int minsum_reduce_neon(const float * messages, int count, minsum_check * check)
+{
+    const uint32x4_t sign_mask = vdupq_n_u32(SIGN_BIT);
+    float32x4_t min1 = vdupq_n_f32(FLT_MAX);
+    float32x4_t min2 = vdupq_n_f32(FLT_MAX);
+    uint32x4_t sign = vdupq_n_u32(0);
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const float32x4_t value = vld1q_f32(messages + n);
+        const float32x4_t magnitude = vabsq_f32(value);
+        sign = veorq_u32(sign, vandq_u32(sign_mask, vreinterpretq_u32_f32(value)));
+        min2 = vminq_f32(min2, vmaxq_f32(min1, magnitude));
+        min1 = vminq_f32(min1, magnitude);
+    }
+
+    float lane_min1[4], lane_min2[4];
+    uint32_t lane_sign[4];
+    vst1q_f32(lane_min1, min1);
+    vst1q_f32(lane_min2, min2);
+    vst1q_u32(lane_sign, sign);
+    minsum_merge_lanes(check, lane_min1, lane_min2, lane_sign, 4);
+    return n;
+}
+
+static int minsum_update_neon(const float * messages, int count, const minsum_check * check, float * updates)
+{
+    const uint32x4_t sign_mask = vdupq_n_u32(SIGN_BIT);
+    const float32x4_t min1 = vdupq_n_f32(check->min1);
+    const float32x4_t scaled1 = vdupq_n_f32(check->min1 * MINSUM_SCALE);
+    const float32x4_t scaled2 = vdupq_n_f32(check->min2 * MINSUM_SCALE);
+    const uint32x4_t sign = vdupq_n_u32(check->sign);
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const float32x4_t value = vld1q_f32(messages + n);
+        const float32x4_t magnitude = vbslq_f32(vceqq_f32(vabsq_f32(value), min1), scaled2, scaled1);
+        const uint32x4_t value_sign = veorq_u32(sign, vandq_u32(sign_mask, vreinterpretq_u32_f32(value)));
+        vst1q_f32(updates + n, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(magnitude), value_sign)));
+    }
+    return n;
+}
+
+#endif
+
+static minsum_kernels select_minsum_kernels(void)
+{
+    minsum_kernels kernels = { NULL, NULL };
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_AVX2))
+    {
+        kernels.reduce = minsum_reduce_avx2;
+        kernels.update = minsum_update_avx2;
+    }
+    else if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        kernels.reduce = minsum_reduce_sse2;
+        kernels.update = minsum_update_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        kernels.reduce = minsum_reduce_neon;
+        kernels.update = minsum_update_neon;
+    }
+#endif
+    return kernels;
 }
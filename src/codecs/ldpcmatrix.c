@@ -0,0 +1,734 @@
+/*****************************************************************************
+**
+**  Implementation of the LDPC matrix cache interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "boxing/codecs/ldpcmatrix.h"
+#include "boxing/log.h"
+#include "boxing/platform/memory.h"
+#include "boxing/platform/thread.h"
+#include "boxing/math/crc32.h"
+#include "boxing/utils.h"
+#include "mod2sparse.h"
+#include "mod2dense.h"
+#include "rcode.h"
+#include "rand.h"
+
+//  SYSTEM INCLUDES
+//
+#include <stdio.h>
+#include <string.h>
+
+//  DEFINES
+//
+
+#define MATRIX_MAGIC       "BXLDPCMX"
+#define MATRIX_MAGIC_SIZE  8
+// Magic, version, random source, key and the sizes M, N, edges and words per column
+#define MATRIX_HEADER_SIZE (MATRIX_MAGIC_SIZE + 4 + 4 + 4 * 4 + 4 * 4)
+#define MATRIX_CRC_SIZE    4
+
+//  PRIVATE INTERFACE
+//
+
+// Generator matrix in the cache, matrices are shared by all codecs with the same key
+// and random source
+typedef struct matrix_entry_s
+{
+    boxing_ldpc_matrix_key  key;
+    uint32_t                random_source;
+    generator_matrix *      matrix;
+    int                     references;
+    struct matrix_entry_s * next;
+} matrix_entry;
+
+typedef struct matrix_reader_s
+{
+    const unsigned char * data;
+    size_t                size;
+    size_t                offset;
+} matrix_reader;
+
+static void               init_cache(void * user);
+static matrix_entry *     find_entry(const boxing_ldpc_matrix_key * key, uint32_t source);
+static matrix_entry *     add_entry(const boxing_ldpc_matrix_key * key, uint32_t source, generator_matrix * matrix);
+static DBOOL              keys_equal(const boxing_ldpc_matrix_key * a, const boxing_ldpc_matrix_key * b);
+static generator_matrix * make_matrix(const boxing_ldpc_matrix_key * key);
+static uint32_t           random_source(void);
+static generator_matrix * deserialize(const unsigned char * data, size_t size, boxing_ldpc_matrix_key * key);
+static char *             cache_file_path(const boxing_ldpc_matrix_key * key, uint32_t source, const char * cache_directory);
+static generator_matrix * read_cache_file(const boxing_ldpc_matrix_key * key, const char * path);
+static void               write_cache_file(const boxing_ldpc_matrix_key * key, const generator_matrix * matrix, const char * path);
+static uint32_t           matrix_crc(const unsigned char * data, size_t size);
+static gvector *          serialize(const boxing_ldpc_matrix_key * key, uint32_t source, const generator_matrix * matrix);
+static unsigned char *    put_u32(unsigned char * data, uint32_t value);
+static uint32_t           get_u32(matrix_reader * reader, DBOOL * ok);
+
+static matrix_entry * cache_entries = NULL;
+static boxing_mutex * cache_mutex = NULL;
+static boxing_once    cache_once = BOXING_THREAD_ONCE_INIT;
+
+// Checksum of the random tables it was computed from
+static const unsigned int * source_tables = NULL;
+static uint32_t             source_checksum = 0;
+
+
+/*!
+  * \addtogroup codecs
+  * \{
+  */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \def BOXING_LDPC_MATRIX_VERSION ldpcmatrix.h
+ *  \brief Version of the serialized matrix format and the matrix construction.
+ *
+ *  Serialized matrices of another version are rejected and rebuilt.
+ *  Version 2 added the random source to the header.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \enum       boxing_ldpc_matrix_method  ldpcmatrix.h
+ *  \brief      Construction method of the parity check and generator matrices.
+ *
+ *  \param BOXING_LDPC_MATRIX_EVENBOTH_3_NO4CYCLE_DENSE  (1) Three checks per bit spread evenly over the rows,
+ *                                                        four cycles removed, dense generator matrix.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \struct     boxing_ldpc_matrix_key_s  ldpcmatrix.h
+ *  \brief      Parameters the matrices are constructed from.
+ *
+ *  \param message_bits  Number of message bits in a codeword.
+ *  \param parity_bits   Number of parity bits in a codeword.
+ *  \param seed          Seed of the pseudo random matrix construction.
+ *  \param method        Construction method, one of boxing_ldpc_matrix_method.
+ */
+
+
+// PUBLIC LDPC MATRIX FUNCTIONS
+//
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Get the generator matrix of the given key.
+ *
+ *  The matrix is looked up in the process wide cache first, then in the
+ *  file cache in cache_directory and is constructed when not found. A
+ *  constructed matrix is written to cache_directory, so the next process
+ *  loads it instead of constructing it again. Only matrices constructed
+ *  from the random numbers of this library, see
+ *  boxing_ldpc_matrix_random_source, are used. The matrix is shared and
+ *  must be returned with boxing_ldpc_matrix_release.
+ *
+ *  \param[in]  key              Matrix parameters.
+ *  \param[in]  cache_directory  Directory of the file cache, NULL to not use files.
+ *  \return the generator matrix or NULL if the key is not valid or the
+ *          library has no random source.
+ */
+
+generator_matrix * boxing_ldpc_matrix_acquire(const boxing_ldpc_matrix_key * key, const char * cache_directory)
+{
+    boxing_thread_once(&cache_once, init_cache, NULL);
+
+    // The construction uses the global state of the random generator, so
+    // matrices are built one at a time
+    boxing_mutex_lock(cache_mutex);
+
+    if (rand_tables() == NULL)
+    {
+        boxing_mutex_unlock(cache_mutex);
+        DLOG_ERROR("No LDPC random source, the library was built without thirdparty/ldpc/randfile");
+        return NULL;
+    }
+
+    const uint32_t source = random_source();
+    matrix_entry * entry = find_entry(key, source);
+    if (entry == NULL)
+    {
+        char * path = cache_directory != NULL ? cache_file_path(key, source, cache_directory) : NULL;
+        generator_matrix * matrix = path != NULL ? read_cache_file(key, path) : NULL;
+        if (matrix == NULL)
+        {
+            matrix = make_matrix(key);
+            if (matrix != NULL && path != NULL)
+            {
+                write_cache_file(key, matrix, path);
+            }
+        }
+        boxing_memory_free(path);
+
+        if (matrix != NULL)
+        {
+            entry = add_entry(key, source, matrix);
+        }
+    }
+
+    if (entry != NULL)
+    {
+        entry->references++;
+    }
+
+    boxing_mutex_unlock(cache_mutex);
+    return entry != NULL ? entry->matrix : NULL;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Return a matrix from boxing_ldpc_matrix_acquire.
+ *
+ *  The matrix stays in the cache until boxing_ldpc_matrix_cache_clear.
+ *
+ *  \param[in]  matrix  Generator matrix.
+ */
+
+void boxing_ldpc_matrix_release(generator_matrix * matrix)
+{
+    if (matrix == NULL)
+    {
+        return;
+    }
+
+    boxing_thread_once(&cache_once, init_cache, NULL);
+    boxing_mutex_lock(cache_mutex);
+    for (matrix_entry * entry = cache_entries; entry != NULL; entry = entry->next)
+    {
+        if (entry->matrix == matrix)
+        {
+            entry->references--;
+            break;
+        }
+    }
+    boxing_mutex_unlock(cache_mutex);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Serialize a dense generator matrix.
+ *
+ *  The little endian format holds a magic, the version, the random source,
+ *  the key, the parity check matrix by columns, the column and row
+ *  orderings and the generator matrix words, followed by a crc32 of all the
+ *  preceding bytes. The random source is the one the cached matrix was
+ *  constructed from, or the current one for a matrix not in the cache. The
+ *  result can be stored or embedded and given to boxing_ldpc_matrix_register.
+ *
+ *  \param[in]  key     Matrix parameters.
+ *  \param[in]  matrix  Dense generator matrix.
+ *  \return vector with the serialized matrix or NULL if the matrix is not dense.
+ */
+
+gvector * boxing_ldpc_matrix_serialize(const boxing_ldpc_matrix_key * key, const generator_matrix * matrix)
+{
+    boxing_thread_once(&cache_once, init_cache, NULL);
+    boxing_mutex_lock(cache_mutex);
+    uint32_t source = random_source();
+    for (matrix_entry * entry = cache_entries; entry != NULL; entry = entry->next)
+    {
+        if (entry->matrix == matrix)
+        {
+            source = entry->random_source;
+            break;
+        }
+    }
+    boxing_mutex_unlock(cache_mutex);
+
+    return serialize(key, source, matrix);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Add a serialized matrix to the cache.
+ *
+ *  Makes a matrix from boxing_ldpc_matrix_serialize available to codecs
+ *  without constructing it, for instance a matrix embedded in the
+ *  application. A key already in the cache keeps its matrix. A matrix
+ *  constructed from other random numbers than those of this library is
+ *  rejected, as is every matrix if the library has no random source.
+ *
+ *  \param[in]  data  Serialized matrix.
+ *  \param[in]  size  Size of data in bytes.
+ *  \return DTRUE if the matrix is valid.
+ */
+
+DBOOL boxing_ldpc_matrix_register(const void * data, size_t size)
+{
+    boxing_ldpc_matrix_key key;
+    boxing_thread_once(&cache_once, init_cache, NULL);
+    boxing_mutex_lock(cache_mutex);
+    generator_matrix * matrix = deserialize((const unsigned char *)data, size, &key);
+    const DBOOL valid = matrix != NULL;
+    if (valid && find_entry(&key, random_source()) == NULL)
+    {
+        add_entry(&key, random_source(), matrix);
+        matrix = NULL;
+    }
+    boxing_mutex_unlock(cache_mutex);
+
+    if (matrix != NULL)
+    {
+        ldpc_generator_free(matrix);
+    }
+    return valid;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Identify the random numbers matrices are constructed from.
+ *
+ *  The pseudo random matrix construction mixes in tables of real random
+ *  numbers built into the library or read from a file, see
+ *  thirdparty/ldpc/rand.c. The value is the crc32 of these tables and is
+ *  recorded in serialized matrices and in the names of the cache files.
+ *
+ *  \return the random source, 0 if the library was built without one.
+ */
+
+uint32_t boxing_ldpc_matrix_random_source(void)
+{
+    boxing_thread_once(&cache_once, init_cache, NULL);
+    boxing_mutex_lock(cache_mutex);
+    const uint32_t source = random_source();
+    boxing_mutex_unlock(cache_mutex);
+    return source;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Free the cached matrices no codec uses.
+ */
+
+void boxing_ldpc_matrix_cache_clear(void)
+{
+    boxing_thread_once(&cache_once, init_cache, NULL);
+    boxing_mutex_lock(cache_mutex);
+    matrix_entry ** link = &cache_entries;
+    while (*link != NULL)
+    {
+        matrix_entry * entry = *link;
+        if (entry->references == 0)
+        {
+            *link = entry->next;
+            ldpc_generator_free(entry->matrix);
+            boxing_memory_free(entry);
+        }
+        else
+        {
+            link = &entry->next;
+        }
+    }
+    boxing_mutex_unlock(cache_mutex);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of codecs group
+  */
+
+
+// PRIVATE LDPC MATRIX FUNCTIONS
+//
+
+static void init_cache(void * user)
+{
+    BOXING_UNUSED_PARAMETER(user);
+    cache_mutex = boxing_mutex_create();
+}
+
+
+static DBOOL keys_equal(const boxing_ldpc_matrix_key * a, const boxing_ldpc_matrix_key * b)
+{
+    return a->message_bits == b->message_bits && a->parity_bits == b->parity_bits &&
+        a->seed == b->seed && a->method == b->method;
+}
+
+
+static matrix_entry * find_entry(const boxing_ldpc_matrix_key * key, uint32_t source)
+{
+    for (matrix_entry * entry = cache_entries; entry != NULL; entry = entry->next)
+    {
+        if (keys_equal(&entry->key, key) && entry->random_source == source)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+
+static matrix_entry * add_entry(const boxing_ldpc_matrix_key * key, uint32_t source, generator_matrix * matrix)
+{
+    matrix_entry * entry = BOXING_MEMORY_ALLOCATE_TYPE(matrix_entry);
+    entry->key = *key;
+    entry->random_source = source;
+    entry->matrix = matrix;
+    entry->references = 0;
+    entry->next = cache_entries;
+    cache_entries = entry;
+    return entry;
+}
+
+
+static generator_matrix * make_matrix(const boxing_ldpc_matrix_key * key)
+{
+    if (key->method != BOXING_LDPC_MATRIX_EVENBOTH_3_NO4CYCLE_DENSE || key->parity_bits == 0)
+    {
+        DLOG_ERROR1("Unsupported LDPC matrix construction method %u", key->method);
+        return NULL;
+    }
+
+    // ex-ldpc36-1000a.pchk 1600 16000 1 evenboth 3 no4cycle
+    distrib * d = distrib_create("3");
+    mod2sparse * H = ldcp_pchk_make(key->seed, pchk_evenboth, d, 1, (int)key->parity_bits, (int)(key->parity_bits + key->message_bits));
+    distrib_free(d);
+    if (H == NULL)
+    {
+        return NULL;
+    }
+
+    generator_matrix * matrix = ldpc_generator_make_dense_mixed(H, gen_dense);
+    mod2sparse_free(H);
+    return matrix;
+}
+
+
+// Called with the cache mutex locked, the checksum is computed again only
+// when the tables are replaced
+static uint32_t random_source(void)
+{
+    const unsigned int * tables = rand_tables();
+    if (tables == NULL)
+    {
+        return 0;
+    }
+    if (tables != source_tables)
+    {
+        unsigned char * data = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(unsigned char, 4 * N_tables * Table_size);
+        unsigned char * out = data;
+        for (int i = 0; i < N_tables * Table_size; i++)
+        {
+            out = put_u32(out, tables[i]);
+        }
+        source_checksum = matrix_crc(data, 4 * N_tables * Table_size);
+        source_tables = tables;
+        boxing_memory_free(data);
+    }
+    return source_checksum;
+}
+
+
+static generator_matrix * deserialize(const unsigned char * data, size_t size, boxing_ldpc_matrix_key * key)
+{
+    if (data == NULL || size < MATRIX_HEADER_SIZE + MATRIX_CRC_SIZE || memcmp(data, MATRIX_MAGIC, MATRIX_MAGIC_SIZE) != 0)
+    {
+        return NULL;
+    }
+
+    matrix_reader reader = { data, size - MATRIX_CRC_SIZE, MATRIX_MAGIC_SIZE };
+    DBOOL ok = DTRUE;
+    const uint32_t version = get_u32(&reader, &ok);
+    const uint32_t source = get_u32(&reader, &ok);
+    key->message_bits = get_u32(&reader, &ok);
+    key->parity_bits = get_u32(&reader, &ok);
+    key->seed = (int32_t)get_u32(&reader, &ok);
+    key->method = get_u32(&reader, &ok);
+    const uint32_t M = get_u32(&reader, &ok);
+    const uint32_t N = get_u32(&reader, &ok);
+    const uint32_t edges = get_u32(&reader, &ok);
+    const uint32_t n_words = get_u32(&reader, &ok);
+
+    if (version != BOXING_LDPC_MATRIX_VERSION)
+    {
+        DLOG_INFO1("Ignoring LDPC matrix of version %u", version);
+        return NULL;
+    }
+
+    if (rand_tables() == NULL || source != random_source())
+    {
+        DLOG_INFO1("Ignoring LDPC matrix of random source %08x", source);
+        return NULL;
+    }
+
+    // The sizes must agree with the key and the data before anything is allocated
+    if (M != key->parity_bits || N != key->parity_bits + key->message_bits || M == 0 || M >= N ||
+        n_words != (M + mod2_wordsize - 1) / mod2_wordsize ||
+        size != MATRIX_HEADER_SIZE + 4 * ((uint64_t)N + edges) + 4 * ((uint64_t)N + M) + 4 * (uint64_t)(N - M) * n_words + MATRIX_CRC_SIZE)
+    {
+        DLOG_ERROR("Invalid LDPC matrix size");
+        return NULL;
+    }
+
+    const uint32_t crc = data[size - 4] | (data[size - 3] << 8) | (data[size - 2] << 16) | ((uint32_t)data[size - 1] << 24);
+    if (crc != matrix_crc(data, size - MATRIX_CRC_SIZE))
+    {
+        DLOG_ERROR("Invalid LDPC matrix checksum");
+        return NULL;
+    }
+
+    generator_matrix * matrix = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(generator_matrix, 1);
+    matrix->M = (int)M;
+    matrix->N = (int)N;
+    matrix->type = 'd';
+    matrix->H = mod2sparse_allocate((int)M, (int)N);
+    matrix->cols = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int, N);
+    matrix->rows = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(int, M);
+    matrix->G = mod2dense_allocate((int)M, (int)(N - M));
+
+    uint32_t edges_read = 0;
+    for (uint32_t j = 0; j < N && ok; j++)
+    {
+        const uint32_t degree = get_u32(&reader, &ok);
+        for (uint32_t k = 0; k < degree && ok; k++)
+        {
+            const uint32_t row = get_u32(&reader, &ok);
+            ok = ok && row < M;
+            if (ok)
+            {
+                mod2sparse_insert(matrix->H, (int)row, (int)j);
+            }
+        }
+        edges_read += degree;
+    }
+    ok = ok && edges_read == edges;
+
+    for (uint32_t j = 0; j < N && ok; j++)
+    {
+        const uint32_t col = get_u32(&reader, &ok);
+        ok = ok && col < N;
+        matrix->cols[j] = (int)col;
+    }
+    for (uint32_t i = 0; i < M && ok; i++)
+    {
+        const uint32_t row = get_u32(&reader, &ok);
+        ok = ok && row < M;
+        matrix->rows[i] = (int)row;
+    }
+    for (uint32_t j = 0; j < N - M && ok; j++)
+    {
+        for (uint32_t w = 0; w < n_words; w++)
+        {
+            matrix->G->col[j][w] = get_u32(&reader, &ok);
+        }
+    }
+
+    if (!ok)
+    {
+        DLOG_ERROR("Invalid LDPC matrix data");
+        ldpc_generator_free(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+
+static char * cache_file_path(const boxing_ldpc_matrix_key * key, uint32_t source, const char * cache_directory)
+{
+    const size_t length = strlen(cache_directory) + 80;
+    char * path = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, length);
+    snprintf(path, length, "%s/ldpc_v%d_%08x_%u_%u_%d_%u.bin", cache_directory, BOXING_LDPC_MATRIX_VERSION,
+        source, key->message_bits, key->parity_bits, (int)key->seed, key->method);
+    return path;
+}
+
+
+static generator_matrix * read_cache_file(const boxing_ldpc_matrix_key * key, const char * path)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    generator_matrix * matrix = NULL;
+    boxing_ldpc_matrix_key file_key;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        size = ftell(file);
+        rewind(file);
+    }
+    if (size > 0)
+    {
+        gvector * data = gvector_create_char_no_init((size_t)size);
+        if (fread(data->buffer, 1, (size_t)size, file) == (size_t)size)
+        {
+            matrix = deserialize((const unsigned char *)data->buffer, (size_t)size, &file_key);
+        }
+        gvector_free(data);
+    }
+    fclose(file);
+
+    if (matrix != NULL && !keys_equal(key, &file_key))
+    {
+        DLOG_ERROR1("LDPC matrix file %s does not match its name", path);
+        ldpc_generator_free(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+
+// The matrix is written to a temporary file and renamed, so a process
+// reading the cache never sees a partly written file
+static void write_cache_file(const boxing_ldpc_matrix_key * key, const generator_matrix * matrix, const char * path)
+{
+    // Called with the cache mutex locked, the matrix is not in the cache yet
+    gvector * data = serialize(key, random_source(), matrix);
+    if (data == NULL)
+    {
+        return;
+    }
+
+    const size_t length = strlen(path) + 5;
+    char * temporary_path = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(char, length);
+    snprintf(temporary_path, length, "%s.tmp", path);
+
+    FILE * file = fopen(temporary_path, "wb");
+    if (file != NULL)
+    {
+        const DBOOL written = fwrite(data->buffer, 1, data->size, file) == data->size;
+        if (fclose(file) == 0 && written)
+        {
+            remove(path);
+            if (rename(temporary_path, path) != 0)
+            {
+                remove(temporary_path);
+            }
+        }
+        else
+        {
+            DLOG_WARNING1("Failed to write LDPC matrix file %s", path);
+            remove(temporary_path);
+        }
+    }
+
+    boxing_memory_free(temporary_path);
+    gvector_free(data);
+}
+
+
+static uint32_t matrix_crc(const unsigned char * data, size_t size)
+{
+    dcrc32 * crc = boxing_math_crc32_create_def();
+    const uint32_t value = boxing_math_crc32_calc_crc(crc, (const char *)data, (unsigned int)size);
+    boxing_math_crc32_free(crc);
+    return value;
+}
+
+
+static gvector * serialize(const boxing_ldpc_matrix_key * key, uint32_t source, const generator_matrix * matrix)
+{
+    if (matrix == NULL || matrix->type != 'd')
+    {
+        return NULL;
+    }
+
+    const int M = matrix->M;
+    const int N = matrix->N;
+    const mod2dense * G = matrix->G;
+
+    uint32_t edges = 0;
+    for (int j = 0; j < N; j++)
+    {
+        for (mod2entry * e = mod2sparse_first_in_col(matrix->H, j); !mod2sparse_at_end(e); e = mod2sparse_next_in_col(e))
+        {
+            edges++;
+        }
+    }
+
+    const size_t size = MATRIX_HEADER_SIZE + 4 * ((size_t)N + edges) + 4 * ((size_t)N + M) +
+        4 * (size_t)G->n_cols * G->n_words + MATRIX_CRC_SIZE;
+    gvector * data = gvector_create_char_no_init(size);
+    unsigned char * out = (unsigned char *)data->buffer;
+
+    memcpy(out, MATRIX_MAGIC, MATRIX_MAGIC_SIZE);
+    out += MATRIX_MAGIC_SIZE;
+    out = put_u32(out, BOXING_LDPC_MATRIX_VERSION);
+    out = put_u32(out, source);
+    out = put_u32(out, key->message_bits);
+    out = put_u32(out, key->parity_bits);
+    out = put_u32(out, (uint32_t)key->seed);
+    out = put_u32(out, key->method);
+    out = put_u32(out, (uint32_t)M);
+    out = put_u32(out, (uint32_t)N);
+    out = put_u32(out, edges);
+    out = put_u32(out, (uint32_t)G->n_words);
+
+    for (int j = 0; j < N; j++)
+    {
+        unsigned char * degree = out;
+        uint32_t count = 0;
+        out += 4;
+        for (mod2entry * e = mod2sparse_first_in_col(matrix->H, j); !mod2sparse_at_end(e); e = mod2sparse_next_in_col(e))
+        {
+            out = put_u32(out, (uint32_t)mod2sparse_row(e));
+            count++;
+        }
+        put_u32(degree, count);
+    }
+
+    for (int j = 0; j < N; j++)
+    {
+        out = put_u32(out, (uint32_t)matrix->cols[j]);
+    }
+    for (int i = 0; i < M; i++)
+    {
+        out = put_u32(out, (uint32_t)matrix->rows[i]);
+    }
+    for (int j = 0; j < G->n_cols; j++)
+    {
+        for (int w = 0; w < G->n_words; w++)
+        {
+            out = put_u32(out, G->col[j][w]);
+        }
+    }
+
+    put_u32(out, matrix_crc((const unsigned char *)data->buffer, size - MATRIX_CRC_SIZE));
+    return data;
+}
+
+
+static unsigned char * put_u32(unsigned char * data, uint32_t value)
+{
+    data[0] = (unsigned char)value;
+    data[1] = (unsigned char)(value >> 8);
+    data[2] = (unsigned char)(value >> 16);
+    data[3] = (unsigned char)(value >> 24);
+    return data + 4;
+}
+
+
+static uint32_t get_u32(matrix_reader * reader, DBOOL * ok)
+{
+    if (!*ok || reader->offset + 4 > reader->size)
+    {
+        *ok = DFALSE;
+        return 0;
+    }
+
+    const unsigned char * data = reader->data + reader->offset;
+    reader->offset += 4;
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
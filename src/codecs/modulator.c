@@ -82,6 +82,7 @@ boxing_codec * boxing_codec_modulator_create(GHashTable * properties, const boxi
     codec->base.name = codec_name;
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
+    codec->base.supports_erasures = DTRUE;
 
     g_variant * key = g_hash_table_lookup(properties, property_name_num_bits_per_pixel_s);
     if(key == NULL)
@@ -135,10 +136,14 @@ void boxing_codec_modulator_free(boxing_codec * codec)
 
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
-    BOXING_UNUSED_PARAMETER(erasures);
     BOXING_UNUSED_PARAMETER(stats);
     BOXING_UNUSED_PARAMETER(user_data);
 
+    if (erasures && erasures->size != data->size)
+    {
+        erasures = NULL;
+    }
+
     gvector * demodulated;
     unsigned char *data_source = (unsigned char *)data->buffer;
     if (CODEC_MEMBER(num_bits_per_pixel) == 1) {
@@ -201,6 +206,23 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
         return DFALSE;
     }
 
+    // A byte is as unreliable as the least reliable of its symbols
+    if (erasures)
+    {
+        const unsigned int symbols_per_byte = 8 / CODEC_MEMBER(num_bits_per_pixel);
+        unsigned char * erasures_data = (unsigned char *)erasures->buffer;
+        for (unsigned int i = 0; i < demodulated->size; i++)
+        {
+            unsigned char erasure = 0;
+            for (unsigned int j = i * symbols_per_byte; j < (i + 1) * symbols_per_byte && j < erasures->size; j++)
+            {
+                erasure = BOXING_MATH_MAX(erasure, erasures_data[j]);
+            }
+            erasures_data[i] = erasure;
+        }
+        gvector_resize(erasures, demodulated->size);
+    }
+
     gvector_swap(data, demodulated);
     gvector_free(demodulated);
     return DTRUE;
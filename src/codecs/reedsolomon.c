@@ -36,6 +36,8 @@ static const char codec_name[] = "ReedSolomon";
 
 static DBOOL codec_encode(void * codec, gvector * data);
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data);
+static rs_decode_context * codec_acquire_decode_context(boxing_codec_reedsolomon * codec);
+static void codec_release_decode_context(boxing_codec_reedsolomon * codec, rs_decode_context * context);
 
 
 /*! 
@@ -49,10 +51,12 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
  *  \struct  boxing_codec_reedsolomon_s  reedsolomon.h
  *  \brief   Reedsolomon codec data storage.
  *  
- *  \param base          Base boxing_codec structure instance.
- *  \param rs            Pointer to the rs_codec structure.
- *  \param message_size  Message size.
- *  \param parity_size   Parity size.
+ *  \param base                  Base boxing_codec structure instance.
+ *  \param rs                    Pointer to the rs_codec structure.
+ *  \param decode_context        Decode buffers reused between decode calls.
+ *  \param decode_context_mutex  Protects decode_context.
+ *  \param message_size          Message size.
+ *  \param parity_size           Parity size.
  *
  *  Reedsolomon codec data storage structure description.
  */
@@ -79,6 +83,8 @@ boxing_codec * boxing_codec_reedsolomon_create(GHashTable * properties, const bo
     BOXING_UNUSED_PARAMETER( config );
     boxing_codec_reedsolomon * codec = BOXING_MEMORY_ALLOCATE_TYPE(boxing_codec_reedsolomon);
     codec->rs = NULL;
+    codec->decode_context = NULL;
+    codec->decode_context_mutex = NULL;
     g_variant * message_size = g_hash_table_lookup(properties, PARAM_NAME_MESSAGE_SIZE);
     if (message_size == NULL)
     {
@@ -103,6 +109,7 @@ boxing_codec * boxing_codec_reedsolomon_create(GHashTable * properties, const bo
     codec->base.encoded_block_size = codec->message_size + codec->parity_size;
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
+    codec->base.supports_erasures = DTRUE;
     codec->rs = rs_create(codec->message_size, codec->parity_size, RS_PRIM_POLY_285);
     if (!codec->rs)
     {
@@ -110,6 +117,8 @@ boxing_codec * boxing_codec_reedsolomon_create(GHashTable * properties, const bo
         boxing_codec_reedsolomon_free((boxing_codec *)codec);
         return NULL;
     }
+    codec->decode_context = rs_decode_context_create(codec->rs);
+    codec->decode_context_mutex = boxing_mutex_create();
 
     return (boxing_codec *)codec;
 }
@@ -127,6 +136,11 @@ boxing_codec * boxing_codec_reedsolomon_create(GHashTable * properties, const bo
 void boxing_codec_reedsolomon_free(boxing_codec * codec)
 {
     boxing_codec_release_base(codec);
+    rs_decode_context_free(((boxing_codec_reedsolomon *)codec)->decode_context);
+    if (((boxing_codec_reedsolomon *)codec)->decode_context_mutex)
+    {
+        boxing_mutex_free(((boxing_codec_reedsolomon *)codec)->decode_context_mutex);
+    }
     rs_free(((boxing_codec_reedsolomon *)codec)->rs);
     boxing_memory_free(codec);
 }
@@ -162,7 +176,6 @@ static DBOOL codec_encode(void * codec, gvector * data)
 
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
-    BOXING_UNUSED_PARAMETER(erasures);
     BOXING_UNUSED_PARAMETER(user_data);
 
     uint32_t message_size = CODEC_MEMBER(message_size);
@@ -173,6 +186,7 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
     // let's trunckate the input data to N * block_size where N is type int
     uint32_t block_count = (uint32_t)data->size / block_size;
     gvector_resize(data, block_count * block_size);
+    DBOOL has_erasures = erasures && erasures->size >= data->size;
 
     gvector * data_decode = gvector_create_char((uint32_t)block_count * message_size, 0x00);
 
@@ -204,10 +218,31 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
             stats->fec_accumulated_amount = fec_amount * fec_weight;
             stats->fec_accumulated_weight = fec_weight;
         }
+
+        // The callback does not use or report erasures
+        if (has_erasures)
+        {
+            gvector_resize(erasures, data_decode->size);
+            memset(erasures->buffer, 0, erasures->size);
+        }
     }
     else
     {
-        rs_decode(((boxing_codec_reedsolomon *)codec)->rs, data, data_decode, &errors_recovered, &errors_fatal, &max_errors_per_block);
+        rs_decode_context * context = codec_acquire_decode_context((boxing_codec_reedsolomon *)codec);
+        if (has_erasures)
+        {
+            // Blocks not correctable from errors alone are retried with the least reliable symbols as erasures,
+            // symbols of blocks that still fail are marked as erased for the next decoder
+            gvector * erasures_decode = gvector_create_char(data_decode->size, 0x00);
+            rs_decode_erasures(((boxing_codec_reedsolomon *)codec)->rs, context, data, data_decode, erasures, erasures_decode, &errors_recovered, &errors_fatal, &max_errors_per_block);
+            gvector_swap(erasures, erasures_decode);
+            gvector_free(erasures_decode);
+        }
+        else
+        {
+            rs_decode(((boxing_codec_reedsolomon *)codec)->rs, context, data, data_decode, &errors_recovered, &errors_fatal, &max_errors_per_block);
+        }
+        codec_release_decode_context((boxing_codec_reedsolomon *)codec, context);
 
         stats->resolved_errors = errors_recovered;
         stats->unresolved_errors = errors_fatal;
@@ -223,3 +258,28 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
 
     return errors_fatal == 0;
 }
+
+// The codec is reentrant, a thread decoding while the decode context of the codec
+// is in use by another thread gets its own context.
+static rs_decode_context * codec_acquire_decode_context(boxing_codec_reedsolomon * codec)
+{
+    boxing_mutex_lock(codec->decode_context_mutex);
+    rs_decode_context * context = codec->decode_context;
+    codec->decode_context = NULL;
+    boxing_mutex_unlock(codec->decode_context_mutex);
+
+    return context ? context : rs_decode_context_create(codec->rs);
+}
+
+static void codec_release_decode_context(boxing_codec_reedsolomon * codec, rs_decode_context * context)
+{
+    boxing_mutex_lock(codec->decode_context_mutex);
+    if (codec->decode_context == NULL)
+    {
+        codec->decode_context = context;
+        context = NULL;
+    }
+    boxing_mutex_unlock(codec->decode_context_mutex);
+
+    rs_decode_context_free(context);
+}
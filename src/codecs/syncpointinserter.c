@@ -115,6 +115,7 @@ boxing_codec * boxing_codec_syncpointinserter_create(GHashTable * properties, co
     codec->base.decode = codec_decode;
     codec->base.encode = codec_encode;
     codec->base.init_capacity = init_capacity;
+    codec->base.supports_erasures = DTRUE;
 
     codec->property_sync_point_centers_m.buffer = NULL;
     codec->property_sync_point_areas_m.buffer = NULL;
@@ -281,7 +282,6 @@ void boxing_codec_syncpointinserter_free(boxing_codec * codec)
 
 static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxing_stats_decode * stats, void* user_data)
 {
-    BOXING_UNUSED_PARAMETER(erasures);
     BOXING_UNUSED_PARAMETER(stats);
     BOXING_UNUSED_PARAMETER(user_data);
 
@@ -302,6 +302,10 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
 
     gvector * result = gvector_create(1, image_height * image_width);
 
+    // The erasures follow the data symbols they belong to
+    char * erasures_source = (erasures && erasures->size == data->size) ? (char *)erasures->buffer : NULL;
+    char * erasures_result = erasures_source;
+
     unsigned int counter = 0;
 
     if (CODEC_MEMBER(property_data_orientation_m) == Horizontal) {
@@ -316,6 +320,10 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
                 if ((*sync_pointer_background == 0) &&
                     (*sync_pointer_foreground == 0))
                 {
+                    if (erasures_source)
+                    {
+                        erasures_result[counter] = erasures_source[ix + iy * image_width];
+                    }
                     GVECTORN(result, char, counter++) = *data_source;
                 }
                 data_source++;
@@ -337,6 +345,10 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
                 if ((sync_pointer_background[ix + iy * image_width] == 0) &&
                     (sync_pointer_foreground[ix + iy * image_width] == 0))
                 {
+                    if (erasures_source)
+                    {
+                        erasures_result[counter] = erasures_source[ix * image_height + iy];
+                    }
                     GVECTORN(result, char, counter++) = *data_source;
                 }
                 data_source++;
@@ -353,6 +365,10 @@ static DBOOL codec_decode(void * codec, gvector * data, gvector * erasures, boxi
     gvector_resize(result, counter);
     gvector_swap(data, result);
     gvector_free(result);
+    if (erasures_source)
+    {
+        gvector_resize(erasures, counter);
+    }
     return DTRUE;
 }
 
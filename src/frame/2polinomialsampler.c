@@ -14,13 +14,41 @@
 
 //  PROJECT INCLUDES
 //
-#include "2polinomialsampler.h"
+#include "boxing/frame/2polinomialsampler.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/thread.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/math/math.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
+
+// Samples the leading locations of a line with SIMD, returns the number of
+// locations sampled. The remaining locations are sampled by the portable code.
+typedef int (*sample_line_kernel)(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels);
+
+typedef struct sample_job_s
+{
+    const boxing_image8 *  image;
+    const boxing_matrixf * location_matrix;
+    boxing_image8 *        out_image;
+    sample_line_kernel     kernel;
+    int                    band_height;
+} sample_job;
 
 //  PRIVATE INTERFACE
 //
 
-static boxing_image8 * sample(boxing_sampler * sampler, const boxing_image8 * image);
+static boxing_image8 *    sample(boxing_sampler * sampler, const boxing_image8 * image);
+static void               sample_band(void * user, int band);
+static void               sample_line(sample_line_kernel kernel, const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels);
+static void               sample_line_portable(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels);
+static sample_line_kernel select_sample_line_kernel(void);
 
 
 /*! 
@@ -55,6 +83,28 @@ boxing_sampler * boxing_2polinomialsampler_create(int width, int height)
 }
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Sample a line of locations.
+ *
+ *  Samples count locations, starting at locations and advancing step locations at a time,
+ *  with the same 2 polinomial interpolation as the sampler created by boxing_2polinomialsampler_create.
+ *  Lets callers sample sparsely or one line at a time without creating an output image.
+ *  The widest SIMD kernel supported by the CPU is used, the result is identical to the portable code.
+ *
+ *  \param[in]  image      Image to be sampled.
+ *  \param[in]  locations  First location to sample.
+ *  \param[in]  count      Number of locations to sample.
+ *  \param[in]  step       Distance between sampled locations.
+ *  \param[out] pixels     Sampled pixels, count values.
+ */
+
+void boxing_2polinomialsampler_sample_line(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels)
+{
+    sample_line(select_sample_line_kernel(), image, locations, count, step, pixels);
+}
+
+
 //----------------------------------------------------------------------------
 /*!
   * \} end of frame group
@@ -64,215 +114,522 @@ boxing_sampler * boxing_2polinomialsampler_create(int width, int height)
 // PRIVATE 2 POLINOMIAL SAMPLER FUNCTIONS
 //
 
-static boxing_image8 * sample(boxing_sampler * sampler, const boxing_image8 * image)
+static void sample_line(sample_line_kernel kernel, const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels)
 {
+    int done = kernel ? kernel(image, locations, count, step, pixels) : 0;
+    sample_line_portable(image, locations + done * step, count - done, step, pixels + done);
+}
 
-    if ( boxing_image8_is_null(image) )
-    {
-        return NULL;
-    }
-
-    boxing_image8 * out_image = boxing_image8_create(sampler->location_matrix.width, sampler->location_matrix.height);
-    boxing_image8_pixel * pixel = out_image->data;
-    for(unsigned int i = 0; i < sampler->location_matrix.height; i++)
+static void sample_line_portable(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels)
+{
+    boxing_image8_pixel * pixel = pixels;
+    const boxing_pointf * scan_line = locations;
+    for (int n = 0; n < count; n++, scan_line += step)
     {
-        boxing_pointf *scan_line = MATRIX_ROW(&sampler->location_matrix, i);
-        const boxing_pointf *scan_line_end = scan_line + sampler->location_matrix.width;
-        for (; scan_line != scan_line_end; scan_line++)
-        {
-            boxing_float x = scan_line->x;
-            boxing_float y = scan_line->y;
+        boxing_float x = scan_line->x;
+        boxing_float y = scan_line->y;
 
-            // See the original code below, this is heavily refactored due to being in performance critical place.
-            typedef boxing_float sampler_float;
-            int xi = (int)x;
-            int yi = (int)y;
-            sampler_float m0, m1, m2, m3, m4, m5, m6, m7, m8;
-            const boxing_image8_pixel * current_pixel = image->data + image->width * (yi - 1) + xi - 1;
-            m0 = *(current_pixel++);
-            m1 = *(current_pixel++);
-            m2 = *current_pixel;
+        // See the original code below, this is heavily refactored due to being in performance critical place.
+        typedef boxing_float sampler_float;
+        int xi = (int)x;
+        int yi = (int)y;
+        sampler_float m0, m1, m2, m3, m4, m5, m6, m7, m8;
+        const boxing_image8_pixel * current_pixel = image->data + image->width * (yi - 1) + xi - 1;
+        m0 = *(current_pixel++);
+        m1 = *(current_pixel++);
+        m2 = *current_pixel;
 
-            current_pixel += image->width - 2;
+        current_pixel += image->width - 2;
 
-            m3 = *(current_pixel++);
-            m4 = *(current_pixel++);
-            m5 = *current_pixel;
+        m3 = *(current_pixel++);
+        m4 = *(current_pixel++);
+        m5 = *current_pixel;
 
-            current_pixel += image->width - 2;
+        current_pixel += image->width - 2;
 
-            m6 = *(current_pixel++);
-            m7 = *(current_pixel++);
-            m8 = *current_pixel;
+        m6 = *(current_pixel++);
+        m7 = *(current_pixel++);
+        m8 = *current_pixel;
 
-            sampler_float x_ = x - (int)x + 1;
-            sampler_float y_ = y - (int)y + 1;
-            sampler_float Z0, Z1, Z2;
-            sampler_float B0, B1;
-            sampler_float Y0 = y_*y_;
-            sampler_float X0 = x_*x_;
+        sampler_float x_ = x - (int)x + 1;
+        sampler_float y_ = y - (int)y + 1;
+        sampler_float Z0, Z1, Z2;
+        sampler_float B0, B1;
+        sampler_float Y0 = y_*y_;
+        sampler_float X0 = x_*x_;
 
-            B0 = m0 * (sampler_float)0.5 - m3 + m6 * (sampler_float)0.5;
-            B1 = m0 * (sampler_float)-1.5 + m3 * 2 + m6 * (sampler_float)-0.5;
+        B0 = m0 * (sampler_float)0.5 - m3 + m6 * (sampler_float)0.5;
+        B1 = m0 * (sampler_float)-1.5 + m3 * 2 + m6 * (sampler_float)-0.5;
 
-            Z0 = Y0*B0 + y_*B1 + m0;
+        Z0 = Y0*B0 + y_*B1 + m0;
 
-            B0 = m1 * (sampler_float)0.5 - m4 + m7 * (sampler_float)0.5;
-            B1 = m1 * (sampler_float)-1.5 + m4 * 2 + m7 * (sampler_float)-0.5;
+        B0 = m1 * (sampler_float)0.5 - m4 + m7 * (sampler_float)0.5;
+        B1 = m1 * (sampler_float)-1.5 + m4 * 2 + m7 * (sampler_float)-0.5;
 
-            Z1 = Y0*B0 + y_*B1 + m1;
+        Z1 = Y0*B0 + y_*B1 + m1;
 
-            B0 = m2 * (sampler_float)0.5 - m5 + m8 * (sampler_float)0.5;
-            B1 = m2 * (sampler_float)-1.5 + m5 * 2 + m8 * (sampler_float)-0.5;
+        B0 = m2 * (sampler_float)0.5 - m5 + m8 * (sampler_float)0.5;
+        B1 = m2 * (sampler_float)-1.5 + m5 * 2 + m8 * (sampler_float)-0.5;
 
-            Z2 = Y0*B0 + y_*B1 + m2;
+        Z2 = Y0*B0 + y_*B1 + m2;
 
-            B0 = Z0 * (sampler_float)0.5 - Z1 + Z2 * (sampler_float)0.5;
-            B1 = Z0 * (sampler_float)-1.5 + Z1 * 2 + Z2 * (sampler_float)-0.5;
+        B0 = Z0 * (sampler_float)0.5 - Z1 + Z2 * (sampler_float)0.5;
+        B1 = Z0 * (sampler_float)-1.5 + Z1 * 2 + Z2 * (sampler_float)-0.5;
 
 
 
 
-            /* float version
-            sampler_float x_ = x - (int)x + 1;
-            sampler_float y_ = y - (int)y + 1;
-            sampler_float Z0, Z1, Z2;
-            sampler_float B0, B1;
-            sampler_float Y0 = y_*y_;
-            sampler_float X0 = x_*x_;
+        /* float version
+        sampler_float x_ = x - (int)x + 1;
+        sampler_float y_ = y - (int)y + 1;
+        sampler_float Z0, Z1, Z2;
+        sampler_float B0, B1;
+        sampler_float Y0 = y_*y_;
+        sampler_float X0 = x_*x_;
 
-            B0 = m0 * (sampler_float)0.5 - m3 + m6 * (sampler_float)0.5;
-            B1 = m0 * (sampler_float)-1.5 + m3 * 2 + m6 * (sampler_float)-0.5;
+        B0 = m0 * (sampler_float)0.5 - m3 + m6 * (sampler_float)0.5;
+        B1 = m0 * (sampler_float)-1.5 + m3 * 2 + m6 * (sampler_float)-0.5;
 
-            Z0 = Y0*B0 + y_*B1 + m0;
+        Z0 = Y0*B0 + y_*B1 + m0;
 
-            B0 = m1 * (sampler_float)0.5 - m4 + m7 * (sampler_float)0.5;
-            B1 = m1 * (sampler_float)-1.5 + m4 * 2 + m7 * (sampler_float)-0.5;
+        B0 = m1 * (sampler_float)0.5 - m4 + m7 * (sampler_float)0.5;
+        B1 = m1 * (sampler_float)-1.5 + m4 * 2 + m7 * (sampler_float)-0.5;
 
-            Z1 = Y0*B0 + y_*B1 + m1;
+        Z1 = Y0*B0 + y_*B1 + m1;
 
-            B0 = m2 * (sampler_float)0.5 - m5 + m8 * (sampler_float)0.5;
-            B1 = m2 * (sampler_float)-1.5 + m5 * 2 + m8 * (sampler_float)-0.5;
+        B0 = m2 * (sampler_float)0.5 - m5 + m8 * (sampler_float)0.5;
+        B1 = m2 * (sampler_float)-1.5 + m5 * 2 + m8 * (sampler_float)-0.5;
 
-            Z2 = Y0*B0 + y_*B1 + m2;
+        Z2 = Y0*B0 + y_*B1 + m2;
 
-            B0 = Z0 * (sampler_float)0.5 - Z1 + Z2 * (sampler_float)0.5;
-            B1 = Z0 * (sampler_float)-1.5 + Z1 * 2 + Z2 * (sampler_float)-0.5;
+        B0 = Z0 * (sampler_float)0.5 - Z1 + Z2 * (sampler_float)0.5;
+        B1 = Z0 * (sampler_float)-1.5 + Z1 * 2 + Z2 * (sampler_float)-0.5;
 
 
-            int res = (int)(X0*B0 + x_*B1 + Z0);
-            */
-            /* // integer version
-            int x_ = (x - (int)x + 1) * 255;
-            int y_ = (y - (int)y + 1) * 255;
-            int Z0, Z1, Z2;
-            int B0, B1;
-            int Y0 = (y_*y_) >> 8;//this increases errors
-            int X0 = (x_*x_) >> 8;//this increases errors
+        int res = (int)(X0*B0 + x_*B1 + Z0);
+        */
+        /* // integer version
+        int x_ = (x - (int)x + 1) * 255;
+        int y_ = (y - (int)y + 1) * 255;
+        int Z0, Z1, Z2;
+        int B0, B1;
+        int Y0 = (y_*y_) >> 8;//this increases errors
+        int X0 = (x_*x_) >> 8;//this increases errors
 
-            B0 = (m0 << 7) - (m3 << 8) + (m6 << 7);
-            B1 = m0 * -384 + (m3 << 9) - (m6 << 7);
+        B0 = (m0 << 7) - (m3 << 8) + (m6 << 7);
+        B1 = m0 * -384 + (m3 << 9) - (m6 << 7);
 
-            Z0 = (Y0*B0 + y_*B1 + (m0 << 16)) >> 8;
+        Z0 = (Y0*B0 + y_*B1 + (m0 << 16)) >> 8;
 
-            B0 = (m1 << 7) - (m4 << 8) + (m7 << 7);
-            B1 = m1 * -384 + (m4 << 9) - (m7 << 7);
+        B0 = (m1 << 7) - (m4 << 8) + (m7 << 7);
+        B1 = m1 * -384 + (m4 << 9) - (m7 << 7);
 
-            Z1 = (Y0*B0 + y_*B1 + (m1 << 16)) >> 8;
+        Z1 = (Y0*B0 + y_*B1 + (m1 << 16)) >> 8;
 
-            B0 = (m2 << 7) - (m5 << 8) + (m8 << 7);
-            B1 = m2 * -384 + (m5 << 9) - (m8 << 7);
+        B0 = (m2 << 7) - (m5 << 8) + (m8 << 7);
+        B1 = m2 * -384 + (m5 << 9) - (m8 << 7);
 
-            Z2 = (Y0*B0 + y_*B1 + (m2 << 16)) >> 8;
+        Z2 = (Y0*B0 + y_*B1 + (m2 << 16)) >> 8;
 
-            B0 = ((Z0 << 7) - (Z1 << 8) + (Z2 << 7)) >> 8;//this increases errors
-            B1 = (Z0 * -384 + (Z1 << 9) - (Z2 << 7)) >> 8;//this increases errors
+        B0 = ((Z0 << 7) - (Z1 << 8) + (Z2 << 7)) >> 8;//this increases errors
+        B1 = (Z0 * -384 + (Z1 << 9) - (Z2 << 7)) >> 8;//this increases errors
 
-            int res = (X0*B0 + x_*B1 + (Z0 << 8)) >> 16;
-            */
+        int res = (X0*B0 + x_*B1 + (Z0 << 8)) >> 16;
+        */
 
-            /*
-            //function z = sample(m, x, y)
-            //  A = [ 0 0 1; 1 1 1; 4 2 1]
-            //  Ai = inv(A)
+        /*
+        //function z = sample(m, x, y)
+        //  A = [ 0 0 1; 1 1 1; 4 2 1]
+        //  Ai = inv(A)
 
-            int xi = (int)x;
-            int yi = (int)y;
-            boxing_double m[3][3];
+        int xi = (int)x;
+        int yi = (int)y;
+        boxing_double m[3][3];
 
-            m[0][0] = image.pixel(xi-1,   yi-1);
-            m[0][1] = image.pixel(xi,     yi-1);
-            m[0][2] = image.pixel(xi+1,   yi-1);
+        m[0][0] = image.pixel(xi-1,   yi-1);
+        m[0][1] = image.pixel(xi,     yi-1);
+        m[0][2] = image.pixel(xi+1,   yi-1);
 
-            m[1][0] = image.pixel(xi-1,   yi  );
-            m[1][1] = image.pixel(xi,     yi  );
-            m[1][2] = image.pixel(xi+1,   yi  );
+        m[1][0] = image.pixel(xi-1,   yi  );
+        m[1][1] = image.pixel(xi,     yi  );
+        m[1][2] = image.pixel(xi+1,   yi  );
 
-            m[2][0] = image.pixel(xi-1,   yi+1);
-            m[2][1] = image.pixel(xi,     yi+1);
-            m[2][2] = image.pixel(xi+1,   yi+1);
+        m[2][0] = image.pixel(xi-1,   yi+1);
+        m[2][1] = image.pixel(xi,     yi+1);
+        m[2][2] = image.pixel(xi+1,   yi+1);
 
-            static boxing_double Ai[3][3] = {
-                {  0.50000,  -1.00000,   0.50000 },
-                { -1.50000,   2.00000,  -0.50000 },
-                {  1.00000,   0.00000,   0.00000 },
-            };
-            boxing_double x_ = x - (int)x + 1;
-            boxing_double y_ = y - (int)y + 1;
-            boxing_double Z[3];
-            boxing_double B[3];
-            boxing_double Y[3] = {y_*y_, y_, 1};
-            boxing_double X[3] = {x_*x_, x_, 1};
+        static boxing_double Ai[3][3] = {
+            {  0.50000,  -1.00000,   0.50000 },
+            { -1.50000,   2.00000,  -0.50000 },
+            {  1.00000,   0.00000,   0.00000 },
+        };
+        boxing_double x_ = x - (int)x + 1;
+        boxing_double y_ = y - (int)y + 1;
+        boxing_double Z[3];
+        boxing_double B[3];
+        boxing_double Y[3] = {y_*y_, y_, 1};
+        boxing_double X[3] = {x_*x_, x_, 1};
 
-            B[0] = m[0][0] * Ai[0][0] + m[1][0] * Ai[0][1] + m[2][0] * Ai[0][2];
-            B[1] = m[0][0] * Ai[1][0] + m[1][0] * Ai[1][1] + m[2][0] * Ai[1][2];
-            B[2] = m[0][0] * Ai[2][0] + m[1][0] * Ai[2][1] + m[2][0] * Ai[2][2];
+        B[0] = m[0][0] * Ai[0][0] + m[1][0] * Ai[0][1] + m[2][0] * Ai[0][2];
+        B[1] = m[0][0] * Ai[1][0] + m[1][0] * Ai[1][1] + m[2][0] * Ai[1][2];
+        B[2] = m[0][0] * Ai[2][0] + m[1][0] * Ai[2][1] + m[2][0] * Ai[2][2];
 
-            Z[0] = Y[0]*B[0] + Y[1]*B[1] + Y[2]*B[2];
+        Z[0] = Y[0]*B[0] + Y[1]*B[1] + Y[2]*B[2];
 
-            B[0] = m[0][1] * Ai[0][0] + m[1][1] * Ai[0][1] + m[2][1] * Ai[0][2];
-            B[1] = m[0][1] * Ai[1][0] + m[1][1] * Ai[1][1] + m[2][1] * Ai[1][2];
-            B[2] = m[0][1] * Ai[2][0] + m[1][1] * Ai[2][1] + m[2][1] * Ai[2][2];
+        B[0] = m[0][1] * Ai[0][0] + m[1][1] * Ai[0][1] + m[2][1] * Ai[0][2];
+        B[1] = m[0][1] * Ai[1][0] + m[1][1] * Ai[1][1] + m[2][1] * Ai[1][2];
+        B[2] = m[0][1] * Ai[2][0] + m[1][1] * Ai[2][1] + m[2][1] * Ai[2][2];
 
-            Z[1] = Y[0]*B[0] + Y[1]*B[1] + Y[2]*B[2];
+        Z[1] = Y[0]*B[0] + Y[1]*B[1] + Y[2]*B[2];
 
-            B[0] = m[0][2] * Ai[0][0] + m[1][2] * Ai[0][1] + m[2][2] * Ai[0][2];
-            B[1] = m[0][2] * Ai[1][0] + m[1][2] * Ai[1][1] + m[2][2] * Ai[1][2];
-            B[2] = m[0][2] * Ai[2][0] + m[1][2] * Ai[2][1] + m[2][2] * Ai[2][2];
+        B[0] = m[0][2] * Ai[0][0] + m[1][2] * Ai[0][1] + m[2][2] * Ai[0][2];
+        B[1] = m[0][2] * Ai[1][0] + m[1][2] * Ai[1][1] + m[2][2] * Ai[1][2];
+        B[2] = m[0][2] * Ai[2][0] + m[1][2] * Ai[2][1] + m[2][2] * Ai[2][2];
 
-            Z[2] = Y[0]*B[0] + Y[1]*B[1] + Y[2]*B[2];
+        Z[2] = Y[0]*B[0] + Y[1]*B[1] + Y[2]*B[2];
 
-            B[0] = Z[0] * Ai[0][0] + Z[1] * Ai[0][1] + Z[2] * Ai[0][2];
-            B[1] = Z[0] * Ai[1][0] + Z[1] * Ai[1][1] + Z[2] * Ai[1][2];
-            B[2] = Z[0] * Ai[2][0] + Z[1] * Ai[2][1] + Z[2] * Ai[2][2];
+        B[0] = Z[0] * Ai[0][0] + Z[1] * Ai[0][1] + Z[2] * Ai[0][2];
+        B[1] = Z[0] * Ai[1][0] + Z[1] * Ai[1][1] + Z[2] * Ai[1][2];
+        B[2] = Z[0] * Ai[2][0] + Z[1] * Ai[2][1] + Z[2] * Ai[2][2];
 
 
-            boxing_double res = X[0]*B[0] + X[1]*B[1] + X[2]*B[2];
-            if(res < 0.0)
-                res = 0.0;
-            else if(res > 255.0)
-                res = 255.0;
-            return (int)res;*/
-            
-            int res = (int)(X0*B0 + x_*B1 + Z0);
-            if (res > BOXING_PIXEL_MIN)
+        boxing_double res = X[0]*B[0] + X[1]*B[1] + X[2]*B[2];
+        if(res < 0.0)
+            res = 0.0;
+        else if(res > 255.0)
+            res = 255.0;
+        return (int)res;*/
+        
+        int res = (int)(X0*B0 + x_*B1 + Z0);
+        if (res > BOXING_PIXEL_MIN)
+        {
+            if (res < BOXING_PIXEL_MAX)
             {
-                if (res < BOXING_PIXEL_MAX)
-                {
-                    *pixel++ = (boxing_image8_pixel)res;
-                }
-                else
-                {
-                    *pixel++ = BOXING_PIXEL_MAX;
-                }
+                *pixel++ = (boxing_image8_pixel)res;
             }
             else
             {
-                *pixel++ = BOXING_PIXEL_MIN;
+                *pixel++ = BOXING_PIXEL_MAX;
             }
         }
+        else
+        {
+            *pixel++ = BOXING_PIXEL_MIN;
+        }
     }
+}
+
+
+static boxing_image8 * sample(boxing_sampler * sampler, const boxing_image8 * image)
+{
+
+    if ( boxing_image8_is_null(image) )
+    {
+        return NULL;
+    }
+
+    boxing_image8 * out_image = boxing_image8_create(sampler->location_matrix.width, sampler->location_matrix.height);
+
+    // Rows of the location matrix are split into bands sampled in parallel
+    const int height = (int)sampler->location_matrix.height;
+    const int band_count = boxing_thread_resolve_count(sampler->thread_count, height);
+
+    sample_job job;
+    job.image = image;
+    job.location_matrix = &sampler->location_matrix;
+    job.out_image = out_image;
+    job.kernel = select_sample_line_kernel();
+    job.band_height = (height + band_count - 1) / band_count;
+
+    boxing_thread_parallel_for(height > 0 ? band_count : 0, band_count, sample_band, &job);
 
     return out_image;
 }
 
+static void sample_band(void * user, int band)
+{
+    const sample_job * job = (const sample_job *)user;
+    const int y_begin = band * job->band_height;
+    const int y_end = BOXING_MATH_MIN(y_begin + job->band_height, (int)job->location_matrix->height);
+
+    for (int i = y_begin; i < y_end; i++)
+    {
+        sample_line(job->kernel, job->image, MATRIX_ROW(job->location_matrix, i), job->location_matrix->width, 1,
+            IMAGE8_SCANLINE(job->out_image, i));
+    }
+}
+
+#if defined (BOXING_CPU_X86)
+
+// The SIMD kernels repeat the operations of the portable code in the same
+// order, without fused multiply-add, so the sampled pixels are identical.
+
+BOXING_CPU_TARGET("sse2")
+static __m128 sample_column_sse2(__m128 top, __m128 middle, __m128 bottom, __m128 y_, __m128 y0)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 minus_one_half = _mm_set1_ps(-1.5f);
+    const __m128 minus_half = _mm_set1_ps(-0.5f);
+
+    __m128 b0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(top, half), middle), _mm_mul_ps(bottom, half));
+    __m128 b1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(top, minus_one_half), _mm_mul_ps(middle, two)), _mm_mul_ps(bottom, minus_half));
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(y0, b0), _mm_mul_ps(y_, b1)), top);
+}
+
+BOXING_CPU_TARGET("sse2")
+static int sample_line_sse2(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels)
+{
+    const int width = image->width;
+    const __m128 one = _mm_set1_ps(1.0f);
+    int m[9][4];
+    int xi[4];
+    int yi[4];
+
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const boxing_pointf * location = locations + n * step;
+        __m128 x, y;
+        if (step == 1)
+        {
+            __m128 a = _mm_loadu_ps(&location[0].x);
+            __m128 b = _mm_loadu_ps(&location[2].x);
+            x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+        else
+        {
+            x = _mm_set_ps(location[3 * step].x, location[2 * step].x, location[step].x, location[0].x);
+            y = _mm_set_ps(location[3 * step].y, location[2 * step].y, location[step].y, location[0].y);
+        }
+
+        __m128i x_int = _mm_cvttps_epi32(x);
+        __m128i y_int = _mm_cvttps_epi32(y);
+        _mm_storeu_si128((__m128i *)xi, x_int);
+        _mm_storeu_si128((__m128i *)yi, y_int);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const boxing_image8_pixel * current_pixel = image->data + width * (yi[lane] - 1) + xi[lane] - 1;
+            for (int row = 0; row < 3; row++, current_pixel += width)
+            {
+                m[3 * row][lane] = current_pixel[0];
+                m[3 * row + 1][lane] = current_pixel[1];
+                m[3 * row + 2][lane] = current_pixel[2];
+            }
+        }
+
+        __m128 pixel[9];
+        for (int k = 0; k < 9; k++)
+        {
+            pixel[k] = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)m[k]));
+        }
+
+        __m128 x_ = _mm_add_ps(_mm_sub_ps(x, _mm_cvtepi32_ps(x_int)), one);
+        __m128 y_ = _mm_add_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(y_int)), one);
+        __m128 y0 = _mm_mul_ps(y_, y_);
+        __m128 x0 = _mm_mul_ps(x_, x_);
+
+        __m128 z0 = sample_column_sse2(pixel[0], pixel[3], pixel[6], y_, y0);
+        __m128 z1 = sample_column_sse2(pixel[1], pixel[4], pixel[7], y_, y0);
+        __m128 z2 = sample_column_sse2(pixel[2], pixel[5], pixel[8], y_, y0);
+        __m128 res = sample_column_sse2(z0, z1, z2, x_, x0);
+
+        // Saturating packs clamp to the pixel range
+        __m128i value = _mm_cvttps_epi32(res);
+        value = _mm_packs_epi32(value, value);
+        value = _mm_packus_epi16(value, value);
+        int packed = _mm_cvtsi128_si32(value);
+        pixels[n] = (boxing_image8_pixel)packed;
+        pixels[n + 1] = (boxing_image8_pixel)(packed >> 8);
+        pixels[n + 2] = (boxing_image8_pixel)(packed >> 16);
+        pixels[n + 3] = (boxing_image8_pixel)(packed >> 24);
+    }
+    return n;
+}
+
+BOXING_CPU_TARGET("avx2")
+static __m256 sample_column_avx2(__m256 top, __m256 middle, __m256 bottom, __m256 y_, __m256 y0)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 minus_one_half = _mm256_set1_ps(-1.5f);
+    const __m256 minus_half = _mm256_set1_ps(-0.5f);
+
+    __m256 b0 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(top, half), middle), _mm256_mul_ps(bottom, half));
+    __m256 b1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(top, minus_one_half), _mm256_mul_ps(middle, two)), _mm256_mul_ps(bottom, minus_half));
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y0, b0), _mm256_mul_ps(y_, b1)), top);
+}
+
+BOXING_CPU_TARGET("avx2")
+static int sample_line_avx2(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels)
+{
+    const int width = image->width;
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i byte_mask = _mm256_set1_epi32(0xff);
+    const __m256i row = _mm256_set1_epi32(width);
+    const __m256i origin = _mm256_set1_epi32(width + 1);
+    // The row gathers read 4 bytes, one past the 3x3 neighbourhood
+    const __m256i last_offset = _mm256_set1_epi32(width * (int)image->height - 4 - 2 * width);
+    const int * data = (const int *)image->data;
+
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        const boxing_pointf * location = locations + n * step;
+        __m256 x, y;
+        if (step == 1)
+        {
+            __m256 a = _mm256_loadu_ps(&location[0].x);
+            __m256 b = _mm256_loadu_ps(&location[4].x);
+            x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+            y = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        else
+        {
+            x = _mm256_set_ps(location[7 * step].x, location[6 * step].x, location[5 * step].x, location[4 * step].x,
+                              location[3 * step].x, location[2 * step].x, location[step].x, location[0].x);
+            y = _mm256_set_ps(location[7 * step].y, location[6 * step].y, location[5 * step].y, location[4 * step].y,
+                              location[3 * step].y, location[2 * step].y, location[step].y, location[0].y);
+        }
+
+        __m256i x_int = _mm256_cvttps_epi32(x);
+        __m256i y_int = _mm256_cvttps_epi32(y);
+        __m256i offset = _mm256_sub_epi32(_mm256_add_epi32(_mm256_mullo_epi32(y_int, row), x_int), origin);
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(offset, last_offset)))
+        {
+            // Too close to the end of the image for the row gathers
+            break;
+        }
+
+        __m256 pixel[9];
+        for (int k = 0; k < 3; k++)
+        {
+            __m256i gathered = _mm256_i32gather_epi32(data, offset, 1);
+            pixel[3 * k] = _mm256_cvtepi32_ps(_mm256_and_si256(gathered, byte_mask));
+            pixel[3 * k + 1] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(gathered, 8), byte_mask));
+            pixel[3 * k + 2] = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(gathered, 16), byte_mask));
+            offset = _mm256_add_epi32(offset, row);
+        }
+
+        __m256 x_ = _mm256_add_ps(_mm256_sub_ps(x, _mm256_cvtepi32_ps(x_int)), one);
+        __m256 y_ = _mm256_add_ps(_mm256_sub_ps(y, _mm256_cvtepi32_ps(y_int)), one);
+        __m256 y0 = _mm256_mul_ps(y_, y_);
+        __m256 x0 = _mm256_mul_ps(x_, x_);
+
+        __m256 z0 = sample_column_avx2(pixel[0], pixel[3], pixel[6], y_, y0);
+        __m256 z1 = sample_column_avx2(pixel[1], pixel[4], pixel[7], y_, y0);
+        __m256 z2 = sample_column_avx2(pixel[2], pixel[5], pixel[8], y_, y0);
+        __m256 res = sample_column_avx2(z0, z1, z2, x_, x0);
+
+        // Saturating packs clamp to the pixel range
+        __m256i value = _mm256_cvttps_epi32(res);
+        __m128i value16 = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+        _mm_storel_epi64((__m128i *)(pixels + n), _mm_packus_epi16(value16, value16));
+    }
+    return n;
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+// The SIMD kernel repeats the operations of the portable code in the same
+// order, without fused multiply-add, so the sampled pixels are identical.
+
+static float32x4_t sample_column_neon(float32x4_t top, float32x4_t middle, float32x4_t bottom, float32x4_t y_, float32x4_t y0)
+{
+    float32x4_t b0 = vaddq_f32(vsubq_f32(vmulq_n_f32(top, 0.5f), middle), vmulq_n_f32(bottom, 0.5f));
+    float32x4_t b1 = vaddq_f32(vaddq_f32(vmulq_n_f32(top, -1.5f), vmulq_n_f32(middle, 2.0f)), vmulq_n_f32(bottom, -0.5f));
+    return vaddq_f32(vaddq_f32(vmulq_f32(y0, b0), vmulq_f32(y_, b1)), top);
+}
+
+static int sample_line_neon(const boxing_image8 * image, const boxing_pointf * locations, int count, int step, boxing_image8_pixel * pixels)
+{
+    const int width = image->width;
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    int32_t m[9][4];
+    int32_t xi[4];
+    int32_t yi[4];
+
+    int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const boxing_pointf * location = locations + n * step;
+        float32x4_t x, y;
+        if (step == 1)
+        {
+            float32x4x2_t xy = vld2q_f32(&location[0].x);
+            x = xy.val[0];
+            y = xy.val[1];
+        }
+        else
+        {
+            float32_t xs[4] = { location[0].x, location[step].x, location[2 * step].x, location[3 * step].x };
+            float32_t ys[4] = { location[0].y, location[step].y, location[2 * step].y, location[3 * step].y };
+            x = vld1q_f32(xs);
+            y = vld1q_f32(ys);
+        }
+
+        int32x4_t x_int = vcvtq_s32_f32(x);
+        int32x4_t y_int = vcvtq_s32_f32(y);
+        vst1q_s32(xi, x_int);
+        vst1q_s32(yi, y_int);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const boxing_image8_pixel * current_pixel = image->data + width * (yi[lane] - 1) + xi[lane] - 1;
+            for (int row = 0; row < 3; row++, current_pixel += width)
+            {
+                m[3 * row][lane] = current_pixel[0];
+                m[3 * row + 1][lane] = current_pixel[1];
+                m[3 * row + 2][lane] = current_pixel[2];
+            }
+        }
+
+        float32x4_t pixel[9];
+        for (int k = 0; k < 9; k++)
+        {
+            pixel[k] = vcvtq_f32_s32(vld1q_s32(m[k]));
+        }
+
+        float32x4_t x_ = vaddq_f32(vsubq_f32(x, vcvtq_f32_s32(x_int)), one);
+        float32x4_t y_ = vaddq_f32(vsubq_f32(y, vcvtq_f32_s32(y_int)), one);
+        float32x4_t y0 = vmulq_f32(y_, y_);
+        float32x4_t x0 = vmulq_f32(x_, x_);
+
+        float32x4_t z0 = sample_column_neon(pixel[0], pixel[3], pixel[6], y_, y0);
+        float32x4_t z1 = sample_column_neon(pixel[1], pixel[4], pixel[7], y_, y0);
+        float32x4_t z2 = sample_column_neon(pixel[2], pixel[5], pixel[8], y_, y0);
+        float32x4_t res = sample_column_neon(z0, z1, z2, x_, x0);
+
+        // Saturating narrowing clamps to the pixel range
+        uint16x4_t value16 = vqmovun_s32(vcvtq_s32_f32(res));
+        uint8x8_t value8 = vqmovn_u16(vcombine_u16(value16, value16));
+        pixels[n] = vget_lane_u8(value8, 0);
+        pixels[n + 1] = vget_lane_u8(value8, 1);
+        pixels[n + 2] = vget_lane_u8(value8, 2);
+        pixels[n + 3] = vget_lane_u8(value8, 3);
+    }
+    return n;
+}
+
+#endif
+
+static sample_line_kernel select_sample_line_kernel(void)
+{
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_AVX2))
+    {
+        return sample_line_avx2;
+    }
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        return sample_line_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        return sample_line_neon;
+    }
+#endif
+    return NULL;
+}
+
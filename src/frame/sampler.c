@@ -85,6 +85,8 @@ const char * BOXING_SAMPLE_HORIZONTALSHIFTS   = "sampler.horizontalshifts";
  *  \param free             Function to free memory. (void (*free)(struct boxing_sampler_s * sampler))
  *  \param location_matrix  Location matrix.
  *  \param state            Sampler state.
+ *  \param thread_count     Worker threads used by samplers that split the locations
+ *                          across threads, less than 1 uses all cores. Default is 1.
  *
  *  Sampler data storage structure description.
  */
@@ -107,6 +109,7 @@ const char * BOXING_SAMPLE_HORIZONTALSHIFTS   = "sampler.horizontalshifts";
 void boxing_sampler_init(boxing_sampler * sampler, int width, int height)
 {
     sampler->state = DFALSE;
+    sampler->thread_count = 1;
     boxing_matrixf_init_in_place(&sampler->location_matrix, width, height);
     sampler->free = boxing_sampler_free;
     sampler->sample = BOXING_NULL_POINTER;
@@ -32,13 +32,6 @@
 //
 
 static int track_frame_simulated_mode(boxing_tracker_gpf * tracker, const boxing_image8 * frame);
-static int boxing_tracker_gpf_track_corner_marks(
-    void* user,
-    const boxing_image8 * image,
-    boxing_corner_mark_definition* definition,
-    boxing_float sampling_rate_x,
-    boxing_float sampling_rate_y,
-    frame_corner_marks* corner_marks );
 
 
 /*! 
@@ -111,6 +104,8 @@ static int boxing_tracker_gpf_track_corner_marks(
  *  \param container_sampler_list   Pointer to the conteiner sampler list.
  *  \param x_sampling_rate          Sampling rate along the X axis.
  *  \param y_sampling_rate          Sampling rate along the Y axis.
+ *  \param integral_image           Summed area tables of the tracked frame, shared by the tracking stages.
+ *  \param thread_count             Number of worker threads used while tracking, less than 1 uses all cores.
  *  \param type                     Type string.
  *  \param on_corner_mark_complete  Pointer to the boxing_corner_mark_complete_cb callback function.
  *  \param user_data                Pointer to the user data.
@@ -237,6 +232,8 @@ void boxing_tracker_init(boxing_tracker * tracker)
     tracker->track_corner_mark = NULL;
     tracker->container_sampler_list = NULL;
     tracker->mode = 0;
+    tracker->integral_image = NULL;
+    tracker->thread_count = 1;
 #ifdef BOXINGLIB_CALLBACK
     tracker->on_corner_mark_complete = NULL;
     tracker->user_data = NULL;
@@ -259,6 +256,7 @@ void boxing_tracker_destroy(boxing_tracker * tracker)
     if (tracker)
     {
         tracker->free(tracker);
+        boxing_integral_image_free(tracker->integral_image);
         boxing_memory_free(tracker);
     }
 }
@@ -293,9 +291,95 @@ int boxing_tracker_gpf_track_frame(boxing_tracker * tracker, const boxing_image8
 
     if(tracker->mode & BOXING_TRACK_SIMULATED)
         return SMEMBER(track_frame_simulated_mode)((boxing_tracker_gpf*)tracker, frame);
+
+    // The summed area tables are built on demand as the frame is tracked
+    if (tracker->integral_image == NULL)
+    {
+        tracker->integral_image = boxing_integral_image_create(frame);
+    }
     else
-        return SMEMBER(track_frame_analog_mode)((boxing_tracker_gpf*)tracker, frame);
+    {
+        boxing_integral_image_reset(tracker->integral_image, frame);
+    }
+    return SMEMBER(track_frame_analog_mode)((boxing_tracker_gpf*)tracker, frame);
+
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Default corner mark tracking.
+ *
+ *  Locates the frame borders and searches for the four corner marks close to
+ *  the frame corners.
+ *
+ *  \param[in]  user             User data.
+ *  \param[in]  image            Image.
+ *  \param[in]  definition       Corner mark definition.
+ *  \param[in]  sampling_rate_x  Sampling rate along the X axis.
+ *  \param[in]  sampling_rate_y  Sampling rate along the Y axis.
+ *  \param[out] corner_marks     Corner marks.
+ *  \return BOXING_CORNER_MARK_OK if all corner marks are found.
+ */
+
+int boxing_tracker_gpf_track_corner_marks(
+    void* user,
+    const boxing_image8 * image, 
+    boxing_corner_mark_definition* definition, 
+    boxing_float sampling_rate_x,
+    boxing_float sampling_rate_y,
+    frame_corner_marks* corner_marks )
+{
+    BOXING_UNUSED_PARAMETER( user );
+
+    if (!boxing_frame_tracker_util_find_frame(image, corner_marks, sampling_rate_x, sampling_rate_y))
+    {
+        DLOG_ERROR( "boxing_tracker_gpf_track_corner_marks  Finding reference marks failed" );
+        return BOXING_CORNER_MARK_TRACKING_ERROR;
+    }
+
+    return boxing_tracker_gpf_validate_corner_marks(image, definition, sampling_rate_x, sampling_rate_y, corner_marks);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Checks that found corner marks are usable.
+ *
+ *  Each corner mark must lie far enough inside the image for a whole corner
+ *  mark symbol around it.
+ *
+ *  \param[in]  image            Image.
+ *  \param[in]  definition       Corner mark definition.
+ *  \param[in]  sampling_rate_x  Sampling rate along the X axis.
+ *  \param[in]  sampling_rate_y  Sampling rate along the Y axis.
+ *  \param[in]  corner_marks     Corner marks.
+ *  \return BOXING_CORNER_MARK_OK if all corner marks are valid.
+ */
+
+int boxing_tracker_gpf_validate_corner_marks(
+    const boxing_image8 * image,
+    const boxing_corner_mark_definition* definition,
+    boxing_float sampling_rate_x,
+    boxing_float sampling_rate_y,
+    frame_corner_marks* corner_marks )
+{
+    boxing_pointi ref_dim = {(int)( definition->corner_mark_symbol * sampling_rate_x ), (int)( definition->corner_mark_symbol * sampling_rate_y )};
+    boxing_pointi* corners[] = { &corner_marks->top_left, &corner_marks->top_right, &corner_marks->bottom_left, &corner_marks->bottom_right };
+    const char* names[] = { "Top left", "Top right", "Bottom left", "Bottom right" };
+    const int corner_count = sizeof(corners)/sizeof(corners[0]);
 
+    for ( int i = 0; i < corner_count; i++ )
+    {
+        DLOG_INFO3( "boxing_tracker_gpf_validate_corner_marks %s reference mark     = (%i, %i)", names[i], corners[i]->x, corners[i]->y );
+        if (!boxing_frame_tracker_util_validate_corner_mark(corners[i], &ref_dim, image))
+        {
+            DLOG_ERROR1( "boxing_tracker_gpf_validate_corner_marks  %s reference mark is not within image dimensions", names[i] );
+            return BOXING_CORNER_MARK_TRACKING_ERROR;
+        }
+    }
+
+    return BOXING_CORNER_MARK_OK;
 }
 
 
@@ -433,37 +517,3 @@ static int track_frame_simulated_mode(boxing_tracker_gpf * tracker, const boxing
 
     return 0;
 }
-
-static int boxing_tracker_gpf_track_corner_marks(
-    void* user,
-    const boxing_image8 * image, 
-    boxing_corner_mark_definition* definition, 
-    boxing_float sampling_rate_x,
-    boxing_float sampling_rate_y,
-    frame_corner_marks* corner_marks )
-{
-    BOXING_UNUSED_PARAMETER( user );
-
-    if (!boxing_frame_tracker_util_find_frame(image, corner_marks, sampling_rate_x, sampling_rate_y))
-    {
-        DLOG_ERROR( "boxing_tracker_gpf_track_corner_marks  Finding reference marks failed" );
-        return BOXING_CORNER_MARK_TRACKING_ERROR;
-    }
-
-    boxing_pointi ref_dim = {(int)( definition->corner_mark_symbol * sampling_rate_x ), (int)( definition->corner_mark_symbol * sampling_rate_y )};
-    boxing_pointi* corners[] = { &corner_marks->top_left, &corner_marks->top_right, &corner_marks->bottom_left, &corner_marks->bottom_right };
-    const char* names[] = { "Top left", "Top right", "Bottom left", "Bottom right" };
-    const int corner_count = sizeof(corners)/sizeof(corners[0]);
-
-    for ( int i = 0; i < corner_count; i++ )
-    {
-        DLOG_INFO3( "boxing_tracker_gpf_track_corner_marks %s reference mark     = (%i, %i)", names[i], corners[i]->x, corners[i]->y );
-        if (!boxing_frame_tracker_util_validate_corner_mark(corners[i], &ref_dim, image))
-        {
-            DLOG_ERROR1( "boxing_tracker_gpf_track_corner_marks  %s reference mark is not within image dimensions", names[i] );
-            return BOXING_CORNER_MARK_TRACKING_ERROR;
-        }
-    }
-
-    return BOXING_CORNER_MARK_OK;
-}
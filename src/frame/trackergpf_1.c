@@ -21,7 +21,7 @@
 #include    "boxing/graphics/referencebar.h"
 #include    "boxing/graphics/calibrationbar.h"
 #include    "boxing/unboxer/syncpoints.h"
-#include    "2polinomialsampler.h"
+#include    "boxing/frame/2polinomialsampler.h"
 #include    "areasampler.h"
 #include    "../unboxer/horizontalmeasures.h"
 #include    "../unboxer/datapoints.h"
@@ -42,6 +42,8 @@
 #define BASEMEMBER(member) (((boxing_tracker_gpf *)tracker)->member)
 #define BASEBASEMEMBER(member) (((boxing_tracker*)tracker)->member)
 #define REFBAR_INVALID_SYNC_REF -1
+// Search radius around the previous corner mark location, in frame pixels
+#define CORNER_MARK_PREDICTION_RADIUS 8
 
 typedef struct {
     int actual;
@@ -56,10 +58,12 @@ static int   track_frame(boxing_tracker * tracker, const boxing_image8 * frame);
 static void  tracker_gpf_1_free(boxing_tracker * tracker);
 static int   validate_coordinate(int width, int height, struct boxing_pointi_s *location);
 static int   track_frame_analog_mode(boxing_tracker_gpf * tracker, const boxing_image8 * input_image);
+static int   find_corner_marks(boxing_tracker_gpf * tracker, const boxing_image8 * input_image, boxing_corner_mark_definition * definition, frame_corner_marks * corner_marks);
 static void  boxing_coordmapper_init_empty(boxing_coordmapper *mapper);
 static void  get_displacement_matrix(boxing_tracker_gpf_1 * tracker, const boxing_image8 * image, boxing_matrixf * displacement_matrix);
 static DBOOL calc_horizontal_offset(boxing_tracker_gpf_1 * tracker, const boxing_image8 * image, const boxing_pointi from, const boxing_pointi to, boxing_float * offsets, int scan_direction);
 static DBOOL calculate_reference_bars(boxing_tracker_gpf_1 * tracker, const boxing_image8 * image);
+static boxing_integral_image * frame_integral_image(boxing_tracker_gpf_1 * tracker, const boxing_image8 * image);
 
 static DBOOL calculate_intersection_points(
     const boxing_linef * horizontal_lines, 
@@ -167,6 +171,7 @@ static boxing_linef * calculate_lines(
  *  \param sync_point_search_radius          Scan radius in pixels, default = 4.5f.
  *  \param sync_point_center_is_bright       Is center pixel white, default = DTRUE.
  *  \param sync_point_max_allowed_variation  Max allowed squared offset variation, default = 0.1f.
+ *  \param thread_count                      Number of worker threads, default = thread count of the tracker.
  *
  *  The correct_frame_geometry_properties serve as input parameters to the correct_frame_geometry function
  *  which purpose is to find syncpoints and validate their positions.
@@ -242,13 +247,14 @@ static boxing_linef * calculate_lines(
 
 boxing_tracker_gpf_1 * boxing_tracker_gpf_1_create(boxing_frame_gpf_1 * generic_frame)
 {
-    boxing_tracker_gpf_1 * tracker = (boxing_tracker_gpf_1 *)BOXING_MEMORY_ALLOCATE_TYPE(boxing_frame_gpf_1);
+    boxing_tracker_gpf_1 * tracker = BOXING_MEMORY_ALLOCATE_TYPE(boxing_tracker_gpf_1);
     boxing_tracker_gpf_init(&tracker->base, (boxing_frame*)generic_frame);
     tracker->base.base.mode = BOXING_TRACK_HORIZONTAL_SHIFT|
                               BOXING_TRACK_CONTENT_CONTAINER|
                               BOXING_TRACK_METADATA_CONTAINER|
                               BOXING_TRACK_CALIBRATION_BAR|
-                              BOXING_TRACK_SYNC_POINTS;
+                              BOXING_TRACK_SYNC_POINTS|
+                              BOXING_TRACK_PREDICT_CORNER_MARKS;
     tracker->base.base.track_frame = track_frame;
     tracker->base.base.free = tracker_gpf_1_free;
     tracker->base.base.type = BOXING_TRACKER_GPF1_NAME;
@@ -272,7 +278,8 @@ boxing_tracker_gpf_1 * boxing_tracker_gpf_1_create(boxing_frame_gpf_1 * generic_
             container->dimension(container).y/container_tile_size.y};
 
     boxing_coordmapper_init_empty(&tracker->coordinate_mapper);
-    
+    tracker->previous_corner_marks_valid = DFALSE;
+
 
     boxing_pointi container_dimension = generic_frame->base.container(&generic_frame->base)->dimension(generic_frame->base.container(&generic_frame->base));
     container_dimension.x /= generic_frame->reference_bar_freq_divider;
@@ -682,7 +689,8 @@ static int track_frame_analog_mode(boxing_tracker_gpf * tracker, const boxing_im
     definition.border_gap = 1;
 
     frame_corner_marks corner_marks;
-    int res = BASEBASEMEMBER(track_corner_mark)(BASEBASEMEMBER(user_data), input_image, &definition, BASEBASEMEMBER(x_sampling_rate), BASEBASEMEMBER(y_sampling_rate), &corner_marks);
+    int res = find_corner_marks(tracker, input_image, &definition, &corner_marks);
+    SMEMBER(previous_corner_marks_valid) = DFALSE;
 
 #ifdef BOXINGLIB_CALLBACK
     if (BASEBASEMEMBER(on_corner_mark_complete))
@@ -759,7 +767,7 @@ static int track_frame_analog_mode(boxing_tracker_gpf * tracker, const boxing_im
     }
 
     const boxing_pointi * corners[4] = { &corner_marks.top_left, &corner_marks.top_right, &corner_marks.bottom_left, &corner_marks.bottom_right };
-    boxing_frame_tracker_util_calculate_average_maxmin(input_image, corners, 4, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate), &SMEMBER(avg_max), &SMEMBER(avg_min));
+    boxing_frame_tracker_util_calculate_average_maxmin_integral(input_image, frame_integral_image((boxing_tracker_gpf_1 *)tracker, input_image), corners, 4, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate), &SMEMBER(avg_max), &SMEMBER(avg_min));
     DLOG_INFO2("Average max, min = %f, %f", SMEMBER(avg_max), SMEMBER(avg_min));
 
     if(!calculate_reference_bars((boxing_tracker_gpf_1 *)tracker, input_image))
@@ -801,6 +809,8 @@ static int track_frame_analog_mode(boxing_tracker_gpf * tracker, const boxing_im
                     tracker->content_sampler->location_matrix.height,
                     SMEMBER(top_reference_bar_sampler)->location_matrix.width,
                     SMEMBER(left_reference_bar_sampler)->location_matrix.width);
+        boxing_memory_free(horizontal_right_shift);
+        boxing_memory_free(horizontal_left_shift);
         return 1;
     }
 
@@ -823,6 +833,8 @@ static int track_frame_analog_mode(boxing_tracker_gpf * tracker, const boxing_im
                                    &corner_marks))
     {
         DLOG_ERROR("track_frame_analog_mode Recovery reference points is not possible. STOP process");
+        boxing_memory_free(horizontal_right_shift);
+        boxing_memory_free(horizontal_left_shift);
         return 1;
     }
 
@@ -842,14 +854,45 @@ static int track_frame_analog_mode(boxing_tracker_gpf * tracker, const boxing_im
         props.sync_point_center_is_bright = DTRUE;
         props.sync_point_max_allowed_variation = 0.1f;
         props.sync_point_search_radius = 4.5f;
+        props.thread_count = BASEBASEMEMBER(thread_count);
         boxing_matrixf * locations = &tracker->content_sampler->location_matrix;
         SMEMBER(correct_frame_geometry)(BASEBASEMEMBER(user_data), input_image, locations, &SMEMBER( syncpoint_index ), &props);
     }
 
+    SMEMBER(previous_corner_marks) = corner_marks;
+    SMEMBER(previous_image_size).x = (int)input_image->width;
+    SMEMBER(previous_image_size).y = (int)input_image->height;
+    SMEMBER(previous_corner_marks_valid) = DTRUE;
+
     return 0;
 }
 
 
+// Consecutive frames are close to each other, so the corner marks are first
+// looked for near the corner marks of the previous frame. The whole image is
+// searched when they are not found there.
+static int find_corner_marks(boxing_tracker_gpf * tracker, const boxing_image8 * input_image, boxing_corner_mark_definition * definition, frame_corner_marks * corner_marks)
+{
+    if ((tracker->base.mode & BOXING_TRACK_PREDICT_CORNER_MARKS) &&
+        SMEMBER(previous_corner_marks_valid) &&
+        SMEMBER(previous_image_size).x == (int)input_image->width &&
+        SMEMBER(previous_image_size).y == (int)input_image->height &&
+        BASEBASEMEMBER(track_corner_mark) == boxing_tracker_gpf_track_corner_marks)
+    {
+        const int search_radius = (int)(CORNER_MARK_PREDICTION_RADIUS * BOXING_MATH_MAX(BASEBASEMEMBER(x_sampling_rate), BASEBASEMEMBER(y_sampling_rate)));
+        if (boxing_frame_tracker_util_find_frame_near_integral(input_image, frame_integral_image((boxing_tracker_gpf_1 *)tracker, input_image), &SMEMBER(previous_corner_marks), corner_marks, search_radius,
+                BASEBASEMEMBER(x_sampling_rate), BASEBASEMEMBER(y_sampling_rate)) &&
+            boxing_tracker_gpf_validate_corner_marks(input_image, definition, BASEBASEMEMBER(x_sampling_rate), BASEBASEMEMBER(y_sampling_rate), corner_marks) == BOXING_CORNER_MARK_OK)
+        {
+            return BOXING_CORNER_MARK_OK;
+        }
+        DLOG_INFO("track_frame_analog_mode Corner marks moved, searching the whole image");
+    }
+
+    return BASEBASEMEMBER(track_corner_mark)(BASEBASEMEMBER(user_data), input_image, definition, BASEBASEMEMBER(x_sampling_rate), BASEBASEMEMBER(y_sampling_rate), corner_marks);
+}
+
+
 static void get_displacement_matrix(boxing_tracker_gpf_1 *tracker, const boxing_image8 * image, boxing_matrixf * displacement_matrix)
 {
      boxing_matrixf_init_in_place(displacement_matrix, 3, 3);
@@ -863,6 +906,7 @@ static void get_displacement_matrix(boxing_tracker_gpf_1 *tracker, const boxing_
      boxing_pointf left_edge_location;
      boxing_pointf center_edge_location;
      boxing_pointf right_edge_location;
+     boxing_integral_image * integral_image = frame_integral_image(tracker, image);
 
      boxing_matrixf * location_matrix = &tracker->base.content_sampler->location_matrix;
      int line_points_size = location_matrix->width;
@@ -872,21 +916,21 @@ static void get_displacement_matrix(boxing_tracker_gpf_1 *tracker, const boxing_
      start.x = (int)( reference_point.x );
      start.y = (int)( reference_point.y-4*BASEMEMBER(base.y_sampling_rate) );
      stop = boxing_math_pointf_to_int( &reference_point );
-     left_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge(image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
+     left_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, integral_image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
      boxing_math_pointf_add( &left_edge_location, &start );
 
      reference_point = (line_points)[line_points_size/2 - 1];
      start.x = (int)( reference_point.x );
      start.y = (int)( reference_point.y-4*BASEMEMBER(base.y_sampling_rate) );
      stop = boxing_math_pointf_to_int( &reference_point );
-     center_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge(image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
+     center_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, integral_image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
      boxing_math_pointf_add( &center_edge_location, &start );
 
      reference_point = (line_points)[line_points_size - 25];
      start.x = (int)( reference_point.x );
      start.y = (int)( reference_point.y-4*BASEMEMBER(base.y_sampling_rate) );
      stop = boxing_math_pointf_to_int( &reference_point );
-     right_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge(image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
+     right_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, integral_image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
      boxing_math_pointf_add( &right_edge_location, &start );
 
      yoffset = center_edge_location.y - (left_edge_location.y+right_edge_location.y)/2;
@@ -899,21 +943,21 @@ static void get_displacement_matrix(boxing_tracker_gpf_1 *tracker, const boxing_
      start.x = (int)( reference_point.x );
      start.y = (int)( reference_point.y+4*BASEMEMBER(base.y_sampling_rate) );
      stop = boxing_math_pointf_to_int( &reference_point );
-     left_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge(image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
+     left_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, integral_image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
      boxing_math_pointf_add( &left_edge_location, &start );
 
      reference_point = (line_points)[line_points_size/2 - 1];
      start.x = (int)( reference_point.x );
      start.y = (int)( reference_point.y+4*BASEMEMBER(base.y_sampling_rate) );
      stop = boxing_math_pointf_to_int( &reference_point );
-     center_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge(image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
+     center_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, integral_image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
      boxing_math_pointf_add( &center_edge_location, &start );
 
      reference_point = (line_points)[line_points_size - 25];
      start.x = (int)( reference_point.x );
      start.y = (int)( reference_point.y+4*BASEMEMBER(base.y_sampling_rate) );
      stop = boxing_math_pointf_to_int( &reference_point );
-     right_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge(image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
+     right_edge_location = boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, integral_image, start, stop, BASEMEMBER(base.x_sampling_rate), BASEMEMBER(base.y_sampling_rate));
      boxing_math_pointf_add( &right_edge_location, &start );
 
      yoffset = center_edge_location.y - (left_edge_location.y+right_edge_location.y)/2;
@@ -934,7 +978,7 @@ static void get_displacement_matrix(boxing_tracker_gpf_1 *tracker, const boxing_
 static DBOOL calc_horizontal_offset(boxing_tracker_gpf_1 * tracker, const boxing_image8 * image, const boxing_pointi from, const boxing_pointi to, float * offsets, int scan_direction)
 {
     boxing_float * border_location = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_float, image->height);
-    boxing_frame_tracker_util_track_vertical_border(image, &from, &to, border_location, scan_direction, BASEMEMBER(base.x_sampling_rate));
+    boxing_frame_tracker_util_track_vertical_border_integral(image, frame_integral_image(tracker, image), &from, &to, border_location, scan_direction, BASEMEMBER(base.x_sampling_rate));
 
     boxing_pointf * top    = tracker->top_reference_bar_sampler->location_matrix.data;
     boxing_pointf * bottom = tracker->bottom_reference_bar_sampler->location_matrix.data;
@@ -962,6 +1006,14 @@ static DBOOL calc_horizontal_offset(boxing_tracker_gpf_1 * tracker, const boxing
 }
 
 
+// Summed area tables of the frame being tracked, NULL for any other image
+static boxing_integral_image * frame_integral_image(boxing_tracker_gpf_1 * tracker, const boxing_image8 * image)
+{
+    boxing_integral_image * integral_image = BASEBASEMEMBER(integral_image);
+    return (integral_image && integral_image->image == image) ? integral_image : NULL;
+}
+
+
 static gvector * sample_reference_bar(boxing_sampler * sampler, const boxing_image8 * image)
 {
     boxing_image8 * sampled_image = NULL;
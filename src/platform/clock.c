@@ -0,0 +1,67 @@
+/*****************************************************************************
+**
+**  Implementation of the monotonic clock interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "boxing/platform/clock.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (D_OS_WIN32)
+#   include <windows.h>
+#elif defined (D_OS_LINUX)
+#   include <time.h>
+#endif
+
+
+/*!
+  * \addtogroup platform
+  * \{
+  */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Monotonic wall clock time.
+ *
+ *  Returns the time in milliseconds from an arbitrary starting point. The
+ *  clock is not affected by changes of the system time, so the difference
+ *  between two calls measures elapsed time. Returns 0 on platforms without
+ *  a clock.
+ *
+ *  \return Time in milliseconds.
+ */
+
+boxing_double boxing_clock_milliseconds(void)
+{
+#if defined (D_OS_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (boxing_double)counter.QuadPart * 1000.0 / (boxing_double)frequency.QuadPart;
+#elif defined (D_OS_LINUX)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (boxing_double)now.tv_sec * 1000.0 + (boxing_double)now.tv_nsec / 1000000.0;
+#else
+    return 0.0;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of platform group
+  */
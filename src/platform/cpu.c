@@ -0,0 +1,217 @@
+/*****************************************************************************
+**
+**  Implementation of the CPU feature detection interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "boxing/platform/cpu.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (BOXING_CPU_X86)
+#   if defined (_MSC_VER)
+#       include <intrin.h>
+#   else
+#       include <cpuid.h>
+#   endif
+#elif defined (BOXING_CPU_ARM) && defined (__linux__) && defined (__aarch64__)
+#   include <sys/auxv.h>
+#   include <asm/hwcap.h>
+#endif
+
+//  PRIVATE INTERFACE
+//
+
+static unsigned int detect_features(void);
+
+static int          cpu_features_detected = 0;
+static unsigned int cpu_features = 0;
+static unsigned int cpu_feature_mask = ~0u;
+
+
+/*!
+  * \addtogroup platform
+  * \{
+  */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \enum   boxing_cpu_feature cpu.h
+ *  \brief  Instruction set extensions used by optimized code paths.
+ *
+ *  \param BOXING_CPU_FEATURE_SSE2    x86 SSE2.
+ *  \param BOXING_CPU_FEATURE_SSSE3   x86 SSSE3 (PSHUFB).
+ *  \param BOXING_CPU_FEATURE_SSE41   x86 SSE4.1.
+ *  \param BOXING_CPU_FEATURE_AVX2    x86 AVX2 with operating system support.
+ *  \param BOXING_CPU_FEATURE_PCLMUL  x86 carry-less multiply.
+ *  \param BOXING_CPU_FEATURE_NEON    ARM Advanced SIMD.
+ *  \param BOXING_CPU_FEATURE_PMULL   ARM polynomial multiply long.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Get supported CPU features.
+ *
+ *  The features are detected on first use and cached. The result is
+ *  restricted by the mask set with boxing_cpu_set_feature_mask.
+ *
+ *  \return Bitwise or of boxing_cpu_feature values.
+ */
+
+unsigned int boxing_cpu_features(void)
+{
+    if (!cpu_features_detected)
+    {
+        cpu_features = detect_features();
+        cpu_features_detected = 1;
+    }
+    return cpu_features & cpu_feature_mask;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Check if CPU feature is supported.
+ *
+ *  \param[in]  feature  One or more boxing_cpu_feature values.
+ *  \return DTRUE if all given features are supported.
+ */
+
+DBOOL boxing_cpu_has_feature(unsigned int feature)
+{
+    return (boxing_cpu_features() & feature) == feature ? DTRUE : DFALSE;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Restrict CPU features.
+ *
+ *  Limit the features reported by boxing_cpu_features. Setting the mask to 0
+ *  forces all optimized code paths to use their portable fallback, this is
+ *  used by tests to compare implementations. The mask is global and should
+ *  not be changed while unboxing is in progress.
+ *
+ *  \param[in]  mask  Bitwise or of allowed boxing_cpu_feature values.
+ */
+
+void boxing_cpu_set_feature_mask(unsigned int mask)
+{
+    cpu_feature_mask = mask;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of platform group
+  */
+
+
+// PRIVATE CPU FUNCTIONS
+//
+
+#if defined (BOXING_CPU_X86)
+
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int registers[4])
+{
+#if defined (_MSC_VER)
+    __cpuidex((int *)registers, (int)leaf, (int)subleaf);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static boxing_uint64 xgetbv(void)
+{
+#if defined (_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    return ((boxing_uint64)edx << 32) | eax;
+#endif
+}
+
+static unsigned int detect_features(void)
+{
+    unsigned int features = 0;
+    unsigned int registers[4] = { 0, 0, 0, 0 };
+
+    cpuid(0, 0, registers);
+    const unsigned int max_leaf = registers[0];
+    if (max_leaf < 1)
+    {
+        return features;
+    }
+
+    cpuid(1, 0, registers);
+    const unsigned int ecx = registers[2];
+    const unsigned int edx = registers[3];
+
+    if (edx & (1u << 26))
+    {
+        features |= BOXING_CPU_FEATURE_SSE2;
+    }
+    if (ecx & (1u << 9))
+    {
+        features |= BOXING_CPU_FEATURE_SSSE3;
+    }
+    if (ecx & (1u << 19))
+    {
+        features |= BOXING_CPU_FEATURE_SSE41;
+    }
+    if (ecx & (1u << 1))
+    {
+        features |= BOXING_CPU_FEATURE_PCLMUL;
+    }
+
+    // AVX2 requires the operating system to save the YMM registers
+    const DBOOL os_saves_ymm = (ecx & (1u << 27)) && (ecx & (1u << 28)) && ((xgetbv() & 6) == 6);
+    if (os_saves_ymm && max_leaf >= 7)
+    {
+        cpuid(7, 0, registers);
+        if (registers[1] & (1u << 5))
+        {
+            features |= BOXING_CPU_FEATURE_AVX2;
+        }
+    }
+
+    return features;
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static unsigned int detect_features(void)
+{
+    unsigned int features = BOXING_CPU_FEATURE_NEON;
+#if defined (__linux__) && defined (__aarch64__) && defined (HWCAP_PMULL)
+    if (getauxval(AT_HWCAP) & HWCAP_PMULL)
+    {
+        features |= BOXING_CPU_FEATURE_PMULL;
+    }
+#elif defined (__APPLE__) || defined (_M_ARM64)
+    features |= BOXING_CPU_FEATURE_PMULL;
+#endif
+    return features;
+}
+
+#else
+
+static unsigned int detect_features(void)
+{
+    return 0;
+}
+
+#endif
@@ -16,6 +16,47 @@
 //
 #include "boxing/platform/memory.h"
 
+//  SYSTEM INCLUDES
+//
+#if defined (D_OS_WIN32)
+#   include <windows.h>
+#elif defined (D_OS_LINUX)
+#   include <sys/mman.h>
+#   include <unistd.h>
+#   if defined (__APPLE__)
+#       include <malloc/malloc.h>
+#   elif defined (__GLIBC__)
+#       include <malloc.h>
+#   endif
+#endif
+
+//  DEFINES
+//
+#if defined (_MSC_VER)
+#   define BOXING_MEMORY_THREAD_LOCAL __declspec(thread)
+#elif defined (__GNUC__) || defined (__clang__)
+#   define BOXING_MEMORY_THREAD_LOCAL __thread
+#else
+#   define BOXING_MEMORY_THREAD_LOCAL
+#endif
+
+//  PRIVATE INTERFACE
+//
+
+typedef struct memory_statistics_s
+{
+    int          depth;
+    boxing_int64 current;
+    boxing_int64 peak;
+} memory_statistics;
+
+// Allocation statistics of the calling thread, only updated inside a memory scope
+static BOXING_MEMORY_THREAD_LOCAL memory_statistics statistics;
+
+static size_t allocation_size(void * pointer, size_t requested_size);
+static void   record_allocation(void * pointer, size_t requested_size);
+static void   record_free(void * pointer);
+
 
 /*! 
   * \addtogroup platform
@@ -93,7 +134,12 @@
 
 void * boxing_memory_allocate(size_t size)
 {
-    return malloc(size);
+    void * buffer = malloc(size);
+    if (statistics.depth)
+    {
+        record_allocation(buffer, size);
+    }
+    return buffer;
 }
 
 
@@ -110,6 +156,40 @@ void * boxing_memory_allocate_and_clear( size_t size )
 {
     void* buffer = malloc( size );
     memset( buffer, 0, size );
+    if (statistics.depth)
+    {
+        record_allocation(buffer, size);
+    }
+    return buffer;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Changes the size of a buffer of continious memory.
+ *
+ *  Changes the size of a buffer allocated with boxing_memory_allocate, the
+ *  content is kept up to the smaller of the old and new sizes. A NULL
+ *  pointer allocates a new buffer.
+ *
+ *  \param[in]  pointer_to_memory  A pointer to the buffer, may be NULL.
+ *  \param[in]  size               New size of the buffer in bytes.
+ */
+
+void * boxing_memory_reallocate(void * pointer_to_memory, size_t size)
+{
+    if (!statistics.depth)
+    {
+        return realloc(pointer_to_memory, size);
+    }
+
+    const size_t old_size = pointer_to_memory ? allocation_size(pointer_to_memory, 0) : 0;
+    void * buffer = realloc(pointer_to_memory, size);
+    if (buffer != NULL || size == 0)
+    {
+        statistics.current -= old_size;
+        record_allocation(buffer, size);
+    }
     return buffer;
 }
 
@@ -127,6 +207,10 @@ void boxing_memory_free(void * pointer_to_memory)
 {
     if (pointer_to_memory != NULL)
     {
+        if (statistics.depth)
+        {
+            record_free(pointer_to_memory);
+        }
         free(pointer_to_memory);
     }
 }
@@ -171,7 +255,201 @@ void boxing_memory_copy(void * pointer_to_memory_destination, const void * point
 }
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Maps a zero filled temporary file into memory.
+ *
+ *  Creates a temporary file in the given directory and maps it into memory,
+ *  so large buffers do not have to be resident. The file is removed when it
+ *  is unmapped with boxing_memory_unmap_temporary_file or when the process
+ *  ends. Returns NULL if the file could not be created or mapped.
+ *
+ *  \param[in]  directory      Directory of the temporary file.
+ *  \param[in]  size_in_bytes  Size of the mapped memory.
+ */
+
+void * boxing_memory_map_temporary_file(const char * directory, size_t size_in_bytes)
+{
+    if (directory == NULL || size_in_bytes == 0)
+    {
+        return NULL;
+    }
+
+#if defined (D_OS_WIN32)
+    char path[MAX_PATH];
+    if (GetTempFileNameA(directory, "box", 0, path) == 0)
+    {
+        return NULL;
+    }
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        DeleteFileA(path);
+        return NULL;
+    }
+    ULARGE_INTEGER size;
+    size.QuadPart = size_in_bytes;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+    void * pointer = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_in_bytes) : NULL;
+    // The view keeps the file open until it is unmapped
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return pointer;
+#elif defined (D_OS_LINUX)
+    size_t length = strlen(directory);
+    char * path = (char *)malloc(length + sizeof("/boxing_XXXXXX"));
+    memcpy(path, directory, length);
+    memcpy(path + length, "/boxing_XXXXXX", sizeof("/boxing_XXXXXX"));
+    int file = mkstemp(path);
+    if (file == -1)
+    {
+        free(path);
+        return NULL;
+    }
+    // The file is removed when the last reference to it, the mapping, is gone
+    unlink(path);
+    free(path);
+    void * pointer = NULL;
+    if (ftruncate(file, (off_t)size_in_bytes) == 0)
+    {
+        pointer = mmap(NULL, size_in_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (pointer == MAP_FAILED)
+        {
+            pointer = NULL;
+        }
+    }
+    close(file);
+    return pointer;
+#else
+    return NULL;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Unmaps memory mapped with boxing_memory_map_temporary_file.
+ *
+ *  Unmaps the memory and removes the temporary file.
+ *
+ *  \param[in]  pointer_to_memory  A pointer to the mapped memory.
+ *  \param[in]  size_in_bytes      Size of the mapped memory.
+ */
+
+void boxing_memory_unmap_temporary_file(void * pointer_to_memory, size_t size_in_bytes)
+{
+    if (pointer_to_memory == NULL)
+    {
+        return;
+    }
+
+#if defined (D_OS_WIN32)
+    (void)size_in_bytes;
+    UnmapViewOfFile(pointer_to_memory);
+#elif defined (D_OS_LINUX)
+    munmap(pointer_to_memory, size_in_bytes);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Starts measuring heap usage.
+ *
+ *  Starts counting the memory allocated and freed through the boxing memory
+ *  functions on the calling thread. Scopes may be nested, each scope measures
+ *  its own peak. Allocations made by other threads are not included.
+ *
+ *  \param[out] scope  Scope state, passed to boxing_memory_scope_end.
+ */
+
+void boxing_memory_scope_begin(boxing_memory_scope * scope)
+{
+    statistics.depth++;
+    scope->base = statistics.current;
+    scope->outer_peak = statistics.peak;
+    statistics.peak = statistics.current;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Ends measuring heap usage.
+ *
+ *  Returns the peak amount of memory held above the level at the start of
+ *  the scope. On platforms where the size of an allocation can not be
+ *  queried, freed memory is not subtracted and the cumulative amount of
+ *  allocated memory is returned.
+ *
+ *  \param[in]  scope  Scope state from boxing_memory_scope_begin.
+ *  \return Peak allocation in bytes.
+ */
+
+size_t boxing_memory_scope_end(boxing_memory_scope * scope)
+{
+    const boxing_int64 peak = statistics.peak - scope->base;
+    if (scope->outer_peak > statistics.peak)
+    {
+        statistics.peak = scope->outer_peak;
+    }
+
+    if (--statistics.depth == 0)
+    {
+        statistics.current = 0;
+        statistics.peak = 0;
+    }
+
+    return peak > 0 ? (size_t)peak : 0;
+}
+
+
 //----------------------------------------------------------------------------
 /*!
   * \} end of platform group
   */
+
+
+// PRIVATE MEMORY FUNCTIONS
+//
+
+static size_t allocation_size(void * pointer, size_t requested_size)
+{
+#if defined (D_OS_WIN32)
+    (void)requested_size;
+    return _msize(pointer);
+#elif defined (__APPLE__)
+    (void)requested_size;
+    return malloc_size(pointer);
+#elif defined (__GLIBC__)
+    (void)requested_size;
+    return malloc_usable_size(pointer);
+#else
+    // The size is unknown on free, so only allocations are counted
+    return pointer ? requested_size : 0;
+#endif
+}
+
+
+static void record_allocation(void * pointer, size_t requested_size)
+{
+    if (pointer == NULL)
+    {
+        return;
+    }
+
+    statistics.current += allocation_size(pointer, requested_size);
+    if (statistics.current > statistics.peak)
+    {
+        statistics.peak = statistics.current;
+    }
+}
+
+
+static void record_free(void * pointer)
+{
+    statistics.current -= allocation_size(pointer, 0);
+}
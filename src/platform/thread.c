@@ -0,0 +1,570 @@
+/*****************************************************************************
+**
+**  Implementation of the thread interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "boxing/platform/thread.h"
+#include "boxing/platform/memory.h"
+#include "boxing/utils.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (D_OS_WIN32)
+#   define  BOXING_THREADS_WIN32
+#   include <windows.h>
+#elif defined (D_OS_LINUX)
+#   define  BOXING_THREADS_POSIX
+#   include <pthread.h>
+#   include <unistd.h>
+#endif
+
+//  DEFINES
+//
+#if defined (__GNUC__) || defined (__clang__)
+#   define BOXING_THREAD_LOCAL __thread
+#else
+#   define BOXING_THREAD_LOCAL
+#endif
+
+//  PRIVATE INTERFACE
+//
+
+struct boxing_thread_s
+{
+#if defined (BOXING_THREADS_WIN32)
+    HANDLE                  handle;
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_t               handle;
+#endif
+    boxing_thread_function  function;
+    void *                  user;
+};
+
+struct boxing_mutex_s
+{
+#if defined (BOXING_THREADS_WIN32)
+    CRITICAL_SECTION        section;
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_mutex_t         mutex;
+#else
+    int                     unused;
+#endif
+};
+
+struct boxing_condition_s
+{
+#if defined (BOXING_THREADS_WIN32)
+    CONDITION_VARIABLE      condition;
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_cond_t          condition;
+#else
+    int                     unused;
+#endif
+};
+
+typedef struct boxing_parallel_job_s
+{
+    boxing_parallel_function function;
+    void *                   user;
+    int                      count;
+    int                      next;
+    boxing_mutex *           mutex;
+} boxing_parallel_job;
+
+typedef struct once_call_s
+{
+    boxing_once_function     function;
+    void *                   user;
+} once_call;
+
+#if defined (BOXING_THREADS_POSIX)
+static BOXING_THREAD_LOCAL once_call * current_once_call = NULL;
+#endif
+
+#if defined (BOXING_THREADS_WIN32)
+static DWORD WINAPI thread_entry(LPVOID parameter)
+{
+    boxing_thread * thread = (boxing_thread *)parameter;
+    thread->function(thread->user);
+    return 0;
+}
+#elif defined (BOXING_THREADS_POSIX)
+static void * thread_entry(void * parameter)
+{
+    boxing_thread * thread = (boxing_thread *)parameter;
+    thread->function(thread->user);
+    return NULL;
+}
+#endif
+
+#if defined (BOXING_THREADS_WIN32)
+static BOOL CALLBACK once_callback(PINIT_ONCE init_once, PVOID parameter, PVOID * context)
+{
+    BOXING_UNUSED_PARAMETER(init_once);
+    BOXING_UNUSED_PARAMETER(context);
+    once_call * call = (once_call *)parameter;
+    call->function(call->user);
+    return TRUE;
+}
+#elif defined (BOXING_THREADS_POSIX)
+static void once_callback(void)
+{
+    current_once_call->function(current_once_call->user);
+}
+#endif
+
+static void parallel_worker(void * user);
+
+
+/*!
+  * \addtogroup platform
+  * \{
+  */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \typedef void (*boxing_thread_function)(void * user)
+ *  \brief Thread entry function.
+ *
+ *  \param[in]  user  User data given to boxing_thread_create.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \typedef void (*boxing_parallel_function)(void * user, int index)
+ *  \brief Parallel loop body.
+ *
+ *  \param[in]  user   User data given to boxing_thread_parallel_for.
+ *  \param[in]  index  Job index in the range [0, count).
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \typedef void (*boxing_once_function)(void * user)
+ *  \brief One time initialization function.
+ *
+ *  \param[in]  user  User data given to boxing_thread_once.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Start a new thread.
+ *
+ *  Start a new thread running the given function. The thread must be
+ *  released with boxing_thread_join. On platforms without thread support
+ *  NULL is returned and the caller is expected to run the function itself.
+ *
+ *  \param[in]  function  Thread function.
+ *  \param[in]  user      User data passed to the thread function.
+ *  \return Thread instance or NULL if no thread could be started.
+ */
+
+boxing_thread * boxing_thread_create(boxing_thread_function function, void * user)
+{
+#if defined (BOXING_THREADS_WIN32) || defined (BOXING_THREADS_POSIX)
+    boxing_thread * thread = BOXING_MEMORY_ALLOCATE_TYPE(boxing_thread);
+    if (thread == NULL)
+    {
+        return NULL;
+    }
+    thread->function = function;
+    thread->user = user;
+#   if defined (BOXING_THREADS_WIN32)
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    if (thread->handle == NULL)
+#   else
+    if (pthread_create(&thread->handle, NULL, thread_entry, thread) != 0)
+#   endif
+    {
+        boxing_memory_free(thread);
+        return NULL;
+    }
+    return thread;
+#else
+    BOXING_UNUSED_PARAMETER(function);
+    BOXING_UNUSED_PARAMETER(user);
+    return NULL;
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Wait for thread to finish.
+ *
+ *  Block until the thread function returns, then release the thread.
+ *
+ *  \param[in]  thread  Thread instance.
+ */
+
+void boxing_thread_join(boxing_thread * thread)
+{
+    if (thread == NULL)
+    {
+        return;
+    }
+#if defined (BOXING_THREADS_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_join(thread->handle, NULL);
+#endif
+    boxing_memory_free(thread);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Number of hardware threads.
+ *
+ *  \return Number of logical processors available, at least 1.
+ */
+
+int boxing_thread_hardware_concurrency(void)
+{
+    int count = 1;
+#if defined (BOXING_THREADS_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (int)info.dwNumberOfProcessors;
+#elif defined (BOXING_THREADS_POSIX) && defined (_SC_NPROCESSORS_ONLN)
+    count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count < 1 ? 1 : count;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Resolve a requested thread count.
+ *
+ *  A thread count less than 1 selects the number of hardware threads. The
+ *  result is never larger than the number of jobs and never less than 1.
+ *
+ *  \param[in]  thread_count  Requested number of threads.
+ *  \param[in]  job_count     Number of independent jobs.
+ *  \return Number of threads to use.
+ */
+
+int boxing_thread_resolve_count(int thread_count, int job_count)
+{
+    if (thread_count < 1)
+    {
+        thread_count = boxing_thread_hardware_concurrency();
+    }
+    if (thread_count > job_count)
+    {
+        thread_count = job_count;
+    }
+    return thread_count < 1 ? 1 : thread_count;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Run loop body in parallel.
+ *
+ *  Call function(user, index) for every index in [0, count) using up to
+ *  thread_count threads, including the calling thread. Jobs are handed out
+ *  in increasing index order. The function returns when all jobs are done.
+ *
+ *  \param[in]  count         Number of jobs.
+ *  \param[in]  thread_count  Number of threads, less than 1 uses all hardware threads.
+ *  \param[in]  function      Loop body.
+ *  \param[in]  user          User data passed to the loop body.
+ */
+
+void boxing_thread_parallel_for(int count, int thread_count, boxing_parallel_function function, void * user)
+{
+    thread_count = boxing_thread_resolve_count(thread_count, count);
+
+    if (thread_count <= 1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            function(user, i);
+        }
+        return;
+    }
+
+    boxing_parallel_job job;
+    job.function = function;
+    job.user = user;
+    job.count = count;
+    job.next = 0;
+    job.mutex = boxing_mutex_create();
+
+    boxing_thread ** threads = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_thread *, thread_count - 1);
+    for (int i = 0; i < thread_count - 1; i++)
+    {
+        threads[i] = boxing_thread_create(parallel_worker, &job);
+    }
+
+    parallel_worker(&job);
+
+    for (int i = 0; i < thread_count - 1; i++)
+    {
+        boxing_thread_join(threads[i]);
+    }
+    boxing_memory_free(threads);
+    boxing_mutex_free(job.mutex);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Run initialization once.
+ *
+ *  Call function(user) the first time the guard is used. Other threads
+ *  using the same guard wait until the function has returned, so data it
+ *  initializes can be read without further locking. The guard must be a
+ *  static variable initialized with BOXING_THREAD_ONCE_INIT.
+ *
+ *  \param[in]  once      One time initialization guard.
+ *  \param[in]  function  Initialization function.
+ *  \param[in]  user      User data passed to the initialization function.
+ */
+
+void boxing_thread_once(boxing_once * once, boxing_once_function function, void * user)
+{
+#if defined (BOXING_THREADS_WIN32)
+    once_call call = { function, user };
+    InitOnceExecuteOnce((PINIT_ONCE)&once->once, once_callback, &call, NULL);
+#elif defined (BOXING_THREADS_POSIX)
+    // pthread_once runs the initialization on the calling thread, which
+    // passes the call to once_callback in a thread local variable
+    once_call call = { function, user };
+    once_call * previous = current_once_call;
+    current_once_call = &call;
+    pthread_once(&once->once, once_callback);
+    current_once_call = previous;
+#else
+    if (!once->done)
+    {
+        function(user);
+        once->done = 1;
+    }
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Create mutex.
+ *
+ *  \return Mutex instance.
+ */
+
+boxing_mutex * boxing_mutex_create(void)
+{
+    boxing_mutex * mutex = BOXING_MEMORY_ALLOCATE_TYPE(boxing_mutex);
+#if defined (BOXING_THREADS_WIN32)
+    InitializeCriticalSection(&mutex->section);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_mutex_init(&mutex->mutex, NULL);
+#endif
+    return mutex;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Free mutex.
+ *
+ *  \param[in]  mutex  Mutex instance.
+ */
+
+void boxing_mutex_free(boxing_mutex * mutex)
+{
+    if (mutex == NULL)
+    {
+        return;
+    }
+#if defined (BOXING_THREADS_WIN32)
+    DeleteCriticalSection(&mutex->section);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_mutex_destroy(&mutex->mutex);
+#endif
+    boxing_memory_free(mutex);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Lock mutex.
+ *
+ *  \param[in]  mutex  Mutex instance.
+ */
+
+void boxing_mutex_lock(boxing_mutex * mutex)
+{
+#if defined (BOXING_THREADS_WIN32)
+    EnterCriticalSection(&mutex->section);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_mutex_lock(&mutex->mutex);
+#else
+    BOXING_UNUSED_PARAMETER(mutex);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Unlock mutex.
+ *
+ *  \param[in]  mutex  Mutex instance.
+ */
+
+void boxing_mutex_unlock(boxing_mutex * mutex)
+{
+#if defined (BOXING_THREADS_WIN32)
+    LeaveCriticalSection(&mutex->section);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_mutex_unlock(&mutex->mutex);
+#else
+    BOXING_UNUSED_PARAMETER(mutex);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Create condition variable.
+ *
+ *  \return Condition variable instance.
+ */
+
+boxing_condition * boxing_condition_create(void)
+{
+    boxing_condition * condition = BOXING_MEMORY_ALLOCATE_TYPE(boxing_condition);
+#if defined (BOXING_THREADS_WIN32)
+    InitializeConditionVariable(&condition->condition);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_cond_init(&condition->condition, NULL);
+#endif
+    return condition;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Free condition variable.
+ *
+ *  \param[in]  condition  Condition variable instance.
+ */
+
+void boxing_condition_free(boxing_condition * condition)
+{
+    if (condition == NULL)
+    {
+        return;
+    }
+#if defined (BOXING_THREADS_POSIX)
+    pthread_cond_destroy(&condition->condition);
+#endif
+    boxing_memory_free(condition);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Wait on condition variable.
+ *
+ *  Atomically release the mutex and wait until the condition is signalled.
+ *  The mutex is locked again when the function returns.
+ *
+ *  \param[in]  condition  Condition variable instance.
+ *  \param[in]  mutex      Locked mutex.
+ */
+
+void boxing_condition_wait(boxing_condition * condition, boxing_mutex * mutex)
+{
+#if defined (BOXING_THREADS_WIN32)
+    SleepConditionVariableCS(&condition->condition, &mutex->section, INFINITE);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_cond_wait(&condition->condition, &mutex->mutex);
+#else
+    BOXING_UNUSED_PARAMETER(condition);
+    BOXING_UNUSED_PARAMETER(mutex);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Wake one thread waiting on the condition variable.
+ *
+ *  \param[in]  condition  Condition variable instance.
+ */
+
+void boxing_condition_signal(boxing_condition * condition)
+{
+#if defined (BOXING_THREADS_WIN32)
+    WakeConditionVariable(&condition->condition);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_cond_signal(&condition->condition);
+#else
+    BOXING_UNUSED_PARAMETER(condition);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Wake all threads waiting on the condition variable.
+ *
+ *  \param[in]  condition  Condition variable instance.
+ */
+
+void boxing_condition_broadcast(boxing_condition * condition)
+{
+#if defined (BOXING_THREADS_WIN32)
+    WakeAllConditionVariable(&condition->condition);
+#elif defined (BOXING_THREADS_POSIX)
+    pthread_cond_broadcast(&condition->condition);
+#else
+    BOXING_UNUSED_PARAMETER(condition);
+#endif
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of platform group
+  */
+
+
+// PRIVATE THREAD FUNCTIONS
+//
+
+static void parallel_worker(void * user)
+{
+    boxing_parallel_job * job = (boxing_parallel_job *)user;
+    for (;;)
+    {
+        boxing_mutex_lock(job->mutex);
+        int index = job->next++;
+        boxing_mutex_unlock(job->mutex);
+
+        if (index >= job->count)
+        {
+            break;
+        }
+        job->function(job->user, index);
+    }
+}
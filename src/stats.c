@@ -12,6 +12,11 @@
 **
 *****************************************************************************/
 
+//  PROJECT INCLUDES
+//
+#include "boxing/stats.h"
+#include "boxing/platform/clock.h"
+
 
 /*! 
   * \addtogroup unbox
@@ -28,6 +33,9 @@
  *  \param unresolved_errors       Number of unresolver boxing errors.
  *  \param fec_accumulated_amount  FEC accumulated amount.
  *  \param fec_accumulated_weight  FEC accumulated weight.
+ *  \param decoded_codewords       Number of codewords of iterative decoders.
+ *  \param decode_iterations       Decoding iterations of all the codewords.
+ *  \param max_decode_iterations   Most decoding iterations of a codeword.
  *
  *  The struct with statistic information about boxing process.
  */
@@ -63,8 +71,54 @@
 
 //----------------------------------------------------------------------------
 /*!
-  * \} end of unbox group
-  */
+ *  \struct  boxing_stats_stage_s  stats.h
+ *  \brief   Resource usage of one processing stage.
+ *
+ *  \param name             Stage name, or codec name for decoding steps.
+ *  \param coding_scheme    Coding scheme of decoding steps, NULL for image processing stages.
+ *  \param step             Decoding step, -1 for image processing stages.
+ *  \param time             Wall time in milliseconds.
+ *  \param peak_allocation  Peak heap memory held by the stage in bytes.
+ */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Starts measuring a stage.
+ *
+ *  Records the start time and starts counting heap allocations made on the
+ *  calling thread. Every call must be paired with boxing_stats_stage_end,
+ *  stages may be nested.
+ *
+ *  \param[out] timer  Stage timer.
+ */
+
+void boxing_stats_stage_begin(boxing_stats_stage_timer * timer)
+{
+    boxing_memory_scope_begin(&timer->memory);
+    timer->start = boxing_clock_milliseconds();
+}
 
 
-typedef int remove_iso_compilers_warning; // Unused type definition to avoid warnings - ISO C requires a translation unit to contain at least one declaration
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Ends measuring a stage.
+ *
+ *  Sets the time and peak_allocation members of the stage, the other members
+ *  are left to the caller.
+ *
+ *  \param[in]  timer  Stage timer started with boxing_stats_stage_begin.
+ *  \param[out] stage  Stage statistics.
+ */
+
+void boxing_stats_stage_end(boxing_stats_stage_timer * timer, boxing_stats_stage * stage)
+{
+    stage->time = boxing_clock_milliseconds() - timer->start;
+    stage->peak_allocation = boxing_memory_scope_end(&timer->memory);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of unbox group
+  */
@@ -19,6 +19,7 @@
 #include    "boxing/graphics/genericframe.h"
 #include    "boxing/unboxer/abstractframeutil.h"
 #include    "unboxerv1.h"
+#include    "datapoints.h"
 #include    "boxing/platform/memory.h"
 #include    "boxing/bool.h"
 #include    "boxing/utils.h"
@@ -238,6 +239,24 @@
  */
 
 
+/*! 
+ *  \typedef gvector * (*boxing_sample_quantize_cb)(void * user, const boxing_image8 * frame, const boxing_matrixf * location_matrix, int block_width, int block_height, int bins, gvector * erasures)
+ *  \brief Boxing fused sample and quantize callback function.
+ *
+ *  \param[in,out]  user             User data.
+ *  \param[in]      frame            Frame.
+ *  \param[in]      location_matrix  Location matrix.
+ *  \param[in]      block_width      Block width.
+ *  \param[in]      block_height     Block height.
+ *  \param[in]      bins             Bins.
+ *  \param[out]     erasures         Unreliability of each datapoint, may be left empty.
+ *
+ *  Replaces both content sampling and quantizing. Returns the bin of each
+ *  datapoint without creating a sampled image. boxing_unboxer_sample_quantize
+ *  is the library implementation.
+ */
+
+
 /*! 
  *  \typedef int (*boxing_tracker_created_cb)(void * user, int * res, boxing_tracker * tracker)
  *  \brief Boxing tracker created callback function.
@@ -367,11 +386,27 @@
  *                                    images to be unboxed. Default filter function is used 
  *                                    if set to NULL. Provide a direct assignemement function 
  *                                    (i.e. destination = source) if you want to skip 
- *                                    filtering.
+ *                                    filtering. The default filter function uses float
+ *                                    arithmetic unless the precision of the filter is
+ *                                    set to BOXING_FILTER_PRECISION_FIXED_POINT.
  *  \param decoding_filters           Codec decoding functions.
  *  \param sample_contents            Boxing sample function.
  *  \param quantize_contents          Boxing quantize function.
- *  \param on_tracker_created         Boxing tracker created callback function.
+ *  \param sample_quantize_contents   Fused sample and quantize function, replaces both
+ *                                    sample_contents and quantize_contents for digital
+ *                                    content. No sampled image exists, so on_content_sampled
+ *                                    is not called. Default is NULL, sampling and quantizing
+ *                                    are done separately.
+ *  \param thread_count               Number of worker threads used for image processing
+ *                                    and by the codecs decoding in parallel. Default is
+ *                                    1 (calling thread only), a value less than 1 uses
+ *                                    all available cores.
+ *  \param pipeline_queue_depth       Maximum number of extracted frames waiting to be
+ *                                    decoded in boxing_unboxer_unbox_batch. Default is 0,
+ *                                    all frames are extracted before decoding starts.
+ *  \param on_tracker_created         Boxing tracker created callback function. The tracker
+ *                                    is kept for the following frames, so the callback is
+ *                                    called once per unboxer and worker thread.
  *  \param on_content_sampled         Boxing content sampled callback function.
  *  \param on_content_quantized       Boxing content quantized callback function.
  *  \param on_metadata_complete       Boxing metadata complete callback function.
@@ -380,6 +415,9 @@
  *  \param on_training_complete       Boxing training complete callback function.
  *  \param on_decode_step             Boxing decode step callback function.
  *  \param on_all_complete            Boxing all complete callback function.
+ *  \param on_stage_timing            Receives the wall time and peak heap allocation of
+ *                                    each image processing stage and decoding step.
+ *                                    Instrumentation is disabled when NULL.
  *  \param orig_image                 Original image.
  *
  *  Configure unboxer. Note that the callback interface is only avaliable if  
@@ -406,6 +444,20 @@
  *  Codec information.
  */
 
+
+//----------------------------------------------------------------------------
+/*!
+ *  \struct  boxing_unboxer_frame_s  unboxer.h 
+ *  \brief   Frame in a batch decoded by boxing_unboxer_unbox_batch.
+ *
+ *  \param image           Input image.
+ *  \param data            Decoded data.
+ *  \param metadata        Decoded metadata.
+ *  \param extract_result  Result from data extraction phase of unboxing.
+ *  \param result          Unboxing status code.
+ *  \param user_data       User data given to the callbacks.
+ */
+
 // PUBLIC UNBOXER FUNCTIONS
 //
 
@@ -458,12 +510,20 @@ boxing_unboxer * boxing_unboxer_create(boxing_unboxer_parameters * parameters)
     unboxer->metadata_codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(unboxer->frame, metadata_container, capasity),
                                         BOXING_CODEC_MODULATION_PAM2, unboxer->parameters.format, "MetadataCodingScheme");
     boxing_codecdispatcher_callback_setup(unboxer->metadata_codec, unboxer->parameters.codec_cb);
+#ifdef BOXINGLIB_CALLBACK
+    unboxer->metadata_codec->on_decode_stage = unboxer->parameters.on_stage_timing;
+#endif
 
     int levels_per_symbol = unboxer->frame->levels_per_symbol(unboxer->frame);
 
     unboxer->codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(unboxer->frame, container, capasity), levels_per_symbol, unboxer->parameters.format, "DataCodingScheme");
     boxing_codecdispatcher_callback_setup(unboxer->codec, unboxer->parameters.codec_cb);
     boxing_codecdispatcher_reset(unboxer->codec);
+
+    // The codecs decoding in parallel, e.g. LDPC and 2DPAM, use the threads of the unboxer
+    g_variant * thread_count = g_variant_create_int(unboxer->parameters.thread_count);
+    boxing_codecdispatcher_set_property(unboxer->codec, PARAM_NAME_THREAD_COUNT, thread_count);
+    g_variant_free(thread_count);
     return (boxing_unboxer *)unboxer;
 }
 
@@ -649,6 +709,38 @@ enum boxing_unboxer_result boxing_unboxer_unbox(gvector * data, boxing_metadata_
 }
 
 
+//---------------------------------------------------------------------------- 
+/*! \brief Decode several images
+ * 
+ *  Decode a sequence of images. The extraction phase is run in parallel on
+ *  worker_count threads, each thread using its own unboxer context. The
+ *  decoding phase is run on the calling thread in the order of the frames,
+ *  so the result of each frame is identical to calling boxing_unboxer_unbox
+ *  for the frames one by one. Callbacks given in the unboxer parameters may
+ *  be called from the worker threads during extraction.
+ *
+ *  If pipeline_queue_depth is set in the unboxer parameters, decoding of a
+ *  frame overlaps with the extraction of the following frames. The worker
+ *  threads wait while pipeline_queue_depth frames are extracted and not yet
+ *  decoded.
+ *
+ *  \param[in,out] frames        Frames to decode. The image, data, metadata and
+ *                               user_data members are input, extract_result and
+ *                               result are set for every frame.
+ *  \param[in]     frame_count   Number of frames.
+ *  \param[in]     unboxer       Unboxer structure.
+ *  \param[in]     worker_count  Number of extraction threads, a value less than
+ *                               1 uses all available cores.
+ *  \return     Unboxing status code of the first frame that failed, or
+ *              BOXING_UNBOXER_OK if all frames were decoded.
+ */
+
+enum boxing_unboxer_result boxing_unboxer_unbox_batch(boxing_unboxer_frame * frames, int frame_count, boxing_unboxer * unboxer, int worker_count)
+{
+    return (enum boxing_unboxer_result)boxing_dunboxerv1_process_batch((boxing_dunboxerv1 *)unboxer, frames, frame_count, worker_count);
+}
+
+
 //---------------------------------------------------------------------------- 
 /*! \brief Dispatcher function.
  * 
@@ -666,6 +758,32 @@ boxing_codecdispatcher *  boxing_unboxer_dispatcher(boxing_unboxer * unboxer, co
 }
 
 
+//---------------------------------------------------------------------------- 
+/*! \brief Sample and quantize content.
+ * 
+ *  Library implementation of the boxing_sample_quantize_cb callback. Samples the
+ *  datapoints with the 2 polinomial sampler and maps them straight to their bins,
+ *  without creating a sampled image. The thresholds of each block are estimated
+ *  from every second datapoint in both directions.
+ *
+ *  \param[in]  user             User data, not used.
+ *  \param[in]  frame            Frame.
+ *  \param[in]  location_matrix  Location of each datapoint in the frame.
+ *  \param[in]  block_width      Block width in datapoints.
+ *  \param[in]  block_height     Block height in datapoints.
+ *  \param[in]  bins             Number of symbols per datapoint.
+ *  \param[out] erasures         Unreliability of each datapoint, ignored if NULL.
+ *  \return  Bin of each datapoint.
+ */
+
+gvector * boxing_unboxer_sample_quantize(void * user, const boxing_image8 * frame, const boxing_matrixf * location_matrix,
+                                         int block_width, int block_height, int bins, gvector * erasures)
+{
+    BOXING_UNUSED_PARAMETER(user);
+    return boxing_datapoints_sample_quantize(frame, location_matrix, block_width, block_height, bins, 2, erasures);
+}
+
+
 //---------------------------------------------------------------------------- 
 /*! \brief Initialize unboxer parameters
  * 
@@ -686,6 +804,7 @@ void boxing_unboxer_parameters_init(boxing_unboxer_parameters * parameters)
     parameters->on_training_complete = NULL;
     parameters->on_decode_step = NULL;
     parameters->on_all_complete = NULL;
+    parameters->on_stage_timing = NULL;
     parameters->orig_image = NULL;
 #endif
     parameters->format = NULL;
@@ -695,6 +814,9 @@ void boxing_unboxer_parameters_init(boxing_unboxer_parameters * parameters)
     parameters->training_result = NULL;
     parameters->sample_contents = NULL;
     parameters->quantize_contents = NULL;
+    parameters->sample_quantize_contents = NULL;
+    parameters->thread_count = 1;
+    parameters->pipeline_queue_depth = 0;
     boxing_filter_init( &parameters->pre_filter );
 }
 
@@ -16,11 +16,64 @@
 //
 #include "datapoints.h"
 #include "horizontalmeasures.h"
+#include "boxing/frame/2polinomialsampler.h"
+#include "boxing/platform/memory.h"
+#include "boxing/platform/cpu.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
+
+//  DEFINES
+//
+
+#define SAMPLE_QUANTIZE_HISTOGRAM_SIZE 256
+#define QUANTIZE_TABLE_SIZE            256
+
+// Lookup tables mapping the gray levels of a block to bins and unreliability.
+// The bin table is a step function, edges holds the gray level of each step.
+typedef struct block_tables_s
+{
+    unsigned char bins[QUANTIZE_TABLE_SIZE];
+    unsigned char erasures[QUANTIZE_TABLE_SIZE];
+    unsigned char edges[QUANTIZE_TABLE_SIZE];
+    int           edge_count;
+} block_tables;
+
+// Packs bins into bytes the way the Modulator codec does
+typedef struct symbol_packer_s
+{
+    int             bits_per_symbol;
+    unsigned char * data;
+    unsigned char * erasures;
+    unsigned int    value;
+    unsigned char   erasure;
+    int             symbols;
+} symbol_packer;
+
+// Maps the leading pixels of a span to bins with SIMD, returns the number of
+// pixels mapped. The remaining pixels are mapped by the portable code.
+typedef int (*quantize_span_kernel)(const boxing_image8_pixel * pixels, int count, const unsigned char * edges, int edge_count, unsigned char * bins);
 
 //  PRIVATE INTERFACE
 //
 
-static int quantisize(const boxing_float * threshold, int threshold_size, int value);
+static int            quantisize(const boxing_float * threshold, int threshold_size, int value);
+static boxing_float   threshold_spacing(const boxing_float * threshold, int threshold_size);
+static unsigned char  unreliability(const boxing_float * threshold, int threshold_size, boxing_float spacing, int value, int bin);
+static gvector *      quantize(const boxing_image8 * image, int block_width, int block_height, int bins, gvector * erasures, int thread_count, int bits_per_symbol);
+static void           sample_thresholds(const boxing_image8 * frame, const boxing_matrixf * location_matrix, int block_width, int block_height,
+                          int sample_step, int threshold_count, boxing_float * thresholds, boxing_image8_pixel * line);
+static void           build_block_tables(const boxing_float * threshold, int threshold_size, block_tables * tables, DBOOL with_erasures);
+static void           quantize_line(quantize_span_kernel kernel, const boxing_image8_pixel * pixels, int count, int block_width,
+                          const block_tables * tables, unsigned char * bins, unsigned char * erasures);
+static void           pack_symbols(symbol_packer * packer, const unsigned char * bins, const unsigned char * erasures, int count);
+static void           pack_flush(symbol_packer * packer);
+static quantize_span_kernel select_quantize_span_kernel(void);
 
 // PUBLIC DATA POINTS FUNCTIONS
 //
@@ -50,29 +103,131 @@ static int quantisize(const boxing_float * threshold, int threshold_size, int va
 
 gvector * boxing_datapoints_quantize(const boxing_image8 * image, int block_width, int block_height, int bins)
 {
-    // theshold is a (cluster_count-1) x M x N matrix
-    boxing_matrix_float * thresholds = boxing_calculate_thresholds(image, block_width, block_height, bins);
+    return quantize(image, block_width, block_height, bins, NULL, 1, 0);
+}
 
-    gvector * data = gvector_create(1, image->width * image->height);
 
-    boxing_pointi block_size = { (int)ceilf(image->width / (boxing_float)thresholds->rows), (int)ceilf(image->height / (boxing_float)thresholds->pages) };
-    int width = image->width;
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Quantize datapoints and estimate their reliability.
+ *
+ *  Same as boxing_datapoints_quantize, but also returns an unreliability value for each datapoint.
+ *  A datapoint closer to a threshold than half the average distance between the thresholds of its block
+ *  gets an unreliability growing linearly from 0 to 255 as it approaches the threshold.
+ *  The values are used as erasure information by the decoders.
+ *
+ *  \param[in]  image           Image to be analysed.
+ *  \param[in]  block_width     Sub image width.
+ *  \param[in]  block_height    Sub image height.
+ *  \param[in]  bins            The number of symols being searched for in the local histograms.
+ *  \param[out] erasures        Unreliability of each datapoint, 0 for reliable datapoints.
+ *  \param[in]  thread_count    Number of worker threads used for the thresholds, less than 1 uses all cores.
+ *  \return The output vector contains the bin index (e.g. 0,1,2,3 for 2bit) , and NOT the actual cluster levels
+ */
+
+gvector * boxing_datapoints_quantize_erasures(const boxing_image8 * image, int block_width, int block_height, int bins, gvector * erasures, int thread_count)
+{
+    return quantize(image, block_width, block_height, bins, erasures, thread_count, 0);
+}
+
 
-    for (unsigned int i = 0; i < image->height; i++)
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Quantize datapoints into packed symbols.
+ *
+ *  Same as boxing_datapoints_quantize_erasures, but the bins are packed into bytes while they are
+ *  quantized, 8 one bit symbols or 4 two bit symbols per byte. The bytes are identical to what the
+ *  Modulator codec decodes from the unpacked bins, and the unreliability of a byte is the highest
+ *  unreliability of its symbols.
+ *
+ *  \param[in]  image           Image to be analysed.
+ *  \param[in]  block_width     Sub image width.
+ *  \param[in]  block_height    Sub image height.
+ *  \param[in]  bins            The number of symols being searched for, 2 or 4.
+ *  \param[out] erasures        Unreliability of each byte, ignored if NULL.
+ *  \param[in]  thread_count    Number of worker threads used for the thresholds, less than 1 uses all cores.
+ *  \return The packed symbols, or NULL if bins is not 2 or 4.
+ */
+
+gvector * boxing_datapoints_quantize_packed(const boxing_image8 * image, int block_width, int block_height, int bins, gvector * erasures, int thread_count)
+{
+    if (bins != 2 && bins != 4)
+    {
+        return NULL;
+    }
+    return quantize(image, block_width, block_height, bins, erasures, thread_count, bins == 2 ? 1 : 2);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Sample and quantize datapoints in one pass.
+ *
+ *  Fused equivalent of sampling the frame with the 2 polinomial sampler followed by
+ *  boxing_datapoints_quantize_erasures. The thresholds of each block are estimated from a sparse
+ *  pre-sample, every sample_step location in both directions, and turned into a lookup table from
+ *  gray level to bin. The datapoints are then sampled one line at a time and mapped straight to
+ *  their bins, so the sampled image is never stored or read back. With a sample_step of 1 the
+ *  result is identical to sampling and quantizing separately.
+ *
+ *  \param[in]  frame            Frame to be sampled.
+ *  \param[in]  location_matrix  Location of each datapoint in the frame.
+ *  \param[in]  block_width      Block width in datapoints.
+ *  \param[in]  block_height     Block height in datapoints.
+ *  \param[in]  bins             The number of symols being searched for in the local histograms.
+ *  \param[in]  sample_step      Distance in datapoints between the locations used to estimate the thresholds.
+ *  \param[out] erasures         Unreliability of each datapoint, ignored if NULL.
+ *  \return The output vector contains the bin index of each datapoint.
+ */
+
+gvector * boxing_datapoints_sample_quantize(const boxing_image8 * frame, const boxing_matrixf * location_matrix, int block_width, int block_height, int bins, int sample_step, gvector * erasures)
+{
+    const int width = location_matrix->width;
+    const int height = location_matrix->height;
+    block_width = BOXING_MATH_MIN(block_width, width);
+    block_height = BOXING_MATH_MIN(block_height, height);
+    sample_step = BOXING_MATH_MAX(sample_step, 1);
+
+    const int horizontal_block_count = (width + block_width - 1) / block_width;
+    const int vertical_block_count = (height + block_height - 1) / block_height;
+    const int threshold_count = bins - 1;
+
+    boxing_image8_pixel * line = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_image8_pixel, width);
+    boxing_float * thresholds = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_float, horizontal_block_count * vertical_block_count * threshold_count);
+    sample_thresholds(frame, location_matrix, block_width, block_height, sample_step, threshold_count, thresholds, line);
+
+    gvector * data = gvector_create(1, width * height);
+    if (erasures)
     {
-        const boxing_image8_pixel* pixel_data = image->data + i * image->width;
-        boxing_image8_pixel *byte_array = (boxing_image8_pixel *)data->buffer + (i*width);
-        const boxing_float * threshold = MATRIX_MULTIPAGE_PAGE_PTR(thresholds, i / block_size.y);
+        gvector_resize(erasures, width * height);
+    }
+    block_tables * tables = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(block_tables, horizontal_block_count);
+    const quantize_span_kernel kernel = select_quantize_span_kernel();
 
-        for (int j = 0; j < width; j++)
+    // Same block layout as boxing_datapoints_quantize
+    boxing_pointi block_size = { (int)ceilf(width / (boxing_float)horizontal_block_count), (int)ceilf(height / (boxing_float)vertical_block_count) };
+    int table_page = -1;
+
+    for (int i = 0; i < height; i++)
+    {
+        const int page = i / block_size.y;
+        if (page != table_page)
         {
-            *byte_array = quantisize(threshold + (j / block_size.x) * thresholds->cols, thresholds->cols, *pixel_data);
-            byte_array++;
-            pixel_data++;
+            for (int m = 0; m < horizontal_block_count; m++)
+            {
+                build_block_tables(thresholds + (page * horizontal_block_count + m) * threshold_count, threshold_count, tables + m, erasures != NULL);
+            }
+            table_page = page;
         }
+
+        boxing_2polinomialsampler_sample_line(frame, MATRIX_ROW(location_matrix, i), width, 1, line);
+        quantize_line(kernel, line, width, block_size.x, tables, (unsigned char *)data->buffer + i * width,
+            erasures ? (unsigned char *)erasures->buffer + i * width : NULL);
     }
-    
-    boxing_matrix_float_free(thresholds);
+
+    boxing_memory_free(tables);
+    boxing_memory_free(thresholds);
+    boxing_memory_free(line);
     return data;
 }
 
@@ -86,6 +241,250 @@ gvector * boxing_datapoints_quantize(const boxing_image8 * image, int block_widt
 // PRIVATE DATA POINTS FUNCTIONS
 //
 
+static gvector * quantize(const boxing_image8 * image, int block_width, int block_height, int bins, gvector * erasures, int thread_count, int bits_per_symbol)
+{
+    // theshold is a (cluster_count-1) x M x N matrix
+    boxing_matrix_float * thresholds = boxing_calculate_thresholds(image, block_width, block_height, bins, thread_count);
+
+    const int width = image->width;
+    const int height = image->height;
+    const int symbol_count = width * height;
+
+    // Packed symbols are quantized one line at a time and packed from the line buffers
+    symbol_packer packer = { bits_per_symbol, NULL, NULL, 0, 0, 0 };
+    unsigned char * line_bins = NULL;
+    unsigned char * line_erasures = NULL;
+    gvector * data;
+    if (bits_per_symbol)
+    {
+        data = gvector_create(1, bits_per_symbol == 1 ? (symbol_count + 7) / 8 : symbol_count / 4);
+        line_bins = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(unsigned char, width);
+        if (erasures)
+        {
+            gvector_resize(erasures, data->size);
+            line_erasures = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(unsigned char, width);
+        }
+        packer.data = (unsigned char *)data->buffer;
+        packer.erasures = erasures ? (unsigned char *)erasures->buffer : NULL;
+    }
+    else
+    {
+        data = gvector_create(1, symbol_count);
+        if (erasures)
+        {
+            gvector_resize(erasures, symbol_count);
+        }
+    }
+
+    block_tables * tables = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(block_tables, thresholds->rows);
+    const quantize_span_kernel kernel = select_quantize_span_kernel();
+
+    boxing_pointi block_size = { (int)ceilf(width / (boxing_float)thresholds->rows), (int)ceilf(height / (boxing_float)thresholds->pages) };
+    int table_page = -1;
+
+    for (int i = 0; i < height; i++)
+    {
+        const int page = i / block_size.y;
+        if (page != table_page)
+        {
+            for (unsigned int m = 0; m < thresholds->rows; m++)
+            {
+                build_block_tables(MATRIX_MULTIPAGE_ROW_PTR(thresholds, m, page), thresholds->cols, tables + m, erasures != NULL);
+            }
+            table_page = page;
+        }
+
+        unsigned char * row_bins = line_bins ? line_bins : (unsigned char *)data->buffer + i * width;
+        unsigned char * row_erasures = NULL;
+        if (erasures)
+        {
+            row_erasures = line_erasures ? line_erasures : (unsigned char *)erasures->buffer + i * width;
+        }
+
+        quantize_line(kernel, IMAGE8_SCANLINE(image, i), width, block_size.x, tables, row_bins, row_erasures);
+
+        if (bits_per_symbol)
+        {
+            pack_symbols(&packer, row_bins, row_erasures, width);
+        }
+    }
+
+    if (bits_per_symbol)
+    {
+        pack_flush(&packer);
+    }
+
+    boxing_memory_free(line_erasures);
+    boxing_memory_free(line_bins);
+    boxing_memory_free(tables);
+    boxing_matrix_float_free(thresholds);
+    return data;
+}
+
+static void sample_thresholds(const boxing_image8 * frame, const boxing_matrixf * location_matrix, int block_width, int block_height,
+    int sample_step, int threshold_count, boxing_float * thresholds, boxing_image8_pixel * line)
+{
+    const int width = location_matrix->width;
+    const int height = location_matrix->height;
+    const int horizontal_block_count = (width + block_width - 1) / block_width;
+    const int vertical_block_count = (height + block_height - 1) / block_height;
+    const int line_count = (block_width + sample_step - 1) / sample_step;
+    int histogram[SAMPLE_QUANTIZE_HISTOGRAM_SIZE];
+
+    for (int n = 0; n < vertical_block_count; n++)
+    {
+        // Same block windows as boxing_calculate_thresholds
+        int y = n * block_height;
+        if (y + block_height >= height)
+            y = height - block_height;
+
+        for (int m = 0; m < horizontal_block_count; m++)
+        {
+            int x = m * block_width;
+            if (x + block_width >= width)
+                x = width - block_width;
+
+            boxing_memory_clear(histogram, sizeof(histogram));
+            int samples = 0;
+            for (int y_pos = y; y_pos < y + block_height; y_pos += sample_step)
+            {
+                boxing_2polinomialsampler_sample_line(frame, MATRIX_PELEMENT(location_matrix, y_pos, x), line_count, sample_step, line);
+                for (int k = 0; k < line_count; k++)
+                {
+                    histogram[line[k]]++;
+                }
+                samples += line_count;
+            }
+
+            boxing_calculate_histogram_thresholds(histogram, samples, thresholds + (n * horizontal_block_count + m) * threshold_count, threshold_count + 1);
+        }
+    }
+}
+
+static void build_block_tables(const boxing_float * threshold, int threshold_size, block_tables * tables, DBOOL with_erasures)
+{
+    const boxing_float spacing = threshold_spacing(threshold, threshold_size);
+    tables->edge_count = 0;
+    for (int value = 0; value < QUANTIZE_TABLE_SIZE; value++)
+    {
+        tables->bins[value] = (unsigned char)quantisize(threshold, threshold_size, value);
+        if (with_erasures)
+        {
+            tables->erasures[value] = unreliability(threshold, threshold_size, spacing, value, tables->bins[value]);
+        }
+
+        // The bins never decrease with the gray level, a step may skip bins
+        for (int bin = value > 0 ? tables->bins[value - 1] : 0; bin < tables->bins[value]; bin++)
+        {
+            tables->edges[tables->edge_count++] = (unsigned char)value;
+        }
+    }
+}
+
+static void quantize_line(quantize_span_kernel kernel, const boxing_image8_pixel * pixels, int count, int block_width,
+    const block_tables * tables, unsigned char * bins, unsigned char * erasures)
+{
+    for (int start = 0, m = 0; start < count; start += block_width, m++)
+    {
+        const block_tables * block = tables + m;
+        const int end = BOXING_MATH_MIN(start + block_width, count);
+
+        int j = start + (kernel ? kernel(pixels + start, end - start, block->edges, block->edge_count, bins + start) : 0);
+        for (; j < end; j++)
+        {
+            bins[j] = block->bins[pixels[j]];
+        }
+
+        if (erasures)
+        {
+            for (j = start; j < end; j++)
+            {
+                erasures[j] = block->erasures[pixels[j]];
+            }
+        }
+    }
+}
+
+static void pack_symbols(symbol_packer * packer, const unsigned char * bins, const unsigned char * erasures, int count)
+{
+    // Gray coded like the Modulator codec
+    static const unsigned char gray[4] = { 0x00, 0x01, 0x03, 0x02 };
+    const int symbols_per_byte = 8 / packer->bits_per_symbol;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (packer->bits_per_symbol == 1)
+        {
+            packer->value = (packer->value << 1) | (bins[i] & 0x01);
+        }
+        else
+        {
+            packer->value = (packer->value << 2) | gray[bins[i] & 0x03];
+        }
+        if (erasures)
+        {
+            packer->erasure = BOXING_MATH_MAX(packer->erasure, erasures[i]);
+        }
+
+        if (++packer->symbols == symbols_per_byte)
+        {
+            *packer->data++ = (unsigned char)packer->value;
+            if (packer->erasures)
+            {
+                *packer->erasures++ = packer->erasure;
+            }
+            packer->value = 0;
+            packer->erasure = 0;
+            packer->symbols = 0;
+        }
+    }
+}
+
+static void pack_flush(symbol_packer * packer)
+{
+    // The Modulator keeps a trailing partial byte of one bit symbols and drops two bit ones
+    if (packer->bits_per_symbol == 1 && packer->symbols > 0)
+    {
+        *packer->data++ = (unsigned char)packer->value;
+        if (packer->erasures)
+        {
+            *packer->erasures++ = packer->erasure;
+        }
+    }
+    packer->symbols = 0;
+}
+
+static boxing_float threshold_spacing(const boxing_float * threshold, int threshold_size)
+{
+    if (threshold_size > 1)
+    {
+        return (threshold[threshold_size - 1] - threshold[0]) / (threshold_size - 1);
+    }
+
+    // With a single threshold the levels are assumed to be symmetric around it
+    return BOXING_MATH_MIN(threshold[0], BOXING_PIXEL_MAX - threshold[0]);
+}
+
+static unsigned char unreliability(const boxing_float * threshold, int threshold_size, boxing_float spacing, int value, int bin)
+{
+    boxing_float distance = spacing;
+    if (bin > 0)
+    {
+        distance = BOXING_MATH_MIN(distance, value - threshold[bin - 1]);
+    }
+    if (bin < threshold_size)
+    {
+        distance = BOXING_MATH_MIN(distance, threshold[bin] - value);
+    }
+
+    boxing_float margin = spacing / 2;
+    if (margin <= 0 || distance >= margin)
+    {
+        return 0;
+    }
+    return (unsigned char)(255 * (1 - BOXING_MATH_MAX(distance, 0) / margin));
+}
+
 static int quantisize(const boxing_float * threshold, int threshold_size, int value)
 {
     int i = 0;
@@ -98,3 +497,88 @@ static int quantisize(const boxing_float * threshold, int threshold_size, int va
     }
     return i;
 }
+
+#if defined (BOXING_CPU_X86)
+
+// A pixel's bin is the number of step edges at or below its gray level, which
+// is exactly the value of the bin table.
+
+BOXING_CPU_TARGET("sse2")
+static int quantize_span_sse2(const boxing_image8_pixel * pixels, int count, const unsigned char * edges, int edge_count, unsigned char * bins)
+{
+    int n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        const __m128i value = _mm_loadu_si128((const __m128i *)(pixels + n));
+        __m128i bin = _mm_setzero_si128();
+        for (int k = 0; k < edge_count; k++)
+        {
+            // value >= edge gives all ones, subtracting it counts the edge
+            const __m128i edge = _mm_set1_epi8((char)edges[k]);
+            bin = _mm_sub_epi8(bin, _mm_cmpeq_epi8(_mm_max_epu8(value, edge), value));
+        }
+        _mm_storeu_si128((__m128i *)(bins + n), bin);
+    }
+    return n;
+}
+
+BOXING_CPU_TARGET("avx2")
+static int quantize_span_avx2(const boxing_image8_pixel * pixels, int count, const unsigned char * edges, int edge_count, unsigned char * bins)
+{
+    int n = 0;
+    for (; n + 32 <= count; n += 32)
+    {
+        const __m256i value = _mm256_loadu_si256((const __m256i *)(pixels + n));
+        __m256i bin = _mm256_setzero_si256();
+        for (int k = 0; k < edge_count; k++)
+        {
+            const __m256i edge = _mm256_set1_epi8((char)edges[k]);
+            bin = _mm256_sub_epi8(bin, _mm256_cmpeq_epi8(_mm256_max_epu8(value, edge), value));
+        }
+        _mm256_storeu_si256((__m256i *)(bins + n), bin);
+    }
+    return n + quantize_span_sse2(pixels + n, count - n, edges, edge_count, bins + n);
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+// A pixel's bin is the number of step edges at or below its gray level, which
+// is exactly the value of the bin table.
+
+static int quantize_span_neon(const boxing_image8_pixel * pixels, int count, const unsigned char * edges, int edge_count, unsigned char * bins)
+{
+    int n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        const uint8x16_t value = vld1q_u8(pixels + n);
+        uint8x16_t bin = vdupq_n_u8(0);
+        for (int k = 0; k < edge_count; k++)
+        {
+            bin = vsubq_u8(bin, vcgeq_u8(value, vdupq_n_u8(edges[k])));
+        }
+        vst1q_u8(bins + n, bin);
+    }
+    return n;
+}
+
+#endif
+
+static quantize_span_kernel select_quantize_span_kernel(void)
+{
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_AVX2))
+    {
+        return quantize_span_avx2;
+    }
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        return quantize_span_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        return quantize_span_neon;
+    }
+#endif
+    return NULL;
+}
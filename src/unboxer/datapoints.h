@@ -24,6 +24,9 @@ extern "C" {
 #include "gvector.h"
 
 gvector * boxing_datapoints_quantize(const boxing_image8 * image, int block_width, int block_height, int levels);
+gvector * boxing_datapoints_quantize_erasures(const boxing_image8 * image, int block_width, int block_height, int levels, gvector * erasures, int thread_count);
+gvector * boxing_datapoints_quantize_packed(const boxing_image8 * image, int block_width, int block_height, int levels, gvector * erasures, int thread_count);
+gvector * boxing_datapoints_sample_quantize(const boxing_image8 * frame, const boxing_matrixf * location_matrix, int block_width, int block_height, int levels, int sample_step, gvector * erasures);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -16,10 +16,101 @@
 //
 #include    "boxing/filter.h"
 #include    "boxing/platform/memory.h"
+#include    "boxing/platform/thread.h"
+#include    "boxing/platform/cpu.h"
+#include    "boxing/utils.h"
+
+//  SYSTEM INCLUDES
+//
+#include    <math.h>
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
 
 //  PRIVATE INTERFACE
 //
+
+// Filter kernel, computes destination pixels starting at x and returns the
+// index of the first pixel not processed.
+typedef int (*boxing_filter_row_kernel)(boxing_image8_pixel * destination, const boxing_float * const * lines,
+                                         const boxing_float * coeff, int rows, int cols, int x, int width);
+
+// Vertical pass kernel of separable float filters, computes the intermediate
+// line starting at x and returns the index of the first value not processed.
+typedef int (*boxing_filter_column_kernel)(boxing_float * destination, const boxing_float * const * lines,
+                                            const boxing_float * coeff, int rows, int x, int width);
+
+// Float coefficients of a separable filter, applied as a vertical pass with
+// rows coefficients and then horizontally as a 1 x cols filter.
+typedef struct boxing_filter_separable_s
+{
+    boxing_float *                  vertical;
+    boxing_float *                  horizontal;
+} boxing_filter_separable;
+
+// Fixed point coefficients. A 2D filter is applied as one pass with rows x
+// cols coefficients. A separable filter is first applied vertically, the
+// vertical pass keeps 7 fraction bits, and then horizontally as a 1 x cols
+// filter.
+typedef struct boxing_filter_fixed_s
+{
+    int                             rows;
+    int                             cols;
+    int                             shift;
+    short *                         coeff;
+    int *                           coeff_pairs;
+    int                             vertical_rows;
+    int                             vertical_shift;
+    short *                         vertical;
+    int *                           vertical_pairs;
+} boxing_filter_fixed;
+
+// Fixed point filter kernel, computes destination pixels starting at x and 
+// returns the index of the first pixel not processed.
+typedef int (*boxing_filter_fixed_row_kernel)(boxing_image8_pixel * destination, const short * const * lines,
+                                               const short * coeff, const int * coeff_pairs, int rows, int cols, int shift, int x, int width);
+
+// Vertical pass kernel of separable fixed point filters, computes the 
+// intermediate line starting at x and returns the index of the first value not processed.
+typedef int (*boxing_filter_fixed_column_kernel)(short * destination, const short * const * lines,
+                                                  const short * coeff, const int * coeff_pairs, int rows, int shift, int x, int width);
+
+// Widens pixels to 16 bit starting at x and returns the index of the first
+// pixel not processed.
+typedef int (*boxing_filter_widen_kernel)(short * destination, const boxing_image8_pixel * pixels, int x, int width);
+
+typedef struct boxing_filter_job_s
+{
+    boxing_image8 *                     image;
+    const boxing_filter_coeff_2d *      coeff;
+    boxing_filter_row_kernel            kernel;
+    const boxing_filter_separable *     separable;
+    boxing_filter_column_kernel         column_kernel;
+    const boxing_filter_fixed *         fixed;
+    boxing_filter_fixed_row_kernel      fixed_kernel;
+    boxing_filter_fixed_column_kernel   fixed_column_kernel;
+    boxing_filter_widen_kernel          widen_kernel;
+    int                                 band_height;
+    boxing_image8_pixel *               halo;
+    DBOOL                               failed;
+} boxing_filter_job;
+
 static void boxing_filter_coefficients_init( boxing_filter_coeff_2d * filter_coeff, int rows, int cols, boxing_float *coefficients );
+static int  boxing_filter_run( boxing_image8 * image, const boxing_filter_coeff_2d * coeff, const boxing_filter_separable * separable,
+                               const boxing_filter_fixed * fixed, int thread_count );
+static DBOOL boxing_filter_rank_one( const double * coeff, int rows, int cols, double * vertical, double * horizontal );
+static DBOOL boxing_filter_separable_init( boxing_filter_separable * separable, const boxing_filter_coeff_2d * coeff );
+static boxing_filter_row_kernel boxing_filter_select_kernel( void );
+static boxing_filter_column_kernel boxing_filter_select_column_kernel( void );
+static boxing_filter_fixed_row_kernel boxing_filter_select_fixed_kernel( void );
+static boxing_filter_fixed_column_kernel boxing_filter_select_fixed_column_kernel( void );
+static boxing_filter_widen_kernel boxing_filter_select_widen_kernel( void );
+static DBOOL boxing_filter_fixed_init( boxing_filter_fixed * fixed, const boxing_filter_coeff_2d * coeff );
+static void boxing_filter_fixed_free( boxing_filter_fixed * fixed );
+static void boxing_filter_band( void * user, int band );
+static void boxing_filter_band_fixed( void * user, int band );
 
 
 /*! 
@@ -49,6 +140,17 @@ static void boxing_filter_coefficients_init( boxing_filter_coeff_2d * filter_coe
  */
 
 
+/*!
+ *  \enum       boxing_filter_precision filter.h
+ *  \brief      Arithmetic of the filter.
+ *  
+ *  \param BOXING_FILTER_PRECISION_FLOAT        (0) Float, boxing_filter_apply.
+ *  \param BOXING_FILTER_PRECISION_FIXED_POINT  (1) 16 bit fixed point, boxing_filter_apply_fixed_point.
+ *
+ *  The enumeration for specifying the arithmetic used to apply the filter.
+ */
+
+
 //----------------------------------------------------------------------------
 /*!
  *  \struct     boxing_filter_coeff_2d_s  unboxer.h
@@ -67,8 +169,10 @@ static void boxing_filter_coefficients_init( boxing_filter_coeff_2d * filter_coe
  *  \struct       boxing_filter_s  unboxer.h
  *  \brief        Data storage for the filter.
  *
- *  \param process  Callback function for the filter
- *  \param coeff    Filter coefficients
+ *  \param process    Callback function for the filter
+ *  \param coeff      Filter coefficients
+ *  \param precision  Arithmetic used when the filter is applied without a callback,
+ *                    BOXING_FILTER_PRECISION_FLOAT unless the caller opts in to fixed point
  *
  *  The structure of the filter data storage: a pointer to callback function and filter coefficients.
  */
@@ -82,7 +186,9 @@ static void boxing_filter_coefficients_init( boxing_filter_coeff_2d * filter_coe
  * 
  *  Initialize filter with default sharpness filter. Note that the filter 
  *  coefficients are reader dependant and should be overridden with coefficients
- *  matching the reader image capture device.
+ *  matching the reader image capture device. The filter is applied in float,
+ *  set precision to BOXING_FILTER_PRECISION_FIXED_POINT for the faster
+ *  approximate filter.
  *
  *  \param[in]  filter      Filter instance.
  */
@@ -101,6 +207,7 @@ void boxing_filter_init( boxing_filter * filter )
     filter->coeff = BOXING_MEMORY_ALLOCATE_TYPE( boxing_filter_coeff_2d );
     boxing_filter_coefficients_init( filter->coeff, 5, 5, default_filter_coefficients );
     filter->process = NULL;
+    filter->precision = BOXING_FILTER_PRECISION_FLOAT;
 }
 
 
@@ -118,6 +225,90 @@ void boxing_filter_free( boxing_filter * filter )
 }
 
 
+//---------------------------------------------------------------------------- 
+/*! \brief Apply 2D filter in place.
+ * 
+ *  Convolve the image with the filter coefficients. Pixels outside the image 
+ *  are taken from the opposite edge (the image wraps around). 
+ *
+ *  The image is split into horizontal bands that are filtered independently,
+ *  each band keeps a ring buffer of the filter rows it needs, so no full size
+ *  temporary image is allocated. Rows are processed with the widest SIMD 
+ *  kernel supported by the CPU, the result is identical for all kernels and 
+ *  thread counts.
+ *
+ *  Filters where all rows are multiples of one row (rank one filters, like
+ *  the gaussian) are applied as a vertical and a horizontal pass. The sums
+ *  are then taken in another order, a pixel may differ by one gray level from
+ *  the 2D convolution where the sum is within float rounding of an integer.
+ *  Other filters are bit exact with the 2D convolution.
+ *
+ *  \param[in,out]  image         Image to filter.
+ *  \param[in]      coeff         Filter coefficients.
+ *  \param[in]      thread_count  Number of worker threads, less than 1 uses all cores.
+ *  \return BOXING_FILTER_CALLBACK_OK on success or BOXING_FILTER_CALLBACK_ERROR.
+ */
+
+int boxing_filter_apply( boxing_image8 * image, const boxing_filter_coeff_2d * coeff, int thread_count )
+{
+    if ( image == NULL || image->data == NULL || coeff == NULL || coeff->coeff == NULL || coeff->rows < 1 || coeff->cols < 1 )
+    {
+        return BOXING_FILTER_CALLBACK_ERROR;
+    }
+
+    boxing_filter_separable separable;
+    if ( !boxing_filter_separable_init( &separable, coeff ) )
+    {
+        return boxing_filter_run( image, coeff, NULL, NULL, thread_count );
+    }
+
+    int result = boxing_filter_run( image, coeff, &separable, NULL, thread_count );
+    boxing_memory_free( separable.vertical );
+    boxing_memory_free( separable.horizontal );
+    return result;
+}
+
+
+//---------------------------------------------------------------------------- 
+/*! \brief Apply 2D filter in place with fixed point arithmetic.
+ * 
+ *  Convolve the image with the filter coefficients like boxing_filter_apply,
+ *  using 16 bit fixed point coefficients and 32 bit integer sums. Filters
+ *  where all rows are multiples of one row (rank one filters, like the
+ *  gaussian) are applied as a vertical and a horizontal pass, a 5x5 filter
+ *  then needs 10 instead of 25 multiplications per pixel.
+ *
+ *  The coefficients are only converted if the rounding error of a pixel is
+ *  below half a gray level, the result then differs by at most one gray 
+ *  level from boxing_filter_apply. Filters with a larger dynamic range are 
+ *  applied with boxing_filter_apply. The result is identical for all 
+ *  kernels and thread counts.
+ *
+ *  \param[in,out]  image         Image to filter.
+ *  \param[in]      coeff         Filter coefficients.
+ *  \param[in]      thread_count  Number of worker threads, less than 1 uses all cores.
+ *  \return BOXING_FILTER_CALLBACK_OK on success or BOXING_FILTER_CALLBACK_ERROR.
+ */
+
+int boxing_filter_apply_fixed_point( boxing_image8 * image, const boxing_filter_coeff_2d * coeff, int thread_count )
+{
+    if ( image == NULL || image->data == NULL || coeff == NULL || coeff->coeff == NULL || coeff->rows < 1 || coeff->cols < 1 )
+    {
+        return BOXING_FILTER_CALLBACK_ERROR;
+    }
+
+    boxing_filter_fixed fixed;
+    if ( !boxing_filter_fixed_init( &fixed, coeff ) )
+    {
+        return boxing_filter_apply( image, coeff, thread_count );
+    }
+
+    int result = boxing_filter_run( image, coeff, NULL, &fixed, thread_count );
+    boxing_filter_fixed_free( &fixed );
+    return result;
+}
+
+
 //----------------------------------------------------------------------------
 /*!
  * \} end of unboxer group
@@ -133,3 +324,1065 @@ static void  boxing_filter_coefficients_init( boxing_filter_coeff_2d* coeff, int
     coeff->cols = columns;
     coeff->coeff = coefficients;
 }
+
+
+// Split the image into bands and filter them with the float kernels, as two
+// passes if separable is set, or the fixed point kernels if fixed is set
+static int boxing_filter_run( boxing_image8 * image, const boxing_filter_coeff_2d * coeff, const boxing_filter_separable * separable,
+                              const boxing_filter_fixed * fixed, int thread_count )
+{
+    const int width = (int)image->width;
+    const int height = (int)image->height;
+    const int rows = coeff->rows;
+    const int y_radius = rows / 2;
+
+    if ( width == 0 || height == 0 )
+    {
+        return BOXING_FILTER_CALLBACK_OK;
+    }
+
+    const int band_count = boxing_thread_resolve_count( thread_count, height );
+
+    boxing_filter_job job;
+    job.image = image;
+    job.coeff = coeff;
+    job.kernel = boxing_filter_select_kernel();
+    job.separable = separable;
+    job.column_kernel = boxing_filter_select_column_kernel();
+    job.fixed = fixed;
+    job.fixed_kernel = boxing_filter_select_fixed_kernel();
+    job.fixed_column_kernel = boxing_filter_select_fixed_column_kernel();
+    job.widen_kernel = boxing_filter_select_widen_kernel();
+    job.band_height = (height + band_count - 1) / band_count;
+    job.failed = DFALSE;
+
+    // Save the rows surrounding each band before any band is modified
+    job.halo = NULL;
+    if ( rows > 1 )
+    {
+        job.halo = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( boxing_image8_pixel, (size_t)band_count * (rows - 1) * width );
+        if ( job.halo == NULL )
+        {
+            return BOXING_FILTER_CALLBACK_ERROR;
+        }
+    }
+
+    for ( int band = 0; band < band_count && rows > 1; band++ )
+    {
+        const int y_begin = band * job.band_height;
+        const int y_end = BOXING_MATH_MIN( y_begin + job.band_height, height );
+        boxing_image8_pixel * halo = job.halo + (size_t)band * (rows - 1) * width;
+
+        for ( int i = 0; i < rows - 1; i++ )
+        {
+            int y = ( i < y_radius ) ? ( y_begin - y_radius + i ) : ( y_end + i - y_radius );
+            y = ( ( y % height ) + height ) % height;
+            memcpy( halo + (size_t)i * width, IMAGE8_SCANLINE( image, y ), width );
+        }
+    }
+
+    boxing_thread_parallel_for( band_count, band_count, fixed ? boxing_filter_band_fixed : boxing_filter_band, &job );
+
+    boxing_memory_free( job.halo );
+
+    return job.failed ? BOXING_FILTER_CALLBACK_ERROR : BOXING_FILTER_CALLBACK_OK;
+}
+
+
+// Rank one decomposition through the row and column of the largest 
+// coefficient, the vertical coefficients are scaled to an absolute sum of
+// one so the intermediate line stays within the pixel range. Filters with a
+// single row or column are not decomposed.
+static DBOOL boxing_filter_rank_one( const double * coeff, int rows, int cols, double * vertical, double * horizontal )
+{
+    int pivot = 0;
+    for ( int i = 0; i < rows * cols; i++ )
+    {
+        if ( fabs( coeff[i] ) > fabs( coeff[pivot] ) )
+        {
+            pivot = i;
+        }
+    }
+
+    if ( rows < 2 || cols < 2 || coeff[pivot] == 0.0 )
+    {
+        return DFALSE;
+    }
+
+    const int pivot_row = pivot / cols;
+    const int pivot_col = pivot % cols;
+    double vertical_sum = 0.0;
+    for ( int i = 0; i < rows; i++ )
+    {
+        vertical[i] = coeff[i * cols + pivot_col] / coeff[pivot];
+        vertical_sum += fabs( vertical[i] );
+    }
+    for ( int i = 0; i < rows; i++ )
+    {
+        vertical[i] /= vertical_sum;
+    }
+    for ( int j = 0; j < cols; j++ )
+    {
+        horizontal[j] = coeff[pivot_row * cols + j] * vertical_sum;
+    }
+    return DTRUE;
+}
+
+// Largest difference of a pixel, in gray levels, between a separable float 
+// filter and the 2D filter it replaces, before the rounding of the sums
+#define BOXING_FILTER_SEPARABLE_MAX_ERROR 0.001
+
+static DBOOL boxing_filter_separable_init( boxing_filter_separable * separable, const boxing_filter_coeff_2d * coeff )
+{
+    const int rows = coeff->rows;
+    const int cols = coeff->cols;
+    double * c = BOXING_STACK_ALLOCATE_TYPE_ARRAY( double, rows * cols );
+    double * vertical = BOXING_STACK_ALLOCATE_TYPE_ARRAY( double, rows );
+    double * horizontal = BOXING_STACK_ALLOCATE_TYPE_ARRAY( double, cols );
+    for ( int i = 0; i < rows * cols; i++ )
+    {
+        c[i] = coeff->coeff[i];
+    }
+
+    if ( !boxing_filter_rank_one( c, rows, cols, vertical, horizontal ) )
+    {
+        return DFALSE;
+    }
+
+    // Only filters that are rank one within float rounding are separated
+    double error = 0.0;
+    for ( int i = 0; i < rows; i++ )
+    {
+        for ( int j = 0; j < cols; j++ )
+        {
+            error += BOXING_PIXEL_MAX * fabs( c[i * cols + j] - (boxing_float)vertical[i] * (boxing_float)horizontal[j] );
+        }
+    }
+    if ( error > BOXING_FILTER_SEPARABLE_MAX_ERROR )
+    {
+        return DFALSE;
+    }
+
+    separable->vertical = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( boxing_float, rows );
+    separable->horizontal = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( boxing_float, cols );
+    for ( int i = 0; i < rows; i++ )
+    {
+        separable->vertical[i] = (boxing_float)vertical[i];
+    }
+    for ( int j = 0; j < cols; j++ )
+    {
+        separable->horizontal[j] = (boxing_float)horizontal[j];
+    }
+    return DTRUE;
+}
+
+static int boxing_filter_row_scalar( boxing_image8_pixel * destination, const boxing_float * const * lines,
+                                     const boxing_float * coeff, int rows, int cols, int x, int width )
+{
+    for ( ; x < width; x++ )
+    {
+        boxing_float value = 0.0f;
+        for ( int i = 0; i < rows; i++ )
+        {
+            const boxing_float * line = lines[i] + x;
+            for ( int j = 0; j < cols; j++ )
+            {
+                value += coeff[i * cols + j] * line[j];
+            }
+        }
+
+        value = BOXING_MATH_CLAMP( BOXING_PIXEL_MIN, BOXING_PIXEL_MAX, value );
+        destination[x] = (boxing_image8_pixel)value;
+    }
+    return x;
+}
+
+static int boxing_filter_column_scalar( boxing_float * destination, const boxing_float * const * lines,
+                                        const boxing_float * coeff, int rows, int x, int width )
+{
+    for ( ; x < width; x++ )
+    {
+        boxing_float value = 0.0f;
+        for ( int i = 0; i < rows; i++ )
+        {
+            value += coeff[i] * lines[i][x];
+        }
+        destination[x] = value;
+    }
+    return x;
+}
+
+// The SIMD kernels accumulate each pixel in the same order as the scalar 
+// kernel and use separate multiply and add instructions (no FMA), the 
+// result is therefore bit exact with the scalar kernel.
+
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("sse2")
+static int boxing_filter_column_sse2( boxing_float * destination, const boxing_float * const * lines,
+                                      const boxing_float * coeff, int rows, int x, int width )
+{
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        __m128 value0 = _mm_setzero_ps();
+        __m128 value1 = _mm_setzero_ps();
+        for ( int i = 0; i < rows; i++ )
+        {
+            const __m128 c = _mm_set1_ps( coeff[i] );
+            value0 = _mm_add_ps( value0, _mm_mul_ps( c, _mm_loadu_ps( lines[i] + x ) ) );
+            value1 = _mm_add_ps( value1, _mm_mul_ps( c, _mm_loadu_ps( lines[i] + x + 4 ) ) );
+        }
+        _mm_storeu_ps( destination + x, value0 );
+        _mm_storeu_ps( destination + x + 4, value1 );
+    }
+    return x;
+}
+
+BOXING_CPU_TARGET("avx2")
+static int boxing_filter_column_avx2( boxing_float * destination, const boxing_float * const * lines,
+                                      const boxing_float * coeff, int rows, int x, int width )
+{
+    for ( ; x + 16 <= width; x += 16 )
+    {
+        __m256 value0 = _mm256_setzero_ps();
+        __m256 value1 = _mm256_setzero_ps();
+        for ( int i = 0; i < rows; i++ )
+        {
+            const __m256 c = _mm256_set1_ps( coeff[i] );
+            value0 = _mm256_add_ps( value0, _mm256_mul_ps( c, _mm256_loadu_ps( lines[i] + x ) ) );
+            value1 = _mm256_add_ps( value1, _mm256_mul_ps( c, _mm256_loadu_ps( lines[i] + x + 8 ) ) );
+        }
+        _mm256_storeu_ps( destination + x, value0 );
+        _mm256_storeu_ps( destination + x + 8, value1 );
+    }
+    return boxing_filter_column_sse2( destination, lines, coeff, rows, x, width );
+}
+
+BOXING_CPU_TARGET("sse2")
+static int boxing_filter_row_sse2( boxing_image8_pixel * destination, const boxing_float * const * lines,
+                                   const boxing_float * coeff, int rows, int cols, int x, int width )
+{
+    const __m128 pixel_min = _mm_set1_ps( (float)BOXING_PIXEL_MIN );
+    const __m128 pixel_max = _mm_set1_ps( (float)BOXING_PIXEL_MAX );
+
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        __m128 value0 = _mm_setzero_ps();
+        __m128 value1 = _mm_setzero_ps();
+        for ( int i = 0; i < rows; i++ )
+        {
+            const boxing_float * line = lines[i] + x;
+            for ( int j = 0; j < cols; j++ )
+            {
+                const __m128 c = _mm_set1_ps( coeff[i * cols + j] );
+                value0 = _mm_add_ps( value0, _mm_mul_ps( c, _mm_loadu_ps( line + j ) ) );
+                value1 = _mm_add_ps( value1, _mm_mul_ps( c, _mm_loadu_ps( line + j + 4 ) ) );
+            }
+        }
+
+        value0 = _mm_min_ps( _mm_max_ps( value0, pixel_min ), pixel_max );
+        value1 = _mm_min_ps( _mm_max_ps( value1, pixel_min ), pixel_max );
+        __m128i packed = _mm_packs_epi32( _mm_cvttps_epi32( value0 ), _mm_cvttps_epi32( value1 ) );
+        _mm_storel_epi64( (__m128i *)( destination + x ), _mm_packus_epi16( packed, packed ) );
+    }
+    return x;
+}
+
+BOXING_CPU_TARGET("avx2")
+static int boxing_filter_row_avx2( boxing_image8_pixel * destination, const boxing_float * const * lines,
+                                   const boxing_float * coeff, int rows, int cols, int x, int width )
+{
+    const __m256 pixel_min = _mm256_set1_ps( (float)BOXING_PIXEL_MIN );
+    const __m256 pixel_max = _mm256_set1_ps( (float)BOXING_PIXEL_MAX );
+
+    for ( ; x + 16 <= width; x += 16 )
+    {
+        __m256 value0 = _mm256_setzero_ps();
+        __m256 value1 = _mm256_setzero_ps();
+        for ( int i = 0; i < rows; i++ )
+        {
+            const boxing_float * line = lines[i] + x;
+            for ( int j = 0; j < cols; j++ )
+            {
+                const __m256 c = _mm256_set1_ps( coeff[i * cols + j] );
+                value0 = _mm256_add_ps( value0, _mm256_mul_ps( c, _mm256_loadu_ps( line + j ) ) );
+                value1 = _mm256_add_ps( value1, _mm256_mul_ps( c, _mm256_loadu_ps( line + j + 8 ) ) );
+            }
+        }
+
+        value0 = _mm256_min_ps( _mm256_max_ps( value0, pixel_min ), pixel_max );
+        value1 = _mm256_min_ps( _mm256_max_ps( value1, pixel_min ), pixel_max );
+        __m256i packed = _mm256_packs_epi32( _mm256_cvttps_epi32( value0 ), _mm256_cvttps_epi32( value1 ) );
+        packed = _mm256_permute4x64_epi64( packed, 0xD8 );
+        __m128i bytes = _mm_packus_epi16( _mm256_castsi256_si128( packed ), _mm256_extracti128_si256( packed, 1 ) );
+        _mm_storeu_si128( (__m128i *)( destination + x ), bytes );
+    }
+    return boxing_filter_row_sse2( destination, lines, coeff, rows, cols, x, width );
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static int boxing_filter_row_neon( boxing_image8_pixel * destination, const boxing_float * const * lines,
+                                   const boxing_float * coeff, int rows, int cols, int x, int width )
+{
+    const float32x4_t pixel_min = vdupq_n_f32( (float)BOXING_PIXEL_MIN );
+    const float32x4_t pixel_max = vdupq_n_f32( (float)BOXING_PIXEL_MAX );
+
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        float32x4_t value0 = vdupq_n_f32( 0.0f );
+        float32x4_t value1 = vdupq_n_f32( 0.0f );
+        for ( int i = 0; i < rows; i++ )
+        {
+            const boxing_float * line = lines[i] + x;
+            for ( int j = 0; j < cols; j++ )
+            {
+                const float32x4_t c = vdupq_n_f32( coeff[i * cols + j] );
+                value0 = vaddq_f32( value0, vmulq_f32( c, vld1q_f32( line + j ) ) );
+                value1 = vaddq_f32( value1, vmulq_f32( c, vld1q_f32( line + j + 4 ) ) );
+            }
+        }
+
+        value0 = vminq_f32( vmaxq_f32( value0, pixel_min ), pixel_max );
+        value1 = vminq_f32( vmaxq_f32( value1, pixel_min ), pixel_max );
+        uint16x8_t packed = vcombine_u16( vmovn_u32( vcvtq_u32_f32( value0 ) ), vmovn_u32( vcvtq_u32_f32( value1 ) ) );
+        vst1_u8( destination + x, vmovn_u16( packed ) );
+    }
+    return x;
+}
+
+static int boxing_filter_column_neon( boxing_float * destination, const boxing_float * const * lines,
+                                      const boxing_float * coeff, int rows, int x, int width )
+{
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        float32x4_t value0 = vdupq_n_f32( 0.0f );
+        float32x4_t value1 = vdupq_n_f32( 0.0f );
+        for ( int i = 0; i < rows; i++ )
+        {
+            const float32x4_t c = vdupq_n_f32( coeff[i] );
+            value0 = vaddq_f32( value0, vmulq_f32( c, vld1q_f32( lines[i] + x ) ) );
+            value1 = vaddq_f32( value1, vmulq_f32( c, vld1q_f32( lines[i] + x + 4 ) ) );
+        }
+        vst1q_f32( destination + x, value0 );
+        vst1q_f32( destination + x + 4, value1 );
+    }
+    return x;
+}
+
+#endif
+
+static boxing_filter_row_kernel boxing_filter_select_kernel( void )
+{
+#if defined (BOXING_CPU_X86)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_AVX2 ) )
+    {
+        return boxing_filter_row_avx2;
+    }
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_SSE2 ) )
+    {
+        return boxing_filter_row_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_NEON ) )
+    {
+        return boxing_filter_row_neon;
+    }
+#endif
+    return NULL;
+}
+
+static boxing_filter_column_kernel boxing_filter_select_column_kernel( void )
+{
+#if defined (BOXING_CPU_X86)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_AVX2 ) )
+    {
+        return boxing_filter_column_avx2;
+    }
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_SSE2 ) )
+    {
+        return boxing_filter_column_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_NEON ) )
+    {
+        return boxing_filter_column_neon;
+    }
+#endif
+    return NULL;
+}
+
+// Convert image row to float and pad it with wrapped pixels on both sides
+static void boxing_filter_load_line( boxing_float * line, const boxing_image8_pixel * pixels, int width, int x_radius, int cols )
+{
+    const int line_width = width + cols - 1;
+    for ( int k = 0; k < x_radius; k++ )
+    {
+        line[k] = pixels[( ( ( k - x_radius ) % width ) + width ) % width];
+    }
+    for ( int x = 0; x < width; x++ )
+    {
+        line[x_radius + x] = pixels[x];
+    }
+    for ( int k = x_radius + width; k < line_width; k++ )
+    {
+        line[k] = pixels[( k - x_radius ) % width];
+    }
+}
+
+// Image row y read by a band, rows above and below the band may be modified 
+// by other bands and are read from the halo
+static const boxing_image8_pixel * boxing_filter_band_line( const boxing_filter_job * job, int band, int y, int y_begin, int y_end )
+{
+    const int width = (int)job->image->width;
+    const int rows = job->coeff->rows;
+    const int y_radius = rows / 2;
+
+    if ( y < y_begin )
+    {
+        return job->halo + ( (size_t)band * ( rows - 1 ) + ( y - ( y_begin - y_radius ) ) ) * width;
+    }
+    if ( y >= y_end )
+    {
+        return job->halo + ( (size_t)band * ( rows - 1 ) + y_radius + ( y - y_end ) ) * width;
+    }
+    return IMAGE8_SCANLINE( job->image, y );
+}
+
+static void boxing_filter_band( void * user, int band )
+{
+    boxing_filter_job * job = (boxing_filter_job *)user;
+    boxing_image8 * image = job->image;
+
+    const int width = (int)image->width;
+    const int height = (int)image->height;
+    const int rows = job->coeff->rows;
+    const int cols = job->coeff->cols;
+    const int y_radius = rows / 2;
+    const int x_radius = cols / 2;
+    const int line_width = width + cols - 1;
+    const boxing_float * coeff = job->coeff->coeff;
+
+    const int y_begin = band * job->band_height;
+    const int y_end = BOXING_MATH_MIN( y_begin + job->band_height, height );
+    if ( y_begin >= y_end )
+    {
+        return;
+    }
+
+    // The intermediate line of separable filters follows the ring
+    const boxing_filter_separable * separable = job->separable;
+    boxing_float * ring = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( boxing_float, (size_t)( rows + 1 ) * line_width );
+    const boxing_float ** lines = BOXING_STACK_ALLOCATE_TYPE_ARRAY( const boxing_float *, rows );
+    if ( ring == NULL )
+    {
+        job->failed = DTRUE;
+        return;
+    }
+    boxing_float * column = ring + (size_t)rows * line_width;
+    const boxing_float * column_line = column;
+
+    // Rows above and below the band may be modified by other bands, read them
+    // from the halo. Rows within the band are read before they are written.
+    for ( int y = y_begin - y_radius; y < y_end + rows - 1 - y_radius; y++ )
+    {
+        const boxing_image8_pixel * pixels = boxing_filter_band_line( job, band, y, y_begin, y_end );
+
+        boxing_filter_load_line( ring + (size_t)( ( ( y % rows ) + rows ) % rows ) * line_width, pixels, width, x_radius, cols );
+
+        const int y_output = y - ( rows - 1 - y_radius );
+        if ( y_output < y_begin )
+        {
+            continue;
+        }
+
+        for ( int i = 0; i < rows; i++ )
+        {
+            const int y_line = y_output - y_radius + i;
+            lines[i] = ring + (size_t)( ( ( y_line % rows ) + rows ) % rows ) * line_width;
+        }
+
+        boxing_image8_pixel * destination = IMAGE8_SCANLINE( image, y_output );
+        int x = 0;
+        if ( separable )
+        {
+            if ( job->column_kernel )
+            {
+                x = job->column_kernel( column, lines, separable->vertical, rows, x, line_width );
+            }
+            boxing_filter_column_scalar( column, lines, separable->vertical, rows, x, line_width );
+
+            x = 0;
+            if ( job->kernel )
+            {
+                x = job->kernel( destination, &column_line, separable->horizontal, 1, cols, x, width );
+            }
+            boxing_filter_row_scalar( destination, &column_line, separable->horizontal, 1, cols, x, width );
+            continue;
+        }
+
+        if ( job->kernel )
+        {
+            x = job->kernel( destination, lines, coeff, rows, cols, x, width );
+        }
+        boxing_filter_row_scalar( destination, lines, coeff, rows, cols, x, width );
+    }
+
+    boxing_memory_free( ring );
+}
+
+
+// FIXED POINT FILTER FUNCTIONS
+//
+
+// Fraction bits of 16 bit fixed point coefficients
+#define BOXING_FILTER_FIXED_MAX_SHIFT   14
+// Fraction bits of the intermediate line of separable filters
+#define BOXING_FILTER_FIXED_COLUMN_BITS 7
+// Largest rounding error of a pixel, in gray levels, accepted for fixed point filters
+#define BOXING_FILTER_FIXED_MAX_ERROR   0.5
+
+// Largest shift where the coefficients fit in 16 bits and the sum of the 
+// products with inputs up to max_input fits in 32 bits, -1 if there is none
+static int boxing_filter_fixed_shift( const double * coeff, int count, double max_input )
+{
+    double max_abs = 0.0;
+    double sum_abs = 0.0;
+    for ( int i = 0; i < count; i++ )
+    {
+        max_abs = BOXING_MATH_MAX( max_abs, fabs( coeff[i] ) );
+        sum_abs += fabs( coeff[i] );
+    }
+
+    for ( int shift = BOXING_FILTER_FIXED_MAX_SHIFT; shift >= 0; shift-- )
+    {
+        const double scale = (double)( 1 << shift );
+        if ( max_abs * scale + 0.5 <= 32767.0 && ( sum_abs * scale + count ) * max_input + scale < 2147483647.0 )
+        {
+            return shift;
+        }
+    }
+    return -1;
+}
+
+static short * boxing_filter_fixed_quantize( const double * coeff, int count, int shift )
+{
+    short * fixed = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( short, count );
+    for ( int i = 0; i < count; i++ )
+    {
+        fixed[i] = (short)lround( coeff[i] * ( 1 << shift ) );
+    }
+    return fixed;
+}
+
+// Neighbouring coefficients of each row packed into one int for the 16 bit
+// multiply add instructions, odd rows are padded with a zero coefficient
+static int * boxing_filter_fixed_pairs( const short * coeff, int rows, int cols )
+{
+    const int pairs = ( cols + 1 ) / 2;
+    int * packed = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( int, rows * pairs );
+    for ( int i = 0; i < rows; i++ )
+    {
+        for ( int j = 0; j < pairs; j++ )
+        {
+            const unsigned short first = (unsigned short)coeff[i * cols + 2 * j];
+            const unsigned short second = 2 * j + 1 < cols ? (unsigned short)coeff[i * cols + 2 * j + 1] : 0;
+            packed[i * pairs + j] = (int)( first | ( (unsigned int)second << 16 ) );
+        }
+    }
+    return packed;
+}
+
+static DBOOL boxing_filter_fixed_init( boxing_filter_fixed * fixed, const boxing_filter_coeff_2d * coeff )
+{
+    const int rows = coeff->rows;
+    const int cols = coeff->cols;
+    const int count = rows * cols;
+
+    double * c = BOXING_STACK_ALLOCATE_TYPE_ARRAY( double, count );
+    double * vertical = BOXING_STACK_ALLOCATE_TYPE_ARRAY( double, rows );
+    double * horizontal = BOXING_STACK_ALLOCATE_TYPE_ARRAY( double, cols );
+    for ( int i = 0; i < count; i++ )
+    {
+        c[i] = coeff->coeff[i];
+    }
+
+    fixed->vertical = NULL;
+    fixed->vertical_pairs = NULL;
+    fixed->vertical_rows = 0;
+    fixed->vertical_shift = 0;
+
+    if ( boxing_filter_rank_one( c, rows, cols, vertical, horizontal ) )
+    {
+        const int shift = boxing_filter_fixed_shift( horizontal, cols, 32767.0 );
+        if ( shift >= 0 )
+        {
+            short * vertical_fixed = boxing_filter_fixed_quantize( vertical, rows, BOXING_FILTER_FIXED_MAX_SHIFT );
+            short * horizontal_fixed = boxing_filter_fixed_quantize( horizontal, cols, shift );
+
+            // Error of the quantized coefficients for the worst case image, 
+            // and the rounding of the intermediate line
+            double error = 0.0;
+            for ( int j = 0; j < cols; j++ )
+            {
+                const double h = (double)horizontal_fixed[j] / ( 1 << shift );
+                for ( int i = 0; i < rows; i++ )
+                {
+                    const double v = (double)vertical_fixed[i] / ( 1 << BOXING_FILTER_FIXED_MAX_SHIFT );
+                    error += BOXING_PIXEL_MAX * fabs( c[i * cols + j] - v * h );
+                }
+                error += fabs( h ) * 0.5 / ( 1 << BOXING_FILTER_FIXED_COLUMN_BITS );
+            }
+
+            if ( error <= BOXING_FILTER_FIXED_MAX_ERROR )
+            {
+                fixed->rows = 1;
+                fixed->cols = cols;
+                fixed->shift = shift + BOXING_FILTER_FIXED_COLUMN_BITS;
+                fixed->coeff = horizontal_fixed;
+                fixed->coeff_pairs = boxing_filter_fixed_pairs( horizontal_fixed, 1, cols );
+                fixed->vertical_rows = rows;
+                fixed->vertical_shift = BOXING_FILTER_FIXED_MAX_SHIFT - BOXING_FILTER_FIXED_COLUMN_BITS;
+                fixed->vertical = vertical_fixed;
+                fixed->vertical_pairs = boxing_filter_fixed_pairs( vertical_fixed, 1, rows );
+                return DTRUE;
+            }
+
+            boxing_memory_free( vertical_fixed );
+            boxing_memory_free( horizontal_fixed );
+        }
+    }
+
+    const int shift = boxing_filter_fixed_shift( c, count, BOXING_PIXEL_MAX );
+    if ( shift < 0 )
+    {
+        return DFALSE;
+    }
+
+    short * coeff_fixed = boxing_filter_fixed_quantize( c, count, shift );
+    double error = 0.0;
+    for ( int i = 0; i < count; i++ )
+    {
+        error += BOXING_PIXEL_MAX * fabs( c[i] - (double)coeff_fixed[i] / ( 1 << shift ) );
+    }
+    if ( error > BOXING_FILTER_FIXED_MAX_ERROR )
+    {
+        boxing_memory_free( coeff_fixed );
+        return DFALSE;
+    }
+
+    fixed->rows = rows;
+    fixed->cols = cols;
+    fixed->shift = shift;
+    fixed->coeff = coeff_fixed;
+    fixed->coeff_pairs = boxing_filter_fixed_pairs( coeff_fixed, rows, cols );
+    return DTRUE;
+}
+
+static void boxing_filter_fixed_free( boxing_filter_fixed * fixed )
+{
+    boxing_memory_free( fixed->coeff );
+    boxing_memory_free( fixed->coeff_pairs );
+    boxing_memory_free( fixed->vertical );
+    boxing_memory_free( fixed->vertical_pairs );
+}
+
+static int boxing_filter_row_fixed_scalar( boxing_image8_pixel * destination, const short * const * lines,
+                                           const short * coeff, const int * coeff_pairs, int rows, int cols, int shift, int x, int width )
+{
+    BOXING_UNUSED_PARAMETER( coeff_pairs );
+
+    for ( ; x < width; x++ )
+    {
+        int value = 0;
+        for ( int i = 0; i < rows; i++ )
+        {
+            const short * line = lines[i] + x;
+            for ( int j = 0; j < cols; j++ )
+            {
+                value += coeff[i * cols + j] * line[j];
+            }
+        }
+
+        value >>= shift;
+        destination[x] = (boxing_image8_pixel)BOXING_MATH_CLAMP( BOXING_PIXEL_MIN, BOXING_PIXEL_MAX, value );
+    }
+    return x;
+}
+
+static int boxing_filter_column_fixed_scalar( short * destination, const short * const * lines,
+                                              const short * coeff, const int * coeff_pairs, int rows, int shift, int x, int width )
+{
+    BOXING_UNUSED_PARAMETER( coeff_pairs );
+
+    for ( ; x < width; x++ )
+    {
+        int value = 1 << ( shift - 1 );
+        for ( int i = 0; i < rows; i++ )
+        {
+            value += coeff[i] * lines[i][x];
+        }
+        destination[x] = (short)( value >> shift );
+    }
+    return x;
+}
+
+// The fixed point SIMD kernels multiply pairs of neighbouring 16 bit values
+// with pairs of coefficients and add them in 32 bits. All sums fit in 32 bits
+// (see boxing_filter_fixed_shift), the result is therefore identical to the
+// scalar kernels.
+
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("sse2")
+static int boxing_filter_row_fixed_sse2( boxing_image8_pixel * destination, const short * const * lines,
+                                         const short * coeff, const int * coeff_pairs, int rows, int cols, int shift, int x, int width )
+{
+    BOXING_UNUSED_PARAMETER( coeff );
+    const int pairs = ( cols + 1 ) / 2;
+    const __m128i count = _mm_cvtsi32_si128( shift );
+
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        __m128i value0 = _mm_setzero_si128();
+        __m128i value1 = _mm_setzero_si128();
+        for ( int i = 0; i < rows; i++ )
+        {
+            const short * line = lines[i] + x;
+            for ( int j = 0; j < pairs; j++ )
+            {
+                const __m128i c = _mm_set1_epi32( coeff_pairs[i * pairs + j] );
+                const __m128i a = _mm_loadu_si128( (const __m128i *)( line + 2 * j ) );
+                const __m128i b = _mm_loadu_si128( (const __m128i *)( line + 2 * j + 1 ) );
+                value0 = _mm_add_epi32( value0, _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), c ) );
+                value1 = _mm_add_epi32( value1, _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), c ) );
+            }
+        }
+
+        __m128i packed = _mm_packs_epi32( _mm_sra_epi32( value0, count ), _mm_sra_epi32( value1, count ) );
+        _mm_storel_epi64( (__m128i *)( destination + x ), _mm_packus_epi16( packed, packed ) );
+    }
+    return x;
+}
+
+BOXING_CPU_TARGET("avx2")
+static int boxing_filter_row_fixed_avx2( boxing_image8_pixel * destination, const short * const * lines,
+                                         const short * coeff, const int * coeff_pairs, int rows, int cols, int shift, int x, int width )
+{
+    const int pairs = ( cols + 1 ) / 2;
+    const __m128i count = _mm_cvtsi32_si128( shift );
+
+    for ( ; x + 16 <= width; x += 16 )
+    {
+        // The unpacked halves hold pixels 0-3 and 8-11, and 4-7 and 12-15
+        __m256i value0 = _mm256_setzero_si256();
+        __m256i value1 = _mm256_setzero_si256();
+        for ( int i = 0; i < rows; i++ )
+        {
+            const short * line = lines[i] + x;
+            for ( int j = 0; j < pairs; j++ )
+            {
+                const __m256i c = _mm256_set1_epi32( coeff_pairs[i * pairs + j] );
+                const __m256i a = _mm256_loadu_si256( (const __m256i *)( line + 2 * j ) );
+                const __m256i b = _mm256_loadu_si256( (const __m256i *)( line + 2 * j + 1 ) );
+                value0 = _mm256_add_epi32( value0, _mm256_madd_epi16( _mm256_unpacklo_epi16( a, b ), c ) );
+                value1 = _mm256_add_epi32( value1, _mm256_madd_epi16( _mm256_unpackhi_epi16( a, b ), c ) );
+            }
+        }
+
+        __m256i packed = _mm256_packs_epi32( _mm256_sra_epi32( value0, count ), _mm256_sra_epi32( value1, count ) );
+        packed = _mm256_permute4x64_epi64( _mm256_packus_epi16( packed, packed ), 0xD8 );
+        _mm_storeu_si128( (__m128i *)( destination + x ), _mm256_castsi256_si128( packed ) );
+    }
+    return boxing_filter_row_fixed_sse2( destination, lines, coeff, coeff_pairs, rows, cols, shift, x, width );
+}
+
+BOXING_CPU_TARGET("sse2")
+static int boxing_filter_column_fixed_sse2( short * destination, const short * const * lines,
+                                            const short * coeff, const int * coeff_pairs, int rows, int shift, int x, int width )
+{
+    BOXING_UNUSED_PARAMETER( coeff );
+    const int pairs = ( rows + 1 ) / 2;
+    const __m128i round = _mm_set1_epi32( 1 << ( shift - 1 ) );
+    const __m128i count = _mm_cvtsi32_si128( shift );
+
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        __m128i value0 = round;
+        __m128i value1 = round;
+        for ( int i = 0; i < pairs; i++ )
+        {
+            const __m128i c = _mm_set1_epi32( coeff_pairs[i] );
+            const __m128i a = _mm_loadu_si128( (const __m128i *)( lines[2 * i] + x ) );
+            const __m128i b = 2 * i + 1 < rows ? _mm_loadu_si128( (const __m128i *)( lines[2 * i + 1] + x ) ) : _mm_setzero_si128();
+            value0 = _mm_add_epi32( value0, _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), c ) );
+            value1 = _mm_add_epi32( value1, _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), c ) );
+        }
+
+        __m128i packed = _mm_packs_epi32( _mm_sra_epi32( value0, count ), _mm_sra_epi32( value1, count ) );
+        _mm_storeu_si128( (__m128i *)( destination + x ), packed );
+    }
+    return x;
+}
+
+BOXING_CPU_TARGET("avx2")
+static int boxing_filter_column_fixed_avx2( short * destination, const short * const * lines,
+                                            const short * coeff, const int * coeff_pairs, int rows, int shift, int x, int width )
+{
+    const int pairs = ( rows + 1 ) / 2;
+    const __m256i round = _mm256_set1_epi32( 1 << ( shift - 1 ) );
+    const __m128i count = _mm_cvtsi32_si128( shift );
+
+    for ( ; x + 16 <= width; x += 16 )
+    {
+        __m256i value0 = round;
+        __m256i value1 = round;
+        for ( int i = 0; i < pairs; i++ )
+        {
+            const __m256i c = _mm256_set1_epi32( coeff_pairs[i] );
+            const __m256i a = _mm256_loadu_si256( (const __m256i *)( lines[2 * i] + x ) );
+            const __m256i b = 2 * i + 1 < rows ? _mm256_loadu_si256( (const __m256i *)( lines[2 * i + 1] + x ) ) : _mm256_setzero_si256();
+            value0 = _mm256_add_epi32( value0, _mm256_madd_epi16( _mm256_unpacklo_epi16( a, b ), c ) );
+            value1 = _mm256_add_epi32( value1, _mm256_madd_epi16( _mm256_unpackhi_epi16( a, b ), c ) );
+        }
+
+        __m256i packed = _mm256_packs_epi32( _mm256_sra_epi32( value0, count ), _mm256_sra_epi32( value1, count ) );
+        _mm256_storeu_si256( (__m256i *)( destination + x ), packed );
+    }
+    return boxing_filter_column_fixed_sse2( destination, lines, coeff, coeff_pairs, rows, shift, x, width );
+}
+
+BOXING_CPU_TARGET("sse2")
+static int boxing_filter_widen_sse2( short * destination, const boxing_image8_pixel * pixels, int x, int width )
+{
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; x + 16 <= width; x += 16 )
+    {
+        const __m128i value = _mm_loadu_si128( (const __m128i *)( pixels + x ) );
+        _mm_storeu_si128( (__m128i *)( destination + x ), _mm_unpacklo_epi8( value, zero ) );
+        _mm_storeu_si128( (__m128i *)( destination + x + 8 ), _mm_unpackhi_epi8( value, zero ) );
+    }
+    return x;
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static int boxing_filter_widen_neon( short * destination, const boxing_image8_pixel * pixels, int x, int width )
+{
+    for ( ; x + 16 <= width; x += 16 )
+    {
+        const uint8x16_t value = vld1q_u8( pixels + x );
+        vst1q_s16( destination + x, vreinterpretq_s16_u16( vmovl_u8( vget_low_u8( value ) ) ) );
+        vst1q_s16( destination + x + 8, vreinterpretq_s16_u16( vmovl_u8( vget_high_u8( value ) ) ) );
+    }
+    return x;
+}
+
+static int boxing_filter_row_fixed_neon( boxing_image8_pixel * destination, const short * const * lines,
+                                         const short * coeff, const int * coeff_pairs, int rows, int cols, int shift, int x, int width )
+{
+    BOXING_UNUSED_PARAMETER( coeff_pairs );
+    const int32x4_t count = vdupq_n_s32( -shift );
+
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        int32x4_t value0 = vdupq_n_s32( 0 );
+        int32x4_t value1 = vdupq_n_s32( 0 );
+        for ( int i = 0; i < rows; i++ )
+        {
+            const short * line = lines[i] + x;
+            for ( int j = 0; j < cols; j++ )
+            {
+                const int16x8_t a = vld1q_s16( line + j );
+                value0 = vmlal_n_s16( value0, vget_low_s16( a ), coeff[i * cols + j] );
+                value1 = vmlal_n_s16( value1, vget_high_s16( a ), coeff[i * cols + j] );
+            }
+        }
+
+        const int16x8_t packed = vcombine_s16( vqmovn_s32( vshlq_s32( value0, count ) ), vqmovn_s32( vshlq_s32( value1, count ) ) );
+        vst1_u8( destination + x, vqmovun_s16( packed ) );
+    }
+    return x;
+}
+
+static int boxing_filter_column_fixed_neon( short * destination, const short * const * lines,
+                                            const short * coeff, const int * coeff_pairs, int rows, int shift, int x, int width )
+{
+    BOXING_UNUSED_PARAMETER( coeff_pairs );
+    const int32x4_t round = vdupq_n_s32( 1 << ( shift - 1 ) );
+    const int32x4_t count = vdupq_n_s32( -shift );
+
+    for ( ; x + 8 <= width; x += 8 )
+    {
+        int32x4_t value0 = round;
+        int32x4_t value1 = round;
+        for ( int i = 0; i < rows; i++ )
+        {
+            const int16x8_t a = vld1q_s16( lines[i] + x );
+            value0 = vmlal_n_s16( value0, vget_low_s16( a ), coeff[i] );
+            value1 = vmlal_n_s16( value1, vget_high_s16( a ), coeff[i] );
+        }
+
+        vst1q_s16( destination + x, vcombine_s16( vqmovn_s32( vshlq_s32( value0, count ) ), vqmovn_s32( vshlq_s32( value1, count ) ) ) );
+    }
+    return x;
+}
+
+#endif
+
+static boxing_filter_fixed_row_kernel boxing_filter_select_fixed_kernel( void )
+{
+#if defined (BOXING_CPU_X86)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_AVX2 ) )
+    {
+        return boxing_filter_row_fixed_avx2;
+    }
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_SSE2 ) )
+    {
+        return boxing_filter_row_fixed_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_NEON ) )
+    {
+        return boxing_filter_row_fixed_neon;
+    }
+#endif
+    return NULL;
+}
+
+static boxing_filter_fixed_column_kernel boxing_filter_select_fixed_column_kernel( void )
+{
+#if defined (BOXING_CPU_X86)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_AVX2 ) )
+    {
+        return boxing_filter_column_fixed_avx2;
+    }
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_SSE2 ) )
+    {
+        return boxing_filter_column_fixed_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_NEON ) )
+    {
+        return boxing_filter_column_fixed_neon;
+    }
+#endif
+    return NULL;
+}
+
+static boxing_filter_widen_kernel boxing_filter_select_widen_kernel( void )
+{
+#if defined (BOXING_CPU_X86)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_SSE2 ) )
+    {
+        return boxing_filter_widen_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if ( boxing_cpu_has_feature( BOXING_CPU_FEATURE_NEON ) )
+    {
+        return boxing_filter_widen_neon;
+    }
+#endif
+    return NULL;
+}
+
+// Widen image row to 16 bit and pad it with wrapped pixels on both sides, 
+// followed by a zero read by the pairwise kernels
+static void boxing_filter_load_line_fixed( short * line, const boxing_image8_pixel * pixels, int width, int x_radius, int cols, boxing_filter_widen_kernel widen )
+{
+    const int line_width = width + cols - 1;
+    for ( int k = 0; k < x_radius; k++ )
+    {
+        line[k] = pixels[( ( ( k - x_radius ) % width ) + width ) % width];
+    }
+    int x = 0;
+    if ( widen )
+    {
+        x = widen( line + x_radius, pixels, x, width );
+    }
+    for ( ; x < width; x++ )
+    {
+        line[x_radius + x] = pixels[x];
+    }
+    for ( int k = x_radius + width; k < line_width; k++ )
+    {
+        line[k] = pixels[( k - x_radius ) % width];
+    }
+    line[line_width] = 0;
+}
+
+static void boxing_filter_band_fixed( void * user, int band )
+{
+    boxing_filter_job * job = (boxing_filter_job *)user;
+    const boxing_filter_fixed * fixed = job->fixed;
+    boxing_image8 * image = job->image;
+
+    const int width = (int)image->width;
+    const int height = (int)image->height;
+    const int rows = job->coeff->rows;
+    const int cols = job->coeff->cols;
+    const int y_radius = rows / 2;
+    const int x_radius = cols / 2;
+    const int line_width = width + cols - 1;
+    const int line_stride = line_width + 1;
+
+    const int y_begin = band * job->band_height;
+    const int y_end = BOXING_MATH_MIN( y_begin + job->band_height, height );
+    if ( y_begin >= y_end )
+    {
+        return;
+    }
+
+    // The intermediate line of separable filters follows the ring
+    short * ring = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY( short, (size_t)( rows + 1 ) * line_stride );
+    const short ** lines = BOXING_STACK_ALLOCATE_TYPE_ARRAY( const short *, rows );
+    if ( ring == NULL )
+    {
+        job->failed = DTRUE;
+        return;
+    }
+    short * column = ring + (size_t)rows * line_stride;
+    const short * column_line = column;
+    column[line_width] = 0;
+
+    for ( int y = y_begin - y_radius; y < y_end + rows - 1 - y_radius; y++ )
+    {
+        const boxing_image8_pixel * pixels = boxing_filter_band_line( job, band, y, y_begin, y_end );
+
+        boxing_filter_load_line_fixed( ring + (size_t)( ( ( y % rows ) + rows ) % rows ) * line_stride, pixels, width, x_radius, cols, job->widen_kernel );
+
+        const int y_output = y - ( rows - 1 - y_radius );
+        if ( y_output < y_begin )
+        {
+            continue;
+        }
+
+        for ( int i = 0; i < rows; i++ )
+        {
+            const int y_line = y_output - y_radius + i;
+            lines[i] = ring + (size_t)( ( ( y_line % rows ) + rows ) % rows ) * line_stride;
+        }
+
+        const short * const * input = lines;
+        if ( fixed->vertical )
+        {
+            int x = 0;
+            if ( job->fixed_column_kernel )
+            {
+                x = job->fixed_column_kernel( column, lines, fixed->vertical, fixed->vertical_pairs, fixed->vertical_rows, fixed->vertical_shift, x, line_width );
+            }
+            boxing_filter_column_fixed_scalar( column, lines, fixed->vertical, fixed->vertical_pairs, fixed->vertical_rows, fixed->vertical_shift, x, line_width );
+            input = &column_line;
+        }
+
+        boxing_image8_pixel * destination = IMAGE8_SCANLINE( image, y_output );
+        int x = 0;
+        if ( job->fixed_kernel )
+        {
+            x = job->fixed_kernel( destination, input, fixed->coeff, fixed->coeff_pairs, fixed->rows, fixed->cols, fixed->shift, x, width );
+        }
+        boxing_filter_row_fixed_scalar( destination, input, fixed->coeff, fixed->coeff_pairs, fixed->rows, fixed->cols, fixed->shift, x, width );
+    }
+
+    boxing_memory_free( ring );
+}
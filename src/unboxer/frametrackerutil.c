@@ -18,6 +18,7 @@
 #include    "boxing/unboxer/sampleutil.h"
 #include    "boxing/log.h"
 #include    "boxing/unboxer/histogramutils.h"
+#include    "boxing/unboxer/integralimage.h"
 #include    "boxing/math/dsp.h"
 #include    "boxing/math/math.h"
 #include    "boxing/platform/memory.h"
@@ -44,16 +45,40 @@
 
 const boxing_float FRAME_GEOMETRY_BORDER_THRESHOLD = 0.30f;
 
+// Corner mark coarse to fine search
+#define CORNER_MARK_SEARCH_LEVELS       3  // Coarsest search grid step is 8 pixels
+#define CORNER_MARK_SEARCH_MIN_TILE     4  // Smallest corner mark tile searched, in grid steps
+#define CORNER_MARK_CANDIDATES          8  // Candidates refined at each level
+#define CORNER_MARK_REFINE_RADIUS       3  // Search radius around a candidate on the finer level
+
 //  PRIVATE INTERFACE
 //
 
+// Corner mark error of a position in the search area, the squared distance of
+// the pixels in the black tiles to the dark level plus that of the pixels in
+// the white tiles to the bright level
+typedef struct corner_mark_error_s
+{
+    boxing_integral_image * integral_image;
+    boxing_pointi           location;
+    boxing_pointi           tile;
+    int                     histogram_min;
+    int                     histogram_max;
+} corner_mark_error;
+
+
 static void         median_filter(boxing_float * location, int height, int size);
 static void         find_max_location_rate(const boxing_float * data, int width, boxing_float reference, boxing_float sampling_rate, boxing_float * location, int height);
 static void         find_max_location_loc(const boxing_float * data, int width, boxing_float reference, boxing_float * location, int height);
-static void         calculate_maxmin(const boxing_image8 * image, const boxing_pointi * corner_mark, boxing_float x_sampling_rate, float y_sampling_rate, float * max, float * min);
+static void         calculate_maxmin(boxing_integral_image * integral_image, const boxing_pointi * corner_mark, boxing_float x_sampling_rate, float y_sampling_rate, float * max, float * min);
 static DBOOL        track_reference_bar_location(gvector * samples, boxing_double * locations, unsigned int locations_size, boxing_float sampling_rate, boxing_float reference_point);
-static boxing_float calculate_average(const boxing_float * matrix, int width, int x_location, int y_location, const boxing_pointi * dimension);
 static boxing_float vertical_displacement(int x, int y, int i, int j, float k, float l, const boxing_matrixf * displacement_matix);
+static boxing_pointi corner_mark_subpattern_dimension(boxing_float x_sampling_rate, boxing_float y_sampling_rate);
+static boxing_pointi find_corner_mark(const boxing_image8 * image, boxing_integral_image * integral_image, boxing_pointi location, boxing_pointi dimension,
+                                     boxing_float x_sampling_rate, boxing_float y_sampling_rate, DBOOL coarse_to_fine);
+static int           find_corner_mark_candidates(const corner_mark_error * error, int search_width, int search_height, int levels, boxing_pointi * candidates);
+static boxing_integral_image * acquire_integral_image(const boxing_image8 * image, boxing_integral_image * integral_image);
+static void          release_integral_image(boxing_integral_image * used, boxing_integral_image * integral_image);
 
 
 /*! 
@@ -84,6 +109,7 @@ static boxing_float vertical_displacement(int x, int y, int i, int j, float k, f
  *  Find reference bar edge function description.
  *
  *  \param[in]  image            Input image.
+ *  \param[in]  integral_image   Summed area tables of image, or NULL.
  *  \param[in]  start            Start point.
  *  \param[in]  stop             Stop point.
  *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
@@ -91,7 +117,7 @@ static boxing_float vertical_displacement(int x, int y, int i, int j, float k, f
  *  \return reference bar edge value.
  */
 
-boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge(const boxing_image8 * image, const boxing_pointi start, const boxing_pointi stop, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi start, const boxing_pointi stop, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
 {
     int length;
     int inc;
@@ -113,18 +139,15 @@ boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge(const boxing_i
     int y = start.y;
 
     int x_start = start.x - radius;
-    int x_end = start.x + radius;
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
 
     for(int i = 0; i < length; i++, y += inc)
     {
-        int avg = 0;
-        for(int x = x_start; x <= x_end; x++)
-        {
-            avg += IMAGE8_PIXEL(image, x, y);
-        }
+        int avg = (int)boxing_integral_image_sum(sums, x_start, y, radius*2+1, 1);
         samples[i] = (boxing_float)avg;
         samples[i] /= (boxing_float)radius*2+1;
     }
+    release_integral_image(sums, integral_image);
 
     // filter coeffs
     boxing_float filter_coefficients[3];
@@ -144,6 +167,27 @@ boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge(const boxing_i
 }
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Find reference bar edge.
+ *
+ *  Same as boxing_frame_tracker_util_find_h_reference_bar_edge_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image            Input image.
+ *  \param[in]  start            Start point.
+ *  \param[in]  stop             Stop point.
+ *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
+ *  \param[in]  y_sampling_rate  Sampling rate along the Y axis.
+ *  \return reference bar edge value.
+ */
+
+boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge(const boxing_image8 * image, const boxing_pointi start, const boxing_pointi stop, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    return boxing_frame_tracker_util_find_h_reference_bar_edge_integral(image, NULL, start, stop, x_sampling_rate, y_sampling_rate);
+}
+
+
 //----------------------------------------------------------------------------
 /*!
  *  \brief Track vertical border.
@@ -151,6 +195,7 @@ boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge(const boxing_i
  *  Track vertical border function description.
  *
  *  \param[in]  image            Input image.
+ *  \param[in]  integral_image   Summed area tables of image, or NULL.
  *  \param[in]  from             Start point.
  *  \param[in]  to               Stop point.
  *  \param[out] border_location  Border location.
@@ -158,7 +203,7 @@ boxing_pointf boxing_frame_tracker_util_find_h_reference_bar_edge(const boxing_i
  *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
  */
 
-void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image, const boxing_pointi * from, const boxing_pointi * to, boxing_float * border_location, int scan_direction, boxing_float x_sampling_rate)
+void boxing_frame_tracker_util_track_vertical_border_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi * from, const boxing_pointi * to, boxing_float * border_location, int scan_direction, boxing_float x_sampling_rate)
 {
     // upper left corner of sampling area
     boxing_pointi location = {(from->x < to->x) ? from->x : to->x, from->y};
@@ -177,7 +222,7 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
 #define FIXED_POINT_BLACKMAN
 #ifdef FIXED_POINT_BLACKMAN
     const unsigned int blackman_window_fixed = (unsigned int)(blackman_window * 10000000.0f);
-    unsigned int image_width = image->width;
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
 #endif
 
     unsigned int data_size_y = dimension.y;
@@ -196,7 +241,6 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
     {
         boxing_float * it = data + row * data_size_x;
 
-        // SLOW: Fix this
         for(unsigned int col = 0, x = location_x; col < data_size_x; col++, x++)
         {
 #ifndef FIXED_POINT_BLACKMAN
@@ -211,18 +255,9 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
             }
             *it = scan_filter_a * a + scan_filter_b * b;
 #else
-            unsigned int a_fixed = 0;
-            unsigned int b_fixed = 0;
-
-            unsigned int blackman_y = y-blackman_window_size/2;
-            const boxing_image8_pixel * data = IMAGE8_PPIXEL(image, x - 1, blackman_y);//image.data( x-1, blackman_y + 0 );
-            for(unsigned int j = 0; j < blackman_window_size; j++)
-            {
-                a_fixed += (*data) * blackman_window_fixed;
-                data += 2;
-                b_fixed += (*data) * blackman_window_fixed;
-                data += image_width - 2;
-            }
+            int blackman_y = (int)(y-blackman_window_size/2);
+            unsigned int a_fixed = (unsigned int)boxing_integral_image_sum(sums, (int)x - 1, blackman_y, 1, blackman_window_size) * blackman_window_fixed;
+            unsigned int b_fixed = (unsigned int)boxing_integral_image_sum(sums, (int)x + 1, blackman_y, 1, blackman_window_size) * blackman_window_fixed;
             *it = scan_filter_a * (a_fixed/10000000.0f) + scan_filter_b * (b_fixed/10000000.0f);
             assert( isfinite( *it ) );
 #endif
@@ -230,6 +265,10 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
         }
     }
 
+#ifdef FIXED_POINT_BLACKMAN
+    release_integral_image(sums, integral_image);
+#endif
+
     find_max_location_rate(data, data_size_x, reference, x_sampling_rate, locations, data_size_y);
 
     // Normalize window
@@ -248,6 +287,27 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
 }
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Track vertical border.
+ *
+ *  Same as boxing_frame_tracker_util_track_vertical_border_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image            Input image.
+ *  \param[in]  from             Start point.
+ *  \param[in]  to               Stop point.
+ *  \param[out] border_location  Border location.
+ *  \param[in]  scan_direction   Scan direction.
+ *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
+ */
+
+void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image, const boxing_pointi * from, const boxing_pointi * to, boxing_float * border_location, int scan_direction, boxing_float x_sampling_rate)
+{
+    boxing_frame_tracker_util_track_vertical_border_integral(image, NULL, from, to, border_location, scan_direction, x_sampling_rate);
+}
+
+
 //----------------------------------------------------------------------------
 /*!
  *  \brief Calculate average max/min value.
@@ -255,6 +315,7 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
  *  Calculate average max/min value function description.
  *
  *  \param[in]  image              Input image.
+ *  \param[in]  integral_image     Summed area tables of image, or NULL.
  *  \param[in]  corner_marks       Corner marks array.
  *  \param[in]  corner_marks_size  Corner marks array size.
  *  \param[out] x_sampling_rate    Sampling rate along the X axis.
@@ -263,8 +324,9 @@ void boxing_frame_tracker_util_track_vertical_border(const boxing_image8 * image
  *  \param[in]  avg_min            Average min.
  */
 
-void boxing_frame_tracker_util_calculate_average_maxmin(
+void boxing_frame_tracker_util_calculate_average_maxmin_integral(
     const boxing_image8 * image, 
+    boxing_integral_image * integral_image,
     const boxing_pointi *const * corner_marks, 
     int corner_marks_size, 
     boxing_float x_sampling_rate, 
@@ -274,20 +336,44 @@ void boxing_frame_tracker_util_calculate_average_maxmin(
 {
     *avg_max = BOXING_PIXEL_MIN;
     *avg_min = BOXING_PIXEL_MIN;
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
 
     for(int i = 0; i < corner_marks_size; i++)
     {
         boxing_float max;
         boxing_float min;
-        calculate_maxmin(image, corner_marks[i], x_sampling_rate, y_sampling_rate, &max, &min);
+        calculate_maxmin(sums, corner_marks[i], x_sampling_rate, y_sampling_rate, &max, &min);
         *avg_max += max;
         *avg_min += min;
     }
+    release_integral_image(sums, integral_image);
     *avg_max /= corner_marks_size;
     *avg_min /= corner_marks_size;
 }
 
 
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Calculate average max/min value.
+ *
+ *  Same as boxing_frame_tracker_util_calculate_average_maxmin_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image              Input image.
+ *  \param[in]  corner_marks       Corner marks array.
+ *  \param[in]  corner_marks_size  Corner marks array size.
+ *  \param[out] x_sampling_rate    Sampling rate along the X axis.
+ *  \param[in]  y_sampling_rate    Sampling rate along the Y axis.
+ *  \param[in]  avg_max            Average max.
+ *  \param[in]  avg_min            Average min.
+ */
+
+void boxing_frame_tracker_util_calculate_average_maxmin(const boxing_image8 * image, const boxing_pointi *const * corner_marks, int corner_marks_size, boxing_float x_sampling_rate, boxing_float y_sampling_rate, boxing_float * avg_max, boxing_float * avg_min)
+{
+    boxing_frame_tracker_util_calculate_average_maxmin_integral(image, NULL, corner_marks, corner_marks_size, x_sampling_rate, y_sampling_rate, avg_max, avg_min);
+}
+
+
 //---------------------------------------------------------------------------- 
 /*! 
  *  \brief  Track reference bar.
@@ -439,16 +525,17 @@ DBOOL boxing_frame_tracker_util_track_reference_bar(
  *  vertical border. It searches along a column stainting in from and the column
  *  lenght is given by length, both in sampled coordinate space.
  *
- *  \param[in]  image   Source image containing the full frame.
- *  \param[in]  from    Start point of search.
- *  \param[in]  lenght  Lenght in pixels (x-direction). Negative value will 
- *                      search for left border.
- *  \param[out] border  Cooridinate of vertical border (if found).
+ *  \param[in]  image           Source image containing the full frame.
+ *  \param[in]  integral_image  Summed area tables of image, or NULL.
+ *  \param[in]  from            Start point of search.
+ *  \param[in]  lenght          Lenght in pixels (x-direction). Negative value will 
+ *                              search for left border.
+ *  \param[out] border          Cooridinate of vertical border (if found).
  *  \return DTRUE if border is found.
  *
  */
 
-DBOOL boxing_frame_tracker_util_find_vertical_border(const boxing_image8 * image, const boxing_pointi * from, int lenght, boxing_pointi * border)
+DBOOL boxing_frame_tracker_util_find_vertical_border_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi * from, int lenght, boxing_pointi * border)
 {
 
     // config parameters
@@ -484,6 +571,7 @@ DBOOL boxing_frame_tracker_util_find_vertical_border(const boxing_image8 * image
     hist = NULL;
 
     threshold = (int)(histogram_min + (histogram_max - histogram_min) * FRAME_GEOMETRY_BORDER_THRESHOLD);
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
 
     while(1)
     {
@@ -507,22 +595,46 @@ DBOOL boxing_frame_tracker_util_find_vertical_border(const boxing_image8 * image
             boxing_pointi point_from = {(start_x < stop_x ? x : x-pixel_size), y - rectangle_size/2};
             boxing_pointi dimension = {pixel_size, rectangle_size};
 
-            boxing_float average = boxing_histogram_calc_average_image(image, &point_from, &dimension);
+            boxing_float average = boxing_integral_image_average(sums, &point_from, &dimension);
 
             if (average > threshold)
             {
                 border->x = x-1;
                 border->y = y;
                 DLOG_INFO2("Found border candidate at: %ix%i", x, y-1);
+                release_integral_image(sums, integral_image);
                 return DTRUE;
             }
         }
     }
 
+    release_integral_image(sums, integral_image);
     DLOG_ERROR("boxing_frame_tracker_util_find_vertical_border failed");
     return DFALSE;
 }
 
+
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief  Locate left or right vertical border of image.
+ *
+ *  Same as boxing_frame_tracker_util_find_vertical_border_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image           Source image containing the full frame.
+ *  \param[in]  from            Start point of search.
+ *  \param[in]  lenght          Lenght in pixels (x-direction). Negative value will 
+ *                              search for left border.
+ *  \param[out] border          Cooridinate of vertical border (if found).
+ *  \return DTRUE if border is found.
+ *
+ */
+
+DBOOL boxing_frame_tracker_util_find_vertical_border(const boxing_image8 * image, const boxing_pointi * from, int lenght, boxing_pointi * border)
+{
+    return boxing_frame_tracker_util_find_vertical_border_integral(image, NULL, from, lenght, border);
+}
+
 //---------------------------------------------------------------------------- 
 /*! 
  *  \brief Locate top or bottom horizontal border of image. 
@@ -531,15 +643,16 @@ DBOOL boxing_frame_tracker_util_find_vertical_border(const boxing_image8 * image
  *  horizontal border. It searches along a line stainting in from and the line
  *  lenght is given by length, both in sampled coordinate space.
  * 
- *  \param[in]  image   Source image containing the full frame. 
- *  \param[in]  from    Start point of search. 
- *  \param[in]  length  Lenght in pixels (y-direction). Negative value will 
- *                      search for bottom border. 
- *  \param[in]  border  Cooridinate of horizontal border (if found).
+ *  \param[in]  image           Source image containing the full frame. 
+ *  \param[in]  integral_image  Summed area tables of image, or NULL.
+ *  \param[in]  from            Start point of search. 
+ *  \param[in]  length          Lenght in pixels (y-direction). Negative value will 
+ *                              search for bottom border. 
+ *  \param[in]  border          Cooridinate of horizontal border (if found).
  *  \return DTRUE if border is found. 
  */ 
 
-DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * image, const boxing_pointi * from, int length, boxing_pointi * border)
+DBOOL boxing_frame_tracker_util_find_horizontal_border_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const boxing_pointi * from, int length, boxing_pointi * border)
 {
     // config parameters 
     int rectangle_size = 200;
@@ -573,6 +686,7 @@ DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * ima
     hist = NULL;
 
     threshold = (int)(histogram_min + (histogram_max - histogram_min) * FRAME_GEOMETRY_BORDER_THRESHOLD);
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
 
     int inc;
     int stop = stop_y;
@@ -596,7 +710,7 @@ DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * ima
             boxing_pointi point_from = {x - rectangle_size/2, (start_y < stop_y ? y : y-pixel_size)};
             boxing_pointi dimension = {rectangle_size, pixel_size};
 
-            boxing_float average = boxing_histogram_calc_average_image(image, &point_from, &dimension);
+            boxing_float average = boxing_integral_image_average(sums, &point_from, &dimension);
 
             if (average > threshold)
             {
@@ -604,15 +718,38 @@ DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * ima
                 border->y = y-1;
 
                 DLOG_INFO2("Found horizontal border candidate at: %ix%i", x, y-1);
+                release_integral_image(sums, integral_image);
                 return DTRUE;
             }
         }
     }
 
+    release_integral_image(sums, integral_image);
     DLOG_ERROR("boxing_frame_tracker_util_find_horizontal_border failed");
     return DFALSE;
 }
 
+
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate top or bottom horizontal border of image. 
+ *
+ *  Same as boxing_frame_tracker_util_find_horizontal_border_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image           Source image containing the full frame. 
+ *  \param[in]  from            Start point of search. 
+ *  \param[in]  length          Lenght in pixels (y-direction). Negative value will 
+ *                              search for bottom border. 
+ *  \param[in]  border          Cooridinate of horizontal border (if found).
+ *  \return DTRUE if border is found. 
+ */ 
+
+DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * image, const boxing_pointi * from, int length, boxing_pointi * border)
+{
+    return boxing_frame_tracker_util_find_horizontal_border_integral(image, NULL, from, length, border);
+}
+
 //---------------------------------------------------------------------------- 
 /*! 
  *  \brief Locate frame corner marks in image. 
@@ -631,7 +768,11 @@ DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * ima
  *  search area specified by location and dimension parameters. If the search area is
  *  outside the image, it's snapped to within image borders.
  *
+ *  Each position is scored from the summed area tables of the image, first
+ *  on coarse grids and then at full resolution around the best positions.
+ *
  *  \param[in]  image           Source image containing the full frame. 
+ *  \param[in]  integral_image  Summed area tables of image, or NULL.
  *  \param[in]  location        Top left corner of search area (image coordinates). 
  *  \param[in]  dimension       Size of search area (image coordinates). 
  *  \param[in]  x_sampling_rate Image pixels per logical pixel - x direction.
@@ -639,121 +780,87 @@ DBOOL boxing_frame_tracker_util_find_horizontal_border(const boxing_image8 * ima
  *  \return location of best matching corner mark in given search area. 
  */ 
 
-boxing_pointi boxing_frame_tracker_util_find_corner_mark(
+boxing_pointi boxing_frame_tracker_util_find_corner_mark_integral(
     const boxing_image8 * image, 
+    boxing_integral_image * integral_image,
     boxing_pointi location, 
     boxing_pointi dimension, 
     boxing_float x_sampling_rate, 
     boxing_float y_sampling_rate)
 {
+    return find_corner_mark(image, integral_image, location, dimension, x_sampling_rate, y_sampling_rate, DTRUE);
+}
 
-    // validate location
-    location.x = BOXING_MATH_CLAMP(0, (int)image->width-1, location.x);
-    location.y = BOXING_MATH_CLAMP(0, (int)image->height-1, location.y);
-
-    if((int)image->width-1 < location.x + dimension.x)
-    {
-        dimension.x = image->width-1;
-    }
-
-    // validate dimension
-    dimension.x = BOXING_MATH_CLAMP(0, (int)image->width-1, location.x + dimension.x) - location.x;
-    dimension.y = BOXING_MATH_CLAMP(0, (int)image->height-1, location.y + dimension.y) - location.y;
-
-    if(dimension.x == 0 || dimension.y == 0)
-    {
-        DLOG_WARNING( "Reference mark out of bounds" );
-        return location;
-    }
-
-    int dimension_x = dimension.x;
-    int dimension_y = dimension.y;
-    int location_x = location.x;
-    int location_y = location.y;
-
-    boxing_float * matrix_black = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_float, (dimension_y * dimension_x));
-    boxing_float * matrix_white = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_float, (dimension_y * dimension_x));
-
-    // calculate max and min
-    int histogram_min = BOXING_PIXEL_MIN;
-    int histogram_max = BOXING_PIXEL_MAX;
-    const boxing_float saturation = 0.05f;
-    boxing_histogram hist = boxing_histogram_create();
-    boxing_histogram_calc_hist(hist, image, &location, &dimension);
-    boxing_histogram_calc_limits(hist, &histogram_min, &histogram_max, saturation );
-    boxing_histogram_free(hist);
-    hist = NULL;
-
-    // precalulate values
-    for(int y = 0; y < dimension_y; y++)
-    {
-        for(int x = 0; x < dimension_x; x++)
-        {
-            int pixel = IMAGE8_PIXEL(image, location_x + x, location_y + y);
-            boxing_float min_delta = (boxing_float)(pixel - histogram_min);
-            boxing_float max_delta = (boxing_float)(pixel - histogram_max);
-
-            matrix_black[y * dimension_x + x] = min_delta * min_delta;
-            matrix_white[y * dimension_x + x] = max_delta * max_delta;
-        }
-    }
-
-    // create accumulated map
-    for(int x = 1; x < dimension_x; x++)
-    {
-        for(int y = 0; y < dimension_y; y++)
-        {
-            matrix_black[y * dimension_x + x] += matrix_black[y * dimension_x + x-1]; 
-            matrix_white[y * dimension_x + x] += matrix_white[y * dimension_x + x-1];
-        }
-    }
 
-    for(int y = 1; y < dimension_y; y++)
-    {
-        for(int x = 0; x < dimension_x; x++)
-        {
-            matrix_black[y * dimension_x + x] += matrix_black[(y-1) * dimension_x + x]; 
-            matrix_white[y * dimension_x + x] += matrix_white[(y-1) * dimension_x + x];
-        }
-    }
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate frame corner marks in image. 
+ *
+ *  Same as boxing_frame_tracker_util_find_corner_mark_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image           Source image containing the full frame. 
+ *  \param[in]  location        Top left corner of search area (image coordinates). 
+ *  \param[in]  dimension       Size of search area (image coordinates). 
+ *  \param[in]  x_sampling_rate Image pixels per logical pixel - x direction.
+ *  \param[in]  y_sampling_rate Image pixels per logical pixel - y direction.
+ *  \return location of best matching corner mark in given search area. 
+ */ 
 
-    boxing_float  min = BOXING_FLOAT_MAX;
-    boxing_pointi min_location = location;
+boxing_pointi boxing_frame_tracker_util_find_corner_mark(const boxing_image8 * image, boxing_pointi location, boxing_pointi dimension, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    return boxing_frame_tracker_util_find_corner_mark_integral(image, NULL, location, dimension, x_sampling_rate, y_sampling_rate);
+}
 
-    const int corner_mark_width = 32;
-    const int corner_mark_height = 32;
-    boxing_pointi subpattern_dimension = {(int)((corner_mark_width/2)*0.9f*x_sampling_rate), (int)((corner_mark_height/2)*0.9f*y_sampling_rate)};
 
-    if(subpattern_dimension.x % 2)
-        subpattern_dimension.x = subpattern_dimension.x + 1;
-    if(subpattern_dimension.y % 2)
-        subpattern_dimension.y = subpattern_dimension.y + 1;
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate frame corner marks in image by exhaustive search. 
+ * 
+ *  Scores every position in the search area at full resolution. This is the
+ *  reference for boxing_frame_tracker_util_find_corner_mark, which only scores
+ *  the most likely positions found on coarser search grids. That search is a
+ *  heuristic; it gave the same results as this one on the test images.
+ *
+ *  \param[in]  image           Source image containing the full frame. 
+ *  \param[in]  integral_image  Summed area tables of image, or NULL.
+ *  \param[in]  location        Top left corner of search area (image coordinates). 
+ *  \param[in]  dimension       Size of search area (image coordinates). 
+ *  \param[in]  x_sampling_rate Image pixels per logical pixel - x direction.
+ *  \param[in]  y_sampling_rate Image pixels per logical pixel - y direction.
+ *  \return location of best matching corner mark in given search area. 
+ */ 
 
-    for(int y = 0; y < dimension_y - subpattern_dimension.y*2; y++)
-    {
-        for(int x = 0; x < dimension_x - subpattern_dimension.x*2; x++)
-        {
-            boxing_float err = 0.0;
-            err += calculate_average(matrix_black, dimension_x, x, y, &subpattern_dimension);
-            err += calculate_average(matrix_black, dimension_x, x + subpattern_dimension.x, y + subpattern_dimension.y, &subpattern_dimension);
-            err += calculate_average(matrix_white, dimension_x, x + subpattern_dimension.x, y, &subpattern_dimension);
-            err += calculate_average(matrix_white, dimension_x, x, y + subpattern_dimension.y, &subpattern_dimension);
+boxing_pointi boxing_frame_tracker_util_find_corner_mark_exhaustive_integral(
+    const boxing_image8 * image, 
+    boxing_integral_image * integral_image,
+    boxing_pointi location, 
+    boxing_pointi dimension, 
+    boxing_float x_sampling_rate, 
+    boxing_float y_sampling_rate)
+{
+    return find_corner_mark(image, integral_image, location, dimension, x_sampling_rate, y_sampling_rate, DFALSE);
+}
 
-            if(min > err)
-            {
-                min = err;
-                min_location.x = location_x + x + subpattern_dimension.x;
-                min_location.y = location_y + y + subpattern_dimension.y;
-            }
 
-        }
-    }
-    boxing_memory_free(matrix_black);
-    boxing_memory_free(matrix_white);
-    
-    DLOG_INFO3( "Corner mark match factor (x=%i y=%i) = %f", location_x, location_y, sqrt(min)/(subpattern_dimension.x*2*subpattern_dimension.y*2) );
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate frame corner marks in image by exhaustive search. 
+ *
+ *  Same as boxing_frame_tracker_util_find_corner_mark_exhaustive_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image           Source image containing the full frame. 
+ *  \param[in]  location        Top left corner of search area (image coordinates). 
+ *  \param[in]  dimension       Size of search area (image coordinates). 
+ *  \param[in]  x_sampling_rate Image pixels per logical pixel - x direction.
+ *  \param[in]  y_sampling_rate Image pixels per logical pixel - y direction.
+ *  \return location of best matching corner mark in given search area. 
+ */ 
 
-    return min_location;
+boxing_pointi boxing_frame_tracker_util_find_corner_mark_exhaustive(const boxing_image8 * image, boxing_pointi location, boxing_pointi dimension, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    return boxing_frame_tracker_util_find_corner_mark_exhaustive_integral(image, NULL, location, dimension, x_sampling_rate, y_sampling_rate);
 }
 
 
@@ -825,16 +932,18 @@ void boxing_frame_tracker_util_add_displacement(const boxing_matrixf * displacem
  *  Locates frame by first locating frame borders, then locating corner marks.
  *
  *  \param[in]  image            Source image.
+ *  \param[in]  integral_image   Summed area tables of image, or NULL.
  *  \param[in]  corner_marks     Corner marks.
  *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
  *  \param[in]  y_sampling_rate  Sampling rate along the Y axis.
  *  \return DTRUE if frame is found.
  */
 
-DBOOL boxing_frame_tracker_util_find_frame(const boxing_image8 * image, frame_corner_marks * corner_marks, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+DBOOL boxing_frame_tracker_util_find_frame_integral(const boxing_image8 * image, boxing_integral_image * integral_image, frame_corner_marks * corner_marks, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
 {
     int width = image->width;
     int height = image->height;
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
 
     boxing_pointi top_samples[3];
     boxing_pointi bottom_samples[3];
@@ -852,30 +961,34 @@ DBOOL boxing_frame_tracker_util_find_frame(const boxing_image8 * image, frame_co
     for ( int i = 1; i < 4; i++ )
     {
         boxing_pointi point = {i*step_x, 0};
-        if (!boxing_frame_tracker_util_find_horizontal_border(image, &point, height / 4, &top_samples[i - 1]))
+        if (!boxing_frame_tracker_util_find_horizontal_border_integral(image, sums, &point, height / 4, &top_samples[i - 1]))
         {
             DLOG_ERROR("boxing_frame_tracker_util_find_frame unable to find top horizontal border");
+            release_integral_image(sums, integral_image);
             return DFALSE;
         }
         point.x = i*step_x;
         point.y = height-1;
-        if (!boxing_frame_tracker_util_find_horizontal_border(image, &point, -height / 4, &bottom_samples[i - 1]))
+        if (!boxing_frame_tracker_util_find_horizontal_border_integral(image, sums, &point, -height / 4, &bottom_samples[i - 1]))
         {
             DLOG_ERROR("boxing_frame_tracker_util_find_frame unable to find bottom horizontal border");
+            release_integral_image(sums, integral_image);
             return DFALSE;
         }
         point.x = 0;
         point.y = i*step_y;
-        if (!boxing_frame_tracker_util_find_vertical_border(image, &point, width / 4, &left_samples[i - 1]))
+        if (!boxing_frame_tracker_util_find_vertical_border_integral(image, sums, &point, width / 4, &left_samples[i - 1]))
         {
             DLOG_ERROR("boxing_frame_tracker_util_find_frame unable to find left vertical border");
+            release_integral_image(sums, integral_image);
             return DFALSE;
         }
         point.x = width-1;
         point.y = i*step_y;
-        if (!boxing_frame_tracker_util_find_vertical_border(image, &point, -width / 4, &right_samples[i - 1]))
+        if (!boxing_frame_tracker_util_find_vertical_border_integral(image, sums, &point, -width / 4, &right_samples[i - 1]))
         {
             DLOG_ERROR("boxing_frame_tracker_util_find_frame unable to find left vertical border");
+            release_integral_image(sums, integral_image);
             return DFALSE;
         }
 
@@ -922,15 +1035,109 @@ DBOOL boxing_frame_tracker_util_find_frame(const boxing_image8 * image, frame_co
     dimension.x = dimension.x*3;
     dimension.y = dimension.y*3;
 
-    *top_left     = boxing_frame_tracker_util_find_corner_mark(image, *top_left, dimension, x_sampling_rate, y_sampling_rate);
-    *top_right    = boxing_frame_tracker_util_find_corner_mark(image, *top_right, dimension, x_sampling_rate, y_sampling_rate);
-    *bottom_left  = boxing_frame_tracker_util_find_corner_mark(image, *bottom_left, dimension, x_sampling_rate, y_sampling_rate);
-    *bottom_right = boxing_frame_tracker_util_find_corner_mark(image, *bottom_right, dimension, x_sampling_rate, y_sampling_rate);
+    *top_left     = boxing_frame_tracker_util_find_corner_mark_integral(image, sums, *top_left, dimension, x_sampling_rate, y_sampling_rate);
+    *top_right    = boxing_frame_tracker_util_find_corner_mark_integral(image, sums, *top_right, dimension, x_sampling_rate, y_sampling_rate);
+    *bottom_left  = boxing_frame_tracker_util_find_corner_mark_integral(image, sums, *bottom_left, dimension, x_sampling_rate, y_sampling_rate);
+    *bottom_right = boxing_frame_tracker_util_find_corner_mark_integral(image, sums, *bottom_right, dimension, x_sampling_rate, y_sampling_rate);
 
+    release_integral_image(sums, integral_image);
     return DTRUE;
 }
 
 
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate frame in image. 
+ *
+ *  Same as boxing_frame_tracker_util_find_frame_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image            Source image.
+ *  \param[in]  corner_marks     Corner marks.
+ *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
+ *  \param[in]  y_sampling_rate  Sampling rate along the Y axis.
+ *  \return DTRUE if frame is found.
+ */
+
+DBOOL boxing_frame_tracker_util_find_frame(const boxing_image8 * image, frame_corner_marks * corner_marks, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    return boxing_frame_tracker_util_find_frame_integral(image, NULL, corner_marks, x_sampling_rate, y_sampling_rate);
+}
+
+
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate frame in image close to a previous location. 
+ *  
+ *  Locates the corner marks of a frame that is expected to be close to the
+ *  corner marks of a previously tracked frame, as consecutive frames on a reel
+ *  are. Each corner mark is searched for within search_radius image pixels of
+ *  its previous location. If a corner mark is not found inside the search
+ *  area the function fails, and the caller should fall back to
+ *  boxing_frame_tracker_util_find_frame.
+ *
+ *  \param[in]  image            Source image.
+ *  \param[in]  integral_image   Summed area tables of image, or NULL.
+ *  \param[in]  previous         Corner marks of the previous frame.
+ *  \param[out] corner_marks     Corner marks.
+ *  \param[in]  search_radius    Search radius in image pixels.
+ *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
+ *  \param[in]  y_sampling_rate  Sampling rate along the Y axis.
+ *  \return DTRUE if all corner marks are found within the search radius.
+ */
+
+DBOOL boxing_frame_tracker_util_find_frame_near_integral(const boxing_image8 * image, boxing_integral_image * integral_image, const frame_corner_marks * previous, frame_corner_marks * corner_marks,
+    int search_radius, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    boxing_pointi subpattern_dimension = corner_mark_subpattern_dimension(x_sampling_rate, y_sampling_rate);
+    boxing_pointi dimension = {2*(subpattern_dimension.x + search_radius) + 1, 2*(subpattern_dimension.y + search_radius) + 1};
+
+    const boxing_pointi * from[] = { &previous->top_left, &previous->top_right, &previous->bottom_left, &previous->bottom_right };
+    boxing_pointi * to[] = { &corner_marks->top_left, &corner_marks->top_right, &corner_marks->bottom_left, &corner_marks->bottom_right };
+    const int corner_count = sizeof(to)/sizeof(to[0]);
+    boxing_integral_image * sums = acquire_integral_image(image, integral_image);
+
+    for (int i = 0; i < corner_count; i++)
+    {
+        boxing_pointi location = {from[i]->x - subpattern_dimension.x - search_radius, from[i]->y - subpattern_dimension.y - search_radius};
+        *to[i] = boxing_frame_tracker_util_find_corner_mark_integral(image, sums, location, dimension, x_sampling_rate, y_sampling_rate);
+
+        // A match on the edge of the search area may be the edge of a mark outside it
+        if (abs(to[i]->x - from[i]->x) >= search_radius || abs(to[i]->y - from[i]->y) >= search_radius)
+        {
+            DLOG_INFO2("boxing_frame_tracker_util_find_frame_near corner mark moved to (%i, %i)", to[i]->x, to[i]->y);
+            release_integral_image(sums, integral_image);
+            return DFALSE;
+        }
+    }
+
+    release_integral_image(sums, integral_image);
+    return DTRUE;
+}
+
+
+//---------------------------------------------------------------------------- 
+/*! 
+ *  \brief Locate frame in image close to a previous location. 
+ *
+ *  Same as boxing_frame_tracker_util_find_frame_near_integral,
+ *  with the summed area tables calculated for the call.
+ *
+ *  \param[in]  image            Source image.
+ *  \param[in]  previous         Corner marks of the previous frame.
+ *  \param[out] corner_marks     Corner marks.
+ *  \param[in]  search_radius    Search radius in image pixels.
+ *  \param[in]  x_sampling_rate  Sampling rate along the X axis.
+ *  \param[in]  y_sampling_rate  Sampling rate along the Y axis.
+ *  \return DTRUE if all corner marks are found within the search radius.
+ */
+
+DBOOL boxing_frame_tracker_util_find_frame_near(const boxing_image8 * image, const frame_corner_marks * previous, frame_corner_marks * corner_marks, int search_radius, boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    return boxing_frame_tracker_util_find_frame_near_integral(image, NULL, previous, corner_marks, search_radius, x_sampling_rate, y_sampling_rate);
+}
+
+
 //----------------------------------------------------------------------------
 /*!
   * \} end of frametrackerutil group
@@ -940,6 +1147,292 @@ DBOOL boxing_frame_tracker_util_find_frame(const boxing_image8 * image, frame_co
 // PRIVATE FRAME TRACKER UTIL FUNCTIONS
 //
 
+// The summed area tables of the caller, or temporary tables for this call
+static boxing_integral_image * acquire_integral_image(const boxing_image8 * image, boxing_integral_image * integral_image)
+{
+    if (integral_image)
+    {
+        assert(integral_image->image == image);
+        return integral_image;
+    }
+    return boxing_integral_image_create(image);
+}
+
+
+static void release_integral_image(boxing_integral_image * used, boxing_integral_image * integral_image)
+{
+    if (used != integral_image)
+    {
+        boxing_integral_image_free(used);
+    }
+}
+
+
+// Size of one of the four squares of the corner mark symbol, slightly reduced
+// and rounded up to an even number of image pixels
+static boxing_pointi corner_mark_subpattern_dimension(boxing_float x_sampling_rate, boxing_float y_sampling_rate)
+{
+    const int corner_mark_width = 32;
+    const int corner_mark_height = 32;
+    boxing_pointi subpattern_dimension = {(int)((corner_mark_width/2)*0.9f*x_sampling_rate), (int)((corner_mark_height/2)*0.9f*y_sampling_rate)};
+
+    if(subpattern_dimension.x % 2)
+        subpattern_dimension.x = subpattern_dimension.x + 1;
+    if(subpattern_dimension.y % 2)
+        subpattern_dimension.y = subpattern_dimension.y + 1;
+
+    return subpattern_dimension;
+}
+
+
+// Squared distance of the pixels in a tile to level, expanded as
+// sum(p*p) - 2*level*sum(p) + count*level*level
+static inline boxing_uint64 corner_mark_tile_error(const corner_mark_error * error, int x, int y, int level)
+{
+    boxing_uint64 sum;
+    boxing_uint64 squared_sum;
+    boxing_integral_image_sums(error->integral_image, error->location.x + x, error->location.y + y, error->tile.x, error->tile.y, &sum, &squared_sum);
+
+    const boxing_uint64 count = (boxing_uint64)error->tile.x * (boxing_uint64)error->tile.y;
+    return squared_sum + count * (boxing_uint64)(level * level) - 2 * (boxing_uint64)level * sum;
+}
+
+
+static inline boxing_uint64 corner_mark_position_error(const corner_mark_error * error, int x, int y)
+{
+    return corner_mark_tile_error(error, x, y, error->histogram_min) +
+           corner_mark_tile_error(error, x + error->tile.x, y + error->tile.y, error->histogram_min) +
+           corner_mark_tile_error(error, x + error->tile.x, y, error->histogram_max) +
+           corner_mark_tile_error(error, x, y + error->tile.y, error->histogram_max);
+}
+
+
+static boxing_pointi find_corner_mark(
+    const boxing_image8 * image, 
+    boxing_integral_image * integral_image,
+    boxing_pointi location, 
+    boxing_pointi dimension, 
+    boxing_float x_sampling_rate, 
+    boxing_float y_sampling_rate,
+    DBOOL coarse_to_fine)
+{
+
+    // validate location
+    location.x = BOXING_MATH_CLAMP(0, (int)image->width-1, location.x);
+    location.y = BOXING_MATH_CLAMP(0, (int)image->height-1, location.y);
+
+    if((int)image->width-1 < location.x + dimension.x)
+    {
+        dimension.x = image->width-1;
+    }
+
+    // validate dimension
+    dimension.x = BOXING_MATH_CLAMP(0, (int)image->width-1, location.x + dimension.x) - location.x;
+    dimension.y = BOXING_MATH_CLAMP(0, (int)image->height-1, location.y + dimension.y) - location.y;
+
+    if(dimension.x == 0 || dimension.y == 0)
+    {
+        DLOG_WARNING( "Reference mark out of bounds" );
+        return location;
+    }
+
+    // calculate max and min
+    int histogram_min = BOXING_PIXEL_MIN;
+    int histogram_max = BOXING_PIXEL_MAX;
+    const boxing_float saturation = 0.05f;
+    boxing_histogram hist = boxing_histogram_create();
+    boxing_histogram_calc_hist(hist, image, &location, &dimension);
+    boxing_histogram_calc_limits(hist, &histogram_min, &histogram_max, saturation );
+    boxing_histogram_free(hist);
+    hist = NULL;
+
+    corner_mark_error error;
+    error.integral_image = acquire_integral_image(image, integral_image);
+    error.location = location;
+    error.tile = corner_mark_subpattern_dimension(x_sampling_rate, y_sampling_rate);
+    error.histogram_min = histogram_min;
+    error.histogram_max = histogram_max;
+
+    boxing_uint64 min = ~(boxing_uint64)0;
+    boxing_pointi min_location = location;
+
+    const int search_width = dimension.x - error.tile.x*2;
+    const int search_height = dimension.y - error.tile.y*2;
+
+    // Number of coarser search grids where a corner mark tile still spans
+    // several grid steps
+    int levels = 0;
+    if (coarse_to_fine)
+    {
+        while (levels < CORNER_MARK_SEARCH_LEVELS &&
+               (error.tile.x >> (levels + 1)) >= CORNER_MARK_SEARCH_MIN_TILE &&
+               (error.tile.y >> (levels + 1)) >= CORNER_MARK_SEARCH_MIN_TILE &&
+               (search_width >> (levels + 1)) > 0 &&
+               (search_height >> (levels + 1)) > 0)
+        {
+            levels++;
+        }
+    }
+
+    // Full resolution search area, either the whole search area or the
+    // neighbourhood of each candidate found on the coarser grids
+    boxing_pointi candidates[CORNER_MARK_CANDIDATES];
+    int candidate_count = 1;
+    int radius = 0;
+    if (levels > 0)
+    {
+        candidate_count = find_corner_mark_candidates(&error, search_width, search_height, levels, candidates);
+        radius = CORNER_MARK_REFINE_RADIUS;
+    }
+
+    int min_x = -1;
+    int min_y = -1;
+    for (int i = 0; i < candidate_count; i++)
+    {
+        int x_begin = 0;
+        int x_end = search_width;
+        int y_begin = 0;
+        int y_end = search_height;
+        if (levels > 0)
+        {
+            x_begin = BOXING_MATH_MAX(candidates[i].x - radius, 0);
+            x_end = BOXING_MATH_MIN(candidates[i].x + radius + 1, search_width);
+            y_begin = BOXING_MATH_MAX(candidates[i].y - radius, 0);
+            y_end = BOXING_MATH_MIN(candidates[i].y + radius + 1, search_height);
+        }
+
+        for(int y = y_begin; y < y_end; y++)
+        {
+            for(int x = x_begin; x < x_end; x++)
+            {
+                boxing_uint64 err = corner_mark_position_error(&error, x, y);
+
+                // Ties go to the first position in scan order, as in the exhaustive search
+                if(min > err || (min == err && (y < min_y || (y == min_y && x < min_x))))
+                {
+                    min = err;
+                    min_x = x;
+                    min_y = y;
+                    min_location.x = location.x + x + error.tile.x;
+                    min_location.y = location.y + y + error.tile.y;
+                }
+
+            }
+        }
+    }
+
+    release_integral_image(error.integral_image, integral_image);
+    
+    DLOG_INFO3( "Corner mark match factor (x=%i y=%i) = %f", location.x, location.y, sqrt((double)min)/(error.tile.x*2*error.tile.y*2) );
+
+    return min_location;
+}
+
+
+typedef struct corner_mark_candidate_s
+{
+    int           x;
+    int           y;
+    boxing_uint64 error;
+} corner_mark_candidate;
+
+
+// Keep the best candidates, a candidate next to a better one is dropped so
+// the candidates do not all end up on the same minimum
+static void add_corner_mark_candidate(corner_mark_candidate * candidates, int * count, int x, int y, boxing_uint64 error)
+{
+    int worst = 0;
+    for (int i = 0; i < *count; i++)
+    {
+        if (abs(candidates[i].x - x) <= 2 && abs(candidates[i].y - y) <= 2)
+        {
+            if (error < candidates[i].error)
+            {
+                candidates[i].x = x;
+                candidates[i].y = y;
+                candidates[i].error = error;
+            }
+            return;
+        }
+        if (candidates[i].error > candidates[worst].error)
+        {
+            worst = i;
+        }
+    }
+
+    if (*count < CORNER_MARK_CANDIDATES)
+    {
+        worst = (*count)++;
+    }
+    else if (error >= candidates[worst].error)
+    {
+        return;
+    }
+
+    candidates[worst].x = x;
+    candidates[worst].y = y;
+    candidates[worst].error = error;
+}
+
+
+// Find the most likely corner mark positions, in full resolution search
+// coordinates, by scoring every position on the coarsest search grid and
+// refining the best positions on each finer grid. A grid on level n has a
+// step of 2^n pixels, the error of a grid position is the full resolution
+// error, so the summed area tables are shared with the final search.
+static int find_corner_mark_candidates(const corner_mark_error * error, int search_width, int search_height, int levels, boxing_pointi * candidates)
+{
+    corner_mark_candidate found[CORNER_MARK_CANDIDATES];
+    int count = 0;
+    for (int level = levels; level >= 1; level--)
+    {
+        const int grid_width = ((search_width - 1) >> level) + 1;
+        const int grid_height = ((search_height - 1) >> level) + 1;
+
+        if (level == levels)
+        {
+            for (int y = 0; y < grid_height; y++)
+            {
+                for (int x = 0; x < grid_width; x++)
+                {
+                    add_corner_mark_candidate(found, &count, x, y, corner_mark_position_error(error, x << level, y << level));
+                }
+            }
+        }
+        else
+        {
+            corner_mark_candidate coarser[CORNER_MARK_CANDIDATES];
+            const int coarser_count = count;
+            for (int i = 0; i < coarser_count; i++)
+            {
+                coarser[i] = found[i];
+            }
+
+            count = 0;
+            for (int i = 0; i < coarser_count; i++)
+            {
+                const int y_end = BOXING_MATH_MIN(2*coarser[i].y + CORNER_MARK_REFINE_RADIUS + 1, grid_height);
+                const int x_end = BOXING_MATH_MIN(2*coarser[i].x + CORNER_MARK_REFINE_RADIUS + 1, grid_width);
+                for (int y = BOXING_MATH_MAX(2*coarser[i].y - CORNER_MARK_REFINE_RADIUS, 0); y < y_end; y++)
+                {
+                    for (int x = BOXING_MATH_MAX(2*coarser[i].x - CORNER_MARK_REFINE_RADIUS, 0); x < x_end; x++)
+                    {
+                        add_corner_mark_candidate(found, &count, x, y, corner_mark_position_error(error, x << level, y << level));
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        candidates[i].x = 2*found[i].x;
+        candidates[i].y = 2*found[i].y;
+    }
+    return count;
+}
+
+
 static boxing_float find_max_location(const boxing_float * data, unsigned int data_size, boxing_float reference)
 {
     boxing_float location = reference;
@@ -1263,7 +1756,7 @@ static void find_max_location_rate(const boxing_float * data, int width, boxing_
 
 
 static void calculate_maxmin(
-    const boxing_image8 * image,
+    boxing_integral_image * integral_image,
     const boxing_pointi * corner_mark,
     boxing_float x_sampling_rate,
     boxing_float y_sampling_rate,
@@ -1273,18 +1766,19 @@ static void calculate_maxmin(
     boxing_pointi dimension = { (int)(10 * x_sampling_rate), (int)(10 * y_sampling_rate) };
     boxing_pointi offset = { (int)(2 * x_sampling_rate), (int)(2 * y_sampling_rate) };
     boxing_pointi location;
+    const boxing_image8 * image = integral_image->image;
 
     *max = BOXING_PIXEL_MIN;
 
     /* upper right */
     location.x = BOXING_MATH_CLAMP(0, (int)image->width - 1, corner_mark->x + offset.x);
     location.y = BOXING_MATH_CLAMP(0, (int)image->height - 1, corner_mark->y - offset.y - dimension.y);
-    *max += (boxing_float)boxing_histogram_calc_average_image(image, &location, &dimension);
+    *max += (boxing_float)boxing_integral_image_average(integral_image, &location, &dimension);
 
     /* lower left */
     location.x = BOXING_MATH_CLAMP(0, (int)image->width - 1, corner_mark->x - offset.x - dimension.x);
     location.y = BOXING_MATH_CLAMP(0, (int)image->height - 1, corner_mark->y + offset.y);
-    *max += (boxing_float)boxing_histogram_calc_average_image(image, &location, &dimension);
+    *max += (boxing_float)boxing_integral_image_average(integral_image, &location, &dimension);
 
     *max /= 2;
 
@@ -1293,12 +1787,12 @@ static void calculate_maxmin(
     /* upper left */
     location.x = BOXING_MATH_CLAMP(0, (int)image->width - 1, corner_mark->x - offset.x - dimension.x);
     location.y = BOXING_MATH_CLAMP(0, (int)image->height - 1, corner_mark->y - offset.y - dimension.y);
-    *min += (boxing_float)boxing_histogram_calc_average_image(image, &location, &dimension);
+    *min += (boxing_float)boxing_integral_image_average(integral_image, &location, &dimension);
 
     /* lower right */
     location.x = BOXING_MATH_CLAMP(0, (int)image->width - 1, corner_mark->x + offset.x);
     location.y = BOXING_MATH_CLAMP(0, (int)image->height - 1, corner_mark->y + offset.y);
-    *min += (boxing_float)boxing_histogram_calc_average_image(image, &location, &dimension);
+    *min += (boxing_float)boxing_integral_image_average(integral_image, &location, &dimension);
 
     *min /= 2;
 }
@@ -1554,19 +2048,3 @@ static DBOOL track_reference_bar_location(gvector * samples, boxing_double * loc
 }
 
 
-static boxing_float calculate_average(const boxing_float * matrix, int width, int x_location, int y_location, const boxing_pointi * dimension)
-{
-    boxing_float retval = matrix[(y_location + dimension->y - 1) * width + x_location + dimension->x - 1];
-
-    if (x_location && y_location)
-    {
-        retval += matrix[(y_location - 1) * width + x_location - 1];
-        retval -= matrix[(y_location - 1) * width + x_location + dimension->x - 1];
-        retval -= matrix[(y_location + dimension->y - 1) * width + x_location - 1];
-    }
-    else if (y_location)
-        retval -= matrix[(y_location - 1) * width + x_location + dimension->x - 1];
-    else if (x_location)
-        retval -= matrix[(y_location + dimension->y - 1) * width + x_location - 1];
-    return retval;
-}
@@ -17,12 +17,16 @@
 #include "horizontalmeasures.h"
 #include "boxing/platform/memory.h"
 #include "boxing/platform/types.h"
+#include "boxing/platform/thread.h"
+#include "boxing/math/math.h"
 
 //  DEFINES
 //
 
-#define KMEANS_ITERATIONS      6
-#define KMEANS_HISTOGRAM_SIZE  256
+#define KMEANS_ITERATIONS       6
+// Iterations when starting from the centers of the neighbouring block
+#define KMEANS_WARM_ITERATIONS  3
+#define KMEANS_HISTOGRAM_SIZE   256
 
 typedef struct boxing_cluster_s
 {
@@ -30,12 +34,24 @@ typedef struct boxing_cluster_s
     int    count;
 } boxing_cluster;
 
+typedef struct block_row_job_s
+{
+    const boxing_image8 * image;
+    int                   block_width;
+    int                   block_height;
+    int                   cluster_count;
+    DBOOL                 calculate_variances;
+    boxing_matrix_float * centeroids;
+} block_row_job;
+
 //  PRIVATE INTERFACE
 //
-static void calculate_means(const boxing_image8 *image, int x, int y, int width, int height, boxing_float* means, boxing_float* variances, unsigned int means_size);
-static void kmeans(int * sampels, int sampels_size, float *means, int means_size, int iterations);
-static void calculate_inital_means_plusplus(boxing_float* means, int means_size, int * histogram, int histogram_size, int histogram_samples);
-static int  sample_histogram(const boxing_image8 *image, int x, int y, int width, int height, int *histogram);
+static boxing_matrix_float * calculate_block_means(const boxing_image8 * image, int block_width, int block_height, int cluster_count, DBOOL calculate_variances, int thread_count);
+static void calculate_block_row(void * user, int n);
+static void block_row_histograms(const boxing_image8 * image, int y, int block_width, int block_height, int block_count, int * histograms);
+static void calculate_histogram_means(const int * histogram, int samples, const boxing_float* initial_means, boxing_float* means, boxing_float* variances, unsigned int means_size);
+static void kmeans(const int * sampels, int sampels_size, float *means, int means_size, int iterations);
+static void calculate_inital_means_plusplus(boxing_float* means, int means_size, const int * histogram, int histogram_size, int histogram_samples);
 
 /*! 
   * \addtogroup unboxer
@@ -54,17 +70,24 @@ static int  sample_histogram(const boxing_image8 *image, int x, int y, int width
  *  run it through a k-means clustering algorithm to generate a given number of thresholds. The number of
  *  thresholds per block is cluster_count - 1. The returning theshold is a (cluster_count-1) x M x N matrix.
  *
+ *  The histograms of a row of blocks are collected in one pass over its pixel rows, and the last block,
+ *  which is moved inside the image and overlaps its neighbour, is slid from the neighbour's histogram
+ *  column by column. The k-means of a block starts from the centers of the block to its left and falls
+ *  back to k-means++ if that leaves a cluster empty. The rows of blocks are processed in parallel, the
+ *  result does not depend on the thread count.
+ *
  *  \param[in]  image           Image to be analysed.
  *  \param[in]  block_width     Sub image width.
  *  \param[out] block_height    Sub image height.
  *  \param[out] cluster_count   The number of symols being searched for in the local histograms.
+ *  \param[in]  thread_count    Number of worker threads, less than 1 uses all cores.
  *  \return Calculated thresholds.
  */
 
-boxing_matrix_float * boxing_calculate_thresholds(const boxing_image8 * image, int block_width, int block_height, int cluster_count)
+boxing_matrix_float * boxing_calculate_thresholds(const boxing_image8 * image, int block_width, int block_height, int cluster_count, int thread_count)
 {
 
-    boxing_matrix_float *centeroids =  boxing_calculate_means(image, block_width, block_height, cluster_count);
+    boxing_matrix_float *centeroids =  calculate_block_means(image, block_width, block_height, cluster_count, DFALSE, thread_count);
     boxing_matrix_float *thresholds = boxing_matrix_float_multipage_create(centeroids->rows, cluster_count - 1, centeroids->pages);
     for (unsigned int n = 0; n < thresholds->pages; n++)
     {
@@ -92,43 +115,46 @@ boxing_matrix_float * boxing_calculate_thresholds(const boxing_image8 * image, i
  *  boxing_calculate_means divides the input image into blocks of size block_width and block_height.
  *  Then it will generate a local histograms for each set of adjoining blocks and use this histogram to
  *  run it through a k-means clustering algorithm to generate a given number of means. The number of
- *  means per block is cluster_count. The returning theshold is a cluster_count x M x N matrix.
+ *  means per block is cluster_count, followed by the cluster_count variances. The returning matrix is a
+ *  2*cluster_count x M x N matrix. The blocks are processed as in boxing_calculate_thresholds.
  *
  *  \param[in]  image           Image to be analysed.
  *  \param[in]  block_width     Sub image width.
  *  \param[out] block_height    Sub image height.
  *  \param[out] cluster_count   The number of symols being searched for in the local histograms.
+ *  \param[in]  thread_count    Number of worker threads, less than 1 uses all cores.
  *  \return Calculated thresholds.
  */
 
-boxing_matrix_float * boxing_calculate_means(const boxing_image8 * image, int block_width, int block_height, int cluster_count)
+boxing_matrix_float * boxing_calculate_means(const boxing_image8 * image, int block_width, int block_height, int cluster_count, int thread_count)
 {
-    int width = image->width;
-    int height = image->height;
-    int horizontal_block_count = (width + block_width - 1) / block_width;
-    int vertical_block_count = (height + block_height - 1) / block_height;
+    return calculate_block_means(image, block_width, block_height, cluster_count, DTRUE, thread_count);
+}
 
-    boxing_matrix_float *centeroids = boxing_matrix_float_multipage_create(horizontal_block_count,  cluster_count * 2, vertical_block_count);
 
-    for (int n = 0; n < vertical_block_count; n++)
-    {
-        for (int m = 0; m < horizontal_block_count; m++)
-        {
-            unsigned int x = m * block_width;
-            if ((x + block_width) >= (unsigned int)image->width)
-                x = image->width - block_width;
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Calculate thresholds from a histogram.
+ *
+ *  Runs the same k-means clustering as boxing_calculate_thresholds on an already sampled histogram,
+ *  for callers that collect the histogram of a block themselves, e.g. from a sparse set of samples.
+ *  The histogram has 256 bins, one per gray level.
+ *
+ *  \param[in]  histogram       Histogram to be analysed.
+ *  \param[in]  samples         Number of samples in the histogram.
+ *  \param[out] thresholds      Calculated thresholds, cluster_count - 1 values.
+ *  \param[in]  cluster_count   The number of symols being searched for in the histogram.
+ */
 
-            unsigned int y = n * block_height;
-            if ((y + block_height) >= (unsigned int)image->height)
-                y = image->height - block_height;
+void boxing_calculate_histogram_thresholds(const int * histogram, int samples, boxing_float * thresholds, int cluster_count)
+{
+    boxing_float means[KMEANS_HISTOGRAM_SIZE];
+    calculate_histogram_means(histogram, samples, NULL, means, NULL, cluster_count);
 
-            boxing_float * means = MATRIX_MULTIPAGE_ROW_PTR(centeroids, m, n);
-            boxing_float * variances = means + cluster_count;
-            calculate_means(image, x, y, block_width, block_height, means, variances, cluster_count);
-        }
+    for (int i = 0; i < cluster_count - 1; i++)
+    {
+        thresholds[i] = (means[i] + means[i + 1]) / 2;
     }
-
-    return centeroids;
 }
 
 
@@ -141,65 +167,116 @@ boxing_matrix_float * boxing_calculate_means(const boxing_image8 * image, int bl
 // PRIVATE HORIZONTAL MEASURES FUNCTIONS
 //
 
-static int sample_histogram(const boxing_image8 *image, int x, int y, int width, int height, int *histogram)
+static boxing_matrix_float * calculate_block_means(const boxing_image8 * image, int block_width, int block_height, int cluster_count, DBOOL calculate_variances, int thread_count)
+{
+    int width = image->width;
+    int height = image->height;
+    int horizontal_block_count = (width + block_width - 1) / block_width;
+    int vertical_block_count = (height + block_height - 1) / block_height;
+
+    boxing_matrix_float *centeroids = boxing_matrix_float_multipage_create(horizontal_block_count,  cluster_count * 2, vertical_block_count);
+
+    block_row_job job;
+    job.image = image;
+    job.block_width = BOXING_MATH_MIN(block_width, width);
+    job.block_height = BOXING_MATH_MIN(block_height, height);
+    job.cluster_count = cluster_count;
+    job.calculate_variances = calculate_variances;
+    job.centeroids = centeroids;
+
+    boxing_thread_parallel_for(vertical_block_count, boxing_thread_resolve_count(thread_count, vertical_block_count), calculate_block_row, &job);
+
+    return centeroids;
+}
+
+static void calculate_block_row(void * user, int n)
 {
-    int min_i = BOXING_PIXEL_MAX;
-    int max_i = BOXING_PIXEL_MIN;
-    int y_end = y + height;
-    int x_end = x + width;
-    int count = 0;
-
-    // find max and min
-    for (int y_pos = y; y_pos < y_end; y_pos++)
+    const block_row_job * job = (const block_row_job *)user;
+    const int block_count = job->centeroids->rows;
+    const int cluster_count = job->cluster_count;
+
+    int y = n * job->block_height;
+    if (y + job->block_height >= (int)job->image->height)
+        y = job->image->height - job->block_height;
+
+    int * histograms = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(int, block_count * KMEANS_HISTOGRAM_SIZE);
+    block_row_histograms(job->image, y, job->block_width, job->block_height, block_count, histograms);
+
+    const int samples = job->block_width * job->block_height;
+    const boxing_float * previous_means = NULL;
+    for (int m = 0; m < block_count; m++)
     {
-        const boxing_image8_pixel *pixel = IMAGE8_PPIXEL(image, x, y_pos);
+        boxing_float * means = MATRIX_MULTIPAGE_ROW_PTR(job->centeroids, m, n);
+        boxing_float * variances = job->calculate_variances ? means + cluster_count : NULL;
+        calculate_histogram_means(histograms + m * KMEANS_HISTOGRAM_SIZE, samples, previous_means, means, variances, cluster_count);
+        previous_means = means;
+    }
+
+    boxing_memory_free(histograms);
+}
+
+static void block_row_histograms(const boxing_image8 * image, int y, int block_width, int block_height, int block_count, int * histograms)
+{
+    const int width = image->width;
+    // The last block is moved inside the image, the other blocks tile the row
+    const int tiled_count = (block_count * block_width > width || block_count == 1) ? block_count - 1 : block_count;
+    const int tiled_end = tiled_count * block_width;
 
-        if (min_i == BOXING_PIXEL_MIN && max_i == BOXING_PIXEL_MAX)
+    for (int y_pos = y; y_pos < y + block_height; y_pos++)
+    {
+        const boxing_image8_pixel * pixel = IMAGE8_SCANLINE(image, y_pos);
+        int * histogram = histograms;
+        for (int x = 0; x < tiled_end; x += block_width, histogram += KMEANS_HISTOGRAM_SIZE)
         {
-            for (int x_pos = x; x_pos < x_end; x_pos++, pixel++)
+            for (int x_pos = x; x_pos < x + block_width; x_pos++)
             {
-                histogram[*pixel]++;
-                count++;
+                histogram[pixel[x_pos]]++;
             }
         }
-        else if (min_i == BOXING_PIXEL_MIN)
+    }
+
+    if (tiled_count == block_count)
+    {
+        return;
+    }
+
+    int * last = histograms + tiled_count * KMEANS_HISTOGRAM_SIZE;
+    const int last_x = width - block_width;
+    if (tiled_count == 0)
+    {
+        for (int y_pos = y; y_pos < y + block_height; y_pos++)
         {
-            for (int x_pos = x; x_pos < x_end; x_pos++, pixel++)
+            const boxing_image8_pixel * pixel = IMAGE8_SCANLINE(image, y_pos);
+            for (int x_pos = last_x; x_pos < width; x_pos++)
             {
-                histogram[*pixel]++;
-                count++;
-                if (max_i < *pixel)
-                    max_i = *pixel;
+                last[pixel[x_pos]]++;
             }
         }
-        else if (max_i == BOXING_PIXEL_MAX)
+        return;
+    }
+
+    // Slide the histogram of the previous block to the last block
+    const int * previous = last - KMEANS_HISTOGRAM_SIZE;
+    const int previous_x = tiled_end - block_width;
+    for (int i = 0; i < KMEANS_HISTOGRAM_SIZE; i++)
+    {
+        last[i] = previous[i];
+    }
+    for (int y_pos = y; y_pos < y + block_height; y_pos++)
+    {
+        const boxing_image8_pixel * pixel = IMAGE8_SCANLINE(image, y_pos);
+        for (int x_pos = previous_x; x_pos < last_x; x_pos++)
         {
-            for (int x_pos = x; x_pos < x_end; x_pos++, pixel++)
-            {
-                histogram[*pixel]++;
-                count++;
-                if (min_i > *pixel)
-                    min_i = *pixel;
-            }
+            last[pixel[x_pos]]--;
         }
-        else
+        for (int x_pos = tiled_end; x_pos < width; x_pos++)
         {
-            for (int x_pos = x; x_pos < x_end; x_pos++, pixel++)
-            {
-                histogram[*pixel]++;
-                count++;
-                if (min_i > *pixel)
-                    min_i = *pixel;
-                else if (max_i < *pixel)
-                    max_i = *pixel;
-            }
+            last[pixel[x_pos]]++;
         }
     }
-
-    return count;
 }
 
-static void calulate_min_distance(boxing_float center, boxing_float* min_distance, int * histogram, int histogram_size, int histogram_samples)
+static void calulate_min_distance(boxing_float center, boxing_float* min_distance, const int * histogram, int histogram_size, int histogram_samples)
 {
     for (int n = 0; n < histogram_size; n++)
     {
@@ -231,38 +308,21 @@ static int update_min_distance(boxing_float* min_distance, boxing_float* distanc
     return pos;
 }
 
-static void calculate_inital_means_plusplus(boxing_float* means, int means_size, int * histogram, int histogram_size, int histogram_samples)
+static void calculate_inital_means_plusplus(boxing_float* means, int means_size, const int * histogram, int histogram_size, int histogram_samples)
 {
-
-    int * histogram_copy = BOXING_STACK_ALLOCATE_TYPE_ARRAY(int, histogram_size);
-
-
-    memcpy(histogram_copy, histogram, histogram_size*sizeof(int));
-
-    int i = 0;
-    int h = 0;
-    means[i] = 0;
-    for (int n = 0; n < histogram_samples / means_size;)
+    // The first mean is the mean of the lowest histogram_samples / means_size samples
+    const int first_samples = histogram_samples / means_size;
+    int remaining = first_samples;
+    means[0] = 0;
+    for (int h = 0; h < histogram_size && remaining > 0; h++)
     {
-        if (h >(histogram_size - 1))
-        {
-            break;
-        }
-
-        if (histogram_copy[h])
-        {
-            means[i] += h;
-            histogram_copy[h]--;
-            n++;
-        }
-        else
-        {
-            h++;
-        }
+        int count = BOXING_MATH_MIN(histogram[h], remaining);
+        means[0] += (boxing_float)h * count;
+        remaining -= count;
     }
-    means[i] /= histogram_samples / means_size;
+    means[0] /= first_samples;
 
-    boxing_float * min_distance = BOXING_STACK_ALLOCATE_TYPE_ARRAY(boxing_float, histogram_size);
+    boxing_float min_distance[KMEANS_HISTOGRAM_SIZE];
     for (int i = 0; i < histogram_size; i++)
     {
         if (histogram[i])
@@ -270,10 +330,8 @@ static void calculate_inital_means_plusplus(boxing_float* means, int means_size,
         else
             min_distance[i] = 0;
     }
-    
-
-    boxing_float * distance = BOXING_STACK_ALLOCATE_TYPE_ARRAY (boxing_float, histogram_size);
 
+    boxing_float distance[KMEANS_HISTOGRAM_SIZE];
 
     for (int k = 1; k < means_size; k++)
     {
@@ -284,9 +342,9 @@ static void calculate_inital_means_plusplus(boxing_float* means, int means_size,
 }
 
 
-static void calc_variances(int * sampels, int sampels_size, float *means, int means_size, float *variances)
+static void calc_variances(const int * sampels, int sampels_size, float *means, int means_size, float *variances)
 {
-    boxing_cluster * var = BOXING_STACK_ALLOCATE_TYPE_ARRAY(boxing_cluster, means_size);
+    boxing_cluster var[KMEANS_HISTOGRAM_SIZE];
 
     boxing_memory_clear(var, sizeof(boxing_cluster) * means_size);
     --means_size;
@@ -321,31 +379,44 @@ static void calc_variances(int * sampels, int sampels_size, float *means, int me
 
 }
 
-static void kmeans(int * sampels, int sampels_size, float *means, int means_size, int iterations)
+// Means must be sorted. Each sample belongs to the nearest mean, so the clusters are
+// consecutive ranges of the histogram and the nearest mean is found by walking the
+// means along with the samples. Empty clusters get an undefined (NaN) mean and are
+// skipped, like a mean equal to a lower one that never gets any samples.
+static void kmeans(const int * sampels, int sampels_size, float *means, int means_size, int iterations)
 {
-    boxing_cluster * clusters = BOXING_STACK_ALLOCATE_TYPE_ARRAY(boxing_cluster, means_size);
+    boxing_cluster clusters[KMEANS_HISTOGRAM_SIZE];
+    int active[KMEANS_HISTOGRAM_SIZE];
 
     while (iterations--)
     {
         boxing_memory_clear(clusters, sizeof(boxing_cluster) * means_size);
 
+        int active_count = 0;
+        for (int i = 0; i < means_size; i++)
+        {
+            if (means[i] == means[i] && (active_count == 0 || means[i] != means[active[active_count - 1]]))
+            {
+                active[active_count++] = i;
+            }
+        }
+        if (active_count == 0)
+        {
+            return;
+        }
+
+        int nearest = 0;
         for (int sample_index = 0; sample_index < sampels_size; sample_index++)
         {
-            boxing_float min_distance = BOXING_FLOAT_MAX;
-            int index = 0;
             boxing_float sample = (boxing_float)sample_index;
-            for (int i = 0; i < means_size; i++)
+            while (nearest + 1 < active_count &&
+                   fabsf(sample - means[active[nearest + 1]]) < fabsf(sample - means[active[nearest]]))
             {
-                boxing_float distance = fabsf(sample - means[i]);
-                if (min_distance > distance)
-                {
-                    index = i;
-                    min_distance = distance;
-                }
+                nearest++;
             }
             int count = sampels[sample_index];
-            clusters[index].sum += sample_index * count;
-            clusters[index].count += count;
+            clusters[active[nearest]].sum += sample_index * count;
+            clusters[active[nearest]].count += count;
         }
 
         for (int i = means_size-1; i >= 0; i--)
@@ -355,6 +426,18 @@ static void kmeans(int * sampels, int sampels_size, float *means, int means_size
     }
 }
 
+static DBOOL means_are_valid(const boxing_float * means, int means_size)
+{
+    for (int i = 0; i < means_size; i++)
+    {
+        if (means[i] != means[i])
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
 int qsort_compare(const void *a, const void *b) 
 {
     if (*(boxing_float*)a > *(boxing_float*)b)
@@ -365,24 +448,33 @@ int qsort_compare(const void *a, const void *b)
         return 0;
 }
 
-static void calculate_means(const boxing_image8 *image, int x, int y, int width, int height, boxing_float* means, boxing_float* variances, unsigned int means_size)
+static void calculate_histogram_means(const int * histogram, int samples, const boxing_float* initial_means, boxing_float* means, boxing_float* variances, unsigned int means_size)
 {
-    const int  iterations = 6;
-    const int histogram_size = 256;
-    int * histogram  = BOXING_STACK_ALLOCATE_TYPE_ARRAY(int, histogram_size);
+    const int histogram_size = KMEANS_HISTOGRAM_SIZE;
 
-    boxing_memory_clear(histogram, histogram_size * sizeof(int));
-
-    int samples = sample_histogram(image, x, y, width, height, histogram);
+    DBOOL converged = DFALSE;
+    if (initial_means && means_are_valid(initial_means, means_size))
+    {
+        // Neighbouring blocks have similar levels, start from the centers of the previous block
+        for (unsigned int i = 0; i < means_size; i++)
+        {
+            means[i] = initial_means[i];
+        }
+        kmeans(histogram, histogram_size, means, means_size, KMEANS_WARM_ITERATIONS);
+        converged = means_are_valid(means, means_size);
+    }
 
-    // calculate initial means
-    calculate_inital_means_plusplus(means, means_size, histogram, histogram_size, samples);
+    if (!converged)
+    {
+        // calculate initial means
+        calculate_inital_means_plusplus(means, means_size, histogram, histogram_size, samples);
+        qsort(means, means_size, sizeof(boxing_float), qsort_compare);
 
-    kmeans(histogram, 256, means, means_size, iterations);
+        kmeans(histogram, histogram_size, means, means_size, KMEANS_ITERATIONS);
+    }
 
     qsort(means, means_size, sizeof(boxing_float), qsort_compare);
 
     if (variances)
-        calc_variances(histogram, 256, means, means_size, variances);
+        calc_variances(histogram, histogram_size, means, means_size, variances);
 }
-
@@ -23,8 +23,9 @@ extern "C" {
 #include "boxing/utils.h"
 #include "boxing/matrix.h"
 
-boxing_matrix_float * boxing_calculate_thresholds(const boxing_image8 * image, int block_width, int block_height, int cluster_count);
-boxing_matrix_float * boxing_calculate_means(const boxing_image8 * image, int block_width, int block_height, int cluster_count);
+boxing_matrix_float * boxing_calculate_thresholds(const boxing_image8 * image, int block_width, int block_height, int cluster_count, int thread_count);
+boxing_matrix_float * boxing_calculate_means(const boxing_image8 * image, int block_width, int block_height, int cluster_count, int thread_count);
+void                  boxing_calculate_histogram_thresholds(const int * histogram, int samples, boxing_float * thresholds, int cluster_count);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,507 @@
+/*****************************************************************************
+**
+**  Implementation of the integral image interface
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "boxing/unboxer/integralimage.h"
+#include "boxing/platform/memory.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/math/math.h"
+#include "boxing/log.h"
+
+//  SYSTEM INCLUDES
+//
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
+
+//  PRIVATE INTERFACE
+//
+
+// Each tile table has a leading row and column of zeros
+#define TILE_STRIDE     (BOXING_INTEGRAL_IMAGE_TILE_SIZE + 1)
+#define TILE_TABLE_SIZE (TILE_STRIDE * TILE_STRIDE)
+
+// Tables of a tile
+#define TILE_SUM         0x01
+#define TILE_SQUARED_SUM 0x02
+
+// Adds the prefix sums of one row of pixels, and optionally of the squared
+// pixels, to the table row above. The row pointers point past the leading zero.
+typedef void (*boxing_integral_image_row_kernel)(const boxing_image8_pixel * pixels, int width,
+    const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared);
+
+static void                             integral_image_row(const boxing_image8_pixel * pixels, int width, int x, boxing_uint32 sum, boxing_uint32 squared_sum,
+                                                           const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared);
+static void                             integral_image_row_c(const boxing_image8_pixel * pixels, int width,
+                                                             const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared);
+static boxing_integral_image_row_kernel integral_image_select_kernel(void);
+static boxing_uint32 * const *          integral_image_tile(boxing_integral_image * integral_image, int tile_x, int tile_y, unsigned char tables);
+static void                             integral_image_free_tiles(boxing_integral_image * integral_image);
+
+
+/*!
+  * \addtogroup unboxer
+  * \{
+  */
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \struct     boxing_integral_image_s  integralimage.h
+ *  \brief      Summed area tables of an image.
+ *
+ *  \param image    Image the tables are built from.
+ *  \param tiles_x  Number of tiles along the X axis.
+ *  \param tiles_y  Number of tiles along the Y axis.
+ *  \param tiles    Sum and squared sum table memory of each tile, NULL until first used.
+ *  \param built    Tables of each tile built from the current image.
+ *
+ *  The image is split in tiles of BOXING_INTEGRAL_IMAGE_TILE_SIZE squared
+ *  pixels, and each tile has its own 32-bit summed area tables. A tile is
+ *  built the first time a box sum touches it, so only the parts of the image
+ *  that are queried are ever scanned, once per image. The table of squared
+ *  pixels is only built for tiles where squared sums are requested. Box sums
+ *  spanning several tiles are added up in 64 bits, so the 32-bit tables never
+ *  overflow.
+ *
+ *  Box sums update the tile tables, so an integral image must not be used
+ *  from more than one thread at a time.
+ */
+
+
+// PUBLIC INTEGRAL IMAGE FUNCTIONS
+//
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Create an integral image.
+ *
+ *  Create summed area tables for the image. No tables are built until the
+ *  first box sum.
+ *
+ *  \param[in]  image  Image, may be NULL and set later with boxing_integral_image_reset.
+ *  \return instance of allocated boxing_integral_image structure.
+ */
+
+boxing_integral_image * boxing_integral_image_create(const boxing_image8 * image)
+{
+    boxing_integral_image * integral_image = BOXING_MEMORY_ALLOCATE_TYPE(boxing_integral_image);
+    integral_image->image = NULL;
+    integral_image->tiles_x = 0;
+    integral_image->tiles_y = 0;
+    integral_image->tiles = NULL;
+    integral_image->built = NULL;
+    boxing_integral_image_reset(integral_image, image);
+    return integral_image;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Frees occupied memory of boxing_integral_image structure.
+ *
+ *  Frees occupied memory of all internal structure pointers and structure pointer.
+ *
+ *  \param[in]  integral_image  Pointer to the boxing_integral_image structure.
+ */
+
+void boxing_integral_image_free(boxing_integral_image * integral_image)
+{
+    if (integral_image)
+    {
+        integral_image_free_tiles(integral_image);
+        boxing_memory_free(integral_image);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Start over with a new image.
+ *
+ *  All tables built so far are discarded. The tile memory is kept for the
+ *  next image when it has the same size, so tracking a sequence of frames
+ *  does not allocate once the tiles in use are known.
+ *
+ *  \param[in]  integral_image  Pointer to the boxing_integral_image structure.
+ *  \param[in]  image           Image.
+ */
+
+void boxing_integral_image_reset(boxing_integral_image * integral_image, const boxing_image8 * image)
+{
+    const int tiles_x = image ? (int)((image->width + BOXING_INTEGRAL_IMAGE_TILE_SIZE - 1) >> BOXING_INTEGRAL_IMAGE_TILE_SHIFT) : 0;
+    const int tiles_y = image ? (int)((image->height + BOXING_INTEGRAL_IMAGE_TILE_SIZE - 1) >> BOXING_INTEGRAL_IMAGE_TILE_SHIFT) : 0;
+
+    if (tiles_x != integral_image->tiles_x || tiles_y != integral_image->tiles_y)
+    {
+        integral_image_free_tiles(integral_image);
+        integral_image->tiles_x = tiles_x;
+        integral_image->tiles_y = tiles_y;
+        if (tiles_x > 0 && tiles_y > 0)
+        {
+            integral_image->tiles = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(boxing_uint32 *, tiles_x * tiles_y * 2);
+            integral_image->built = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(unsigned char, tiles_x * tiles_y);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < tiles_x * tiles_y; i++)
+        {
+            integral_image->built[i] = 0;
+        }
+    }
+    integral_image->image = image;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Sum of the pixels in a rectangle.
+ *
+ *  Sum of the pixels, and optionally of the squared pixels, in the part of
+ *  the rectangle that is inside the image.
+ *
+ *  \param[in]  integral_image  Pointer to the boxing_integral_image structure.
+ *  \param[in]  x               Left edge of the rectangle.
+ *  \param[in]  y               Top edge of the rectangle.
+ *  \param[in]  width           Width of the rectangle.
+ *  \param[in]  height          Height of the rectangle.
+ *  \param[out] sum             Sum of the pixels.
+ *  \param[out] squared_sum     Sum of the squared pixels, may be NULL.
+ */
+
+void boxing_integral_image_sums(boxing_integral_image * integral_image, int x, int y, int width, int height,
+                                boxing_uint64 * sum, boxing_uint64 * squared_sum)
+{
+    const unsigned char tables = squared_sum ? TILE_SUM | TILE_SQUARED_SUM : TILE_SUM;
+    *sum = 0;
+    if (squared_sum)
+    {
+        *squared_sum = 0;
+    }
+
+    if (integral_image->image == NULL)
+    {
+        return;
+    }
+
+    const int x_begin = BOXING_MATH_MAX(x, 0);
+    const int y_begin = BOXING_MATH_MAX(y, 0);
+    const int x_end = BOXING_MATH_MIN(x + width, (int)integral_image->image->width);
+    const int y_end = BOXING_MATH_MIN(y + height, (int)integral_image->image->height);
+    if (x_begin >= x_end || y_begin >= y_end)
+    {
+        return;
+    }
+
+    for (int tile_y = y_begin >> BOXING_INTEGRAL_IMAGE_TILE_SHIFT; tile_y <= (y_end - 1) >> BOXING_INTEGRAL_IMAGE_TILE_SHIFT; tile_y++)
+    {
+        const int origin_y = tile_y << BOXING_INTEGRAL_IMAGE_TILE_SHIFT;
+        const int top = (BOXING_MATH_MAX(y_begin, origin_y) - origin_y) * TILE_STRIDE;
+        const int bottom = (BOXING_MATH_MIN(y_end, origin_y + BOXING_INTEGRAL_IMAGE_TILE_SIZE) - origin_y) * TILE_STRIDE;
+
+        for (int tile_x = x_begin >> BOXING_INTEGRAL_IMAGE_TILE_SHIFT; tile_x <= (x_end - 1) >> BOXING_INTEGRAL_IMAGE_TILE_SHIFT; tile_x++)
+        {
+            const int origin_x = tile_x << BOXING_INTEGRAL_IMAGE_TILE_SHIFT;
+            const int left = BOXING_MATH_MAX(x_begin, origin_x) - origin_x;
+            const int right = BOXING_MATH_MIN(x_end, origin_x + BOXING_INTEGRAL_IMAGE_TILE_SIZE) - origin_x;
+
+            boxing_uint32 * const * tile = integral_image_tile(integral_image, tile_x, tile_y, tables);
+            const boxing_uint32 * table = tile[0];
+            *sum += table[bottom + right] - table[bottom + left] - table[top + right] + table[top + left];
+            if (squared_sum)
+            {
+                table = tile[1];
+                *squared_sum += table[bottom + right] - table[bottom + left] - table[top + right] + table[top + left];
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Sum of the pixels in a rectangle.
+ *
+ *  Sum of the pixels in the part of the rectangle that is inside the image.
+ *
+ *  \param[in]  integral_image  Pointer to the boxing_integral_image structure.
+ *  \param[in]  x               Left edge of the rectangle.
+ *  \param[in]  y               Top edge of the rectangle.
+ *  \param[in]  width           Width of the rectangle.
+ *  \param[in]  height          Height of the rectangle.
+ *  \return sum of the pixels.
+ */
+
+boxing_uint64 boxing_integral_image_sum(boxing_integral_image * integral_image, int x, int y, int width, int height)
+{
+    boxing_uint64 sum;
+    boxing_integral_image_sums(integral_image, x, y, width, height, &sum, NULL);
+    return sum;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Average of the pixels in a rectangle.
+ *
+ *  Sum of the pixels inside the image divided by the area of the whole
+ *  rectangle, the same as boxing_histogram_calc_average_image.
+ *
+ *  \param[in]  integral_image  Pointer to the boxing_integral_image structure.
+ *  \param[in]  point           Upper left corner of the rectangle.
+ *  \param[in]  dimension       Size of the rectangle.
+ *  \return average pixel value.
+ */
+
+boxing_float boxing_integral_image_average(boxing_integral_image * integral_image, const boxing_pointi * point, const boxing_pointi * dimension)
+{
+    boxing_uint64 sum = boxing_integral_image_sum(integral_image, point->x, point->y, dimension->x, dimension->y);
+    return (long long)sum / (boxing_float)(dimension->x * dimension->y);
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+  * \} end of unboxer group
+  */
+
+
+// PRIVATE INTEGRAL IMAGE FUNCTIONS
+//
+
+// Finish a row from x, where sum and squared_sum are the row sums so far
+static void integral_image_row(const boxing_image8_pixel * pixels, int width, int x, boxing_uint32 sum, boxing_uint32 squared_sum,
+                               const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared)
+{
+    if (row_squared)
+    {
+        for (; x < width; x++)
+        {
+            const boxing_uint32 pixel = pixels[x];
+            sum += pixel;
+            squared_sum += pixel * pixel;
+            row[x] = above[x] + sum;
+            row_squared[x] = above_squared[x] + squared_sum;
+        }
+    }
+    else
+    {
+        for (; x < width; x++)
+        {
+            sum += pixels[x];
+            row[x] = above[x] + sum;
+        }
+    }
+}
+
+
+static void integral_image_row_c(const boxing_image8_pixel * pixels, int width,
+                                 const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared)
+{
+    integral_image_row(pixels, width, 0, 0, 0, above, row, above_squared, row_squared);
+}
+
+
+#if defined (BOXING_CPU_X86)
+
+// Inclusive prefix sum of the four lanes plus the carry from the lanes before
+BOXING_CPU_TARGET("sse2")
+static inline __m128i integral_image_prefix_sse2(__m128i value, __m128i carry)
+{
+    value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+    value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+    return _mm_add_epi32(value, carry);
+}
+
+
+BOXING_CPU_TARGET("sse2")
+static void integral_image_row_sse2(const boxing_image8_pixel * pixels, int width,
+                                    const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    __m128i carry_squared = zero;
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128((const __m128i *)(pixels + x));
+        const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        __m128i words[4];
+        words[0] = _mm_unpacklo_epi16(low, zero);
+        words[1] = _mm_unpackhi_epi16(low, zero);
+        words[2] = _mm_unpacklo_epi16(high, zero);
+        words[3] = _mm_unpackhi_epi16(high, zero);
+
+        for (int i = 0; i < 4; i++)
+        {
+            const __m128i value = integral_image_prefix_sse2(words[i], carry);
+            carry = _mm_shuffle_epi32(value, 0xff);
+            _mm_storeu_si128((__m128i *)(row + x + 4*i), _mm_add_epi32(value, _mm_loadu_si128((const __m128i *)(above + x + 4*i))));
+
+            if (row_squared)
+            {
+                // The upper half of each 32-bit lane is zero, so the pairwise
+                // multiply-add gives the squared pixel
+                const __m128i squared = integral_image_prefix_sse2(_mm_madd_epi16(words[i], words[i]), carry_squared);
+                carry_squared = _mm_shuffle_epi32(squared, 0xff);
+                _mm_storeu_si128((__m128i *)(row_squared + x + 4*i), _mm_add_epi32(squared, _mm_loadu_si128((const __m128i *)(above_squared + x + 4*i))));
+            }
+        }
+    }
+
+    integral_image_row(pixels, width, x, (boxing_uint32)_mm_cvtsi128_si32(carry), (boxing_uint32)_mm_cvtsi128_si32(carry_squared),
+                       above, row, above_squared, row_squared);
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+// Inclusive prefix sum of the four lanes plus the carry from the lanes before
+static inline uint32x4_t integral_image_prefix_neon(uint32x4_t value, uint32x4_t carry)
+{
+    const uint32x4_t zero = vdupq_n_u32(0);
+    value = vaddq_u32(value, vextq_u32(zero, value, 3));
+    value = vaddq_u32(value, vextq_u32(zero, value, 2));
+    return vaddq_u32(value, carry);
+}
+
+
+static void integral_image_row_neon(const boxing_image8_pixel * pixels, int width,
+                                    const boxing_uint32 * above, boxing_uint32 * row, const boxing_uint32 * above_squared, boxing_uint32 * row_squared)
+{
+    uint32x4_t carry = vdupq_n_u32(0);
+    uint32x4_t carry_squared = vdupq_n_u32(0);
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        const uint8x16_t bytes = vld1q_u8(pixels + x);
+        const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+        const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+        uint32x4_t words[4];
+        words[0] = vmovl_u16(vget_low_u16(low));
+        words[1] = vmovl_u16(vget_high_u16(low));
+        words[2] = vmovl_u16(vget_low_u16(high));
+        words[3] = vmovl_u16(vget_high_u16(high));
+
+        for (int i = 0; i < 4; i++)
+        {
+            const uint32x4_t value = integral_image_prefix_neon(words[i], carry);
+            carry = vdupq_n_u32(vgetq_lane_u32(value, 3));
+            vst1q_u32(row + x + 4*i, vaddq_u32(value, vld1q_u32(above + x + 4*i)));
+
+            if (row_squared)
+            {
+                const uint32x4_t squared = integral_image_prefix_neon(vmulq_u32(words[i], words[i]), carry_squared);
+                carry_squared = vdupq_n_u32(vgetq_lane_u32(squared, 3));
+                vst1q_u32(row_squared + x + 4*i, vaddq_u32(squared, vld1q_u32(above_squared + x + 4*i)));
+            }
+        }
+    }
+
+    integral_image_row(pixels, width, x, vgetq_lane_u32(carry, 0), vgetq_lane_u32(carry_squared, 0),
+                       above, row, above_squared, row_squared);
+}
+
+#endif
+
+static boxing_integral_image_row_kernel integral_image_select_kernel(void)
+{
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        return integral_image_row_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        return integral_image_row_neon;
+    }
+#endif
+    return integral_image_row_c;
+}
+
+
+// Summed area tables of a tile, the requested tables are built on first use.
+// The sum table is rebuilt along with the squared sum table.
+static boxing_uint32 * const * integral_image_tile(boxing_integral_image * integral_image, int tile_x, int tile_y, unsigned char tables)
+{
+    const int index = tile_y * integral_image->tiles_x + tile_x;
+    boxing_uint32 ** tile = integral_image->tiles + 2 * index;
+    if ((integral_image->built[index] & tables) == tables)
+    {
+        return tile;
+    }
+
+    if (tile[0] == NULL)
+    {
+        tile[0] = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_uint32, TILE_TABLE_SIZE);
+    }
+    if ((tables & TILE_SQUARED_SUM) && tile[1] == NULL)
+    {
+        tile[1] = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_uint32, TILE_TABLE_SIZE);
+    }
+    boxing_uint32 * table = tile[0];
+    boxing_uint32 * table_squared = (tables & TILE_SQUARED_SUM) ? tile[1] : NULL;
+
+    const boxing_image8 * image = integral_image->image;
+    const int origin_x = tile_x << BOXING_INTEGRAL_IMAGE_TILE_SHIFT;
+    const int origin_y = tile_y << BOXING_INTEGRAL_IMAGE_TILE_SHIFT;
+    const int width = BOXING_MATH_MIN(BOXING_INTEGRAL_IMAGE_TILE_SIZE, (int)image->width - origin_x);
+    const int height = BOXING_MATH_MIN(BOXING_INTEGRAL_IMAGE_TILE_SIZE, (int)image->height - origin_y);
+    boxing_integral_image_row_kernel kernel = integral_image_select_kernel();
+
+    for (int x = 0; x <= width; x++)
+    {
+        table[x] = 0;
+        if (table_squared)
+        {
+            table_squared[x] = 0;
+        }
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        boxing_uint32 * row = table + (y + 1) * TILE_STRIDE;
+        boxing_uint32 * row_squared = table_squared ? table_squared + (y + 1) * TILE_STRIDE : NULL;
+        row[0] = 0;
+        if (row_squared)
+        {
+            row_squared[0] = 0;
+        }
+        kernel(IMAGE8_PPIXEL(image, origin_x, origin_y + y), width, row + 1 - TILE_STRIDE, row + 1,
+               row_squared ? row_squared + 1 - TILE_STRIDE : NULL, row_squared ? row_squared + 1 : NULL);
+    }
+
+    integral_image->built[index] |= tables;
+    return tile;
+}
+
+
+static void integral_image_free_tiles(boxing_integral_image * integral_image)
+{
+    for (int i = 0; i < integral_image->tiles_x * integral_image->tiles_y * 2; i++)
+    {
+        boxing_memory_free(integral_image->tiles[i]);
+    }
+    boxing_memory_free(integral_image->tiles);
+    boxing_memory_free(integral_image->built);
+    integral_image->tiles = NULL;
+    integral_image->built = NULL;
+}
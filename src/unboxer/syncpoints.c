@@ -17,11 +17,27 @@
 #include "boxing/unboxer/syncpoints.h"
 #include "boxing/utils.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/thread.h"
+#include "boxing/platform/cpu.h"
 #include "boxing/log.h"
 
+//  SYSTEM INCLUDES
+//
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
+
 //  DEFINES
 //
 
+// Number of sync points located together, one per byte lane of a SIMD register
+#define SYNCPOINT_BATCH_SIZE 16
+// Largest search window side handled by the batch kernels, the row moments
+// of larger windows do not fit in 16 bits
+#define SYNCPOINT_BATCH_MAX_SIDE 16
+
 typedef struct rectanglef_s
 {
     boxing_pointf top_left;
@@ -30,13 +46,44 @@ typedef struct rectanglef_s
     boxing_pointf bot_right;
 } rectanglef;
 
+// Search windows of a batch of sync points in structure of arrays layout,
+// pixels[k][lane] is pixel k of the window of sync point lane
+typedef struct syncpoint_batch_s
+{
+    int                 count;
+    int                 x[SYNCPOINT_BATCH_SIZE];
+    int                 y[SYNCPOINT_BATCH_SIZE];
+    boxing_image8_pixel pixels[SYNCPOINT_BATCH_MAX_SIDE * SYNCPOINT_BATCH_MAX_SIDE][SYNCPOINT_BATCH_SIZE];
+    int                 sum_gray[SYNCPOINT_BATCH_SIZE];
+    int                 sum_prod_x[SYNCPOINT_BATCH_SIZE];
+    int                 sum_prod_y[SYNCPOINT_BATCH_SIZE];
+} syncpoint_batch;
+
+// Computes the gray value sum and the gray value weighted window coordinates
+// of all sync points in the batch
+typedef void (*syncpoint_batch_kernel)(syncpoint_batch * batch, int side, DBOOL is_center_point_bright);
+
+typedef struct syncpoint_job_s
+{
+    const boxing_matrixf * positions;
+    const boxing_image8 *  scan_image;
+    boxing_float           search_radius;
+    DBOOL                  is_center_point_bright;
+    syncpoint_batch_kernel kernel;
+    int                    band_height;
+    boxing_matrixf *       result;
+} syncpoint_job;
+
 //  PRIVATE INTERFACE
 //
 
 static void correct_symbol_location_matrix_with_sync_points(boxing_matrixf *initial_symbol_location_matrix, const boxing_matrixi *syncpoint_locations_source, const boxing_matrixf *syncpoint_location_scan);
 static void correct_symbol_location_matrix_area(boxing_matrixf * initial_symbol_location_matrix, const boxing_recti *ref_area_src, const rectanglef *offset, DBOOL correct_right_border, DBOOL correct_bottom_border);
 static boxing_pointf determine_precise_syncpoint_position_in_scan_image(const boxing_pointf syncpoint_positions_in_scan_image, const boxing_image8 * scan_image, boxing_float search_radius_scan_image, DBOOL is_center_point_bright);
-static boxing_matrixf * determine_syncpoints(const boxing_matrixf * syncpoint_positions_in_scan_image_from_syncbars, const boxing_image8 * scan_image, boxing_float search_radius_scan_image, DBOOL is_center_point_bright);
+static boxing_matrixf * determine_syncpoints(const boxing_matrixf * syncpoint_positions_in_scan_image_from_syncbars, const boxing_image8 * scan_image, boxing_float search_radius_scan_image, DBOOL is_center_point_bright, int thread_count);
+static void determine_syncpoints_band(void * user, int band);
+static void locate_syncpoint_batch(const syncpoint_job * job, syncpoint_batch * batch, int first, int side);
+static syncpoint_batch_kernel select_syncpoint_batch_kernel(void);
 static boxing_matrixf * correct_syncpoint_offsets(const boxing_matrixf *sync_point_offsets, boxing_float max_allowed_sqr_offset_variation);
 
 // PUBLIC SYNC POINTS FUNCTIONS
@@ -80,7 +127,7 @@ boxing_matrixf * boxing_syncpoints_correct_frame_geometry(void * user, const box
     // Determine the locations of the sync points from the scanned image by searching the centers of the sync points
 
     // Calculate offset
-    boxing_matrixf * sync_point_offsets = determine_syncpoints( &sync_point_locations_from_raster_locations, frame, properties->sync_point_search_radius, properties->sync_point_center_is_bright );
+    boxing_matrixf * sync_point_offsets = determine_syncpoints( &sync_point_locations_from_raster_locations, frame, properties->sync_point_search_radius, properties->sync_point_center_is_bright, properties->thread_count );
 
     int use_rows = BOXING_MATH_MIN(sync_point_offsets->height, sync_point_locations_from_raster_locations.height);
     int use_cols = BOXING_MATH_MIN(sync_point_offsets->width, sync_point_locations_from_raster_locations.width);
@@ -479,27 +526,282 @@ static void correct_symbol_location_matrix_area(boxing_matrixf * initial_symbol_
 /**
  * Determine the locations of the sync points in the scanned frame. This is done by searching for
  * sync points at the assumed positions derived from the sync bars.
+ *
+ * The rows of sync points are split into bands that are located in parallel. Within a band the
+ * search windows of SYNCPOINT_BATCH_SIZE sync points are gathered into a structure of arrays and
+ * located together with the widest SIMD kernel supported by the CPU. All sums are integer, the
+ * result is therefore identical for all kernels and thread counts.
  * \param syncpoint_positions_in_scan_image_from_syncbars The positions of the sync point within the scanned image
  * \param scan_image The scanned image
  * \param search_radius_scan_image The search radius (horizontal and vertical around the assumed position of a sync point) where a sync point is searched
  * \param is_center_point_bright DTRUE if the center of the sync point is bright, DFALSE if not
+ * \param thread_count Number of worker threads, less than 1 uses all cores
  * \return A matrix with all found sync point positions
  */
-static boxing_matrixf * determine_syncpoints(const boxing_matrixf * syncpoint_positions_in_scan_image_from_syncbars, const boxing_image8 * scan_image, boxing_float search_radius_scan_image, DBOOL is_center_point_bright)
+static boxing_matrixf * determine_syncpoints(const boxing_matrixf * syncpoint_positions_in_scan_image_from_syncbars, const boxing_image8 * scan_image, boxing_float search_radius_scan_image, DBOOL is_center_point_bright, int thread_count)
 {
     boxing_matrixf * result = boxing_matrixf_create(syncpoint_positions_in_scan_image_from_syncbars->width, syncpoint_positions_in_scan_image_from_syncbars->height);
 
-    for (unsigned int iy = 0; iy < syncpoint_positions_in_scan_image_from_syncbars->height; iy++)
+    const int height = (int)syncpoint_positions_in_scan_image_from_syncbars->height;
+    const int band_count = boxing_thread_resolve_count(thread_count, height);
+
+    syncpoint_job job;
+    job.positions = syncpoint_positions_in_scan_image_from_syncbars;
+    job.scan_image = scan_image;
+    job.search_radius = search_radius_scan_image;
+    job.is_center_point_bright = is_center_point_bright;
+    job.kernel = select_syncpoint_batch_kernel();
+    job.band_height = (height + band_count - 1) / band_count;
+    job.result = result;
+
+    boxing_thread_parallel_for(height > 0 ? band_count : 0, band_count, determine_syncpoints_band, &job);
+
+    return result;
+}
+
+/**
+ * Locate the sync points in one band of sync point rows
+ * \param user The sync point job
+ * \param band Index of the band
+ */
+static void determine_syncpoints_band(void * user, int band)
+{
+    const syncpoint_job * job = (const syncpoint_job *)user;
+    const int width = (int)job->positions->width;
+    const int y_begin = band * job->band_height;
+    const int y_end = BOXING_MATH_MIN(y_begin + job->band_height, (int)job->positions->height);
+
+    // Side of the search window used for the center of gravity
+    const int side = (int)lround(2.0*job->search_radius) + 1;
+
+    if (job->kernel == NULL || side < 1 || side > SYNCPOINT_BATCH_MAX_SIDE)
     {
-        for (unsigned int ix = 0; ix < syncpoint_positions_in_scan_image_from_syncbars->width; ix++)
+        for (int iy = y_begin; iy < y_end; iy++)
         {
-            boxing_pointf sync_point_position_from_sync_bar = MATRIX_ELEMENT(syncpoint_positions_in_scan_image_from_syncbars, iy, ix);
-            boxing_pointf found_position = determine_precise_syncpoint_position_in_scan_image(sync_point_position_from_sync_bar, scan_image, search_radius_scan_image, is_center_point_bright);
-            MATRIX_ELEMENT(result, iy, ix) = found_position;
+            for (int ix = 0; ix < width; ix++)
+            {
+                boxing_pointf sync_point_position_from_sync_bar = MATRIX_ELEMENT(job->positions, iy, ix);
+                MATRIX_ELEMENT(job->result, iy, ix) = determine_precise_syncpoint_position_in_scan_image(sync_point_position_from_sync_bar, job->scan_image, job->search_radius, job->is_center_point_bright);
+            }
         }
+        return;
     }
 
-    return result;
+    syncpoint_batch batch;
+    const int end = y_end * width;
+    for (int first = y_begin * width; first < end; first += SYNCPOINT_BATCH_SIZE)
+    {
+        batch.count = BOXING_MATH_MIN(SYNCPOINT_BATCH_SIZE, end - first);
+        locate_syncpoint_batch(job, &batch, first, side);
+    }
+}
+
+/**
+ * Locate a batch of sync points, the result is identical to determine_precise_syncpoint_position_in_scan_image
+ * \param job The sync point job
+ * \param batch The batch, count must be set
+ * \param first Index of the first sync point of the batch in the position matrix
+ * \param side Side of the search window
+ */
+static void locate_syncpoint_batch(const syncpoint_job * job, syncpoint_batch * batch, int first, int side)
+{
+    const boxing_pointf * positions = job->positions->data + first;
+    boxing_pointf * found_positions = job->result->data + first;
+
+    for (int lane = 0; lane < SYNCPOINT_BATCH_SIZE; lane++)
+    {
+        if (lane >= batch->count)
+        {
+            for (int k = 0; k < side * side; k++)
+            {
+                batch->pixels[k][lane] = 0;
+            }
+            continue;
+        }
+
+        batch->x[lane] = lround(positions[lane].x - job->search_radius);
+        batch->y[lane] = lround(positions[lane].y - job->search_radius);
+        for (int iy = 0; iy < side; iy++)
+        {
+            const boxing_image8_pixel * row = &IMAGE8_PIXEL(job->scan_image, batch->x[lane], batch->y[lane] + iy);
+            for (int ix = 0; ix < side; ix++)
+            {
+                batch->pixels[iy * side + ix][lane] = row[ix];
+            }
+        }
+    }
+
+    job->kernel(batch, side, job->is_center_point_bright);
+
+    for (int lane = 0; lane < batch->count; lane++)
+    {
+        const int sum_gray = batch->sum_gray[lane];
+        if (!sum_gray)
+        {
+            /* No valid sync point location where found,
+               returning inital location instead
+               */
+            found_positions[lane] = positions[lane];
+            continue;
+        }
+
+        // Move the window coordinates to image coordinates
+        const int sum_prod_x = batch->x[lane] * sum_gray + batch->sum_prod_x[lane];
+        const int sum_prod_y = batch->y[lane] * sum_gray + batch->sum_prod_y[lane];
+        found_positions[lane].x = (boxing_float)sum_prod_x / sum_gray;
+        found_positions[lane].y = (boxing_float)sum_prod_y / sum_gray;
+    }
+}
+
+// The batch kernels find the minimum and maximum gray value in the top left
+// (side - 1) x (side - 1) pixels of each window and sum the gray values above
+// the minimum (bright center) or below the maximum (dark center) over the
+// whole side x side window, like determine_precise_syncpoint_position_in_scan_image.
+// Row sums are accumulated in 16 bit lanes and widened to 32 bit per row.
+
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("sse2")
+static void syncpoint_batch_sse2(syncpoint_batch * batch, int side, DBOOL is_center_point_bright)
+{
+    const int minmax_side = BOXING_MATH_MAX(side - 1, 1);
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i min_gray = _mm_loadu_si128((const __m128i *)batch->pixels[0]);
+    __m128i max_gray = min_gray;
+    for (int iy = 0; iy < minmax_side; iy++)
+    {
+        for (int ix = 0; ix < minmax_side; ix++)
+        {
+            const __m128i gray_value = _mm_loadu_si128((const __m128i *)batch->pixels[iy * side + ix]);
+            min_gray = _mm_min_epu8(min_gray, gray_value);
+            max_gray = _mm_max_epu8(max_gray, gray_value);
+        }
+    }
+    const __m128i gray_threshold = is_center_point_bright == DTRUE ? min_gray : max_gray;
+
+    __m128i sum_gray[4] = { zero, zero, zero, zero };
+    __m128i sum_prod_x[4] = { zero, zero, zero, zero };
+    __m128i sum_prod_y[4] = { zero, zero, zero, zero };
+    for (int iy = 0; iy < side; iy++)
+    {
+        __m128i row_gray[2] = { zero, zero };
+        __m128i row_prod_x[2] = { zero, zero };
+        for (int ix = 0; ix < side; ix++)
+        {
+            const __m128i gray_value = _mm_loadu_si128((const __m128i *)batch->pixels[iy * side + ix]);
+            const __m128i gray_used = is_center_point_bright == DTRUE ?
+                _mm_subs_epu8(gray_value, gray_threshold) : _mm_subs_epu8(gray_threshold, gray_value);
+            const __m128i column = _mm_set1_epi16((short)ix);
+            const __m128i gray_used_lo = _mm_unpacklo_epi8(gray_used, zero);
+            const __m128i gray_used_hi = _mm_unpackhi_epi8(gray_used, zero);
+            row_gray[0] = _mm_add_epi16(row_gray[0], gray_used_lo);
+            row_gray[1] = _mm_add_epi16(row_gray[1], gray_used_hi);
+            row_prod_x[0] = _mm_add_epi16(row_prod_x[0], _mm_mullo_epi16(gray_used_lo, column));
+            row_prod_x[1] = _mm_add_epi16(row_prod_x[1], _mm_mullo_epi16(gray_used_hi, column));
+        }
+
+        const __m128i row = _mm_set1_epi16((short)iy);
+        for (int i = 0; i < 2; i++)
+        {
+            const __m128i row_prod_y = _mm_mullo_epi16(row_gray[i], row);
+            sum_gray[2 * i] = _mm_add_epi32(sum_gray[2 * i], _mm_unpacklo_epi16(row_gray[i], zero));
+            sum_gray[2 * i + 1] = _mm_add_epi32(sum_gray[2 * i + 1], _mm_unpackhi_epi16(row_gray[i], zero));
+            sum_prod_x[2 * i] = _mm_add_epi32(sum_prod_x[2 * i], _mm_unpacklo_epi16(row_prod_x[i], zero));
+            sum_prod_x[2 * i + 1] = _mm_add_epi32(sum_prod_x[2 * i + 1], _mm_unpackhi_epi16(row_prod_x[i], zero));
+            sum_prod_y[2 * i] = _mm_add_epi32(sum_prod_y[2 * i], _mm_unpacklo_epi16(row_prod_y, zero));
+            sum_prod_y[2 * i + 1] = _mm_add_epi32(sum_prod_y[2 * i + 1], _mm_unpackhi_epi16(row_prod_y, zero));
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        _mm_storeu_si128((__m128i *)(batch->sum_gray + 4 * i), sum_gray[i]);
+        _mm_storeu_si128((__m128i *)(batch->sum_prod_x + 4 * i), sum_prod_x[i]);
+        _mm_storeu_si128((__m128i *)(batch->sum_prod_y + 4 * i), sum_prod_y[i]);
+    }
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static void syncpoint_batch_neon(syncpoint_batch * batch, int side, DBOOL is_center_point_bright)
+{
+    const int minmax_side = BOXING_MATH_MAX(side - 1, 1);
+
+    uint8x16_t min_gray = vld1q_u8(batch->pixels[0]);
+    uint8x16_t max_gray = min_gray;
+    for (int iy = 0; iy < minmax_side; iy++)
+    {
+        for (int ix = 0; ix < minmax_side; ix++)
+        {
+            const uint8x16_t gray_value = vld1q_u8(batch->pixels[iy * side + ix]);
+            min_gray = vminq_u8(min_gray, gray_value);
+            max_gray = vmaxq_u8(max_gray, gray_value);
+        }
+    }
+    const uint8x16_t gray_threshold = is_center_point_bright == DTRUE ? min_gray : max_gray;
+
+    uint32x4_t sum_gray[4];
+    uint32x4_t sum_prod_x[4];
+    uint32x4_t sum_prod_y[4];
+    for (int i = 0; i < 4; i++)
+    {
+        sum_gray[i] = vdupq_n_u32(0);
+        sum_prod_x[i] = vdupq_n_u32(0);
+        sum_prod_y[i] = vdupq_n_u32(0);
+    }
+
+    for (int iy = 0; iy < side; iy++)
+    {
+        uint16x8_t row_gray[2] = { vdupq_n_u16(0), vdupq_n_u16(0) };
+        uint16x8_t row_prod_x[2] = { vdupq_n_u16(0), vdupq_n_u16(0) };
+        for (int ix = 0; ix < side; ix++)
+        {
+            const uint8x16_t gray_value = vld1q_u8(batch->pixels[iy * side + ix]);
+            const uint8x16_t gray_used = is_center_point_bright == DTRUE ?
+                vqsubq_u8(gray_value, gray_threshold) : vqsubq_u8(gray_threshold, gray_value);
+            const uint8x8_t column = vdup_n_u8((uint8_t)ix);
+            row_gray[0] = vaddw_u8(row_gray[0], vget_low_u8(gray_used));
+            row_gray[1] = vaddw_u8(row_gray[1], vget_high_u8(gray_used));
+            row_prod_x[0] = vmlal_u8(row_prod_x[0], vget_low_u8(gray_used), column);
+            row_prod_x[1] = vmlal_u8(row_prod_x[1], vget_high_u8(gray_used), column);
+        }
+
+        for (int i = 0; i < 2; i++)
+        {
+            sum_gray[2 * i] = vaddw_u16(sum_gray[2 * i], vget_low_u16(row_gray[i]));
+            sum_gray[2 * i + 1] = vaddw_u16(sum_gray[2 * i + 1], vget_high_u16(row_gray[i]));
+            sum_prod_x[2 * i] = vaddw_u16(sum_prod_x[2 * i], vget_low_u16(row_prod_x[i]));
+            sum_prod_x[2 * i + 1] = vaddw_u16(sum_prod_x[2 * i + 1], vget_high_u16(row_prod_x[i]));
+            sum_prod_y[2 * i] = vmlal_n_u16(sum_prod_y[2 * i], vget_low_u16(row_gray[i]), (uint16_t)iy);
+            sum_prod_y[2 * i + 1] = vmlal_n_u16(sum_prod_y[2 * i + 1], vget_high_u16(row_gray[i]), (uint16_t)iy);
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        vst1q_s32(batch->sum_gray + 4 * i, vreinterpretq_s32_u32(sum_gray[i]));
+        vst1q_s32(batch->sum_prod_x + 4 * i, vreinterpretq_s32_u32(sum_prod_x[i]));
+        vst1q_s32(batch->sum_prod_y + 4 * i, vreinterpretq_s32_u32(sum_prod_y[i]));
+    }
+}
+
+#endif
+
+static syncpoint_batch_kernel select_syncpoint_batch_kernel(void)
+{
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSE2))
+    {
+        return syncpoint_batch_sse2;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        return syncpoint_batch_neon;
+    }
+#endif
+    return NULL;
 }
 
 /**
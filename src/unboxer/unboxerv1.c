@@ -26,11 +26,13 @@
 #include    "frameutil.h"
 #include    "boxing/log.h"
 #include    "boxing/platform/memory.h"
+#include    "boxing/platform/thread.h"
 #include    "boxing/bool.h"
 
 //  PRIVATE INTERFACE
 //
 
+static int          dunboxerv1_apply_filter(boxing_dunboxerv1 * unboxer, boxing_image8 * image, const boxing_filter_coeff_2d * filter_coeff);
 static int          dunboxerv1_sharpness_filter(void* user_data, boxing_dunboxerv1 * unboxer, boxing_image8 * image, boxing_float mix);
 static int          dunboxerv1_visual_sharpness_filter(void* user_data, boxing_dunboxerv1 * unboxer, boxing_image8 * image);
 static DBOOL        dunboxerv1_calculate_lut(struct boxing_tracker_s * tracker, const boxing_image8 * image, boxing_image8_pixel * lut);
@@ -40,14 +42,49 @@ static boxing_float dunboxerv1_calculate_mtf_max_min(struct boxing_tracker_s * t
 static int          dunboxerv1_calculate_mtf(boxing_dunboxerv1 * unboxer, const boxing_image8 * image,
                                                 int symbols_per_pixel, struct boxing_tracker_s * tracker, void * user_data,
                                                 boxing_float *horizontal_mtf, boxing_float *vertical_mtf);
-static int      extract_digital_content( void* user, boxing_dunboxerv1 * unboxer, boxing_image8 * sampled_image, int symbols_per_pixel, gvector * the_data_array, DBOOL quantize_data );
+static int      extract_digital_content( void* user, boxing_dunboxerv1 * unboxer, boxing_image8 * sampled_image, int symbols_per_pixel, gvector * the_data_array, gvector * erasures, DBOOL quantize_data );
 static int      extract_analog_content(boxing_image8 * sampled_image, gvector *the_data_array, void * user_data);
 static int      dunboxerv1_load_data_from_image(boxing_dunboxerv1 * unboxer, boxing_image8 * image,
-                                                       gvector * the_data_array, boxing_metadata_list * metadata_list, int horizontal_border_tracking, 
+                                                       gvector * the_data_array, gvector * erasures, boxing_metadata_list * metadata_list, int horizontal_border_tracking, 
                                                        struct boxing_tracker_s * tracker, void * user_data, DBOOL quantize_data);
 static void     pack_data( gvector * data );
-static int      dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, boxing_metadata_list * metadata,
+static int      dunboxerv1_extract_container(boxing_dunboxerv1 * unboxer, gvector * data, gvector * erasures,
+                boxing_metadata_list * metadata_list, boxing_image8 * frame, void * user_data);
+static int      dunboxerv1_decode(boxing_dunboxerv1 * unboxer, gvector * data, gvector * erasures, boxing_metadata_list * metadata,
                 boxing_stats_decode * decode_stats, unsigned int step, void * user_data);
+static int      dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, gvector * erasures, boxing_metadata_list * metadata,
+                boxing_stats_decode * decode_stats, unsigned int step, void * user_data);
+static int      dunboxerv1_decode_container(boxing_dunboxerv1 * unboxer, gvector * data, gvector * erasures, boxing_metadata_list * metadata_list,
+                int extract_result, void * user_data);
+static boxing_dunboxerv1 * dunboxerv1_create_worker(const boxing_dunboxerv1 * unboxer);
+static void     dunboxerv1_free_worker(boxing_dunboxerv1 * worker);
+static void     dunboxerv1_extract_worker(void * user, int index);
+static void     dunboxerv1_extract_thread(void * user);
+static void     dunboxerv1_stage_begin(const boxing_dunboxerv1 * unboxer, boxing_stats_stage_timer * timer);
+static void     dunboxerv1_stage_end(const boxing_dunboxerv1 * unboxer, boxing_stats_stage_timer * timer, const char * name,
+                const char * coding_scheme, int step, void * user_data);
+
+typedef struct dunboxerv1_batch_s
+{
+    boxing_dunboxerv1 **   workers;
+    boxing_unboxer_frame * frames;
+    gvector **             erasures;
+    int                    frame_count;
+    int                    next_frame;
+    int                    decoded_frames;
+    int                    queue_depth;
+    DBOOL *                extracted;
+    boxing_mutex *         mutex;
+    boxing_condition *     frame_extracted;
+    boxing_condition *     frame_decoded;
+} dunboxerv1_batch;
+
+typedef struct dunboxerv1_batch_thread_s
+{
+    dunboxerv1_batch *     batch;
+    int                    index;
+    boxing_thread *        thread;
+} dunboxerv1_batch_thread;
 
 
 /*! 
@@ -90,6 +127,7 @@ boxing_dunboxerv1 * boxing_dunboxerv1_create()
 {
     boxing_dunboxerv1 * unboxer = BOXING_MEMORY_ALLOCATE_TYPE(boxing_dunboxerv1);
     unboxer->frame = NULL;
+    unboxer->tracker = NULL;
     boxing_unboxer_parameters_init( &unboxer->parameters );
     unboxer->frame_util = (boxing_abstract_frame_util*)boxing_frame_util_create();
     return unboxer;
@@ -106,6 +144,7 @@ boxing_dunboxerv1 * boxing_dunboxerv1_create()
 
 void boxing_dunboxerv1_destroy(boxing_dunboxerv1 * unboxer)
 {
+    boxing_tracker_destroy(unboxer->tracker);
     boxing_generic_frame_factory_free(unboxer->frame);
     boxing_frame_util_destroy(unboxer->frame_util);
     boxing_memory_free(unboxer);
@@ -123,6 +162,9 @@ void boxing_dunboxerv1_destroy(boxing_dunboxerv1 * unboxer)
 
 int boxing_dunboxerv1_setup_config(boxing_dunboxerv1 * unboxer)
 {
+    // The tracker refers to the frame
+    boxing_tracker_destroy(unboxer->tracker);
+    unboxer->tracker = NULL;
 
     boxing_generic_frame_factory_free(unboxer->frame);
     unboxer->frame = boxing_generic_frame_factory_create(unboxer->parameters.format);
@@ -158,6 +200,10 @@ int boxing_dunboxerv1_setup_config(boxing_dunboxerv1 * unboxer)
  *  To detect that an error was ignored in the extraction phase, the user must 
  *  look at the extract_result parameter.
  *
+ *  When the built in quantizer is used, the reliability of each quantized
+ *  symbol is passed to the decoders as erasures, the symbols of a frame that
+ *  failed extraction are all erased.
+ *
  *  \param[in]      unboxer         Unboxer structure.
  *  \param[out]     data            Decoded digital data.
  *  \param[out]     metadata_list   Decoded metadata.
@@ -175,35 +221,190 @@ int boxing_dunboxerv1_process(
     int * extract_result,
     void * user_data)
 {
-    boxing_stats_decode decode_stats = { 0, 0, 0.0f, 0.0f };
     boxing_image8 * frame = image;
+    gvector * erasures = gvector_create_char(0, 0);
+
+    *extract_result = dunboxerv1_extract_container(unboxer, data, erasures, metadata_list, frame, user_data);
 
-    *extract_result = boxing_dunboxerv1_extract_container(unboxer, data, metadata_list, frame, user_data);
-    if (*extract_result != BOXING_UNBOXER_OK)
+    int result = dunboxerv1_decode_container(unboxer, data, erasures, metadata_list, *extract_result, user_data);
+    gvector_free(erasures);
+    return result;
+}
+
+
+//----------------------------------------------------------------------------
+/*!
+ *  \brief Unbox data and metadata from several frames.
+ *
+ *  The extraction phase of the frames is run in parallel, each worker thread
+ *  owns a separate unboxer context with its own frame and metadata codec.
+ *  The decoding phase is run on the calling thread in frame order, so
+ *  codecs with state spanning several frames see the same sequence as when
+ *  the frames are unboxed one by one with boxing_dunboxerv1_process.
+ *
+ *  If the pipeline_queue_depth parameter is larger than 0 the two phases are
+ *  pipelined, the calling thread decodes a frame while the worker threads
+ *  extract the following frames. The workers wait when pipeline_queue_depth
+ *  frames are extracted and not yet decoded. Otherwise all frames are
+ *  extracted before decoding starts.
+ *
+ *  \param[in]      unboxer       Unboxer structure.
+ *  \param[in,out]  frames        Frames to be unboxed.
+ *  \param[in]      frame_count   Number of frames.
+ *  \param[in]      worker_count  Number of extraction threads, a value less
+ *                                than 1 uses all available cores.
+ *  \return Result of the first frame not decoded successfully or
+ *          BOXING_UNBOXER_OK.
+ */
+
+int boxing_dunboxerv1_process_batch(
+    boxing_dunboxerv1 * unboxer,
+    boxing_unboxer_frame * frames,
+    int frame_count,
+    int worker_count)
+{
+    if (frame_count <= 0)
     {
-        boxing_codecdispatcher * dispatcher = boxing_dunboxerv1_dispatcher((boxing_unboxer *)unboxer, CODEC_DISPATCHER_DATA_CODING_SCHEME);
+        return BOXING_UNBOXER_OK;
+    }
+    if (frames == NULL)
+    {
+        return BOXING_UNBOXER_INPUT_DATA_ERROR;
+    }
 
-        if (!dispatcher)
+    worker_count = boxing_thread_resolve_count(worker_count, frame_count);
+    const DBOOL pipelined = unboxer->parameters.pipeline_queue_depth > 0 ? DTRUE : DFALSE;
+
+    if (worker_count == 1 && !pipelined)
+    {
+        int result = BOXING_UNBOXER_OK;
+        for (int i = 0; i < frame_count; i++)
         {
-            return *extract_result;
+            boxing_unboxer_frame * frame = frames + i;
+            frame->result = boxing_dunboxerv1_process(unboxer, frame->data, frame->metadata, frame->image, &frame->extract_result, frame->user_data);
+            if (result == BOXING_UNBOXER_OK)
+            {
+                result = frame->result;
+            }
         }
+        return result;
+    }
 
-        int encoded_size = (int)boxing_codecdispatcher_get_encoded_packet_size(dispatcher);
-        gvector_resize(data, encoded_size);
-        boxing_memory_clear(data->buffer, encoded_size);
+    dunboxerv1_batch batch;
+    batch.workers = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_dunboxerv1 *, worker_count);
+    batch.frames = frames;
+    batch.erasures = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(gvector *, frame_count);
+    batch.frame_count = frame_count;
+    batch.next_frame = 0;
+    batch.decoded_frames = 0;
+    batch.queue_depth = pipelined ? unboxer->parameters.pipeline_queue_depth : 0;
+    batch.extracted = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY_CLEAR(DBOOL, frame_count);
+    batch.mutex = boxing_mutex_create();
+    batch.frame_extracted = boxing_condition_create();
+    batch.frame_decoded = boxing_condition_create();
+    for (int i = 0; i < frame_count; i++)
+    {
+        batch.erasures[i] = gvector_create_char(0, 0);
     }
 
-    int decode_result = *extract_result;
-    for(unsigned int step = 0; step < unboxer->codec->decode_codecs.size; step++ )
+    int created_workers = 0;
+    while (created_workers < worker_count)
     {
-        decode_result = boxing_dunboxerv1_decode(unboxer, data, metadata_list, &decode_stats, step, user_data);
-        if (decode_result != BOXING_UNBOXER_OK)
+        batch.workers[created_workers] = dunboxerv1_create_worker(unboxer);
+        if (batch.workers[created_workers] == NULL)
         {
             break;
         }
+        created_workers++;
     }
 
-    return decode_result;
+    int result = BOXING_UNBOXER_OK;
+    if (created_workers < worker_count)
+    {
+        DLOG_ERROR( "boxing_dunboxerv1_process_batch:  Failed to create worker context" );
+        result = BOXING_UNBOXER_CONFIG_ERROR;
+    }
+    else if (pipelined)
+    {
+        dunboxerv1_batch_thread * threads = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(dunboxerv1_batch_thread, worker_count);
+        int started_threads = 0;
+        for (int i = 0; i < worker_count; i++)
+        {
+            threads[i].batch = &batch;
+            threads[i].index = i;
+            threads[i].thread = boxing_thread_create(dunboxerv1_extract_thread, threads + i);
+            if (threads[i].thread != NULL)
+            {
+                started_threads++;
+            }
+        }
+
+        if (started_threads == 0)
+        {
+            // No threads available, extract all frames before decoding
+            batch.queue_depth = 0;
+            dunboxerv1_extract_worker(&batch, 0);
+        }
+
+        for (int i = 0; i < frame_count; i++)
+        {
+            boxing_mutex_lock(batch.mutex);
+            while (!batch.extracted[i])
+            {
+                boxing_condition_wait(batch.frame_extracted, batch.mutex);
+            }
+            boxing_mutex_unlock(batch.mutex);
+
+            boxing_unboxer_frame * frame = frames + i;
+            frame->result = dunboxerv1_decode_container(unboxer, frame->data, batch.erasures[i], frame->metadata, frame->extract_result, frame->user_data);
+            if (result == BOXING_UNBOXER_OK)
+            {
+                result = frame->result;
+            }
+
+            boxing_mutex_lock(batch.mutex);
+            batch.decoded_frames++;
+            boxing_condition_broadcast(batch.frame_decoded);
+            boxing_mutex_unlock(batch.mutex);
+        }
+
+        for (int i = 0; i < worker_count; i++)
+        {
+            boxing_thread_join(threads[i].thread);
+        }
+        boxing_memory_free(threads);
+    }
+    else
+    {
+        boxing_thread_parallel_for(worker_count, worker_count, dunboxerv1_extract_worker, &batch);
+
+        for (int i = 0; i < frame_count; i++)
+        {
+            boxing_unboxer_frame * frame = frames + i;
+            frame->result = dunboxerv1_decode_container(unboxer, frame->data, batch.erasures[i], frame->metadata, frame->extract_result, frame->user_data);
+            if (result == BOXING_UNBOXER_OK)
+            {
+                result = frame->result;
+            }
+        }
+    }
+
+    for (int i = 0; i < created_workers; i++)
+    {
+        dunboxerv1_free_worker(batch.workers[i]);
+    }
+    for (int i = 0; i < frame_count; i++)
+    {
+        gvector_free(batch.erasures[i]);
+    }
+    boxing_memory_free(batch.workers);
+    boxing_memory_free(batch.erasures);
+    boxing_memory_free(batch.extracted);
+    boxing_mutex_free(batch.mutex);
+    boxing_condition_free(batch.frame_extracted);
+    boxing_condition_free(batch.frame_decoded);
+
+    return result;
 }
 
 //----------------------------------------------------------------------------
@@ -227,42 +428,7 @@ int boxing_dunboxerv1_extract_container(
     boxing_image8 * frame,
     void * user_data)
 {
-    if (!unboxer->frame)
-    {
-        DLOG_ERROR( "dunboxer_process:  Failed to inititalize frame");
-        return BOXING_UNBOXER_CONFIG_ERROR;
-    }
-
-    int retval = BOXING_UNBOXER_OK;
-
-    boxing_tracker * tracker = unboxer->frame->create_frame_tracker(unboxer->frame);
-
-#ifdef BOXINGLIB_CALLBACK
-    tracker->on_corner_mark_complete = unboxer->parameters.on_corner_mark_complete;
-    tracker->user_data = user_data;
-
-    if (unboxer->parameters.on_tracker_created)
-    {
-        if (unboxer->parameters.on_tracker_created(user_data, &retval, tracker) != BOXING_PROCESS_CALLBACK_OK)
-        {
-            return BOXING_UNBOXER_PROCESS_CALLBACK_ABORT;
-        }
-    }
-#endif
-    retval = dunboxerv1_load_data_from_image(unboxer, frame, data, metadata_list, DTRUE, tracker, user_data, unboxer->quantize_data_on_load);
-    boxing_tracker_destroy(tracker);
-
-#ifdef BOXINGLIB_CALLBACK
-    if (unboxer->parameters.on_content_quantized)
-    {
-        if (unboxer->parameters.on_content_quantized(user_data, &retval, (char *)data->buffer, (int)data->size) != BOXING_PROCESS_CALLBACK_OK)
-        {
-            return BOXING_UNBOXER_PROCESS_CALLBACK_ABORT;
-        }
-    }
-#endif
-    
-    return retval; 
+    return dunboxerv1_extract_container(unboxer, data, NULL, metadata_list, frame, user_data);
 }
 
 
@@ -283,25 +449,7 @@ int boxing_dunboxerv1_extract_container(
 
 int boxing_dunboxerv1_decode(boxing_dunboxerv1 * unboxer, gvector * data, boxing_metadata_list * metadata, boxing_stats_decode * decode_stats, unsigned int step, void * user_data)
 {
-    boxing_metadata_item_content_type * item = (boxing_metadata_item_content_type *)boxing_metadata_list_find_item(metadata, BOXING_METADATA_TYPE_CONTENTTYPE);
-    if (item && item->value == BOXING_METADATA_CONTENT_TYPES_VISUAL)
-    {
-        DLOG_INFO( "boxing_dunboxerv1_decode:  Skipping decode, visual content" );
-        return BOXING_UNBOXER_OK;
-    }
-
-    int retval = dunboxerv1_decode_step(unboxer, data, metadata, decode_stats, step, user_data);
-#ifdef BOXINGLIB_CALLBACK
-    if (unboxer->parameters.on_all_complete && ((retval != BOXING_UNBOXER_OK) || (step == (unboxer->codec->encode_codecs.size - 1))))
-    {
-        int res = retval;
-        if (unboxer->parameters.on_all_complete(user_data, &res, decode_stats) != BOXING_PROCESS_CALLBACK_OK)
-        {
-            return BOXING_UNBOXER_PROCESS_CALLBACK_ABORT;
-        }
-    }
-#endif
-    return retval;
+    return dunboxerv1_decode(unboxer, data, NULL, metadata, decode_stats, step, user_data);
 }
 
 
@@ -347,6 +495,92 @@ boxing_codecdispatcher * boxing_dunboxerv1_dispatcher(const boxing_unboxer * unb
 // PRIVATE UNBOXER V1 FUNCTIONS
 //
 
+// Extract the container, the erasures are filled with the reliability of the
+// quantized symbols when the built in quantizer is used and left empty otherwise.
+static int dunboxerv1_extract_container(
+    boxing_dunboxerv1 * unboxer,
+    gvector * data,
+    gvector * erasures,
+    boxing_metadata_list * metadata_list,
+    boxing_image8 * frame,
+    void * user_data)
+{
+    if (!unboxer->frame)
+    {
+        DLOG_ERROR( "dunboxer_process:  Failed to inititalize frame");
+        return BOXING_UNBOXER_CONFIG_ERROR;
+    }
+
+    int retval = BOXING_UNBOXER_OK;
+
+    // The tracker is kept from frame to frame, so the samplers are only
+    // allocated once and the tracker can start from the previous frame geometry
+    boxing_tracker * tracker = unboxer->tracker;
+    if (tracker == NULL)
+    {
+        tracker = unboxer->frame->create_frame_tracker(unboxer->frame);
+
+#ifdef BOXINGLIB_CALLBACK
+        tracker->on_corner_mark_complete = unboxer->parameters.on_corner_mark_complete;
+        tracker->user_data = user_data;
+
+        if (unboxer->parameters.on_tracker_created)
+        {
+            if (unboxer->parameters.on_tracker_created(user_data, &retval, tracker) != BOXING_PROCESS_CALLBACK_OK)
+            {
+                boxing_tracker_destroy(tracker);
+                return BOXING_UNBOXER_PROCESS_CALLBACK_ABORT;
+            }
+        }
+#endif
+        unboxer->tracker = tracker;
+    }
+    tracker->thread_count = unboxer->parameters.thread_count;
+#ifdef BOXINGLIB_CALLBACK
+    tracker->user_data = user_data;
+#endif
+
+    retval = dunboxerv1_load_data_from_image(unboxer, frame, data, erasures, metadata_list, DTRUE, tracker, user_data, unboxer->quantize_data_on_load);
+
+#ifdef BOXINGLIB_CALLBACK
+    if (unboxer->parameters.on_content_quantized)
+    {
+        if (unboxer->parameters.on_content_quantized(user_data, &retval, (char *)data->buffer, (int)data->size) != BOXING_PROCESS_CALLBACK_OK)
+        {
+            return BOXING_UNBOXER_PROCESS_CALLBACK_ABORT;
+        }
+    }
+#endif
+    
+    return retval; 
+}
+
+
+// Decode a step of the data container, erasures may be NULL
+static int dunboxerv1_decode(boxing_dunboxerv1 * unboxer, gvector * data, gvector * erasures, boxing_metadata_list * metadata, boxing_stats_decode * decode_stats, unsigned int step, void * user_data)
+{
+    boxing_metadata_item_content_type * item = (boxing_metadata_item_content_type *)boxing_metadata_list_find_item(metadata, BOXING_METADATA_TYPE_CONTENTTYPE);
+    if (item && item->value == BOXING_METADATA_CONTENT_TYPES_VISUAL)
+    {
+        DLOG_INFO( "boxing_dunboxerv1_decode:  Skipping decode, visual content" );
+        return BOXING_UNBOXER_OK;
+    }
+
+    int retval = dunboxerv1_decode_step(unboxer, data, erasures, metadata, decode_stats, step, user_data);
+#ifdef BOXINGLIB_CALLBACK
+    if (unboxer->parameters.on_all_complete && ((retval != BOXING_UNBOXER_OK) || (step == (unboxer->codec->encode_codecs.size - 1))))
+    {
+        int res = retval;
+        if (unboxer->parameters.on_all_complete(user_data, &res, decode_stats) != BOXING_PROCESS_CALLBACK_OK)
+        {
+            return BOXING_UNBOXER_PROCESS_CALLBACK_ABORT;
+        }
+    }
+#endif
+    return retval;
+}
+
+
 //----------------------------------------------------------------------------
 /*!
  *  Decode data using the 
@@ -359,7 +593,7 @@ boxing_codecdispatcher * boxing_dunboxerv1_dispatcher(const boxing_unboxer * unb
  *  \return Unboxing result status code
  */
 
-static int dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, boxing_metadata_list * metadata, boxing_stats_decode * decode_stats, unsigned int step, void * user_data)
+static int dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, gvector * erasures, boxing_metadata_list * metadata, boxing_stats_decode * decode_stats, unsigned int step, void * user_data)
 {
 #ifndef BOXINGLIB_CALLBACK
 	BOXING_UNUSED_PARAMETER(user_data);
@@ -396,6 +630,10 @@ static int dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, b
                     }
                     // convert data oldschool style
                     pack_data(data);
+                    if (erasures)
+                    {
+                        gvector_resize(erasures, 0);
+                    }
                 }
             }
         }
@@ -443,7 +681,10 @@ static int dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, b
 
         // old school codec does not calculate CRC, but last decoder will fail
         // if any errors are detected
-        retval = boxing_codecdispatcher_decode_step_codec(codec, data, NULL, decode_stats, user_data) ? BOXING_UNBOXER_OK : BOXING_UNBOXER_DATA_DECODE_ERROR;
+        boxing_stats_stage_timer timer;
+        dunboxerv1_stage_begin(unboxer, &timer);
+        retval = boxing_codecdispatcher_decode_step_codec(codec, data, erasures, decode_stats, user_data) ? BOXING_UNBOXER_OK : BOXING_UNBOXER_DATA_DECODE_ERROR;
+        dunboxerv1_stage_end(unboxer, &timer, codec->name, the_dispatcher->codeing_scheme, (int)step, user_data);
 
         if (retval != BOXING_UNBOXER_OK)
         {
@@ -491,6 +732,15 @@ static int dunboxerv1_decode_step(boxing_dunboxerv1 * unboxer, gvector * data, b
     return retval;
 }
 
+static int dunboxerv1_apply_filter(boxing_dunboxerv1 * unboxer, boxing_image8 * image, const boxing_filter_coeff_2d * filter_coeff)
+{
+    if (unboxer->parameters.pre_filter.precision == BOXING_FILTER_PRECISION_FIXED_POINT)
+    {
+        return boxing_filter_apply_fixed_point(image, filter_coeff, unboxer->parameters.thread_count);
+    }
+    return boxing_filter_apply(image, filter_coeff, unboxer->parameters.thread_count);
+}
+
 static int dunboxerv1_sharpness_filter(void* user_data, boxing_dunboxerv1 * unboxer, boxing_image8 * image, boxing_float mix)
 {
     if ( !unboxer->parameters.pre_filter.coeff )
@@ -498,8 +748,6 @@ static int dunboxerv1_sharpness_filter(void* user_data, boxing_dunboxerv1 * unbo
         return BOXING_FILTER_CALLBACK_ERROR;
     }
 
-    const int width = image->width;
-    const int height = image->height;
     boxing_filter_coeff_2d filter_coeff;
     filter_coeff.rows = unboxer->parameters.pre_filter.coeff->rows;
     filter_coeff.cols = unboxer->parameters.pre_filter.coeff->cols;
@@ -515,51 +763,13 @@ static int dunboxerv1_sharpness_filter(void* user_data, boxing_dunboxerv1 * unbo
     {
         return unboxer->parameters.pre_filter.process(user_data, image, filter_coeff.coeff, coeff_count);
     }
-    else
-    {
-        boxing_image8 destination;
-        boxing_image8_init_in_place(&destination, width, height);
-        if (destination.data == NULL)
-        {
-            DLOG_ERROR( "unboxer_sharpness_filter:  Can't allocate temporary image data! Filter is not applied!");
-            return BOXING_FILTER_CALLBACK_ERROR;
-        }
-        boxing_image8_pixel * destination_pixel = destination.data;
-        const int rows = filter_coeff.rows;
-        const int cols = filter_coeff.cols;
-        const int filter_y_radius = rows / 2;
-        const int filter_x_radius = cols / 2;
-        boxing_float * coeff = filter_coeff.coeff;
-
-        for (int y = 0; y < height; y++)
-        {
-            for (int x = 0; x < width; x++)
-            {
-                int Y = (y - filter_y_radius + height) % height;
-
-                boxing_float value = 0.0f;
 
-                for (int i = 0; i < rows; i++)
-                {
-                    int X = x - filter_x_radius + width;
-                    const boxing_image8_pixel * pixel = image->data + Y * width;
-                    for (int j = 0; j < cols; j++)
-                    {
-                        value += *(coeff + i*cols + j) * *(pixel + (X++) % width);
-                    }
-
-                    Y = ((Y + 1) % height);
-                }
-
-                value = BOXING_MATH_CLAMP(BOXING_PIXEL_MIN, BOXING_PIXEL_MAX, value);
-                *destination_pixel++ = (boxing_image8_pixel)value;
-            }
-        }
-        memcpy(image->data, destination.data, width * height);
-        boxing_memory_free(destination.data);
+    int result = dunboxerv1_apply_filter(unboxer, image, &filter_coeff);
+    if (result != BOXING_FILTER_CALLBACK_OK)
+    {
+        DLOG_ERROR( "unboxer_sharpness_filter:  Can't allocate filter buffers! Filter is not applied!");
     }
-
-    return BOXING_FILTER_CALLBACK_OK;
+    return result;
 }
 
 static int dunboxerv1_visual_sharpness_filter(void* user_data, boxing_dunboxerv1 * unboxer, boxing_image8 * image)
@@ -568,8 +778,6 @@ static int dunboxerv1_visual_sharpness_filter(void* user_data, boxing_dunboxerv1
     {
         return BOXING_FILTER_CALLBACK_ERROR;
     }
-    const int width = image->width;
-    const int height = image->height;
 
     boxing_filter_coeff_2d filter_coeff;
     filter_coeff.rows = 5;
@@ -591,52 +799,13 @@ static int dunboxerv1_visual_sharpness_filter(void* user_data, boxing_dunboxerv1
     {
         return unboxer->parameters.pre_filter.process(user_data, image, filter_coeff.coeff, coeff_count);
     }
-    else
-    {
-        boxing_image8 destination;
-        boxing_image8_init_in_place(&destination, width, height);
-        if (destination.data == NULL)
-        {
-            DLOG_ERROR( "unboxer_visual_sharpness_filter:  Can't allocate temporary image data! Filter is not applied!");
-            return BOXING_FILTER_CALLBACK_ERROR;
-        }
-
-        boxing_image8_pixel * destination_pixel = destination.data;
-        const int rows = filter_coeff.rows;
-        const int cols = filter_coeff.cols;
-        const int filter_y_radius = rows / 2;
-        const int filter_x_radius = cols / 2;
-        boxing_float * coeff = filter_coeff.coeff;
-
-        for (int y = 0; y < height; y++)
-        {
-            for (int x = 0; x < width; x++)
-            {
-                int Y = (y - filter_y_radius + height) % height;
-
-                boxing_float value = 0.0f;
-
-                for (int i = 0; i < rows; i++)
-                {
-                    int X = x - filter_x_radius + width;
-                    const boxing_image8_pixel * pixel = image->data + Y * width;
-                    for (int j = 0; j < cols; j++)
-                    {
-                        value += *(coeff + i*cols + j) * *(pixel + (X++) % width);
-                    }
 
-                    Y = ((Y + 1) % height);
-                }
-
-                value = BOXING_MATH_CLAMP(BOXING_PIXEL_MIN, BOXING_PIXEL_MAX, value);
-                *destination_pixel++ = (boxing_image8_pixel)value;
-            }
-        }
-        memcpy(image->data, destination.data, width * height);
-        boxing_memory_free(destination.data);
+    int result = dunboxerv1_apply_filter(unboxer, image, &filter_coeff);
+    if (result != BOXING_FILTER_CALLBACK_OK)
+    {
+        DLOG_ERROR( "unboxer_visual_sharpness_filter:  Can't allocate filter buffers! Filter is not applied!");
     }
-
-    return BOXING_FILTER_CALLBACK_OK;
+    return result;
 }
 
 static DBOOL dunboxerv1_calculate_lut(struct boxing_tracker_s * tracker, const boxing_image8 * image, boxing_image8_pixel* lut)
@@ -776,7 +945,7 @@ static DBOOL decode_metadata(
         gvector_free(packed_data);
     }
 
-    boxing_stats_decode decode_stats = {0, 0, 0.0f, 0.0f};
+    boxing_stats_decode decode_stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
     
     if (!boxing_codecdispatcher_decode(codec, metadata_bytes, &decode_stats, user_data))
     {
@@ -939,8 +1108,13 @@ static int dunboxerv1_calculate_mtf(
     return retval;
 }
 
- static int extract_digital_content(void* user, boxing_dunboxerv1 * unboxer, boxing_image8 * sampled_image, int symbols_per_pixel, gvector * the_data_array, DBOOL quantize_data)
+ static int extract_digital_content(void* user, boxing_dunboxerv1 * unboxer, boxing_image8 * sampled_image, int symbols_per_pixel, gvector * the_data_array, gvector * erasures, DBOOL quantize_data)
 {
+    if (erasures)
+    {
+        gvector_resize(erasures, 0);
+    }
+
     if (!quantize_data)
     {
         gvector_resize(the_data_array, sampled_image->width * sampled_image->height);
@@ -954,7 +1128,7 @@ static int dunboxerv1_calculate_mtf(
     }
     else
     {
-        gvector_replace(the_data_array, boxing_datapoints_quantize(sampled_image, 32, 32, symbols_per_pixel));
+        gvector_replace(the_data_array, boxing_datapoints_quantize_erasures(sampled_image, 32, 32, symbols_per_pixel, erasures, unboxer->parameters.thread_count));
     }
     return  BOXING_UNBOXER_OK;
 }
@@ -1011,6 +1185,7 @@ static int dunboxerv1_load_data_from_image(
     boxing_dunboxerv1 * unboxer,
     boxing_image8 * image, 
     gvector * the_data_array, 
+    gvector * erasures,
     boxing_metadata_list * metadata_list,
     int horizontal_border_tracking,
     struct boxing_tracker_s * tracker,
@@ -1050,7 +1225,11 @@ static int dunboxerv1_load_data_from_image(
 
     tracker->mode = tracker_mode;
 
-    if (tracker->track_frame(tracker, image))
+    boxing_stats_stage_timer timer;
+    dunboxerv1_stage_begin(unboxer, &timer);
+    const int track_result = tracker->track_frame(tracker, image);
+    dunboxerv1_stage_end(unboxer, &timer, "tracking", NULL, -1, user_data);
+    if (track_result)
     {
         DLOG_ERROR( "unboxing_load_data_from_image:  Tracking frame failed");
         return BOXING_UNBOXER_BORDER_TRACKING_ERROR;
@@ -1064,8 +1243,10 @@ static int dunboxerv1_load_data_from_image(
         return BOXING_UNBOXER_METADATA_ERROR;
     }
 
-    
-    if (!decode_metadata(metadata_list, image, metadata_sampler, unboxer->metadata_codec, user_data))
+    dunboxerv1_stage_begin(unboxer, &timer);
+    const DBOOL metadata_decoded = decode_metadata(metadata_list, image, metadata_sampler, unboxer->metadata_codec, user_data);
+    dunboxerv1_stage_end(unboxer, &timer, "metadata", NULL, -1, user_data);
+    if (!metadata_decoded)
     {
         DLOG_WARNING( "unboxing_load_data_from_image:  Decoding meta data failed");
         retval = BOXING_UNBOXER_METADATA_ERROR;
@@ -1143,13 +1324,16 @@ static int dunboxerv1_load_data_from_image(
         // Measure MTF, used by adaptive sharpening
         boxing_float horizontal_mtf;
         boxing_float vertical_mtf;
+        dunboxerv1_stage_begin(unboxer, &timer);
         int result = dunboxerv1_calculate_mtf(unboxer, image, symbols_per_pixel, tracker, user_data, &horizontal_mtf, &vertical_mtf);
+        dunboxerv1_stage_end(unboxer, &timer, "mtf", NULL, -1, user_data);
         if (result != BOXING_UNBOXER_OK)
         {
             return result;
         }
 
         int sharpen_result;
+        dunboxerv1_stage_begin(unboxer, &timer);
         if (is_analogue_data)
         {
             sharpen_result = dunboxerv1_visual_sharpness_filter(user_data, unboxer, image);
@@ -1161,6 +1345,7 @@ static int dunboxerv1_load_data_from_image(
                                                                       unboxer->parameters.pre_filter.coeff);
             sharpen_result = dunboxerv1_sharpness_filter(user_data, unboxer, image, mix);
         }
+        dunboxerv1_stage_end(unboxer, &timer, "filter", NULL, -1, user_data);
 
         if ( sharpen_result == BOXING_FILTER_CALLBACK_ERROR )
         {
@@ -1180,7 +1365,22 @@ static int dunboxerv1_load_data_from_image(
         return BOXING_UNBOXER_DATA_DECODE_ERROR;
     }
 
+    if ( unboxer->parameters.sample_quantize_contents && !is_analogue_data && quantize_data )
+    {
+        // Map the datapoints straight to symbols, no sampled image is created
+        dunboxerv1_stage_begin(unboxer, &timer);
+        if (erasures)
+        {
+            gvector_resize(erasures, 0);
+        }
+        gvector_replace(the_data_array, unboxer->parameters.sample_quantize_contents(user_data, image, &content_sampler->location_matrix,
+            32, 32, symbols_per_pixel, erasures));
+        dunboxerv1_stage_end(unboxer, &timer, "sampling and quantization", NULL, -1, user_data);
+        return BOXING_UNBOXER_OK;
+    }
+
     boxing_image8 * sampled_image = NULL;
+    dunboxerv1_stage_begin(unboxer, &timer);
     if ( unboxer->parameters.sample_contents )
     {
         // Hijack the content sampler
@@ -1189,6 +1389,7 @@ static int dunboxerv1_load_data_from_image(
     }
     else
     {
+        content_sampler->thread_count = unboxer->parameters.thread_count;
         sampled_image = content_sampler->sample( content_sampler, image );
     }
 
@@ -1202,6 +1403,7 @@ static int dunboxerv1_load_data_from_image(
             dunboxerv1_apply_lut(sampled_image, lut);
         }
     }
+    dunboxerv1_stage_end(unboxer, &timer, "sampling", NULL, -1, user_data);
 
 #ifdef BOXINGLIB_CALLBACK
     if (unboxer->parameters.on_content_sampled)
@@ -1220,20 +1422,184 @@ static int dunboxerv1_load_data_from_image(
     }
 #endif
 
+    dunboxerv1_stage_begin(unboxer, &timer);
     if( is_analogue_data )
     {
         retval = extract_analog_content(sampled_image, the_data_array, user_data);
     } 
     else 
     {
-        retval = extract_digital_content(user_data, unboxer, sampled_image, symbols_per_pixel, the_data_array, quantize_data);
+        retval = extract_digital_content(user_data, unboxer, sampled_image, symbols_per_pixel, the_data_array, erasures, quantize_data);
     }
+    dunboxerv1_stage_end(unboxer, &timer, "quantization", NULL, -1, user_data);
 
     boxing_image8_free(sampled_image);
     return retval;
 }
 
-// convert data oldschool style 
+static int dunboxerv1_decode_container(
+    boxing_dunboxerv1 * unboxer,
+    gvector * data,
+    gvector * erasures,
+    boxing_metadata_list * metadata_list,
+    int extract_result,
+    void * user_data)
+{
+    boxing_stats_decode decode_stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+
+    if (extract_result != BOXING_UNBOXER_OK)
+    {
+        boxing_codecdispatcher * dispatcher = boxing_dunboxerv1_dispatcher((boxing_unboxer *)unboxer, CODEC_DISPATCHER_DATA_CODING_SCHEME);
+
+        if (!dispatcher)
+        {
+            return extract_result;
+        }
+
+        int encoded_size = (int)boxing_codecdispatcher_get_encoded_packet_size(dispatcher);
+        gvector_resize(data, encoded_size);
+        boxing_memory_clear(data->buffer, encoded_size);
+
+        // Nothing is known about the content, erase all of it
+        gvector_resize(erasures, encoded_size);
+        memset(erasures->buffer, 0xff, encoded_size);
+    }
+
+    int decode_result = extract_result;
+    for(unsigned int step = 0; step < unboxer->codec->decode_codecs.size; step++ )
+    {
+        decode_result = dunboxerv1_decode(unboxer, data, erasures, metadata_list, &decode_stats, step, user_data);
+        if (decode_result != BOXING_UNBOXER_OK)
+        {
+            break;
+        }
+    }
+
+    return decode_result;
+}
+
+
+// Worker contexts share the data codec of the unboxer, it is only read during
+// extraction. The metadata codec and the frame are owned by the worker.
+static boxing_dunboxerv1 * dunboxerv1_create_worker(const boxing_dunboxerv1 * unboxer)
+{
+    boxing_dunboxerv1 * worker = boxing_dunboxerv1_create();
+    if (!worker)
+    {
+        return NULL;
+    }
+
+    boxing_unboxer_parameters_free(&worker->parameters);
+    worker->parameters = unboxer->parameters;
+    worker->parameters.thread_count = 1;
+
+    if (worker->parameters.training_result && worker->frame_util)
+    {
+        worker->frame_util->deserialize(worker->frame_util, (char *)worker->parameters.training_result);
+    }
+
+    if (boxing_dunboxerv1_setup_config(worker) != BOXING_UNBOXER_OK)
+    {
+        boxing_dunboxerv1_destroy(worker);
+        return NULL;
+    }
+
+    worker->metadata_codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(worker->frame, metadata_container, capasity),
+                                        BOXING_CODEC_MODULATION_PAM2, worker->parameters.format, "MetadataCodingScheme");
+    boxing_codecdispatcher_callback_setup(worker->metadata_codec, worker->parameters.codec_cb);
+#ifdef BOXINGLIB_CALLBACK
+    worker->metadata_codec->on_decode_stage = worker->parameters.on_stage_timing;
+#endif
+    worker->codec = unboxer->codec;
+    return worker;
+}
+
+
+static void dunboxerv1_free_worker(boxing_dunboxerv1 * worker)
+{
+    boxing_codecdispatcher_free(worker->metadata_codec);
+    boxing_dunboxerv1_destroy(worker);
+}
+
+
+static void dunboxerv1_extract_worker(void * user, int index)
+{
+    dunboxerv1_batch * batch = (dunboxerv1_batch *)user;
+    boxing_dunboxerv1 * worker = batch->workers[index];
+
+    for (;;)
+    {
+        boxing_mutex_lock(batch->mutex);
+        // Back pressure, wait for the decoder when the queue is full
+        while (batch->queue_depth > 0 && batch->next_frame < batch->frame_count &&
+               batch->next_frame - batch->decoded_frames >= batch->queue_depth)
+        {
+            boxing_condition_wait(batch->frame_decoded, batch->mutex);
+        }
+        int frame_index = batch->next_frame++;
+        boxing_mutex_unlock(batch->mutex);
+
+        if (frame_index >= batch->frame_count)
+        {
+            break;
+        }
+
+        boxing_unboxer_frame * frame = batch->frames + frame_index;
+        frame->extract_result = dunboxerv1_extract_container(worker, frame->data, batch->erasures[frame_index], frame->metadata, frame->image, frame->user_data);
+
+        boxing_mutex_lock(batch->mutex);
+        batch->extracted[frame_index] = DTRUE;
+        boxing_condition_broadcast(batch->frame_extracted);
+        boxing_mutex_unlock(batch->mutex);
+    }
+}
+
+
+static void dunboxerv1_extract_thread(void * user)
+{
+    dunboxerv1_batch_thread * thread = (dunboxerv1_batch_thread *)user;
+    dunboxerv1_extract_worker(thread->batch, thread->index);
+}
+
+
+static void dunboxerv1_stage_begin(const boxing_dunboxerv1 * unboxer, boxing_stats_stage_timer * timer)
+{
+#ifdef BOXINGLIB_CALLBACK
+    if (unboxer->parameters.on_stage_timing)
+    {
+        boxing_stats_stage_begin(timer);
+    }
+#else
+    BOXING_UNUSED_PARAMETER(unboxer);
+    BOXING_UNUSED_PARAMETER(timer);
+#endif
+}
+
+
+static void dunboxerv1_stage_end(const boxing_dunboxerv1 * unboxer, boxing_stats_stage_timer * timer, const char * name,
+    const char * coding_scheme, int step, void * user_data)
+{
+#ifdef BOXINGLIB_CALLBACK
+    if (unboxer->parameters.on_stage_timing)
+    {
+        boxing_stats_stage stage;
+        boxing_stats_stage_end(timer, &stage);
+        stage.name = name;
+        stage.coding_scheme = coding_scheme;
+        stage.step = step;
+        unboxer->parameters.on_stage_timing(user_data, &stage);
+    }
+#else
+    BOXING_UNUSED_PARAMETER(unboxer);
+    BOXING_UNUSED_PARAMETER(timer);
+    BOXING_UNUSED_PARAMETER(name);
+    BOXING_UNUSED_PARAMETER(coding_scheme);
+    BOXING_UNUSED_PARAMETER(step);
+    BOXING_UNUSED_PARAMETER(user_data);
+#endif
+}
+
+
 static void pack_data(gvector * data)
 {                    
     gvector packed_data;
@@ -42,6 +42,7 @@ typedef struct boxing_dunboxerv1_s
     struct boxing_abstract_frame_util_s * frame_util;
     boxing_codecdispatcher *              codec;
     boxing_codecdispatcher *              metadata_codec;
+    struct boxing_tracker_s *             tracker;
     int                                   preload_frames;
     DBOOL                                 quantize_data_on_load;
 } boxing_dunboxerv1;
@@ -52,6 +53,8 @@ int                     boxing_dunboxerv1_setup_config(boxing_dunboxerv1 * unbox
 int                     boxing_dunboxerv1_process(boxing_dunboxerv1 * unboxer, gvector * data,
                                                   boxing_metadata_list * metadata_list, boxing_image8 * image,
 												  int * extract_result, void *user_data);
+int                     boxing_dunboxerv1_process_batch(boxing_dunboxerv1 * unboxer, boxing_unboxer_frame * frames,
+                                                        int frame_count, int worker_count);
 int                     boxing_dunboxerv1_extract_container(boxing_dunboxerv1 * unboxer, gvector * data,
                             boxing_metadata_list * metadata_list, boxing_image8 * image, void *user_data);
 int                     boxing_dunboxerv1_decode(boxing_dunboxerv1 * unboxer, gvector * data, 
@@ -0,0 +1,959 @@
+/*****************************************************************************
+**
+**  Implementation of the unboxing benchmark application
+**
+**  Creation date:  2026/10/17
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+//  PROJECT INCLUDES
+//
+#include "boxing/unboxer.h"
+#include "boxing/config.h"
+#include "boxing/metadata.h"
+#include "boxing/utils.h"
+#include "boxing/codecs/cipher.h"
+#include "boxing/codecs/codecdispatcher.h"
+#include "boxing/graphics/genericframe.h"
+#include "boxing/graphics/genericframefactory.h"
+#include "boxing/graphics/image8paintdevice.h"
+#include "boxing/graphics/painter.h"
+#include "boxing/math/crc32.h"
+#include "boxing/math/crc64.h"
+#include "boxing/platform/clock.h"
+#include "boxing/platform/memory.h"
+#include "boxing/string.h"
+#include "boxing_config.h"
+
+//  SYSTEM INCLUDES
+//
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//  DEFINES
+//
+//#define LOGGING_ENABLED // Enables log output from the unboxing library
+
+#define BENCHMARK_MAX_STAGES 32
+#define BENCHMARK_PI 3.14159265358979323846
+
+
+typedef struct command_line_parameters_s
+{
+    const char*  format;
+    unsigned int frame_count;
+    unsigned int stripe_size;
+    int          thread_count;
+    size_t       x_size;
+    size_t       y_size;
+    double       scale;
+    double       blur;
+    double       noise;
+    double       rotation;
+    double       gain_drift;
+    DBOOL        is_raw;
+    DBOOL        is_fused;
+    DBOOL        help;
+    DBOOL        valid;
+} command_line_parameters;
+
+typedef struct benchmark_stage_s
+{
+    const char * name;
+    const char * coding_scheme;
+    int          step;
+    double       total_ms;
+    double       min_ms;
+    double       max_ms;
+    size_t       peak_allocation;
+    unsigned int count;
+} benchmark_stage;
+
+typedef struct benchmark_timer_s
+{
+    benchmark_stage      stages[BENCHMARK_MAX_STAGES];
+    unsigned int         stage_count;
+    double               frame_start;
+    double               extract_end;
+    boxing_stats_decode  stats;
+} benchmark_timer;
+
+typedef struct benchmark_random_s
+{
+    boxing_uint32 state;
+} benchmark_random;
+
+static const char * result_names[] =
+{
+    "OK",
+    "METADATA ERROR",
+    "BORDER TRACKING ERROR",
+    "DATA DECODE ERROR",
+    "CRC MISMATCH ERROR",
+    "CONFIG ERROR",
+    "PROCESS CALLBACK ABORT"
+};
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Uniform pseudo random number in the range (0, 1). A private generator is
+ *  used so the synthetic frames are identical on every host and release.
+ *
+ *  \param random  Generator state.
+ *  \return Random number.
+ */
+
+static double benchmark_random_uniform(benchmark_random * random)
+{
+    boxing_uint32 x = random->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    random->state = x;
+    return ((double)x + 1.0) / 4294967297.0;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Normal distributed pseudo random number with zero mean and unit variance.
+ *
+ *  \param random  Generator state.
+ *  \return Random number.
+ */
+
+static double benchmark_random_gaussian(benchmark_random * random)
+{
+    double u1 = benchmark_random_uniform(random);
+    double u2 = benchmark_random_uniform(random);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * BENCHMARK_PI * u2);
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Append a metadata item with a 32 bit value to the list.
+ *
+ *  \param list   Metadata list.
+ *  \param type   Metadata type.
+ *  \param value  Item value.
+ */
+
+static void append_metadata_u32(boxing_metadata_list * list, boxing_metadata_type type, boxing_uint32 value)
+{
+    boxing_metadata_item * item = boxing_metadata_item_create(type);
+    ((boxing_metadata_item_u32 *)item)->value = value;
+    boxing_metadata_list_append_item(list, item);
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Encode the metadata list and place it in the metadata container of the frame.
+ *
+ *  \param frame     Frame to update.
+ *  \param codec     Metadata codec dispatcher.
+ *  \param metadata  Metadata to encode.
+ *  \return DTRUE on success.
+ */
+
+static DBOOL set_frame_metadata(boxing_frame * frame, boxing_codecdispatcher * codec, boxing_metadata_list * metadata)
+{
+    gvector * data = boxing_metadata_list_serialize(metadata);
+
+    if (boxing_codecdispatcher_version_cmp(&codec->version, &BOXING_CODEC_DISPATCHER_1_0) < 0)
+    {
+        // Older dispatchers expect a padded packet terminated by a CRC32
+        const size_t packet_size = boxing_codecdispatcher_get_decoded_packet_size(codec);
+        const size_t used_size = data->size;
+        gvector_resize(data, packet_size);
+        boxing_memory_clear((char *)data->buffer + used_size, packet_size - used_size);
+
+        dcrc32 * crc = boxing_math_crc32_create_def();
+        boxing_uint32 crc_value = boxing_math_crc32_calc_crc(crc, (char *)data->buffer, (unsigned int)(packet_size - 4));
+        boxing_math_crc32_free(crc);
+
+        unsigned char * crc_bytes = (unsigned char *)data->buffer + packet_size - 4;
+        crc_bytes[0] = (unsigned char)(crc_value >> 24);
+        crc_bytes[1] = (unsigned char)(crc_value >> 16);
+        crc_bytes[2] = (unsigned char)(crc_value >> 8);
+        crc_bytes[3] = (unsigned char)crc_value;
+    }
+
+    if (!boxing_codecdispatcher_encode(codec, data))
+    {
+        gvector_free(data);
+        return DFALSE;
+    }
+
+    if (codec->symbol_alignment == BOXING_CODEC_SYMBOL_ALIGNMENT_BIT)
+    {
+        gvector * bits = gvector_create_char(data->size * 8, 0);
+        for (size_t i = 0; i < bits->size; i++)
+        {
+            ((char *)bits->buffer)[i] = (((unsigned char *)data->buffer)[i / 8] >> (7 - i % 8)) & 1;
+        }
+        gvector_free(data);
+        data = bits;
+    }
+
+    BOXING_VIRTUAL2p2(frame, metadata_container, set_data, (char *)data->buffer, (int)data->size);
+    gvector_free(data);
+    return DTRUE;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Render a synthetic frame filled with pseudo random data. The data is encoded
+ *  with the data coding scheme of the format and the frame is painted through
+ *  the generic frame components.
+ *
+ *  \param[in]  config        Boxing format configuration.
+ *  \param[in]  frame_number  Frame number, also used as the random seed.
+ *  \param[out] source        Unencoded frame data.
+ *  \return Rendered frame or NULL on error.
+ */
+
+static boxing_image8 * render_frame(boxing_config * config, unsigned int frame_number, gvector ** source)
+{
+    boxing_frame * frame = boxing_generic_frame_factory_create(config);
+    if (frame == NULL)
+    {
+        return NULL;
+    }
+
+    const int levels = frame->levels_per_symbol(frame);
+    boxing_codecdispatcher * data_codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(frame, container, capasity), levels, config, "DataCodingScheme");
+    boxing_codecdispatcher * metadata_codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(frame, metadata_container, capasity), BOXING_CODEC_MODULATION_PAM2, config, "MetadataCodingScheme");
+    boxing_image8 * image = NULL;
+
+    const boxing_uint32 cipher_key = 1234 + frame_number;
+    const int size = boxing_codecdispatcher_get_decoded_packet_size(data_codec);
+    benchmark_random random = { 0x9e3779b9u ^ (frame_number * 2654435761u) };
+
+    *source = gvector_create_char(size, 0);
+    for (int i = 0; i < size; i++)
+    {
+        ((unsigned char *)(*source)->buffer)[i] = (unsigned char)(benchmark_random_uniform(&random) * 256.0);
+    }
+
+    boxing_metadata_list * metadata = boxing_metadata_list_create();
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_JOBID, 1);
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_FRAMENUMBER, frame_number);
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_CIPHERKEY, cipher_key);
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_DATASIZE, size);
+
+    boxing_metadata_item * content_type = boxing_metadata_item_create(BOXING_METADATA_TYPE_CONTENTTYPE);
+    ((boxing_metadata_item_content_type *)content_type)->value = BOXING_METADATA_CONTENT_TYPES_DATA;
+    boxing_metadata_list_append_item(metadata, content_type);
+
+    dcrc64 * crc = boxing_math_crc64_create_def();
+    boxing_metadata_item * data_crc = boxing_metadata_item_create(BOXING_METADATA_TYPE_DATACRC);
+    ((boxing_metadata_item_data_crc *)data_crc)->value = boxing_math_crc64_calc_crc(crc, (*source)->buffer, size);
+    boxing_metadata_list_append_item(metadata, data_crc);
+    boxing_math_crc64_free(crc);
+
+    // The unboxer reads the cipher key from the metadata
+    for (unsigned int i = 0; i < data_codec->encode_codecs.size; i++)
+    {
+        boxing_codec * codec = GVECTORN(&data_codec->encode_codecs, boxing_codec *, i);
+        if (boxing_string_equal(codec->name, "Cipher"))
+        {
+            ((boxing_codec_cipher *)codec)->key = cipher_key;
+        }
+    }
+
+    gvector * data = gvector_create_char(size, 0);
+    boxing_memory_copy(data->buffer, (*source)->buffer, size);
+    if (!boxing_codecdispatcher_encode(data_codec, data))
+    {
+        fprintf(stderr, "Failed to encode the frame data.\n");
+        goto cleanup;
+    }
+
+    BOXING_VIRTUAL2p2(frame, container, set_data, (char *)data->buffer, (int)data->size);
+
+    if (!set_frame_metadata(frame, metadata_codec, metadata))
+    {
+        fprintf(stderr, "Failed to encode the frame metadata.\n");
+        goto cleanup;
+    }
+
+    boxing_pointi frame_size = frame->size(frame);
+    image = boxing_image8_create(frame_size.x, frame_size.y);
+    boxing_paintdevice * device = boxing_image8paintdevice_create(image);
+    boxing_painter painter;
+    boxing_painter_init(&painter, device);
+    frame->render(frame, &painter);
+    device->free(device);
+
+    // The frame is painted with symbol levels, map them to gray levels
+    const size_t pixel_count = (size_t)image->width * image->height;
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        image->data[i] = (boxing_image8_pixel)(image->data[i] * 255 / (levels - 1));
+    }
+
+cleanup:
+    gvector_free(data);
+    boxing_metadata_list_free(metadata);
+    boxing_codecdispatcher_free(metadata_codec);
+    boxing_codecdispatcher_free(data_codec);
+    boxing_generic_frame_factory_free(frame);
+    if (image == NULL)
+    {
+        gvector_free(*source);
+        *source = NULL;
+    }
+    return image;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Blur the image with a separable gaussian kernel.
+ *
+ *  \param image  Image to blur.
+ *  \param sigma  Standard deviation of the kernel in pixels.
+ */
+
+static void blur_image(boxing_image8 * image, double sigma)
+{
+    const int radius = (int)ceil(sigma * 3.0);
+    const int width = (int)image->width;
+    const int height = (int)image->height;
+    const int taps = 2 * radius + 1;
+
+    float * kernel = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(float, taps);
+    double kernel_sum = 0.0;
+    for (int i = -radius; i <= radius; i++)
+    {
+        kernel[i + radius] = (float)exp(-(double)(i * i) / (2.0 * sigma * sigma));
+        kernel_sum += kernel[i + radius];
+    }
+    for (int i = 0; i < taps; i++)
+    {
+        kernel[i] = (float)(kernel[i] / kernel_sum);
+    }
+
+    // Horizontal pass, one row at a time
+    unsigned char * row = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(unsigned char, width);
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char * line = image->data + (size_t)y * width;
+        boxing_memory_copy(row, line, width);
+        for (int x = 0; x < width; x++)
+        {
+            float sum = 0.0f;
+            for (int k = -radius; k <= radius; k++)
+            {
+                const int sx = BOXING_MATH_CLAMP(0, width - 1, x + k);
+                sum += kernel[k + radius] * row[sx];
+            }
+            line[x] = (unsigned char)(sum + 0.5f);
+        }
+    }
+    boxing_memory_free(row);
+
+    // Vertical pass, accumulating whole rows to stay cache friendly
+    boxing_image8 * source = boxing_image8_copy(image);
+    float * sums = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(float, width);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            sums[x] = 0.0f;
+        }
+        for (int k = -radius; k <= radius; k++)
+        {
+            const int sy = BOXING_MATH_CLAMP(0, height - 1, y + k);
+            const unsigned char * line = source->data + (size_t)sy * width;
+            const float weight = kernel[k + radius];
+            for (int x = 0; x < width; x++)
+            {
+                sums[x] += weight * line[x];
+            }
+        }
+        unsigned char * line = image->data + (size_t)y * width;
+        for (int x = 0; x < width; x++)
+        {
+            line[x] = (unsigned char)(sums[x] + 0.5f);
+        }
+    }
+    boxing_memory_free(sums);
+    boxing_image8_free(source);
+    boxing_memory_free(kernel);
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Simulate a film scan of a rendered frame. The frame is rotated about its
+ *  center, scaled with bilinear interpolation and placed in the middle of the
+ *  scan, then blurred, shaded with a linear gain drift and given gaussian
+ *  noise.
+ *
+ *  \param frame         Rendered frame.
+ *  \param parameters    Scan simulation parameters.
+ *  \param frame_number  Frame number, used as the noise seed.
+ *  \return Simulated scan.
+ */
+
+static boxing_image8 * simulate_scan(const boxing_image8 * frame, const command_line_parameters * parameters, unsigned int frame_number)
+{
+    // Default to the scaled frame with a margin, similar to the film scanner output
+    const size_t width = parameters->x_size ? parameters->x_size : (size_t)ceil(frame->width * parameters->scale * 1.04);
+    const size_t height = parameters->y_size ? parameters->y_size : (size_t)ceil(frame->height * parameters->scale * 1.06);
+    boxing_image8 * scan = boxing_image8_create((unsigned int)width, (unsigned int)height);
+
+    const double angle = parameters->rotation * BENCHMARK_PI / 180.0;
+    const double cos_angle = cos(angle) / parameters->scale;
+    const double sin_angle = sin(angle) / parameters->scale;
+    const double scan_center_x = width / 2.0;
+    const double scan_center_y = height / 2.0;
+    const double frame_center_x = frame->width / 2.0 - 0.5;
+    const double frame_center_y = frame->height / 2.0 - 0.5;
+    const int frame_width = (int)frame->width;
+    const int frame_height = (int)frame->height;
+
+    for (size_t y = 0; y < height; y++)
+    {
+        unsigned char * line = scan->data + y * width;
+        const double dy = y + 0.5 - scan_center_y;
+        for (size_t x = 0; x < width; x++)
+        {
+            // Inverse mapping from the scan to the frame
+            const double dx = x + 0.5 - scan_center_x;
+            const double fx = cos_angle * dx + sin_angle * dy + frame_center_x;
+            const double fy = -sin_angle * dx + cos_angle * dy + frame_center_y;
+            const int x0 = (int)floor(fx);
+            const int y0 = (int)floor(fy);
+
+            double value = 0.0;
+            if (x0 >= -1 && y0 >= -1 && x0 < frame_width && y0 < frame_height)
+            {
+                const double ax = fx - x0;
+                const double ay = fy - y0;
+                const int xs[2] = { x0, x0 + 1 };
+                const int ys[2] = { y0, y0 + 1 };
+                const double wx[2] = { 1.0 - ax, ax };
+                const double wy[2] = { 1.0 - ay, ay };
+                for (int j = 0; j < 2; j++)
+                {
+                    if (ys[j] < 0 || ys[j] >= frame_height)
+                    {
+                        continue;
+                    }
+                    for (int i = 0; i < 2; i++)
+                    {
+                        if (xs[i] >= 0 && xs[i] < frame_width)
+                        {
+                            value += wx[i] * wy[j] * frame->data[(size_t)ys[j] * frame_width + xs[i]];
+                        }
+                    }
+                }
+            }
+            line[x] = (unsigned char)(value + 0.5);
+        }
+    }
+
+    if (parameters->blur > 0.0)
+    {
+        blur_image(scan, parameters->blur);
+    }
+
+    if (parameters->gain_drift != 0.0 || parameters->noise > 0.0)
+    {
+        benchmark_random random = { 0x2545f491u ^ (frame_number * 2654435761u) };
+        for (size_t y = 0; y < height; y++)
+        {
+            unsigned char * line = scan->data + y * width;
+            for (size_t x = 0; x < width; x++)
+            {
+                // Gain varies linearly along the diagonal of the scan
+                const double gain = 1.0 + parameters->gain_drift * (((double)x / width + (double)y / height) / 2.0 - 0.5);
+                double value = line[x] * gain;
+                if (parameters->noise > 0.0)
+                {
+                    value += parameters->noise * benchmark_random_gaussian(&random);
+                }
+                line[x] = (unsigned char)BOXING_MATH_CLAMP(0.0, 255.0, value + 0.5);
+            }
+        }
+    }
+
+    return scan;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Stage timing callback, accumulates the statistics of each stage.
+ *
+ *  \param user   Timer state.
+ *  \param stats  Statistics of the completed stage.
+ */
+
+static void on_stage_timing(void * user, const boxing_stats_stage * stats)
+{
+    benchmark_timer * timer = (benchmark_timer *)user;
+
+    benchmark_stage * stage = NULL;
+    for (unsigned int i = 0; i < timer->stage_count; i++)
+    {
+        if (timer->stages[i].step == stats->step &&
+            boxing_string_equal(timer->stages[i].name, stats->name) &&
+            boxing_string_equal(timer->stages[i].coding_scheme, stats->coding_scheme))
+        {
+            stage = &timer->stages[i];
+            break;
+        }
+    }
+
+    if (stage == NULL)
+    {
+        if (timer->stage_count == BENCHMARK_MAX_STAGES)
+        {
+            return;
+        }
+        stage = &timer->stages[timer->stage_count++];
+        stage->name = stats->name;
+        stage->coding_scheme = stats->coding_scheme;
+        stage->step = stats->step;
+        stage->total_ms = 0.0;
+        stage->min_ms = stats->time;
+        stage->max_ms = stats->time;
+        stage->peak_allocation = 0;
+        stage->count = 0;
+    }
+
+    stage->total_ms += stats->time;
+    stage->min_ms = BOXING_MATH_MIN(stage->min_ms, stats->time);
+    stage->max_ms = BOXING_MATH_MAX(stage->max_ms, stats->time);
+    stage->peak_allocation = BOXING_MATH_MAX(stage->peak_allocation, stats->peak_allocation);
+    stage->count++;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Content quantized callback, marks the end of the extraction phase.
+ *
+ *  \param user  Timer state.
+ *  \param res   Unboxing result.
+ *  \param data  Quantized data.
+ *  \param size  Size of the quantized data.
+ */
+
+static int on_content_quantized(void * user, int * res, char * data, int size)
+{
+    BOXING_UNUSED_PARAMETER(res);
+    BOXING_UNUSED_PARAMETER(data);
+    BOXING_UNUSED_PARAMETER(size);
+    ((benchmark_timer *)user)->extract_end = boxing_clock_milliseconds();
+    return BOXING_PROCESS_CALLBACK_OK;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Unboxing complete callback, keeps the decoding statistics.
+ *
+ *  \param user   Timer state.
+ *  \param res    Unboxing result.
+ *  \param stats  Unboxing statistics.
+ */
+
+static int on_all_complete(void * user, int * res, boxing_stats_decode * stats)
+{
+    BOXING_UNUSED_PARAMETER(res);
+    ((benchmark_timer *)user)->stats = *stats;
+    return BOXING_PROCESS_CALLBACK_OK;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Compare decoded data with the source data.
+ *
+ *  \param data    Decoded data.
+ *  \param source  Source data.
+ *  \return DTRUE if the data is identical.
+ */
+
+static DBOOL data_equal(const gvector * data, const gvector * source)
+{
+    if (data->size != source->size)
+    {
+        return DFALSE;
+    }
+
+    for (size_t i = 0; i < data->size; i++)
+    {
+        if (((const char *)data->buffer)[i] != ((const char *)source->buffer)[i])
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Print the accumulated stage timings.
+ *
+ *  \param timer  Timer state.
+ */
+
+static void print_stages(const benchmark_timer * timer)
+{
+    printf("\n%-40s %6s %10s %10s %10s %12s\n", "Stage", "Count", "Mean ms", "Min ms", "Max ms", "Peak KiB");
+    for (unsigned int i = 0; i < timer->stage_count; i++)
+    {
+        const benchmark_stage * stage = &timer->stages[i];
+        char name[64];
+        if (stage->step < 0)
+        {
+            snprintf(name, sizeof(name), "%s", stage->name);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%s %2d %s", stage->coding_scheme, stage->step, stage->name);
+        }
+        printf("%-40s %6u %10.2f %10.2f %10.2f %12.0f\n", name, stage->count, stage->total_ms / stage->count,
+            stage->min_ms, stage->max_ms, stage->peak_allocation / 1024.0);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Parse a floating point option value.
+ *
+ *  \param[in]  argc       Number parameters in the input command line.
+ *  \param[in]  argv       Array parameters in the input command line.
+ *  \param[in,out] index   Index of the option, moved past the value.
+ *  \param[out] value      Parsed value.
+ *  \return DTRUE if a value was present.
+ */
+
+static DBOOL get_double_value(int argc, char *argv[], int * index, double * value)
+{
+    if (*index + 1 >= argc)
+    {
+        return DFALSE;
+    }
+    *value = atof(argv[++(*index)]);
+    (*index)++;
+    return DTRUE;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Read benchmark parameters from input command line. If return_parameters.valid is DFALSE the usage has been printed,
+ *  either because help was asked for or because the command line is invalid.
+ *
+ *  \param[in] argc   Number parameters in the input command line.
+ *  \param[in] argv   Array parameters in the input command line.
+ *  \return benchmark parameters from input command line.
+ */
+
+static command_line_parameters get_parameters(int argc, char *argv[])
+{
+    command_line_parameters parameters;
+
+    parameters.format = "4kv10";
+    parameters.frame_count = 5;
+    parameters.stripe_size = 1;
+    parameters.thread_count = 1;
+    parameters.x_size = 0;
+    parameters.y_size = 0;
+    parameters.scale = 3.0;
+    parameters.blur = 0.8;
+    parameters.noise = 3.0;
+    parameters.rotation = 0.1;
+    parameters.gain_drift = 0.1;
+    parameters.is_raw = DFALSE;
+    parameters.is_fused = DFALSE;
+    parameters.help = DFALSE;
+    parameters.valid = DTRUE;
+
+    int arg_index = 1;
+    while (arg_index < argc && parameters.valid)
+    {
+        const char * option = argv[arg_index];
+        double value = 0.0;
+
+        if (boxing_string_equal(option, "-f") == DTRUE && arg_index + 1 < argc)
+        {
+            parameters.format = argv[++arg_index];
+            arg_index++;
+        }
+        else if (boxing_string_equal(option, "-s") == DTRUE && arg_index + 2 < argc)
+        {
+            parameters.x_size = atoi(argv[++arg_index]);
+            parameters.y_size = atoi(argv[++arg_index]);
+            arg_index++;
+        }
+        else if (boxing_string_equal(option, "-n") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.frame_count = (unsigned int)value;
+        }
+        else if (boxing_string_equal(option, "-stripe") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.stripe_size = (unsigned int)value;
+        }
+        else if (boxing_string_equal(option, "-t") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.thread_count = (int)value;
+        }
+        else if (boxing_string_equal(option, "-scale") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.scale = value;
+        }
+        else if (boxing_string_equal(option, "-blur") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.blur = value;
+        }
+        else if (boxing_string_equal(option, "-noise") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.noise = value;
+        }
+        else if (boxing_string_equal(option, "-rotation") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.rotation = value;
+        }
+        else if (boxing_string_equal(option, "-gain") == DTRUE && get_double_value(argc, argv, &arg_index, &value))
+        {
+            parameters.gain_drift = value;
+        }
+        else if (boxing_string_equal(option, "-is_raw") == DTRUE)
+        {
+            parameters.is_raw = DTRUE;
+            arg_index++;
+        }
+        else if (boxing_string_equal(option, "-fused") == DTRUE)
+        {
+            parameters.is_fused = DTRUE;
+            arg_index++;
+        }
+        else if (boxing_string_equal(option, "-h") == DTRUE || boxing_string_equal(option, "--help") == DTRUE)
+        {
+            parameters.help = DTRUE;
+            parameters.valid = DFALSE;
+        }
+        else
+        {
+            fprintf(stderr, "Unsupported input parameter in the command line!!! (%s)\n", option);
+            parameters.valid = DFALSE;
+        }
+    }
+
+    if (parameters.frame_count == 0 || parameters.stripe_size == 0 || parameters.scale <= 0.0)
+    {
+        parameters.valid = DFALSE;
+    }
+
+    if (parameters.valid == DFALSE)
+    {
+        printf(
+            "Unboxer benchmark application - renders synthetic frames, simulates a scan and times the unboxer.\n"
+            "\n"
+            "app [-f <format>] [-n <frames>] [-stripe <frames>] [-t <threads>] [-s <width> <height>]\n"
+            "    [-scale <factor>] [-blur <sigma>] [-noise <sigma>] [-rotation <degrees>] [-gain <drift>] [-is_raw]\n"
+            "    [-fused] [-h]\n"
+            "\n"
+            "Where:\n"
+            "   -f <boxing-format>  : Boxing format, default 4kv10.\n"
+            "   -n <frames>         : Number of frames to render and unbox, default 5.\n"
+            "   -stripe <frames>    : Data stripe size of the format, default 1 so every frame decodes on its own.\n"
+            "   -t <threads>        : Worker threads used by the unboxer image processing, default 1.\n"
+            "   -s <width> <height> : Scan dimension in pixels, default is the scaled frame with a small margin.\n"
+            "   -scale <factor>     : Scan pixels per frame pixel, default 3.0.\n"
+            "   -blur <sigma>       : Gaussian blur in scan pixels, default 0.8.\n"
+            "   -noise <sigma>      : Gaussian noise in gray levels, default 3.0.\n"
+            "   -rotation <degrees> : Rotation of the frame in the scan, default 0.1.\n"
+            "   -gain <drift>       : Relative gain change across the scan, default 0.1.\n"
+            "   -is_raw             : Unbox the rendered frames directly, without scan simulation.\n"
+            "   -fused              : Sample and quantize the content in one pass.\n"
+            "   -h, --help          : Print this help.\n"
+            );
+    }
+
+    return parameters;
+}
+
+
+//----------------------------------------------------------------------------
+/*! \ingroup unboxtests
+ *
+ *  Unboxing benchmark application.
+ *
+ */
+
+int main(int argc, char *argv[])
+{
+    command_line_parameters parameters = get_parameters(argc, argv);
+    if (parameters.valid == DFALSE)
+    {
+        return parameters.help ? 0 : 1;
+    }
+
+    boxing_config * config = boxing_get_boxing_config(parameters.format);
+    if (config == NULL)
+    {
+        fprintf(stderr, "Unsupported boxing format: '%s'\n", parameters.format);
+        return 1;
+    }
+    boxing_config_set_property_uint(config, "MultiFrameFormat", "DataStripeSize", parameters.stripe_size);
+
+    // Render and scan all frames up front, only unboxing is timed
+    boxing_image8 ** images = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_image8 *, parameters.frame_count);
+    gvector ** sources = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(gvector *, parameters.frame_count);
+    const double generate_start = boxing_clock_milliseconds();
+    for (unsigned int i = 0; i < parameters.frame_count; i++)
+    {
+        boxing_image8 * frame = render_frame(config, i, &sources[i]);
+        if (frame == NULL)
+        {
+            fprintf(stderr, "Failed to render frame %u.\n", i);
+            return 1;
+        }
+
+        if (parameters.is_raw)
+        {
+            images[i] = frame;
+        }
+        else
+        {
+            images[i] = simulate_scan(frame, &parameters, i);
+            boxing_image8_free(frame);
+        }
+    }
+    printf("Generated %u %s frames of %ux%u pixels in %.0f ms\n", parameters.frame_count, parameters.format,
+        images[0]->width, images[0]->height, boxing_clock_milliseconds() - generate_start);
+
+    benchmark_timer timer;
+    timer.stage_count = 0;
+
+    boxing_unboxer_parameters unboxer_parameters;
+    boxing_unboxer_parameters_init(&unboxer_parameters);
+    unboxer_parameters.format = config;
+    unboxer_parameters.is_raw = parameters.is_raw;
+    unboxer_parameters.thread_count = parameters.thread_count;
+    if (parameters.is_fused)
+    {
+        unboxer_parameters.sample_quantize_contents = boxing_unboxer_sample_quantize;
+    }
+    unboxer_parameters.on_stage_timing = on_stage_timing;
+    unboxer_parameters.on_content_quantized = on_content_quantized;
+    unboxer_parameters.on_all_complete = on_all_complete;
+
+    boxing_unboxer * unboxer = boxing_unboxer_create(&unboxer_parameters);
+
+    int result = 0;
+    double total_ms = 0.0;
+    double extract_ms = 0.0;
+    for (unsigned int i = 0; i < parameters.frame_count; i++)
+    {
+        // The unboxer sharpens the image in place
+        boxing_image8 * image = boxing_image8_copy(images[i]);
+        gvector * data = gvector_create_char(0, 0);
+        boxing_metadata_list * metadata = boxing_metadata_list_create();
+        int extract_result = BOXING_UNBOXER_OK;
+
+        timer.frame_start = boxing_clock_milliseconds();
+        timer.extract_end = timer.frame_start;
+        const int unbox_result = boxing_unboxer_unbox(data, metadata, image, unboxer, &extract_result, &timer);
+        const double frame_end = boxing_clock_milliseconds();
+
+        total_ms += frame_end - timer.frame_start;
+        extract_ms += timer.extract_end - timer.frame_start;
+
+        const DBOOL match = data_equal(data, sources[i]);
+        printf("Frame %u: %s, %.1f ms, resolved errors %d, unresolved errors %d%s\n", i, result_names[unbox_result],
+            frame_end - timer.frame_start, timer.stats.resolved_errors, timer.stats.unresolved_errors,
+            unbox_result == BOXING_UNBOXER_OK && !match ? ", DATA MISMATCH" : "");
+        if (timer.stats.decoded_codewords)
+        {
+            printf("Frame %u: %u codewords, %.2f decoding iterations per codeword, at most %u\n", i, timer.stats.decoded_codewords,
+                timer.stats.decode_iterations / (double)timer.stats.decoded_codewords, timer.stats.max_decode_iterations);
+        }
+        if (unbox_result != BOXING_UNBOXER_OK || !match)
+        {
+            result = 1;
+        }
+
+        boxing_metadata_list_free(metadata);
+        gvector_free(data);
+        boxing_image8_free(image);
+    }
+
+    print_stages(&timer);
+    printf("\n%-32s %10.2f ms\n", "extract (mean)", extract_ms / parameters.frame_count);
+    printf("%-32s %10.2f ms\n", "decode (mean)", (total_ms - extract_ms) / parameters.frame_count);
+    printf("%-32s %10.2f ms\n", "full unbox (mean)", total_ms / parameters.frame_count);
+    printf("%-32s %10.3f fps\n", "throughput", parameters.frame_count * 1000.0 / total_ms);
+
+    boxing_unboxer_free(unboxer);
+    for (unsigned int i = 0; i < parameters.frame_count; i++)
+    {
+        boxing_image8_free(images[i]);
+        gvector_free(sources[i]);
+    }
+    boxing_memory_free(images);
+    boxing_memory_free(sources);
+    boxing_config_free(config);
+
+    return result;
+}
+
+#if defined (LOGGING_ENABLED)
+void boxing_log( int log_level, const char * string )
+{
+    printf( "%d : %s\n", log_level, string );
+}
+
+void boxing_log_args( int log_level, const char * format, ... )
+{
+    va_list args;
+    va_start(args, format);
+
+    printf( "%d : ", log_level );
+    vprintf( format, args );
+    printf( "\n" );
+
+    va_end(args);
+}
+#else
+void boxing_log(int log_level, const char * string) { BOXING_UNUSED_PARAMETER(log_level); BOXING_UNUSED_PARAMETER(string); }
+void boxing_log_args(int log_level, const char * format, ...) { BOXING_UNUSED_PARAMETER(log_level); BOXING_UNUSED_PARAMETER(format); }
+#endif // LOGGING_ENABLED
+
+void(*boxing_log_custom)(int log_level, const char * string) = NULL;
+void(*boxing_log_args_custom)(int log_level, const char * format, va_list args) = NULL;
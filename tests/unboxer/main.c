@@ -20,7 +20,11 @@
 #include <stdio.h>
 #if defined (D_OS_WIN32)
 #include <io.h>
+#include <windows.h>
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -29,14 +33,12 @@
 //#define LOGGING_ENABLED // Enables log output from the unboxing library
 
 #if defined ( D_OS_WIN32 )
-#define DFSEEK _fseeki64
-#define DFTELL _ftelli64
 #define access _access
-#else
-#define DFSEEK fseeko
-#define DFTELL ftello
 #endif
 
+// Size of the output file buffer
+#define OUTPUT_BUFFER_SIZE (4*1024*1024)
+
 
 typedef struct command_line_parameters_s
 {
@@ -49,6 +51,18 @@ typedef struct command_line_parameters_s
     DBOOL        is_raw;
 } command_line_parameters;
 
+// Read only view of an input file, the pages are mapped copy on write as the
+// unboxer may filter the image in place
+typedef struct mapped_file_s
+{
+    boxing_image8_pixel * data;
+    boxing_int64          size;
+#if defined (D_OS_WIN32)
+    HANDLE                file;
+    HANDLE                mapping;
+#endif
+} mapped_file;
+
 static const char * result_names[] =
 {
     "OK",
@@ -121,30 +135,19 @@ static int unboxing_complete_callback(void * user, int* res, boxing_stats_decode
 //---------------------------------------------------------------------------- 
 /*! \ingroup unboxtests
  *
- *  Write data to file. 
+ *  Write data to the output file. The file is kept open and buffered for
+ *  all frames.
  *
  *  \param output_data       Output data.
+ *  \param out_file          Output file.
  *  \param output_file_name  Output file name.
  *  \return 0 on success, -1 on error
  */
 
-static int save_output_data(gvector* output_data, const char * output_file_name)
+static int save_output_data(gvector* output_data, FILE * out_file, const char * output_file_name)
 {
-    // Save output data to the file
-#ifndef WIN32
-    FILE * out_file = fopen(output_file_name, "a+");
-#else
-    FILE * out_file = fopen(output_file_name, "a+b");
-#endif
-    if (out_file == NULL)
-    {
-        fprintf(stderr, "Failed to create output file: '%s'\n", output_file_name);
-        return -1;
-    }
-
     if (output_data->size != fwrite(output_data->buffer, output_data->item_size, output_data->size, out_file))
     {
-        fclose(out_file);
         fprintf(stderr, "Output file write error.\n");
         return -1;
     }
@@ -152,12 +155,139 @@ static int save_output_data(gvector* output_data, const char * output_file_name)
     {
         printf("Output data saved to: '%s'\n\n", output_file_name);
     }
-    fclose(out_file);
 
     return 0;
 }
 
 
+//---------------------------------------------------------------------------- 
+/*! \ingroup unboxtests
+ *
+ *  Map an input file into memory.
+ *
+ *  \param[out] file       Mapped file.
+ *  \param[in]  file_name  File name.
+ *  \return DTRUE on success.
+ */
+
+static DBOOL mapped_file_open(mapped_file * file, const char * file_name)
+{
+    file->data = NULL;
+    file->size = 0;
+
+#if defined (D_OS_WIN32)
+    file->mapping = NULL;
+    file->file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file->file == INVALID_HANDLE_VALUE)
+    {
+        return DFALSE;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file->file);
+        return DFALSE;
+    }
+    file->size = size.QuadPart;
+
+    file->mapping = CreateFileMappingA(file->file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (file->mapping == NULL)
+    {
+        CloseHandle(file->file);
+        return DFALSE;
+    }
+
+    file->data = (boxing_image8_pixel *)MapViewOfFile(file->mapping, FILE_MAP_COPY, 0, 0, 0);
+    if (file->data == NULL)
+    {
+        CloseHandle(file->mapping);
+        CloseHandle(file->file);
+        return DFALSE;
+    }
+#else
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+    {
+        return DFALSE;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0)
+    {
+        close(fd);
+        return DFALSE;
+    }
+    file->size = status.st_size;
+
+    void * data = mmap(NULL, (size_t)file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return DFALSE;
+    }
+    file->data = (boxing_image8_pixel *)data;
+    madvise(data, (size_t)file->size, MADV_SEQUENTIAL);
+#endif
+
+    return DTRUE;
+}
+
+
+//---------------------------------------------------------------------------- 
+/*! \ingroup unboxtests
+ *
+ *  Unmap an input file.
+ *
+ *  \param[in] file  Mapped file.
+ */
+
+static void mapped_file_close(mapped_file * file)
+{
+#if defined (D_OS_WIN32)
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+#else
+    munmap(file->data, (size_t)file->size);
+#endif
+    file->data = NULL;
+}
+
+
+//---------------------------------------------------------------------------- 
+/*! \ingroup unboxtests
+ *
+ *  Give the system a hint about how a range of the mapped file is used.
+ *
+ *  \param[in] file      Mapped file.
+ *  \param[in] offset    Start of the range.
+ *  \param[in] size      Size of the range.
+ *  \param[in] will_need DTRUE to start reading the range ahead, DFALSE to
+ *                       release the pages of a range that is done.
+ */
+
+static void mapped_file_advise(const mapped_file * file, boxing_int64 offset, boxing_int64 size, DBOOL will_need)
+{
+#if defined (D_OS_WIN32)
+    BOXING_UNUSED_PARAMETER(file);
+    BOXING_UNUSED_PARAMETER(offset);
+    BOXING_UNUSED_PARAMETER(size);
+    BOXING_UNUSED_PARAMETER(will_need);
+#else
+    // madvise needs a page aligned start address
+    const boxing_int64 page_size = sysconf(_SC_PAGESIZE);
+    boxing_int64 begin = offset - offset % page_size;
+    boxing_int64 end = BOXING_MATH_MIN(offset + size, file->size);
+    if (begin < end)
+    {
+        madvise(file->data + begin, (size_t)(end - begin), will_need ? MADV_WILLNEED : MADV_DONTNEED);
+    }
+#endif
+}
+
+
 //---------------------------------------------------------------------------- 
 /*! \ingroup unboxtests
  *
@@ -335,6 +465,7 @@ static command_line_parameters get_parameters(int argc, char *argv[])
             "Where:\n"
             "   -i <input file>     : Name of the binary input file(s) in the following format: \n"
             "                         width * height bytes: 8 bit per pixel grayscale data.\n"
+            "                         A file may hold several frames one after another.\n"
             "   -s <width> <height> : Specify dimension of input file(s) in pixels. All files must have same dimensions.\n"
             "   -f <boxing-format>  : Boxing format. Supported formats: 4kv6, 4kv7, 4kv8, 4kv9 and 4kv10.\n"
             "   -o <output file>    : Write decoded data to file.\n"
@@ -360,78 +491,69 @@ static DBOOL has_wildcard(char* file_name)
 }
 
 
-static int unbox_file(const char* file_name, command_line_parameters input_parameters, boxing_unboxer_utility* utility)
+static int unbox_file(const char* file_name, command_line_parameters input_parameters, boxing_unboxer_utility* utility, FILE * out_file)
 {
     const size_t width = input_parameters.x_size;
     const size_t height = input_parameters.y_size;
+    const boxing_int64 frame_size = (boxing_int64)(width * height);
 
-#ifndef WIN32
-    FILE * file = fopen(file_name, "r");
-#else
-    FILE * file = fopen(file_name, "rb");
-#endif
-    if (file == NULL)
+    mapped_file file;
+    if (!mapped_file_open(&file, file_name))
     {
         fprintf(stderr, "Failed to read file '%s'.\n", file_name);
         return -1;
     }
 
-    // Obtain file size
-    if (DFSEEK(file, 0L, SEEK_END) != 0)
+    // A reel file holds several frames one after another
+    if (file.size % frame_size != 0)
     {
+        printf("File '%s' size (%lld) is not a multiple of the input image dimensions (width=%lu height=%lu).\n", file_name, (long long)file.size, (unsigned long)width, (unsigned long)height);
+        mapped_file_close(&file);
         return -1;
     }
 
-    const boxing_int64 file_size = DFTELL(file);
-    if(file_size < 0)
-    {
-        return -1;
-    }
-
-    // Go to the starting data position
-    if (DFSEEK(file, 0L, SEEK_SET) != 0)
-    {
-        return -1;
-    }
+    const boxing_int64 frame_count = file.size / frame_size;
+    printf("Reading image data file '%s' with %lld frame(s) ...\n", file_name, (long long)frame_count);
 
-    // Files size must match image dimensions
-    if (file_size != (boxing_int64)(width * height))
+    int result = 0;
+    for (boxing_int64 frame = 0; frame < frame_count && result == 0; frame++)
     {
-        printf("File '%s' size (%lld) does not match with input image dimensions (width=%lu height=%lu).\n", file_name, (unsigned long long)file_size, width, height);
-        return -1;
-    }
-
-    printf("Reading image data file '%s' ...\n", file_name);
-
-    boxing_image8* input_image = boxing_image8_create((unsigned int)width, (unsigned int)height);
-    if (1 != fread(input_image->data, width * height, 1, file))
-    {
-        fprintf(stderr, "Failed to read image data.\n");
-        return -1;
-    }
+        const boxing_int64 offset = frame * frame_size;
+        if (frame_count > 1)
+        {
+            printf("Frame %lld at offset %lld\n", (long long)frame, (long long)offset);
+        }
 
-    printf("The image data file read successfully!\nStarting unboxing...\n");
+        // Read the next frame while this one is unboxed
+        mapped_file_advise(&file, offset + frame_size, frame_size, DTRUE);
 
-    fclose(file);
+        // The frame is unboxed straight from the mapped pages
+        boxing_image8 input_image;
+        input_image.width = (unsigned int)width;
+        input_image.height = (unsigned int)height;
+        input_image.is_owning_data = DFALSE;
+        input_image.data = file.data + offset;
 
-    gvector* output_data = gvector_create(1, 0);
-    int process_result = boxing_unboxer_utility_unbox(utility, input_image, output_data);
-    if (process_result == BOXING_UNBOXER_OK)
-    {
-        if (save_output_data(output_data, input_parameters.output) != 0)
+        gvector* output_data = gvector_create(1, 0);
+        int process_result = boxing_unboxer_utility_unbox(utility, &input_image, output_data);
+        if (process_result == BOXING_UNBOXER_OK && out_file != NULL)
         {
-            return -1;
+            if (save_output_data(output_data, out_file, input_parameters.output) != 0)
+            {
+                result = -1;
+            }
         }
-    }
-    gvector_free(output_data);
-    boxing_image8_free(input_image);
+        else if (process_result != BOXING_UNBOXER_OK)
+        {
+            result = -1;
+        }
+        gvector_free(output_data);
 
-    if (process_result != BOXING_UNBOXER_OK)
-    {
-        return -1;
+        mapped_file_advise(&file, offset, frame_size, DFALSE);
     }
 
-    return 0;
+    mapped_file_close(&file);
+    return result;
 }
 
 
@@ -470,6 +592,19 @@ int main(int argc, char *argv[])
     boxing_unboxer_utility* utility = boxing_unboxer_utility_create(parameters.format, parameters.is_raw);
 #endif
 
+    FILE * out_file = NULL;
+    if (parameters.output != NULL)
+    {
+        out_file = fopen(parameters.output, "ab");
+        if (out_file == NULL)
+        {
+            fprintf(stderr, "Failed to create output file: '%s'\n", parameters.output);
+            boxing_unboxer_utility_free(utility);
+            return 1;
+        }
+        setvbuf(out_file, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+    }
+
     int result = 1;
     while (parameters.input_start_index <= parameters.input_end_index)
     {
@@ -478,7 +613,7 @@ int main(int argc, char *argv[])
         if (has_wildcard(file_name) == DFALSE)
         {
             printf("Input file: '%s'\n", file_name);
-            result = unbox_file(file_name, parameters, utility);
+            result = unbox_file(file_name, parameters, utility, out_file);
         }
         else
         {
@@ -506,7 +641,7 @@ int main(int argc, char *argv[])
                     continue;
                 }
 
-                result = unbox_file(current_file_name, parameters, utility);
+                result = unbox_file(current_file_name, parameters, utility, out_file);
                 boxing_string_free(current_file_name);
 
                 if (result != BOXING_UNBOXER_OK)
@@ -519,6 +654,11 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (out_file != NULL && fclose(out_file) != 0)
+    {
+        fprintf(stderr, "Output file write error.\n");
+        result = 1;
+    }
     boxing_unboxer_utility_free(utility);
     
     return result;
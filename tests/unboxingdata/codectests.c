@@ -0,0 +1,1063 @@
+/*****************************************************************************
+**
+**  codec unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/codecs/reedsolomon.h"
+#include "boxing/codecs/ftfinterleaving.h"
+#include "boxing/codecs/cipher.h"
+#include "boxing/codecs/ldpcmatrix.h"
+#include "boxing/codecs/2dpam.h"
+#include "boxing/config.h"
+#include "boxing/utils.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/math/math.h"
+#include "g_variant.h"
+#include "rand.h"
+#include <math.h>
+#include <stdio.h>
+
+#define RS_MESSAGE_SIZE 200
+#define RS_PARITY_SIZE  20
+#define RS_BLOCK_SIZE   (RS_MESSAGE_SIZE + RS_PARITY_SIZE)
+#define RS_BLOCK_COUNT  3
+
+#define FTF_DISTANCE    19
+#define FTF_FRAME_SIZE  701
+#define FTF_FRAMES      50
+
+#define CIPHER_KEY      0x12345678u
+
+#define LDPC_MESSAGE_SIZE 64
+#define LDPC_PARITY_SIZE  64
+#define LDPC_BLOCK_COUNT  8
+
+// An odd number of sync points per row, the symbol pairs then cross the block rows
+#define PAM_IMAGE_WIDTH   253
+#define PAM_IMAGE_HEIGHT  150
+
+
+static boxing_codec * create_reedsolomon(unsigned int message_size, unsigned int parity_size)
+{
+    GHashTable * properties = g_hash_table_new_full(g_str_hash, g_str_equal, boxing_utils_g_hash_table_destroy_item_string, boxing_utils_g_hash_table_destroy_item_g_variant);
+    g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_MESSAGE_SIZE), g_variant_create_uint(message_size));
+    g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_PARITY_SIZE), g_variant_create_uint(parity_size));
+    boxing_codec * codec = boxing_codec_reedsolomon_create(properties, NULL);
+    g_hash_table_destroy(properties);
+    return codec;
+}
+
+
+static boxing_codec * create_ftf_interleaving(unsigned int distance, const char * buffer_directory)
+{
+    GHashTable * properties = g_hash_table_new_full(g_str_hash, g_str_equal, boxing_utils_g_hash_table_destroy_item_string, boxing_utils_g_hash_table_destroy_item_g_variant);
+    g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_CODEC_MULTI_FRAME_STRIPE_SIZE), g_variant_create_uint(distance));
+    if (buffer_directory)
+    {
+        g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_BUFFER_DIRECTORY), g_variant_create_string(buffer_directory));
+    }
+    boxing_codec * codec = boxing_codec_create(codec_ftf_interleaving_name, properties, NULL);
+    g_hash_table_destroy(properties);
+    codec->reset(codec);
+    return codec;
+}
+
+
+static boxing_codec * create_cipher(const char * key)
+{
+    boxing_config * config = boxing_config_create();
+    boxing_config_set_property(config, "FrameFormat", "type", "GPFv1.0");
+    GHashTable * properties = g_hash_table_new_full(g_str_hash, g_str_equal, boxing_utils_g_hash_table_destroy_item_string, boxing_utils_g_hash_table_destroy_item_g_variant);
+    g_hash_table_replace(properties, boxing_string_clone("key"), g_variant_create_string(key));
+    boxing_codec * codec = boxing_codec_cipher_create(properties, config);
+    g_hash_table_destroy(properties);
+    boxing_config_free(config);
+    return codec;
+}
+
+
+static boxing_codec * create_ldpc(const char * decoder, const char * matrix_cache)
+{
+    GHashTable * properties = g_hash_table_new_full(g_str_hash, g_str_equal, boxing_utils_g_hash_table_destroy_item_string, boxing_utils_g_hash_table_destroy_item_g_variant);
+    g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_MESSAGE_SIZE), g_variant_create_uint(LDPC_MESSAGE_SIZE));
+    g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_PARITY_SIZE), g_variant_create_uint(LDPC_PARITY_SIZE));
+    if (decoder)
+    {
+        g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_DECODER), g_variant_create_string(decoder));
+    }
+    if (matrix_cache)
+    {
+        g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_MATRIX_CACHE), g_variant_create_string(matrix_cache));
+    }
+    boxing_codec * codec = boxing_codec_create("LDPC", properties, NULL);
+    g_hash_table_destroy(properties);
+    if (codec)
+    {
+        codec->init_capacity(codec, (LDPC_MESSAGE_SIZE + LDPC_PARITY_SIZE) * 8 * LDPC_BLOCK_COUNT);
+    }
+    return codec;
+}
+
+
+// Standard normal distributed value
+static double gaussian(void)
+{
+    const double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    const double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+
+// Soft values of the encoded bits as the demodulator delivers them, ten times
+// the log likelihood ratio with positive values for one, sent over a channel
+// with gaussian noise
+static gvector * ldpc_channel(const gvector * encoded, double noise)
+{
+    gvector * soft = gvector_create_char(encoded->size, 0);
+    for (unsigned int i = 0; i < encoded->size; i++)
+    {
+        const double received = (GVECTORN8(encoded, i) ? 1.0 : -1.0) + noise * gaussian();
+        const double llr = 20.0 * received / (noise * noise);
+        GVECTORN8(soft, i) = (char)BOXING_MATH_CLAMP(-127.0, 127.0, llr);
+    }
+    return soft;
+}
+
+
+static boxing_codec * create_2dpam(const char * llr)
+{
+    boxing_config * config = boxing_config_create();
+    GHashTable * properties = g_hash_table_new_full(g_str_hash, g_str_equal, boxing_utils_g_hash_table_destroy_item_string, boxing_utils_g_hash_table_destroy_item_g_variant);
+    boxing_pointi image_size = { PAM_IMAGE_WIDTH, PAM_IMAGE_HEIGHT };
+    g_hash_table_replace(properties, boxing_string_clone("ImageSizePixel"), g_variant_create_pointi(image_size));
+    g_hash_table_replace(properties, boxing_string_clone("SyncPointDistancePixel"), g_variant_create_uint(50));
+    g_hash_table_replace(properties, boxing_string_clone("SyncPointRadiusPixel"), g_variant_create_uint(3));
+    g_hash_table_replace(properties, boxing_string_clone("NumBitsPerPixel"), g_variant_create_uint(3));
+    if (llr)
+    {
+        g_hash_table_replace(properties, boxing_string_clone(PARAM_NAME_LLR), g_variant_create_string(llr));
+    }
+    boxing_codec * codec = boxing_codec_create(codec_2dpam_name, properties, config);
+    g_hash_table_destroy(properties);
+    boxing_config_free(config);
+    return codec;
+}
+
+
+// Random message bits, one per byte, modulated into a frame of gray levels 40
+// apart with gaussian noise
+static gvector * pam_frame(boxing_codec * codec, gvector * message, double noise)
+{
+    for (unsigned int i = 0; i < message->size; i++)
+    {
+        GVECTORN8(message, i) = (char)(rand() % 2);
+    }
+
+    gvector * frame = gvector_create_char(0, 0);
+    gvector_append_data(frame, message->size, message->buffer);
+    codec->encode(codec, frame);
+    for (unsigned int i = 0; i < frame->size; i++)
+    {
+        const double level = 30.0 + 40.0 * (unsigned char)GVECTORN8(frame, i) + noise * gaussian();
+        GVECTORN8(frame, i) = (char)(unsigned char)BOXING_MATH_CLAMP(0.0, 255.0, level + 0.5);
+    }
+    return frame;
+}
+
+
+static gvector * clone_data(const gvector * data)
+{
+    gvector * clone = gvector_create_char(0, 0);
+    gvector_append_data(clone, data->size, data->buffer);
+    return clone;
+}
+
+
+// Keystream generated one LFSR step at a time like the original cipher
+static void cipher_reference(gvector * data, uint32_t key)
+{
+    uint32_t lfsr = key;
+    for (unsigned int i = 0; i < data->size; i++)
+    {
+        unsigned char cipher_byte = 0;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            lfsr = (lfsr >> 1) ^ ((~(lfsr & 1u) + 1) & 0xD0000001u);
+            cipher_byte = (unsigned char)((cipher_byte << 1) | (0x1 & (lfsr >> 31)));
+        }
+        GVECTORN8(data, i) ^= (char)cipher_byte;
+    }
+}
+
+
+// Byte n of frame t as interleaved by the former linked list implementation,
+// it is taken from the input frame distance - 1 - n % distance frames earlier
+static char ftf_reference_encoded(gvector ** frames, int t, unsigned int n)
+{
+    int source = t - (FTF_DISTANCE - 1) + (int)(n % FTF_DISTANCE);
+    return source < 0 ? 0 : GVECTORN8(frames[source], n);
+}
+
+
+static gvector * create_message(unsigned int size)
+{
+    gvector * message = gvector_create_char(size, 0);
+    for (unsigned int i = 0; i < size; i++)
+    {
+        GVECTORN8(message, i) = (char)(rand() % 256);
+    }
+    return message;
+}
+
+
+static void corrupt(gvector * data, gvector * erasures, unsigned int position, unsigned char erasure)
+{
+    GVECTORN8(data, position) ^= (char)(1 + rand() % 255);
+    if (erasures)
+    {
+        GVECTORN8(erasures, position) = (char)erasure;
+    }
+}
+
+
+static DBOOL data_equal(const gvector * a, const gvector * b)
+{
+    if (a->size != b->size)
+    {
+        return DFALSE;
+    }
+    for (unsigned int i = 0; i < a->size; i++)
+    {
+        if (GVECTORN8(a, i) != GVECTORN8(b, i))
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+// Tests for file boxing/codecs/reedsolomon.h
+
+//
+//  FUNCTIONS Reed Solomon Tests
+//
+
+// More symbol errors than the parity can correct are corrected when they are marked as erasures
+BOXING_START_TEST(boxing_codec_reedsolomon_erasures_test1)
+{
+    srand(4);
+    boxing_codec * codec = create_reedsolomon(RS_MESSAGE_SIZE, RS_PARITY_SIZE);
+    BOXING_ASSERT(codec != NULL);
+    BOXING_ASSERT(codec->supports_erasures == DTRUE);
+
+    gvector * message = create_message(RS_MESSAGE_SIZE * RS_BLOCK_COUNT);
+    gvector * data = gvector_create_char(0, 0);
+    gvector_append_data(data, message->size, message->buffer);
+    BOXING_ASSERT(codec->encode(codec, data) == DTRUE);
+    BOXING_ASSERT(data->size == RS_BLOCK_SIZE * RS_BLOCK_COUNT);
+
+    gvector * corrupted = gvector_create_char(0, 0);
+    gvector * erasures = gvector_create_char(data->size, 0);
+    gvector_append_data(corrupted, data->size, data->buffer);
+    for (unsigned int i = 0; i < 14; i++)
+    {
+        corrupt(corrupted, erasures, RS_BLOCK_SIZE + i * 15, 200);
+    }
+    // Errors without erasure information still cost two parity symbols
+    corrupt(corrupted, erasures, 2 * RS_BLOCK_SIZE + 3, 0);
+    corrupt(corrupted, erasures, 2 * RS_BLOCK_SIZE + 100, 0);
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        corrupt(corrupted, erasures, 2 * RS_BLOCK_SIZE + 5 + i * 20, 1 + i);
+    }
+
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    BOXING_ASSERT(codec->decode(codec, corrupted, erasures, &stats, NULL) == DTRUE);
+    BOXING_ASSERT(data_equal(corrupted, message) == DTRUE);
+    BOXING_ASSERT(stats.unresolved_errors == 0);
+    BOXING_ASSERT(stats.resolved_errors == 26);
+    BOXING_ASSERT(erasures->size == message->size);
+    for (unsigned int i = 0; i < erasures->size; i++)
+    {
+        BOXING_ASSERT(GVECTORN8(erasures, i) == 0);
+    }
+
+    gvector_free(erasures);
+    gvector_free(corrupted);
+    gvector_free(data);
+    gvector_free(message);
+    codec->free(codec);
+}
+END_TEST
+
+
+// Blocks not corrected are marked as erased in the decoded data
+BOXING_START_TEST(boxing_codec_reedsolomon_erasures_test2)
+{
+    srand(5);
+    boxing_codec * codec = create_reedsolomon(RS_MESSAGE_SIZE, RS_PARITY_SIZE);
+
+    gvector * message = create_message(RS_MESSAGE_SIZE * RS_BLOCK_COUNT);
+    gvector * data = gvector_create_char(0, 0);
+    gvector_append_data(data, message->size, message->buffer);
+    codec->encode(codec, data);
+
+    gvector * erasures = gvector_create_char(data->size, 0);
+    for (unsigned int i = 0; i < 40; i++)
+    {
+        corrupt(data, erasures, RS_BLOCK_SIZE + i * 5, 255);
+    }
+
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    codec->decode(codec, data, erasures, &stats, NULL);
+    BOXING_ASSERT(erasures->size == message->size);
+    for (unsigned int i = 0; i < erasures->size; i++)
+    {
+        BOXING_ASSERT((unsigned char)GVECTORN8(erasures, i) == ((i / RS_MESSAGE_SIZE == 1) ? 0xff : 0));
+    }
+    for (unsigned int i = 0; i < RS_MESSAGE_SIZE; i++)
+    {
+        BOXING_ASSERT(GVECTORN8(data, i) == GVECTORN8(message, i));
+        BOXING_ASSERT(GVECTORN8(data, i + 2 * RS_MESSAGE_SIZE) == GVECTORN8(message, i + 2 * RS_MESSAGE_SIZE));
+    }
+
+    gvector_free(erasures);
+    gvector_free(data);
+    gvector_free(message);
+    codec->free(codec);
+}
+END_TEST
+
+
+// Decoding without erasures is unchanged
+BOXING_START_TEST(boxing_codec_reedsolomon_erasures_test3)
+{
+    srand(6);
+    boxing_codec * codec = create_reedsolomon(RS_MESSAGE_SIZE, RS_PARITY_SIZE);
+
+    gvector * message = create_message(RS_MESSAGE_SIZE * RS_BLOCK_COUNT);
+    gvector * data = gvector_create_char(0, 0);
+    gvector_append_data(data, message->size, message->buffer);
+    codec->encode(codec, data);
+
+    for (unsigned int i = 0; i < RS_PARITY_SIZE / 2; i++)
+    {
+        corrupt(data, NULL, i * 21, 0);
+    }
+
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    BOXING_ASSERT(codec->decode(codec, data, NULL, &stats, NULL) == DTRUE);
+    BOXING_ASSERT(data_equal(data, message) == DTRUE);
+    BOXING_ASSERT(stats.resolved_errors == RS_PARITY_SIZE / 2);
+
+    gvector_free(data);
+    gvector_free(message);
+    codec->free(codec);
+}
+END_TEST
+
+
+// The SIMD syndrome kernels give the same result as the scalar kernel, also for a last partial group of codewords
+BOXING_START_TEST(boxing_codec_reedsolomon_syndrome_kernels_test)
+{
+    const unsigned int masks[3] = { ~0u, BOXING_CPU_FEATURE_SSE2 | BOXING_CPU_FEATURE_SSSE3, 0 };
+    const unsigned int block_count = 37;
+    gvector * decoded[3];
+    boxing_stats_decode stats[3];
+
+    for (int m = 0; m < 3; m++)
+    {
+        boxing_cpu_set_feature_mask(masks[m]);
+        boxing_codec * codec = create_reedsolomon(231, 24);
+        boxing_cpu_set_feature_mask(~0u);
+
+        srand(7);
+        decoded[m] = create_message(231 * block_count);
+        codec->encode(codec, decoded[m]);
+        for (unsigned int block = 0; block < block_count; block += 3)
+        {
+            for (unsigned int i = 0; i < block % 16; i++)
+            {
+                corrupt(decoded[m], NULL, block * 255 + (unsigned int)rand() % 255, 0);
+            }
+        }
+
+        stats[m].resolved_errors = 0;
+        stats[m].unresolved_errors = 0;
+        codec->decode(codec, decoded[m], NULL, &stats[m], NULL);
+        codec->free(codec);
+    }
+
+    BOXING_ASSERT(stats[0].resolved_errors > 0);
+    for (int m = 1; m < 3; m++)
+    {
+        BOXING_ASSERT(data_equal(decoded[m], decoded[0]) == DTRUE);
+        BOXING_ASSERT(stats[m].resolved_errors == stats[0].resolved_errors);
+        BOXING_ASSERT(stats[m].unresolved_errors == stats[0].unresolved_errors);
+    }
+
+    for (int m = 0; m < 3; m++)
+    {
+        gvector_free(decoded[m]);
+    }
+}
+END_TEST
+
+
+static void ftf_round_trip(const char * buffer_directory)
+{
+    srand(8);
+    gvector * frames[FTF_FRAMES];
+    for (int t = 0; t < FTF_FRAMES; t++)
+    {
+        frames[t] = create_message(FTF_FRAME_SIZE);
+    }
+
+    boxing_codec * encoder = create_ftf_interleaving(FTF_DISTANCE, buffer_directory);
+    boxing_codec * decoder = create_ftf_interleaving(FTF_DISTANCE, buffer_directory);
+    BOXING_ASSERT(encoder != NULL && decoder != NULL);
+
+    for (int t = 0; t < FTF_FRAMES; t++)
+    {
+        gvector * data = gvector_create_char(0, 0);
+        gvector_append_data(data, frames[t]->size, frames[t]->buffer);
+        BOXING_ASSERT(encoder->encode(encoder, data) == DTRUE);
+        BOXING_ASSERT(data->size == FTF_FRAME_SIZE);
+        for (unsigned int n = 0; n < FTF_FRAME_SIZE; n++)
+        {
+            BOXING_ASSERT(GVECTORN8(data, n) == ftf_reference_encoded(frames, t, n));
+        }
+
+        // The erasures follow the data
+        gvector * erasures = gvector_create_char(0, 0);
+        gvector_append_data(erasures, data->size, data->buffer);
+
+        boxing_stats_decode stats;
+        BOXING_ASSERT(decoder->decode(decoder, data, erasures, &stats, NULL) == DTRUE);
+        if (t < FTF_DISTANCE - 1)
+        {
+            BOXING_ASSERT(data->size == 0);
+            BOXING_ASSERT(erasures->size == 0);
+        }
+        else
+        {
+            BOXING_ASSERT(data_equal(data, frames[t - (FTF_DISTANCE - 1)]) == DTRUE);
+            BOXING_ASSERT(data_equal(erasures, frames[t - (FTF_DISTANCE - 1)]) == DTRUE);
+        }
+
+        gvector_free(erasures);
+        gvector_free(data);
+    }
+
+    encoder->free(encoder);
+    decoder->free(decoder);
+    for (int t = 0; t < FTF_FRAMES; t++)
+    {
+        gvector_free(frames[t]);
+    }
+}
+
+
+// Tests for file boxing/codecs/ftfinterleaving.h
+
+//
+//  FUNCTIONS FTF Interleaving Tests
+//
+
+// Interleaved frames match the former implementation and are restored by the decoder
+BOXING_START_TEST(boxing_codec_ftf_interleaving_round_trip_test)
+{
+    ftf_round_trip(NULL);
+}
+END_TEST
+
+
+// The same with the interleaving window kept in a file
+BOXING_START_TEST(boxing_codec_ftf_interleaving_file_buffer_test)
+{
+    ftf_round_trip(".");
+}
+END_TEST
+
+
+// The same without SIMD instructions
+BOXING_START_TEST(boxing_codec_ftf_interleaving_scalar_test)
+{
+    boxing_cpu_set_feature_mask(0);
+    ftf_round_trip(NULL);
+    boxing_cpu_set_feature_mask(~0u);
+}
+END_TEST
+
+
+// Tests for file boxing/codecs/cipher.h
+
+//
+//  FUNCTIONS Cipher Tests
+//
+
+// The table driven keystream matches the bit serial LFSR, also when the
+// cached keystream is reused for shorter data and regenerated for longer data
+BOXING_START_TEST(boxing_codec_cipher_keystream_test)
+{
+    srand(5);
+    boxing_codec * codec = create_cipher("0x12345678");
+    BOXING_ASSERT(codec != NULL);
+    BOXING_ASSERT(((boxing_codec_cipher *)codec)->key == CIPHER_KEY);
+
+    const unsigned int sizes[] = { 1000, 7, 1, 8, 1003, 4099, 64 };
+    for (unsigned int n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++)
+    {
+        gvector * message = create_message(sizes[n]);
+        gvector * expected = gvector_create_char(sizes[n], 0);
+        for (unsigned int i = 0; i < sizes[n]; i++)
+        {
+            GVECTORN8(expected, i) = GVECTORN8(message, i);
+        }
+        cipher_reference(expected, CIPHER_KEY);
+
+        boxing_stats_decode stats;
+        BOXING_ASSERT(codec->decode(codec, message, NULL, &stats, NULL) == DTRUE);
+        BOXING_ASSERT(data_equal(message, expected) == DTRUE);
+
+        gvector_free(expected);
+        gvector_free(message);
+    }
+
+    boxing_codec_cipher_free(codec);
+}
+END_TEST
+
+
+// Encoding with an automatic key and decoding with the selected key restores the data
+BOXING_START_TEST(boxing_codec_cipher_round_trip_test)
+{
+    srand(6);
+    boxing_codec * codec = create_cipher("auto");
+    BOXING_ASSERT(codec != NULL);
+
+    gvector * message = create_message(2053);
+    gvector * data = gvector_create_char(message->size, 0);
+    for (unsigned int i = 0; i < message->size; i++)
+    {
+        GVECTORN8(data, i) = GVECTORN8(message, i);
+    }
+
+    BOXING_ASSERT(codec->encode(codec, data) == DTRUE);
+    BOXING_ASSERT(data_equal(message, data) == DFALSE);
+
+    boxing_stats_decode stats;
+    BOXING_ASSERT(codec->decode(codec, data, NULL, &stats, NULL) == DTRUE);
+    BOXING_ASSERT(data_equal(message, data) == DTRUE);
+
+    gvector_free(data);
+    gvector_free(message);
+    boxing_codec_cipher_free(codec);
+}
+END_TEST
+
+
+// Tests for file boxing/codecs/ldpccodec.h
+
+//
+//  FUNCTIONS LDPC Tests
+//
+
+// Tables of real random numbers for the LDPC matrix construction, filled from a fixed pseudo random sequence
+static void fill_ldpc_tables(unsigned int * tables, uint32_t seed)
+{
+    for (int i = 0; i < N_tables * Table_size; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        tables[i] = seed;
+    }
+}
+
+
+// Fixed random tables for the LDPC codec tests, so they do not depend on the random file the library is built with
+static void use_ldpc_test_tables(void)
+{
+    static unsigned int tables[N_tables * Table_size];
+    fill_ldpc_tables(tables, 2718);
+    rand_use_tables(tables);
+}
+
+
+// Min-sum corrects the same noisy codewords as the probability propagation reference
+BOXING_START_TEST(boxing_codec_ldpc_min_sum_test)
+{
+    srand(9);
+    use_ldpc_test_tables();
+    boxing_codec * reference = create_ldpc(PARAM_NAME_DECODER_PROBABILITY_PROPAGATION, NULL);
+    boxing_codec * codec = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, NULL);
+    BOXING_ASSERT(reference != NULL && codec != NULL);
+    BOXING_ASSERT(create_ldpc("unknown", NULL) == NULL);
+
+    gvector * message = create_message(LDPC_MESSAGE_SIZE * LDPC_BLOCK_COUNT);
+    gvector * encoded = clone_data(message);
+    BOXING_ASSERT(reference->encode(reference, encoded) == DTRUE);
+    BOXING_ASSERT(encoded->size == (LDPC_MESSAGE_SIZE + LDPC_PARITY_SIZE) * 8 * LDPC_BLOCK_COUNT);
+
+    gvector * soft = ldpc_channel(encoded, 0.7);
+    gvector * expected = clone_data(soft);
+    gvector * data = clone_data(soft);
+
+    boxing_stats_decode expected_stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    BOXING_ASSERT(reference->decode(reference, expected, NULL, &expected_stats, NULL) == DTRUE);
+    BOXING_ASSERT(codec->decode(codec, data, NULL, &stats, NULL) == DTRUE);
+
+    BOXING_ASSERT(data_equal(expected, message) == DTRUE);
+    BOXING_ASSERT(data_equal(data, message) == DTRUE);
+    BOXING_ASSERT(expected_stats.unresolved_errors == 0);
+    BOXING_ASSERT(stats.unresolved_errors == 0);
+    BOXING_ASSERT(stats.resolved_errors > 0);
+    BOXING_ASSERT(stats.resolved_errors == expected_stats.resolved_errors);
+    BOXING_ASSERT(stats.decoded_codewords == LDPC_BLOCK_COUNT);
+    BOXING_ASSERT(stats.max_decode_iterations <= 25);
+
+    gvector_free(data);
+    gvector_free(expected);
+    gvector_free(soft);
+    gvector_free(encoded);
+    gvector_free(message);
+    codec->free(codec);
+    reference->free(reference);
+    rand_use_tables(NULL);
+}
+END_TEST
+
+
+// The SIMD check node updates give exactly the same result as the portable
+// code, also for codewords that can not be corrected
+BOXING_START_TEST(boxing_codec_ldpc_min_sum_kernels_test)
+{
+    srand(10);
+    use_ldpc_test_tables();
+    boxing_codec * codec = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, NULL);
+    BOXING_ASSERT(codec != NULL);
+
+    gvector * message = create_message(LDPC_MESSAGE_SIZE * LDPC_BLOCK_COUNT);
+    gvector * encoded = clone_data(message);
+    BOXING_ASSERT(codec->encode(codec, encoded) == DTRUE);
+
+    gvector * expected = ldpc_channel(encoded, 0.95);
+    gvector * data = clone_data(expected);
+
+    boxing_stats_decode expected_stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    boxing_cpu_set_feature_mask(0);
+    BOXING_ASSERT(codec->decode(codec, expected, NULL, &expected_stats, NULL) == DTRUE);
+    boxing_cpu_set_feature_mask(~0u);
+    BOXING_ASSERT(codec->decode(codec, data, NULL, &stats, NULL) == DTRUE);
+
+    BOXING_ASSERT(data_equal(data, expected) == DTRUE);
+    BOXING_ASSERT(stats.resolved_errors == expected_stats.resolved_errors);
+    BOXING_ASSERT(stats.unresolved_errors == expected_stats.unresolved_errors);
+    BOXING_ASSERT(stats.unresolved_errors > 0);
+
+    gvector_free(data);
+    gvector_free(expected);
+    gvector_free(encoded);
+    gvector_free(message);
+    codec->free(codec);
+    rand_use_tables(NULL);
+}
+END_TEST
+
+
+// The layered schedule corrects the same codewords in fewer iterations than flooding
+BOXING_START_TEST(boxing_codec_ldpc_layered_min_sum_test)
+{
+    srand(11);
+    use_ldpc_test_tables();
+    boxing_codec * flooding = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, NULL);
+    boxing_codec * codec = create_ldpc(PARAM_NAME_DECODER_LAYERED_MIN_SUM, NULL);
+    BOXING_ASSERT(flooding != NULL && codec != NULL);
+
+    gvector * message = create_message(LDPC_MESSAGE_SIZE * LDPC_BLOCK_COUNT);
+    gvector * encoded = clone_data(message);
+    BOXING_ASSERT(codec->encode(codec, encoded) == DTRUE);
+
+    gvector * expected = ldpc_channel(encoded, 0.7);
+    gvector * data = clone_data(expected);
+
+    boxing_stats_decode expected_stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    BOXING_ASSERT(flooding->decode(flooding, expected, NULL, &expected_stats, NULL) == DTRUE);
+    BOXING_ASSERT(codec->decode(codec, data, NULL, &stats, NULL) == DTRUE);
+
+    BOXING_ASSERT(data_equal(expected, message) == DTRUE);
+    BOXING_ASSERT(data_equal(data, message) == DTRUE);
+    BOXING_ASSERT(stats.unresolved_errors == 0);
+    BOXING_ASSERT(stats.resolved_errors == expected_stats.resolved_errors);
+    BOXING_ASSERT(stats.decoded_codewords == LDPC_BLOCK_COUNT);
+    BOXING_ASSERT(stats.decode_iterations < expected_stats.decode_iterations);
+
+    gvector_free(data);
+    gvector_free(expected);
+    gvector_free(encoded);
+    gvector_free(message);
+    codec->free(codec);
+    flooding->free(flooding);
+    rand_use_tables(NULL);
+}
+END_TEST
+
+
+// Decoding the codewords on several threads gives the same result as one thread
+BOXING_START_TEST(boxing_codec_ldpc_threads_test)
+{
+    srand(12);
+    use_ldpc_test_tables();
+    const char * decoders[] = { PARAM_NAME_DECODER_PROBABILITY_PROPAGATION, PARAM_NAME_DECODER_MIN_SUM, PARAM_NAME_DECODER_LAYERED_MIN_SUM };
+    for (int d = 0; d < 3; d++)
+    {
+        boxing_codec * codec = create_ldpc(decoders[d], NULL);
+        BOXING_ASSERT(codec != NULL);
+
+        gvector * message = create_message(LDPC_MESSAGE_SIZE * LDPC_BLOCK_COUNT);
+        gvector * encoded = clone_data(message);
+        BOXING_ASSERT(codec->encode(codec, encoded) == DTRUE);
+
+        gvector * expected = ldpc_channel(encoded, 0.9);
+        gvector * data = clone_data(expected);
+
+        boxing_stats_decode expected_stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+        boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+        BOXING_ASSERT(codec->decode(codec, expected, NULL, &expected_stats, NULL) == DTRUE);
+        g_variant * thread_count = g_variant_create_int(3);
+        codec->set_property(codec, PARAM_NAME_THREAD_COUNT, thread_count);
+        g_variant_free(thread_count);
+        BOXING_ASSERT(codec->decode(codec, data, NULL, &stats, NULL) == DTRUE);
+
+        BOXING_ASSERT(data_equal(data, expected) == DTRUE);
+        BOXING_ASSERT(stats.resolved_errors == expected_stats.resolved_errors);
+        BOXING_ASSERT(stats.unresolved_errors == expected_stats.unresolved_errors);
+        BOXING_ASSERT(stats.decoded_codewords == expected_stats.decoded_codewords);
+        BOXING_ASSERT(stats.decode_iterations == expected_stats.decode_iterations);
+        BOXING_ASSERT(stats.max_decode_iterations == expected_stats.max_decode_iterations);
+
+        gvector_free(data);
+        gvector_free(expected);
+        gvector_free(encoded);
+        gvector_free(message);
+        codec->free(codec);
+    }
+    rand_use_tables(NULL);
+}
+END_TEST
+
+
+// Serialized matrix of the test codec from the matrix cache
+static gvector * serialize_ldpc_matrix(const boxing_ldpc_matrix_key * key)
+{
+    struct ldpc_generator_s * matrix = boxing_ldpc_matrix_acquire(key, NULL);
+    gvector * serialized = boxing_ldpc_matrix_serialize(key, matrix);
+    boxing_ldpc_matrix_release(matrix);
+    return serialized;
+}
+
+
+static DBOOL file_exists(const char * path)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return DFALSE;
+    }
+    fclose(file);
+    return DTRUE;
+}
+
+
+// Constructed, file cached and registered matrices are identical and give the same codewords
+BOXING_START_TEST(boxing_codec_ldpc_matrix_cache_test)
+{
+    srand(13);
+    use_ldpc_test_tables();
+    const boxing_ldpc_matrix_key key = { LDPC_MESSAGE_SIZE * 8, LDPC_PARITY_SIZE * 8, 1, BOXING_LDPC_MATRIX_EVENBOTH_3_NO4CYCLE_DENSE };
+    char path[64];
+    sprintf(path, "./ldpc_v%d_%08x_%u_%u_1_%u.bin", BOXING_LDPC_MATRIX_VERSION, boxing_ldpc_matrix_random_source(),
+        key.message_bits, key.parity_bits, key.method);
+    remove(path);
+    boxing_ldpc_matrix_cache_clear();
+
+    // A constructed matrix is written to the file cache
+    boxing_codec * codec = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, ".");
+    BOXING_ASSERT(codec != NULL);
+    BOXING_ASSERT(file_exists(path) == DTRUE);
+    gvector * message = create_message(LDPC_MESSAGE_SIZE * LDPC_BLOCK_COUNT);
+    gvector * expected = clone_data(message);
+    BOXING_ASSERT(codec->encode(codec, expected) == DTRUE);
+    gvector * serialized = serialize_ldpc_matrix(&key);
+    BOXING_ASSERT(serialized != NULL);
+    codec->free(codec);
+
+    // Loaded from the file cache
+    boxing_ldpc_matrix_cache_clear();
+    codec = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, ".");
+    BOXING_ASSERT(codec != NULL);
+    gvector * loaded = serialize_ldpc_matrix(&key);
+    BOXING_ASSERT(data_equal(loaded, serialized) == DTRUE);
+    gvector * encoded = clone_data(message);
+    BOXING_ASSERT(codec->encode(codec, encoded) == DTRUE);
+    BOXING_ASSERT(data_equal(encoded, expected) == DTRUE);
+    gvector_free(encoded);
+    gvector_free(loaded);
+    codec->free(codec);
+
+    // Constructed again without the file cache
+    boxing_ldpc_matrix_cache_clear();
+    remove(path);
+    codec = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, NULL);
+    BOXING_ASSERT(codec != NULL);
+    BOXING_ASSERT(file_exists(path) == DFALSE);
+    loaded = serialize_ldpc_matrix(&key);
+    BOXING_ASSERT(data_equal(loaded, serialized) == DTRUE);
+    gvector_free(loaded);
+    codec->free(codec);
+
+    // Corrupted and truncated data is rejected, valid data is registered
+    boxing_ldpc_matrix_cache_clear();
+    gvector * corrupted = clone_data(serialized);
+    GVECTORN8(corrupted, corrupted->size / 2) ^= 0x10;
+    BOXING_ASSERT(boxing_ldpc_matrix_register(corrupted->buffer, corrupted->size) == DFALSE);
+    BOXING_ASSERT(boxing_ldpc_matrix_register(serialized->buffer, serialized->size - 1) == DFALSE);
+    BOXING_ASSERT(boxing_ldpc_matrix_register(serialized->buffer, serialized->size) == DTRUE);
+    codec = create_ldpc(PARAM_NAME_DECODER_MIN_SUM, NULL);
+    BOXING_ASSERT(codec != NULL);
+    encoded = clone_data(message);
+    BOXING_ASSERT(codec->encode(codec, encoded) == DTRUE);
+    BOXING_ASSERT(data_equal(encoded, expected) == DTRUE);
+    gvector_free(encoded);
+    codec->free(codec);
+
+    gvector_free(corrupted);
+    gvector_free(serialized);
+    gvector_free(expected);
+    gvector_free(message);
+    boxing_ldpc_matrix_cache_clear();
+    rand_use_tables(NULL);
+}
+END_TEST
+
+
+// Little endian word of a serialized matrix
+static uint32_t serialized_word(const gvector * data, size_t offset)
+{
+    const unsigned char * word = (const unsigned char *)data->buffer + offset;
+    return word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t)word[3] << 24);
+}
+
+
+// A matrix constructed from fixed random tables is pinned by its checksum, any change of
+// the construction changes the matrices of archived data. Matrices of other random tables
+// are not used, and without random tables no matrix is constructed.
+BOXING_START_TEST(boxing_codec_ldpc_matrix_random_source_test)
+{
+    static unsigned int tables[N_tables * Table_size];
+    static unsigned int other_tables[N_tables * Table_size];
+    fill_ldpc_tables(tables, 12345);
+    fill_ldpc_tables(other_tables, 54321);
+    const boxing_ldpc_matrix_key key = { 256, 128, 1, BOXING_LDPC_MATRIX_EVENBOTH_3_NO4CYCLE_DENSE };
+    boxing_ldpc_matrix_cache_clear();
+
+    rand_use_tables(tables);
+    const uint32_t source = boxing_ldpc_matrix_random_source();
+    gvector * serialized = serialize_ldpc_matrix(&key);
+
+    BOXING_ASSERT(source == 0xafaf8648u);
+    BOXING_ASSERT(serialized != NULL);
+    BOXING_ASSERT(serialized_word(serialized, 8) == BOXING_LDPC_MATRIX_VERSION);
+    BOXING_ASSERT(serialized_word(serialized, 12) == source);
+    BOXING_ASSERT(serialized_word(serialized, serialized->size - 4) == 0xefff8525u);
+
+    // The matrix of other tables is another one, the matrix of the first tables is rejected
+    rand_use_tables(other_tables);
+    const uint32_t other_source = boxing_ldpc_matrix_random_source();
+    gvector * other_serialized = serialize_ldpc_matrix(&key);
+    BOXING_ASSERT(other_source != source);
+    BOXING_ASSERT(serialized_word(other_serialized, 12) == other_source);
+    BOXING_ASSERT(data_equal(other_serialized, serialized) == DFALSE);
+    BOXING_ASSERT(boxing_ldpc_matrix_register(serialized->buffer, serialized->size) == DFALSE);
+    BOXING_ASSERT(boxing_ldpc_matrix_register(other_serialized->buffer, other_serialized->size) == DTRUE);
+
+    // A library built without the random file reports the missing random source
+    rand_use_tables(NULL);
+    if (rand_tables() == NULL)
+    {
+        BOXING_ASSERT(boxing_ldpc_matrix_random_source() == 0);
+        BOXING_ASSERT(boxing_ldpc_matrix_acquire(&key, NULL) == NULL);
+        BOXING_ASSERT(boxing_ldpc_matrix_register(other_serialized->buffer, other_serialized->size) == DFALSE);
+        BOXING_ASSERT(create_ldpc(PARAM_NAME_DECODER_MIN_SUM, NULL) == NULL);
+    }
+
+    gvector_free(other_serialized);
+    gvector_free(serialized);
+    boxing_ldpc_matrix_cache_clear();
+}
+END_TEST
+
+
+// The max-log LLRs are close to the exact LLRs and give as many bit errors
+BOXING_START_TEST(boxing_codec_2dpam_max_log_test)
+{
+    srand(14);
+    boxing_codec * reference = create_2dpam(NULL);
+    boxing_codec * codec = create_2dpam(PARAM_NAME_LLR_MAX_LOG);
+    BOXING_ASSERT(reference != NULL && codec != NULL);
+    BOXING_ASSERT(create_2dpam("unknown") == NULL);
+
+    gvector * message = gvector_create_char(codec->decoded_block_size, 0);
+    gvector * expected = pam_frame(codec, message, 12.0);
+    BOXING_ASSERT(expected->size == PAM_IMAGE_WIDTH * PAM_IMAGE_HEIGHT);
+    gvector * data = clone_data(expected);
+    BOXING_ASSERT(reference->decode(reference, expected, NULL, NULL, NULL) == DTRUE);
+    BOXING_ASSERT(codec->decode(codec, data, NULL, NULL, NULL) == DTRUE);
+    BOXING_ASSERT(data->size == message->size);
+    BOXING_ASSERT(expected->size == message->size);
+
+    int max_deviation = 0;
+    int total_deviation = 0;
+    int expected_bit_errors = 0;
+    int bit_errors = 0;
+    for (unsigned int i = 0; i < data->size; i++)
+    {
+        const int exact_llr = (signed char)GVECTORN8(expected, i);
+        const int llr = (signed char)GVECTORN8(data, i);
+        max_deviation = BOXING_MATH_MAX(max_deviation, abs(llr - exact_llr));
+        total_deviation += abs(llr - exact_llr);
+        expected_bit_errors += (exact_llr > 0) != (GVECTORN8(message, i) == 1);
+        bit_errors += (llr > 0) != (GVECTORN8(message, i) == 1);
+    }
+
+    // Max-log is off by at most ten times the log of the 18 points of a bit
+    // value, which only happens far from all points
+    BOXING_ASSERT(max_deviation <= 29);
+    BOXING_ASSERT(total_deviation <= (int)data->size / 2);
+    BOXING_ASSERT(expected_bit_errors > 0);
+    BOXING_ASSERT(bit_errors <= expected_bit_errors + expected_bit_errors / 100);
+
+    gvector_free(data);
+    gvector_free(expected);
+    gvector_free(message);
+    codec->free(codec);
+    reference->free(reference);
+}
+END_TEST
+
+
+// The SIMD max-log kernels give exactly the same LLRs as the portable code
+BOXING_START_TEST(boxing_codec_2dpam_max_log_kernels_test)
+{
+    srand(15);
+    boxing_codec * codec = create_2dpam(PARAM_NAME_LLR_MAX_LOG);
+    BOXING_ASSERT(codec != NULL);
+
+    gvector * message = gvector_create_char(codec->decoded_block_size, 0);
+    gvector * expected = pam_frame(codec, message, 12.0);
+    gvector * data = clone_data(expected);
+    boxing_cpu_set_feature_mask(0);
+    BOXING_ASSERT(codec->decode(codec, expected, NULL, NULL, NULL) == DTRUE);
+    boxing_cpu_set_feature_mask(~0u);
+    BOXING_ASSERT(codec->decode(codec, data, NULL, NULL, NULL) == DTRUE);
+
+    BOXING_ASSERT(data_equal(data, expected) == DTRUE);
+
+    gvector_free(data);
+    gvector_free(expected);
+    gvector_free(message);
+    codec->free(codec);
+}
+END_TEST
+
+
+// Demodulating the block rows on several threads gives the same LLRs as one thread
+BOXING_START_TEST(boxing_codec_2dpam_threads_test)
+{
+    srand(16);
+    const char * llrs[] = { PARAM_NAME_LLR_EXACT, PARAM_NAME_LLR_MAX_LOG };
+    const int thread_counts[] = { 2, 3, 16 };
+    for (int l = 0; l < 2; l++)
+    {
+        boxing_codec * codec = create_2dpam(llrs[l]);
+        BOXING_ASSERT(codec != NULL);
+        BOXING_ASSERT(codec->reentrant);
+
+        gvector * message = gvector_create_char(codec->decoded_block_size, 0);
+        gvector * frame = pam_frame(codec, message, 12.0);
+        gvector * expected = clone_data(frame);
+        BOXING_ASSERT(codec->decode(codec, expected, NULL, NULL, NULL) == DTRUE);
+
+        for (int t = 0; t < 3; t++)
+        {
+            g_variant * thread_count = g_variant_create_int(thread_counts[t]);
+            codec->set_property(codec, PARAM_NAME_THREAD_COUNT, thread_count);
+            g_variant_free(thread_count);
+
+            gvector * data = clone_data(frame);
+            BOXING_ASSERT(codec->decode(codec, data, NULL, NULL, NULL) == DTRUE);
+            BOXING_ASSERT(data_equal(data, expected) == DTRUE);
+            gvector_free(data);
+        }
+
+        gvector_free(expected);
+        gvector_free(frame);
+        gvector_free(message);
+        codec->free(codec);
+    }
+}
+END_TEST
+
+
+Suite * codec_tests(void)
+{
+    TCase * tc_reedsolomon_functions_tests = tcase_create("reedsolomon_functions_tests");
+    tcase_add_test(tc_reedsolomon_functions_tests, boxing_codec_reedsolomon_erasures_test1);
+    tcase_add_test(tc_reedsolomon_functions_tests, boxing_codec_reedsolomon_erasures_test2);
+    tcase_add_test(tc_reedsolomon_functions_tests, boxing_codec_reedsolomon_erasures_test3);
+    tcase_add_test(tc_reedsolomon_functions_tests, boxing_codec_reedsolomon_syndrome_kernels_test);
+
+    TCase * tc_ftf_interleaving_functions_tests = tcase_create("ftf_interleaving_functions_tests");
+    tcase_add_test(tc_ftf_interleaving_functions_tests, boxing_codec_ftf_interleaving_round_trip_test);
+    tcase_add_test(tc_ftf_interleaving_functions_tests, boxing_codec_ftf_interleaving_file_buffer_test);
+    tcase_add_test(tc_ftf_interleaving_functions_tests, boxing_codec_ftf_interleaving_scalar_test);
+
+    TCase * tc_cipher_functions_tests = tcase_create("cipher_functions_tests");
+    tcase_add_test(tc_cipher_functions_tests, boxing_codec_cipher_keystream_test);
+    tcase_add_test(tc_cipher_functions_tests, boxing_codec_cipher_round_trip_test);
+
+    TCase * tc_ldpc_functions_tests = tcase_create("ldpc_functions_tests");
+    tcase_add_test(tc_ldpc_functions_tests, boxing_codec_ldpc_min_sum_test);
+    tcase_add_test(tc_ldpc_functions_tests, boxing_codec_ldpc_min_sum_kernels_test);
+    tcase_add_test(tc_ldpc_functions_tests, boxing_codec_ldpc_layered_min_sum_test);
+    tcase_add_test(tc_ldpc_functions_tests, boxing_codec_ldpc_threads_test);
+    tcase_add_test(tc_ldpc_functions_tests, boxing_codec_ldpc_matrix_cache_test);
+    tcase_add_test(tc_ldpc_functions_tests, boxing_codec_ldpc_matrix_random_source_test);
+
+    TCase * tc_2dpam_functions_tests = tcase_create("2dpam_functions_tests");
+    tcase_add_test(tc_2dpam_functions_tests, boxing_codec_2dpam_max_log_test);
+    tcase_add_test(tc_2dpam_functions_tests, boxing_codec_2dpam_max_log_kernels_test);
+    tcase_add_test(tc_2dpam_functions_tests, boxing_codec_2dpam_threads_test);
+
+    Suite * s = suite_create("codec_test_util");
+    suite_add_tcase(s, tc_reedsolomon_functions_tests);
+    suite_add_tcase(s, tc_ftf_interleaving_functions_tests);
+    suite_add_tcase(s, tc_cipher_functions_tests);
+    suite_add_tcase(s, tc_ldpc_functions_tests);
+    suite_add_tcase(s, tc_2dpam_functions_tests);
+
+    return s;
+}
@@ -16,8 +16,25 @@
 #include "boxing/math/crc32.h"
 #include "boxing/math/crc64.h"
 #include "boxing/utils.h"
+#include "boxing/platform/cpu.h"
 #include <stdio.h>
 
+#define KAT_BUFFER_SIZE 1000
+
+static const char kat_check[] = "123456789";
+
+// Aligned test pattern, KAT_BUFFER_SIZE bytes of (i * 31 + 7) mod 256
+static const char * kat_buffer(void)
+{
+    static boxing_uint64 storage[(KAT_BUFFER_SIZE + 7) / 8];
+    unsigned char * buffer = (unsigned char *)storage;
+    for (int i = 0; i < KAT_BUFFER_SIZE; i++)
+    {
+        buffer[i] = (unsigned char)(i * 31 + 7);
+    }
+    return (const char *)buffer;
+}
+
 BOXING_START_TEST(boxing_crc32_create_def_test0)
 {
     dcrc32 * calc_crc = boxing_math_crc32_create_def();
@@ -166,6 +183,74 @@ BOXING_START_TEST(boxing_crc64_reset_crc_test0)
 }
 END_TEST
 
+// Known answers with and without carry-less multiply folding, the unaligned
+// data with a seed covers the slicing code continuing from the leading bytes
+static void crc64_known_answers(void)
+{
+    const char * buffer = kat_buffer();
+    dcrc64 * calc_crc = boxing_math_crc64_create_def();
+    BOXING_ASSERT(0x6C40DF5F0B497347ULL == boxing_math_crc64_calc_crc_re(calc_crc, 0, kat_check, 9));
+    BOXING_ASSERT(0x014E7C83D104BC0BULL == boxing_math_crc64_calc_crc_re(calc_crc, 0, buffer, KAT_BUFFER_SIZE));
+    BOXING_ASSERT(0x34B2B3A48941584DULL == boxing_math_crc64_calc_crc_re(calc_crc, 0x0123456789ABCDEFULL, buffer + 3, KAT_BUFFER_SIZE - 3));
+
+    // Chained calculation gives the same crc as one pass
+    boxing_math_crc64_calc_crc(calc_crc, buffer, 1);
+    boxing_math_crc64_calc_crc(calc_crc, buffer + 1, 7);
+    boxing_math_crc64_calc_crc(calc_crc, buffer + 8, 101);
+    BOXING_ASSERT(0x014E7C83D104BC0BULL == boxing_math_crc64_calc_crc(calc_crc, buffer + 109, KAT_BUFFER_SIZE - 109));
+    boxing_math_crc64_free(calc_crc);
+
+    // A polynom without shared tables
+    calc_crc = boxing_math_crc64_create(0, 0xAD93D23594C935A9ULL);
+    BOXING_ASSERT(0x375C2FDCEAA05982ULL == boxing_math_crc64_calc_crc(calc_crc, buffer, KAT_BUFFER_SIZE));
+    boxing_math_crc64_free(calc_crc);
+}
+
+static void crc32_known_answers(void)
+{
+    const char * buffer = kat_buffer();
+    dcrc32 * calc_crc = boxing_math_crc32_create_def();
+    BOXING_ASSERT(0xC052A8C8 == boxing_math_crc32_calc_crc_re(calc_crc, 0, kat_check, 9));
+    BOXING_ASSERT(0x3958E369 == boxing_math_crc32_calc_crc_re(calc_crc, 0, buffer, KAT_BUFFER_SIZE));
+    BOXING_ASSERT(0x4ACF46DF == boxing_math_crc32_calc_crc_re(calc_crc, 0x89ABCDEF, buffer + 3, KAT_BUFFER_SIZE - 3));
+
+    boxing_math_crc32_calc_crc(calc_crc, buffer, 1);
+    boxing_math_crc32_calc_crc(calc_crc, buffer + 1, 7);
+    boxing_math_crc32_calc_crc(calc_crc, buffer + 8, 101);
+    BOXING_ASSERT(0x3958E369 == boxing_math_crc32_calc_crc(calc_crc, buffer + 109, KAT_BUFFER_SIZE - 109));
+    boxing_math_crc32_free(calc_crc);
+
+    calc_crc = boxing_math_crc32_create(0, POLY_CRC_32);
+    BOXING_ASSERT(0x89A1897F == boxing_math_crc32_calc_crc(calc_crc, kat_check, 9));
+    boxing_math_crc32_free(calc_crc);
+
+    calc_crc = boxing_math_crc32_create(0, POLY_CRC_32Q);
+    BOXING_ASSERT(0x976EC861 == boxing_math_crc32_calc_crc(calc_crc, buffer, KAT_BUFFER_SIZE));
+    boxing_math_crc32_free(calc_crc);
+
+    calc_crc = boxing_math_crc32_create(0, 0xA833982B);
+    BOXING_ASSERT(0x35FDA101 == boxing_math_crc32_calc_crc(calc_crc, buffer, KAT_BUFFER_SIZE));
+    boxing_math_crc32_free(calc_crc);
+}
+
+BOXING_START_TEST(boxing_crc64_known_answer_test)
+{
+    boxing_cpu_set_feature_mask(0);
+    crc64_known_answers();
+    boxing_cpu_set_feature_mask(~0u);
+    crc64_known_answers();
+}
+END_TEST
+
+BOXING_START_TEST(boxing_crc32_known_answer_test)
+{
+    boxing_cpu_set_feature_mask(0);
+    crc32_known_answers();
+    boxing_cpu_set_feature_mask(~0u);
+    crc32_known_answers();
+}
+END_TEST
+
 
 Suite * crc32_tests(void)
 {
@@ -175,6 +260,7 @@ Suite * crc32_tests(void)
     tcase_add_test(tc_crc32_utils_tests, boxing_crc32_calc_crc_test1);
     tcase_add_test(tc_crc32_utils_tests, boxing_crc32_get_crc_test0);
     tcase_add_test(tc_crc32_utils_tests, boxing_crc32_reset_crc_test0);
+    tcase_add_test(tc_crc32_utils_tests, boxing_crc32_known_answer_test);
 
     TCase * tc_crc64_utils_tests = tcase_create("tc_crc64_util_tests");
     tcase_add_test(tc_crc64_utils_tests, boxing_crc64_create_def_test0);
@@ -182,6 +268,7 @@ Suite * crc32_tests(void)
     tcase_add_test(tc_crc64_utils_tests, boxing_crc64_calc_crc_test1);
     tcase_add_test(tc_crc64_utils_tests, boxing_crc64_get_crc_test0);
     tcase_add_test(tc_crc64_utils_tests, boxing_crc64_reset_crc_test0);
+    tcase_add_test(tc_crc64_utils_tests, boxing_crc64_known_answer_test);
 
     Suite * s = suite_create("crc_test_util");
     suite_add_tcase(s, tc_crc32_utils_tests);
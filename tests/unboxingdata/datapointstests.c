@@ -0,0 +1,196 @@
+/*****************************************************************************
+**
+**  datapoints unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "datapoints.h"
+#include "boxing/codecs/modulator.h"
+#include "boxing/image8.h"
+#include "boxing/utils.h"
+#include "boxing/platform/cpu.h"
+#include "g_variant.h"
+#include <stdlib.h>
+
+// Neither a multiple of 8 nor of 4 datapoints, the Modulator keeps a partial
+// byte of one bit symbols and drops the trailing two bit symbols
+#define DATAPOINTS_WIDTH  203
+#define DATAPOINTS_HEIGHT 45
+#define BLOCK_SIZE        32
+
+
+// Every datapoint is one of the evenly spread levels plus noise, close enough
+// to the thresholds to give the datapoints a range of unreliability
+static boxing_image8 * create_datapoints_image(int levels, int noise)
+{
+    boxing_image8 * image = boxing_image8_create(DATAPOINTS_WIDTH, DATAPOINTS_HEIGHT);
+    const int level_spacing = 200 / (levels - 1);
+    for (unsigned int i = 0; i < image->width * image->height; i++)
+    {
+        const int level = 20 + (rand() % levels) * level_spacing + rand() % (2 * noise + 1) - noise;
+        image->data[i] = (boxing_image8_pixel)BOXING_MATH_CLAMP(0, 255, level);
+    }
+    return image;
+}
+
+
+static boxing_codec * create_modulator(unsigned int bits_per_pixel)
+{
+    GHashTable * properties = g_hash_table_new_full(g_str_hash, g_str_equal, boxing_utils_g_hash_table_destroy_item_string, boxing_utils_g_hash_table_destroy_item_g_variant);
+    g_hash_table_replace(properties, boxing_string_clone("NumBitsPerPixel"), g_variant_create_uint(bits_per_pixel));
+    boxing_codec * codec = boxing_codec_modulator_create(properties, NULL);
+    g_hash_table_destroy(properties);
+    return codec;
+}
+
+
+static DBOOL vectors_equal(const gvector * a, const gvector * b)
+{
+    if (a->size != b->size)
+    {
+        return DFALSE;
+    }
+    for (unsigned int i = 0; i < a->size; i++)
+    {
+        if (((unsigned char *)a->buffer)[i] != ((unsigned char *)b->buffer)[i])
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+// The packed symbols and their unreliability are what the Modulator decodes from the bins
+static void test_quantize_packed(int levels, unsigned int bits_per_pixel)
+{
+    boxing_image8 * image = create_datapoints_image(levels, 200 / (levels - 1) / 3);
+
+    gvector * expected_erasures = gvector_create(1, 0);
+    gvector * expected = boxing_datapoints_quantize_erasures(image, BLOCK_SIZE, BLOCK_SIZE, levels, expected_erasures, 1);
+    boxing_codec * modulator = create_modulator(bits_per_pixel);
+    boxing_stats_decode stats = { 0, 0, 0.0f, 0.0f, 0, 0, 0 };
+    BOXING_ASSERT(modulator->decode(modulator, expected, expected_erasures, &stats, NULL) == DTRUE);
+
+    gvector * erasures = gvector_create(1, 0);
+    gvector * data = boxing_datapoints_quantize_packed(image, BLOCK_SIZE, BLOCK_SIZE, levels, erasures, 1);
+    gvector * data_without_erasures = boxing_datapoints_quantize_packed(image, BLOCK_SIZE, BLOCK_SIZE, levels, NULL, 1);
+
+    const unsigned int datapoints = DATAPOINTS_WIDTH * DATAPOINTS_HEIGHT;
+    BOXING_ASSERT(data->size == (bits_per_pixel == 1 ? (datapoints + 7) / 8 : datapoints / 4));
+    BOXING_ASSERT(vectors_equal(data, expected));
+    BOXING_ASSERT(vectors_equal(erasures, expected_erasures));
+    BOXING_ASSERT(vectors_equal(data_without_erasures, expected));
+
+    // The test is only meaningful if some bytes are unreliable and some are not
+    int unreliable = 0;
+    for (unsigned int i = 0; i < erasures->size; i++)
+    {
+        unreliable += ((unsigned char *)erasures->buffer)[i] != 0;
+    }
+    BOXING_ASSERT(unreliable > 0 && unreliable < (int)erasures->size);
+
+    gvector_free(data_without_erasures);
+    gvector_free(data);
+    gvector_free(erasures);
+    gvector_free(expected);
+    gvector_free(expected_erasures);
+    boxing_codec_modulator_free(modulator);
+    boxing_image8_free(image);
+}
+
+
+// The SIMD lookup gives the same bins as the portable lookup
+static void test_quantize_simd(int levels)
+{
+    boxing_image8 * image = create_datapoints_image(levels, 200 / (levels - 1) / 2);
+
+    boxing_cpu_set_feature_mask(0);
+    gvector * expected = boxing_datapoints_quantize(image, BLOCK_SIZE, BLOCK_SIZE, levels);
+    boxing_cpu_set_feature_mask(~0u);
+    gvector * data = boxing_datapoints_quantize(image, BLOCK_SIZE, BLOCK_SIZE, levels);
+
+    BOXING_ASSERT(data->size == DATAPOINTS_WIDTH * DATAPOINTS_HEIGHT);
+    BOXING_ASSERT(vectors_equal(data, expected));
+
+    gvector_free(expected);
+    gvector_free(data);
+    boxing_image8_free(image);
+}
+
+
+// Tests for functions in datapoints.h
+
+//
+//  FUNCTIONS Datapoints Tests
+//
+
+// One bit symbols, the last byte holds 7 symbols
+BOXING_START_TEST(boxing_datapoints_quantize_packed_test1)
+{
+    srand(1);
+    test_quantize_packed(2, 1);
+}
+END_TEST
+
+
+// Two bit symbols, the last 3 symbols are dropped
+BOXING_START_TEST(boxing_datapoints_quantize_packed_test2)
+{
+    srand(2);
+    test_quantize_packed(4, 2);
+}
+END_TEST
+
+
+// Only 2 and 4 levels are packed
+BOXING_START_TEST(boxing_datapoints_quantize_packed_test3)
+{
+    srand(3);
+    boxing_image8 * image = create_datapoints_image(8, 4);
+    BOXING_ASSERT(boxing_datapoints_quantize_packed(image, BLOCK_SIZE, BLOCK_SIZE, 8, NULL, 1) == NULL);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Two levels
+BOXING_START_TEST(boxing_datapoints_quantize_test1)
+{
+    srand(4);
+    test_quantize_simd(2);
+}
+END_TEST
+
+
+// Four levels
+BOXING_START_TEST(boxing_datapoints_quantize_test2)
+{
+    srand(5);
+    test_quantize_simd(4);
+}
+END_TEST
+
+
+Suite * datapoints_test(void)
+{
+    TCase * tc_datapoints_functions_tests = tcase_create("datapoints_functions_tests");
+    tcase_add_test(tc_datapoints_functions_tests, boxing_datapoints_quantize_packed_test1);
+    tcase_add_test(tc_datapoints_functions_tests, boxing_datapoints_quantize_packed_test2);
+    tcase_add_test(tc_datapoints_functions_tests, boxing_datapoints_quantize_packed_test3);
+    tcase_add_test(tc_datapoints_functions_tests, boxing_datapoints_quantize_test1);
+    tcase_add_test(tc_datapoints_functions_tests, boxing_datapoints_quantize_test2);
+
+    Suite * s = suite_create("datapoints_test_util");
+    suite_add_tcase(s, tc_datapoints_functions_tests);
+    return s;
+}
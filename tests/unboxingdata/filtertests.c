@@ -0,0 +1,448 @@
+/*****************************************************************************
+**
+**  filter unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/filter.h"
+#include "boxing/image8.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/platform/memory.h"
+#include "boxing/utils.h"
+
+static boxing_float sharpness_coefficients[] =
+{
+    -0.085390f,  0.188372f, -0.363868f,  0.188372f, -0.085390f,
+     0.188372f, -0.499956f,  0.441212f, -0.499956f,  0.188372f,
+    -0.363868f,  0.441212f,  1.500000f,  0.441212f, -0.363868f,
+     0.188372f, -0.499956f,  0.441212f, -0.499956f,  0.188372f,
+    -0.085390f,  0.188372f, -0.363868f,  0.188372f, -0.085390f
+};
+
+static boxing_float visual_coefficients[] =
+{
+    0.00048091f, 0.00501119f, 0.01094545f, 0.00501119f, 0.00048091f,
+    0.00501119f, 0.05221780f, 0.11405416f, 0.05221780f, 0.00501119f,
+    0.01094545f, 0.11405416f, 0.24911720f, 0.11405416f, 0.01094545f,
+    0.00501119f, 0.05221780f, 0.11405416f, 0.05221780f, 0.00501119f,
+    0.00048091f, 0.00501119f, 0.01094545f, 0.00501119f, 0.00048091f
+};
+
+
+// Reference implementation, the original full image filter of the unboxer
+static void reference_filter(boxing_image8 * image, const boxing_filter_coeff_2d * filter_coeff)
+{
+    const int width = image->width;
+    const int height = image->height;
+    boxing_image8 destination;
+    boxing_image8_init_in_place(&destination, width, height);
+
+    boxing_image8_pixel * destination_pixel = destination.data;
+    const int rows = filter_coeff->rows;
+    const int cols = filter_coeff->cols;
+    const int filter_y_radius = rows / 2;
+    const int filter_x_radius = cols / 2;
+    boxing_float * coeff = filter_coeff->coeff;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int Y = (y - filter_y_radius + height) % height;
+
+            boxing_float value = 0.0f;
+
+            for (int i = 0; i < rows; i++)
+            {
+                int X = x - filter_x_radius + width;
+                const boxing_image8_pixel * pixel = image->data + Y * width;
+                for (int j = 0; j < cols; j++)
+                {
+                    value += *(coeff + i*cols + j) * *(pixel + (X++) % width);
+                }
+
+                Y = ((Y + 1) % height);
+            }
+
+            value = BOXING_MATH_CLAMP(BOXING_PIXEL_MIN, BOXING_PIXEL_MAX, value);
+            *destination_pixel++ = (boxing_image8_pixel)value;
+        }
+    }
+    boxing_memory_copy(image->data, destination.data, width * height);
+    boxing_memory_free(destination.data);
+}
+
+
+static boxing_image8 * create_random_image(unsigned int width, unsigned int height)
+{
+    boxing_image8 * image = boxing_image8_create(width, height);
+    for (unsigned int i = 0; i < width * height; i++)
+    {
+        image->data[i] = (boxing_image8_pixel)(rand() % 256);
+    }
+    return image;
+}
+
+
+static DBOOL filter_matches_reference(unsigned int width, unsigned int height, boxing_float * coefficients, boxing_float mix, int thread_count)
+{
+    boxing_float mixed[25];
+    for (int i = 0; i < 25; i++)
+    {
+        mixed[i] = coefficients[i] * mix;
+    }
+    mixed[12] = coefficients[12] * mix + (1 - mix);
+
+    boxing_filter_coeff_2d filter_coeff;
+    filter_coeff.rows = 5;
+    filter_coeff.cols = 5;
+    filter_coeff.coeff = mixed;
+
+    boxing_image8 * expected = create_random_image(width, height);
+    boxing_image8 * result = boxing_image8_copy(expected);
+
+    reference_filter(expected, &filter_coeff);
+    int status = boxing_filter_apply(result, &filter_coeff, thread_count);
+
+    DBOOL equal = (status == BOXING_FILTER_CALLBACK_OK);
+    for (unsigned int i = 0; i < width * height && equal; i++)
+    {
+        equal = (expected->data[i] == result->data[i]);
+    }
+
+    boxing_image8_free(expected);
+    boxing_image8_free(result);
+    return equal;
+}
+
+
+// Largest difference between the fixed point filter and the reference, -1 on failure
+static int fixed_point_difference(const boxing_image8 * image, boxing_float * coefficients, int rows, int cols, int thread_count)
+{
+    boxing_filter_coeff_2d filter_coeff;
+    filter_coeff.rows = rows;
+    filter_coeff.cols = cols;
+    filter_coeff.coeff = coefficients;
+
+    boxing_image8 * expected = boxing_image8_copy(image);
+    boxing_image8 * result = boxing_image8_copy(image);
+
+    reference_filter(expected, &filter_coeff);
+    int difference = boxing_filter_apply_fixed_point(result, &filter_coeff, thread_count) == BOXING_FILTER_CALLBACK_OK ? 0 : -1;
+    for (unsigned int i = 0; i < image->width * image->height && difference >= 0; i++)
+    {
+        difference = BOXING_MATH_MAX(difference, abs(expected->data[i] - result->data[i]));
+    }
+
+    boxing_image8_free(expected);
+    boxing_image8_free(result);
+    return difference;
+}
+
+
+// Number of pixels where the filter differs from the reference, -1 if a pixel differs by more than one gray level
+static int separable_difference(const boxing_image8 * image, boxing_float * coefficients, int rows, int cols, int thread_count)
+{
+    boxing_filter_coeff_2d filter_coeff;
+    filter_coeff.rows = rows;
+    filter_coeff.cols = cols;
+    filter_coeff.coeff = coefficients;
+
+    boxing_image8 * expected = boxing_image8_copy(image);
+    boxing_image8 * result = boxing_image8_copy(image);
+
+    reference_filter(expected, &filter_coeff);
+    int differences = boxing_filter_apply(result, &filter_coeff, thread_count) == BOXING_FILTER_CALLBACK_OK ? 0 : -1;
+    for (unsigned int i = 0; i < image->width * image->height && differences >= 0; i++)
+    {
+        const int difference = abs(expected->data[i] - result->data[i]);
+        differences = difference > 1 ? -1 : differences + difference;
+    }
+
+    boxing_image8_free(expected);
+    boxing_image8_free(result);
+    return differences;
+}
+
+
+// Smooth random image, so most filtered pixels are not clipped
+static boxing_image8 * create_smooth_image(unsigned int width, unsigned int height)
+{
+    boxing_image8 * image = boxing_image8_create(width, height);
+    for (unsigned int y = 0; y < height; y++)
+    {
+        for (unsigned int x = 0; x < width; x++)
+        {
+            IMAGE8_PIXEL(image, x, y) = (boxing_image8_pixel)(96 + (x * 7 + y * 3) % 64 + rand() % 16);
+        }
+    }
+    return image;
+}
+
+
+static void mix_coefficients(boxing_float * mixed, const boxing_float * coefficients, boxing_float mix)
+{
+    for (int i = 0; i < 25; i++)
+    {
+        mixed[i] = coefficients[i] * mix;
+    }
+    mixed[12] = coefficients[12] * mix + (1 - mix);
+}
+
+
+// Tests for file boxing/filter.h
+
+//
+//  FUNCTIONS Filter Tests
+//
+
+// Single threaded filter is bit exact with the reference
+BOXING_START_TEST(boxing_filter_apply_test1)
+{
+    srand(1);
+    BOXING_ASSERT(filter_matches_reference(256, 128, sharpness_coefficients, 1.0f, 1) == DTRUE);
+    BOXING_ASSERT(filter_matches_reference(251, 67, sharpness_coefficients, 0.7f, 1) == DTRUE);
+    BOXING_ASSERT(filter_matches_reference(99, 41, visual_coefficients, 1.0f, 1) == DTRUE);
+}
+END_TEST
+
+
+// Multithreaded filter is bit exact with the reference, including bands smaller than the filter
+BOXING_START_TEST(boxing_filter_apply_test2)
+{
+    srand(2);
+    BOXING_ASSERT(filter_matches_reference(317, 203, sharpness_coefficients, 1.0f, 2) == DTRUE);
+    BOXING_ASSERT(filter_matches_reference(317, 203, sharpness_coefficients, 0.45f, 3) == DTRUE);
+    BOXING_ASSERT(filter_matches_reference(64, 16, sharpness_coefficients, 1.0f, 8) == DTRUE);
+    BOXING_ASSERT(filter_matches_reference(33, 9, visual_coefficients, 1.0f, 9) == DTRUE);
+}
+END_TEST
+
+
+// Portable fallback is bit exact with the reference
+BOXING_START_TEST(boxing_filter_apply_test3)
+{
+    srand(3);
+    boxing_cpu_set_feature_mask(0);
+    DBOOL equal = filter_matches_reference(203, 77, sharpness_coefficients, 0.8f, 2);
+    boxing_cpu_set_feature_mask(~0u);
+
+    BOXING_ASSERT(equal == DTRUE);
+}
+END_TEST
+
+
+// Filter with a single row and column is applied
+BOXING_START_TEST(boxing_filter_apply_test4)
+{
+    boxing_float gain = 2.0f;
+    boxing_filter_coeff_2d filter_coeff = { 1, 1, &gain };
+    boxing_image8 * image = create_random_image(37, 11);
+    boxing_image8 * copy = boxing_image8_copy(image);
+
+    BOXING_ASSERT(boxing_filter_apply(image, &filter_coeff, 4) == BOXING_FILTER_CALLBACK_OK);
+    for (unsigned int i = 0; i < 37 * 11; i++)
+    {
+        BOXING_ASSERT(image->data[i] == BOXING_MATH_MIN(copy->data[i] * 2, 255));
+    }
+
+    boxing_image8_free(image);
+    boxing_image8_free(copy);
+}
+END_TEST
+
+
+// Invalid input is rejected
+BOXING_START_TEST(boxing_filter_apply_test5)
+{
+    boxing_filter_coeff_2d filter_coeff = { 5, 5, sharpness_coefficients };
+    boxing_image8 * image = create_random_image(16, 16);
+
+    BOXING_ASSERT(boxing_filter_apply(NULL, &filter_coeff, 1) == BOXING_FILTER_CALLBACK_ERROR);
+    BOXING_ASSERT(boxing_filter_apply(image, NULL, 1) == BOXING_FILTER_CALLBACK_ERROR);
+
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Separable filters are applied as two passes, a pixel differs from the reference only where the
+// 2D sum is within float rounding of a gray level
+BOXING_START_TEST(boxing_filter_apply_test6)
+{
+    srand(10);
+    const boxing_float vertical[3] = { 0.3f, 0.55f, 0.15f };
+    const boxing_float horizontal[4] = { -0.45f, 1.35f, 0.35f, -0.25f };
+    boxing_float separable[12];
+    boxing_float transposed[12];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            separable[i * 4 + j] = vertical[i] * horizontal[j];
+            transposed[j * 3 + i] = vertical[i] * horizontal[j];
+        }
+    }
+
+    boxing_image8 * image = create_random_image(331, 157);
+    const int pixels = 331 * 157;
+    int differences = separable_difference(image, separable, 3, 4, 1);
+    BOXING_ASSERT(differences >= 0 && differences < pixels / 1000);
+    differences = separable_difference(image, transposed, 4, 3, 3);
+    BOXING_ASSERT(differences >= 0 && differences < pixels / 1000);
+    differences = separable_difference(image, visual_coefficients, 5, 5, 4);
+    BOXING_ASSERT(differences >= 0 && differences < pixels / 1000);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Separable SIMD kernels are bit exact with the portable fallback
+BOXING_START_TEST(boxing_filter_apply_test7)
+{
+    srand(11);
+    boxing_filter_coeff_2d visual = { 5, 5, visual_coefficients };
+    boxing_image8 * image = create_random_image(203, 61);
+    boxing_image8 * expected = boxing_image8_copy(image);
+
+    boxing_cpu_set_feature_mask(0);
+    int status = boxing_filter_apply(expected, &visual, 1);
+    boxing_cpu_set_feature_mask(~0u);
+    BOXING_ASSERT(status == BOXING_FILTER_CALLBACK_OK);
+    BOXING_ASSERT(boxing_filter_apply(image, &visual, 4) == BOXING_FILTER_CALLBACK_OK);
+
+    for (unsigned int i = 0; i < image->width * image->height; i++)
+    {
+        BOXING_ASSERT(image->data[i] == expected->data[i]);
+    }
+
+    boxing_image8_free(image);
+    boxing_image8_free(expected);
+}
+END_TEST
+
+
+// Fixed point filter is within one gray level of the reference
+BOXING_START_TEST(boxing_filter_apply_fixed_point_test1)
+{
+    srand(6);
+    boxing_float mixed[25];
+    boxing_image8 * image = create_smooth_image(301, 97);
+
+    mix_coefficients(mixed, sharpness_coefficients, 0.45f);
+    BOXING_ASSERT(fixed_point_difference(image, mixed, 5, 5, 1) <= 1);
+    mix_coefficients(mixed, sharpness_coefficients, 1.0f);
+    BOXING_ASSERT(fixed_point_difference(image, mixed, 5, 5, 3) <= 1);
+    BOXING_ASSERT(fixed_point_difference(image, visual_coefficients, 5, 5, 2) <= 1);
+
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Separable filters that are not square or symmetric are within one gray level of the reference
+BOXING_START_TEST(boxing_filter_apply_fixed_point_test2)
+{
+    srand(7);
+    const boxing_float vertical[3] = { 0.25f, 0.5f, 0.125f };
+    const boxing_float horizontal[4] = { -0.5f, 1.5f, 0.75f, -0.25f };
+    boxing_float separable[12];
+    boxing_float transposed[12];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            separable[i * 4 + j] = vertical[i] * horizontal[j];
+            transposed[j * 3 + i] = vertical[i] * horizontal[j];
+        }
+    }
+
+    boxing_image8 * image = create_smooth_image(77, 45);
+    BOXING_ASSERT(fixed_point_difference(image, separable, 3, 4, 1) <= 1);
+    BOXING_ASSERT(fixed_point_difference(image, transposed, 4, 3, 5) <= 1);
+    BOXING_ASSERT(fixed_point_difference(image, separable, 1, 12, 2) <= 1);
+    BOXING_ASSERT(fixed_point_difference(image, separable, 12, 1, 2) <= 1);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Fixed point SIMD kernels are bit exact with the portable fallback
+BOXING_START_TEST(boxing_filter_apply_fixed_point_test3)
+{
+    srand(8);
+    boxing_float mixed[25];
+    mix_coefficients(mixed, sharpness_coefficients, 0.7f);
+    boxing_filter_coeff_2d sharpness = { 5, 5, mixed };
+    boxing_filter_coeff_2d visual = { 5, 5, visual_coefficients };
+
+    const boxing_filter_coeff_2d * filters[2] = { &sharpness, &visual };
+    for (int i = 0; i < 2; i++)
+    {
+        boxing_image8 * image = create_smooth_image(203, 61);
+        boxing_image8 * expected = boxing_image8_copy(image);
+
+        boxing_cpu_set_feature_mask(0);
+        int status = boxing_filter_apply_fixed_point(expected, filters[i], 1);
+        boxing_cpu_set_feature_mask(~0u);
+        BOXING_ASSERT(status == BOXING_FILTER_CALLBACK_OK);
+        BOXING_ASSERT(boxing_filter_apply_fixed_point(image, filters[i], 4) == BOXING_FILTER_CALLBACK_OK);
+
+        for (unsigned int j = 0; j < image->width * image->height; j++)
+        {
+            BOXING_ASSERT(image->data[j] == expected->data[j]);
+        }
+
+        boxing_image8_free(image);
+        boxing_image8_free(expected);
+    }
+}
+END_TEST
+
+
+// Filters with too large dynamic range for 16 bit coefficients are applied in float
+BOXING_START_TEST(boxing_filter_apply_fixed_point_test4)
+{
+    srand(9);
+    boxing_float coefficients[9] = { -0.1f, -2.9f, -0.1f, -2.9f, 1000.3f, -2.9f, -0.1f, -2.9f, -0.1f };
+    boxing_image8 * image = create_smooth_image(50, 40);
+    for (unsigned int i = 0; i < image->width * image->height; i++)
+    {
+        image->data[i] /= 64;
+    }
+
+    BOXING_ASSERT(fixed_point_difference(image, coefficients, 3, 3, 2) == 0);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+Suite * filter_tests(void)
+{
+    TCase * tc_filter_functions_tests = tcase_create("filter_functions_tests");
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test1);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test2);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test3);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test4);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test5);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test6);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_test7);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_fixed_point_test1);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_fixed_point_test2);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_fixed_point_test3);
+    tcase_add_test(tc_filter_functions_tests, boxing_filter_apply_fixed_point_test4);
+
+    Suite * s = suite_create("filter_test_util");
+    suite_add_tcase(s, tc_filter_functions_tests);
+
+    return s;
+}
@@ -0,0 +1,233 @@
+/*****************************************************************************
+**
+**  frame tracker utility unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/unboxer/frametrackerutil.h"
+#include "boxing/frame/trackergpf.h"
+#include "boxing/image8.h"
+#include "boxing/utils.h"
+#include <stdlib.h>
+
+#define TRACKER_SAMPLING_RATE 2.0f
+#define TRACKER_IMAGE_WIDTH   480
+#define TRACKER_IMAGE_HEIGHT  320
+
+
+// Draw a corner mark symbol centered at (cx, cy), a 2x2 checkerboard with the
+// top left tile black surrounded by a black quiet zone
+static void draw_corner_mark(boxing_image8 * image, int cx, int cy, boxing_float sampling_rate)
+{
+    const int border = (int)(20 * sampling_rate);
+    const int tile = (int)(16 * sampling_rate);
+
+    for (int y = cy - border; y < cy + border; y++)
+    {
+        for (int x = cx - border; x < cx + border; x++)
+        {
+            boxing_image8_pixel pixel = 0;
+            if (x >= cx - tile && x < cx + tile && y >= cy - tile && y < cy + tile)
+            {
+                pixel = ((x < cx) == (y < cy)) ? 0 : 255;
+            }
+            IMAGE8_PIXEL(image, x, y) = pixel;
+        }
+    }
+}
+
+
+static boxing_image8 * create_frame_image(const frame_corner_marks * corner_marks)
+{
+    boxing_image8 * image = boxing_image8_create(TRACKER_IMAGE_WIDTH, TRACKER_IMAGE_HEIGHT);
+    for (unsigned int i = 0; i < image->width * image->height; i++)
+    {
+        image->data[i] = 128;
+    }
+
+    draw_corner_mark(image, corner_marks->top_left.x, corner_marks->top_left.y, TRACKER_SAMPLING_RATE);
+    draw_corner_mark(image, corner_marks->top_right.x, corner_marks->top_right.y, TRACKER_SAMPLING_RATE);
+    draw_corner_mark(image, corner_marks->bottom_left.x, corner_marks->bottom_left.y, TRACKER_SAMPLING_RATE);
+    draw_corner_mark(image, corner_marks->bottom_right.x, corner_marks->bottom_right.y, TRACKER_SAMPLING_RATE);
+    return image;
+}
+
+
+static DBOOL point_near(const boxing_pointi * a, const boxing_pointi * b)
+{
+    return abs(a->x - b->x) <= 1 && abs(a->y - b->y) <= 1;
+}
+
+
+static frame_corner_marks shift_corner_marks(const frame_corner_marks * corner_marks, int dx, int dy)
+{
+    frame_corner_marks shifted = *corner_marks;
+    boxing_pointi * points[] = { &shifted.top_left, &shifted.top_right, &shifted.bottom_left, &shifted.bottom_right };
+    for (int i = 0; i < 4; i++)
+    {
+        points[i]->x += dx;
+        points[i]->y += dy;
+    }
+    return shifted;
+}
+
+
+// Blur with a 3x3 box filter and add uniform noise, like a scanned frame
+static void degrade_image(boxing_image8 * image, int noise)
+{
+    boxing_image8 * source = boxing_image8_copy(image);
+    for (int y = 1; y < (int)image->height - 1; y++)
+    {
+        for (int x = 1; x < (int)image->width - 1; x++)
+        {
+            int sum = 0;
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    sum += IMAGE8_PIXEL(source, x + dx, y + dy);
+                }
+            }
+            int pixel = sum / 9 + rand() % (2 * noise + 1) - noise;
+            IMAGE8_PIXEL(image, x, y) = (boxing_image8_pixel)BOXING_MATH_CLAMP(0, 255, pixel);
+        }
+    }
+    boxing_image8_free(source);
+}
+
+
+static const frame_corner_marks test_corner_marks = { { 70, 66 }, { 411, 63 }, { 68, 251 }, { 409, 254 } };
+
+
+// Tests for file boxing/unboxer/frametrackerutil.h
+
+//
+//  FUNCTIONS Corner Mark Tests
+//
+
+// The best match of the corner mark pattern is the center of the symbol
+BOXING_START_TEST(boxing_frame_tracker_util_find_corner_mark_test)
+{
+    boxing_image8 * image = create_frame_image(&test_corner_marks);
+
+    boxing_pointi location = { 0, 0 };
+    boxing_pointi dimension = { (int)(96 * TRACKER_SAMPLING_RATE), (int)(96 * TRACKER_SAMPLING_RATE) };
+    boxing_pointi found = boxing_frame_tracker_util_find_corner_mark(image, location, dimension, TRACKER_SAMPLING_RATE, TRACKER_SAMPLING_RATE);
+    BOXING_ASSERT(point_near(&found, &test_corner_marks.top_left) == DTRUE);
+
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// The coarse to fine search finds the same location as the exhaustive reference search on the test images
+BOXING_START_TEST(boxing_frame_tracker_util_find_corner_mark_pyramid_test)
+{
+    const boxing_float sampling_rates[] = { 1.0f, 1.5f, 2.0f, 3.0f, 4.0f };
+    srand(11);
+
+    for (unsigned int i = 0; i < sizeof(sampling_rates) / sizeof(sampling_rates[0]); i++)
+    {
+        const boxing_float sampling_rate = sampling_rates[i];
+        const int search_size = (int)(96 * sampling_rate);
+
+        for (int n = 0; n < 8; n++)
+        {
+            boxing_image8 * image = boxing_image8_create(search_size + 16, search_size + 16);
+            for (unsigned int p = 0; p < image->width * image->height; p++)
+            {
+                image->data[p] = 128;
+            }
+
+            const int margin = (int)(24 * sampling_rate);
+            boxing_pointi center = { margin + rand() % (search_size - 2 * margin), margin + rand() % (search_size - 2 * margin) };
+            draw_corner_mark(image, center.x, center.y, sampling_rate);
+            degrade_image(image, 10 + n * 5);
+
+            boxing_pointi location = { 4, 4 };
+            boxing_pointi dimension = { search_size, search_size };
+            boxing_pointi exhaustive = boxing_frame_tracker_util_find_corner_mark_exhaustive(image, location, dimension, sampling_rate, sampling_rate);
+            boxing_pointi pyramid = boxing_frame_tracker_util_find_corner_mark(image, location, dimension, sampling_rate, sampling_rate);
+            BOXING_ASSERT(point_near(&exhaustive, &center) == DTRUE);
+            BOXING_ASSERT(pyramid.x == exhaustive.x && pyramid.y == exhaustive.y);
+
+            boxing_image8_free(image);
+        }
+    }
+}
+END_TEST
+
+
+// Corner marks close to the previous location are found in a narrow search
+BOXING_START_TEST(boxing_frame_tracker_util_find_frame_near_test)
+{
+    boxing_image8 * image = create_frame_image(&test_corner_marks);
+
+    frame_corner_marks previous = shift_corner_marks(&test_corner_marks, 5, -4);
+    frame_corner_marks found;
+    BOXING_ASSERT(boxing_frame_tracker_util_find_frame_near(image, &previous, &found, 16, TRACKER_SAMPLING_RATE, TRACKER_SAMPLING_RATE) == DTRUE);
+    BOXING_ASSERT(point_near(&found.top_left, &test_corner_marks.top_left) == DTRUE);
+    BOXING_ASSERT(point_near(&found.top_right, &test_corner_marks.top_right) == DTRUE);
+    BOXING_ASSERT(point_near(&found.bottom_left, &test_corner_marks.bottom_left) == DTRUE);
+    BOXING_ASSERT(point_near(&found.bottom_right, &test_corner_marks.bottom_right) == DTRUE);
+
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Corner marks that moved further than the search radius are reported as not found
+BOXING_START_TEST(boxing_frame_tracker_util_find_frame_near_miss_test)
+{
+    boxing_image8 * image = create_frame_image(&test_corner_marks);
+
+    frame_corner_marks previous = shift_corner_marks(&test_corner_marks, 30, 0);
+    frame_corner_marks found;
+    BOXING_ASSERT(boxing_frame_tracker_util_find_frame_near(image, &previous, &found, 16, TRACKER_SAMPLING_RATE, TRACKER_SAMPLING_RATE) == DFALSE);
+
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Found corner marks are only accepted with a whole corner mark symbol inside the image
+BOXING_START_TEST(boxing_tracker_gpf_validate_corner_marks_test)
+{
+    boxing_image8 * image = create_frame_image(&test_corner_marks);
+    boxing_corner_mark_definition definition;
+    definition.corner_mark_symbol = 32;
+
+    frame_corner_marks corner_marks = test_corner_marks;
+    BOXING_ASSERT(boxing_tracker_gpf_validate_corner_marks(image, &definition, TRACKER_SAMPLING_RATE, TRACKER_SAMPLING_RATE, &corner_marks) == BOXING_CORNER_MARK_OK);
+    corner_marks = shift_corner_marks(&test_corner_marks, -40, 0);
+    BOXING_ASSERT(boxing_tracker_gpf_validate_corner_marks(image, &definition, TRACKER_SAMPLING_RATE, TRACKER_SAMPLING_RATE, &corner_marks) != BOXING_CORNER_MARK_OK);
+    corner_marks = shift_corner_marks(&test_corner_marks, 0, 40);
+    BOXING_ASSERT(boxing_tracker_gpf_validate_corner_marks(image, &definition, TRACKER_SAMPLING_RATE, TRACKER_SAMPLING_RATE, &corner_marks) != BOXING_CORNER_MARK_OK);
+
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+Suite * frametrackerutil_test(void)
+{
+    TCase * tc_corner_mark_functions_tests = tcase_create("corner_mark_functions_tests");
+    tcase_add_test(tc_corner_mark_functions_tests, boxing_frame_tracker_util_find_corner_mark_test);
+    tcase_add_test(tc_corner_mark_functions_tests, boxing_frame_tracker_util_find_corner_mark_pyramid_test);
+    tcase_add_test(tc_corner_mark_functions_tests, boxing_frame_tracker_util_find_frame_near_test);
+    tcase_add_test(tc_corner_mark_functions_tests, boxing_frame_tracker_util_find_frame_near_miss_test);
+    tcase_add_test(tc_corner_mark_functions_tests, boxing_tracker_gpf_validate_corner_marks_test);
+
+    Suite * s = suite_create("frametrackerutil_test_util");
+    suite_add_tcase(s, tc_corner_mark_functions_tests);
+    return s;
+}
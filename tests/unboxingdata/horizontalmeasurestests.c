@@ -0,0 +1,157 @@
+/*****************************************************************************
+**
+**  horizontal measures unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "horizontalmeasures.h"
+#include "boxing/image8.h"
+#include "boxing/matrix.h"
+#include <stdlib.h>
+#include <math.h>
+
+#define BLOCK_SIZE      64
+#define HISTOGRAM_SIZE  256
+
+// Largest difference in gray levels allowed between a warm started and a cold k-means. Both stop
+// after a fixed number of iterations, on overlapping levels they are not fully converged.
+#define MEANS_TOLERANCE 2.0f
+
+
+// Every pixel is one of the evenly spread levels plus noise, the gain falls off
+// by gain_drift from the top left to the bottom right corner
+static boxing_image8 * create_level_image(int width, int height, int levels, int noise, boxing_float gain_drift)
+{
+    boxing_image8 * image = boxing_image8_create(width, height);
+    const int level_spacing = 180 / (levels - 1);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const boxing_float gain = 1.0f - gain_drift * (x + y) / (width + height);
+            const int level = (int)((30 + (rand() % levels) * level_spacing) * gain);
+            // The sum of two uniform draws, most samples are near the level
+            const int offset = rand() % (noise + 1) + rand() % (noise + 1) - noise;
+            IMAGE8_PIXEL(image, x, y) = (boxing_image8_pixel)BOXING_MATH_CLAMP(0, 255, level + offset);
+        }
+    }
+    return image;
+}
+
+
+static boxing_image8 * copy_block(const boxing_image8 * image, int left, int top)
+{
+    boxing_image8 * block = boxing_image8_create(BLOCK_SIZE, BLOCK_SIZE);
+    for (int y = 0; y < BLOCK_SIZE; y++)
+    {
+        for (int x = 0; x < BLOCK_SIZE; x++)
+        {
+            IMAGE8_PIXEL(block, x, y) = IMAGE8_PIXEL(image, left + x, top + y);
+        }
+    }
+    return block;
+}
+
+
+// The blocks of a row start their k-means from the centers of the block to the left. A block
+// on its own takes the k-means++ start, it must end up at the same means and thresholds.
+static void test_warm_start(int levels, int noise)
+{
+    boxing_image8 * image = create_level_image(8 * BLOCK_SIZE, 4 * BLOCK_SIZE, levels, noise, 0.3f);
+
+    boxing_matrix_float * means = boxing_calculate_means(image, BLOCK_SIZE, BLOCK_SIZE, levels, 1);
+    boxing_matrix_float * thresholds = boxing_calculate_thresholds(image, BLOCK_SIZE, BLOCK_SIZE, levels, 1);
+    BOXING_ASSERT(means->rows == 8 && means->pages == 4);
+    BOXING_ASSERT(thresholds->rows == 8 && thresholds->pages == 4);
+
+    for (unsigned int n = 0; n < means->pages; n++)
+    {
+        for (unsigned int m = 0; m < means->rows; m++)
+        {
+            boxing_image8 * block = copy_block(image, m * BLOCK_SIZE, n * BLOCK_SIZE);
+
+            boxing_matrix_float * cold_means = boxing_calculate_means(block, BLOCK_SIZE, BLOCK_SIZE, levels, 1);
+
+            int histogram[HISTOGRAM_SIZE] = { 0 };
+            for (int i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++)
+            {
+                histogram[block->data[i]]++;
+            }
+            boxing_float cold_thresholds[HISTOGRAM_SIZE];
+            boxing_calculate_histogram_thresholds(histogram, BLOCK_SIZE * BLOCK_SIZE, cold_thresholds, levels);
+
+            const boxing_float * warm_means = MATRIX_MULTIPAGE_ROW_PTR(means, m, n);
+            const boxing_float * warm_thresholds = MATRIX_MULTIPAGE_ROW_PTR(thresholds, m, n);
+            for (int i = 0; i < levels; i++)
+            {
+                BOXING_ASSERT(fabsf(warm_means[i] - cold_means->data[i]) <= MEANS_TOLERANCE);
+            }
+            for (int i = 0; i < levels - 1; i++)
+            {
+                BOXING_ASSERT(fabsf(warm_thresholds[i] - cold_thresholds[i]) <= MEANS_TOLERANCE);
+            }
+
+            boxing_matrix_float_free(cold_means);
+            boxing_image8_free(block);
+        }
+    }
+
+    boxing_matrix_float_free(means);
+    boxing_matrix_float_free(thresholds);
+    boxing_image8_free(image);
+}
+
+
+// Tests for functions in horizontalmeasures.h
+
+//
+//  FUNCTIONS Horizontal Measures Tests
+//
+
+// Two noisy levels
+BOXING_START_TEST(boxing_calculate_means_warm_start_test1)
+{
+    srand(1);
+    test_warm_start(2, 30);
+}
+END_TEST
+
+
+// Four noisy levels
+BOXING_START_TEST(boxing_calculate_means_warm_start_test2)
+{
+    srand(2);
+    test_warm_start(4, 16);
+}
+END_TEST
+
+
+// Four levels where the noise of neighbouring levels overlaps
+BOXING_START_TEST(boxing_calculate_means_warm_start_test3)
+{
+    srand(3);
+    test_warm_start(4, 28);
+}
+END_TEST
+
+
+Suite * horizontalmeasures_test(void)
+{
+    TCase * tc_horizontalmeasures_functions_tests = tcase_create("horizontalmeasures_functions_tests");
+    tcase_add_test(tc_horizontalmeasures_functions_tests, boxing_calculate_means_warm_start_test1);
+    tcase_add_test(tc_horizontalmeasures_functions_tests, boxing_calculate_means_warm_start_test2);
+    tcase_add_test(tc_horizontalmeasures_functions_tests, boxing_calculate_means_warm_start_test3);
+
+    Suite * s = suite_create("horizontalmeasures_test_util");
+    suite_add_tcase(s, tc_horizontalmeasures_functions_tests);
+    return s;
+}
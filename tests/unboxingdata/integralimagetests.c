@@ -0,0 +1,209 @@
+/*****************************************************************************
+**
+**  integral image unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/unboxer/integralimage.h"
+#include "boxing/image8.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/utils.h"
+#include <stdlib.h>
+
+
+static boxing_image8 * create_random_image(int width, int height)
+{
+    boxing_image8 * image = boxing_image8_create(width, height);
+    for (int i = 0; i < width * height; i++)
+    {
+        image->data[i] = (boxing_image8_pixel)(rand() % 256);
+    }
+    return image;
+}
+
+
+// Sums of the rectangle clipped to the image, pixel by pixel
+static void reference_sums(const boxing_image8 * image, int x, int y, int width, int height, boxing_uint64 * sum, boxing_uint64 * squared_sum)
+{
+    *sum = 0;
+    *squared_sum = 0;
+    for (int j = y; j < y + height; j++)
+    {
+        for (int i = x; i < x + width; i++)
+        {
+            if (i >= 0 && j >= 0 && i < (int)image->width && j < (int)image->height)
+            {
+                const boxing_uint64 pixel = IMAGE8_PIXEL(image, i, j);
+                *sum += pixel;
+                *squared_sum += pixel * pixel;
+            }
+        }
+    }
+}
+
+
+// Random rectangles, inside and across tiles and partly outside the image,
+// have the same sums as the reference
+static DBOOL sums_match_reference(boxing_integral_image * integral_image, int count)
+{
+    const boxing_image8 * image = integral_image->image;
+    for (int n = 0; n < count; n++)
+    {
+        const int x = rand() % (image->width + 40) - 20;
+        const int y = rand() % (image->height + 40) - 20;
+        const int width = rand() % 2 ? rand() % 16 + 1 : rand() % (BOXING_INTEGRAL_IMAGE_TILE_SIZE * 5);
+        const int height = rand() % 2 ? rand() % 16 + 1 : rand() % (BOXING_INTEGRAL_IMAGE_TILE_SIZE * 5);
+
+        boxing_uint64 expected_sum;
+        boxing_uint64 expected_squared_sum;
+        reference_sums(image, x, y, width, height, &expected_sum, &expected_squared_sum);
+
+        boxing_uint64 sum;
+        boxing_uint64 squared_sum;
+        boxing_integral_image_sums(integral_image, x, y, width, height, &sum, &squared_sum);
+        if (sum != expected_sum || squared_sum != expected_squared_sum ||
+            boxing_integral_image_sum(integral_image, x, y, width, height) != expected_sum)
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+// Tests for file boxing/unboxer/integralimage.h
+
+//
+//  FUNCTIONS Integral Image Tests
+//
+
+// Box sums are exact, the image does not end on a tile boundary
+BOXING_START_TEST(boxing_integral_image_sums_test1)
+{
+    srand(1);
+    boxing_image8 * image = create_random_image(2 * BOXING_INTEGRAL_IMAGE_TILE_SIZE + 37, BOXING_INTEGRAL_IMAGE_TILE_SIZE + 101);
+    boxing_integral_image * integral_image = boxing_integral_image_create(image);
+
+    BOXING_ASSERT(sums_match_reference(integral_image, 500) == DTRUE);
+
+    boxing_integral_image_free(integral_image);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Sums that do not fit in 32 bits are exact
+BOXING_START_TEST(boxing_integral_image_sums_test2)
+{
+    const int size = 300;
+    boxing_image8 * image = boxing_image8_create(size, size);
+    for (int i = 0; i < size * size; i++)
+    {
+        image->data[i] = BOXING_PIXEL_MAX;
+    }
+    boxing_integral_image * integral_image = boxing_integral_image_create(image);
+
+    boxing_uint64 sum;
+    boxing_uint64 squared_sum;
+    boxing_integral_image_sums(integral_image, 0, 0, size, size, &sum, &squared_sum);
+    BOXING_ASSERT(sum == (boxing_uint64)size * size * 255);
+    BOXING_ASSERT(squared_sum == (boxing_uint64)size * size * 255 * 255);
+
+    boxing_integral_image_free(integral_image);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Portable fallback is exact, and squared sums can be requested later
+BOXING_START_TEST(boxing_integral_image_sums_test3)
+{
+    srand(3);
+    boxing_image8 * image = create_random_image(BOXING_INTEGRAL_IMAGE_TILE_SIZE + 13, 75);
+
+    boxing_cpu_set_feature_mask(0);
+    boxing_integral_image * integral_image = boxing_integral_image_create(image);
+    boxing_uint64 sum = boxing_integral_image_sum(integral_image, 0, 0, image->width, image->height);
+    DBOOL equal = sums_match_reference(integral_image, 200);
+    boxing_cpu_set_feature_mask(~0u);
+
+    boxing_uint64 expected_sum;
+    boxing_uint64 expected_squared_sum;
+    reference_sums(image, 0, 0, image->width, image->height, &expected_sum, &expected_squared_sum);
+    BOXING_ASSERT(sum == expected_sum);
+    BOXING_ASSERT(equal == DTRUE);
+
+    boxing_integral_image_free(integral_image);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Tables are rebuilt after a reset, also for an image of another size
+BOXING_START_TEST(boxing_integral_image_reset_test1)
+{
+    srand(4);
+    boxing_image8 * first = create_random_image(300, 200);
+    boxing_image8 * second = create_random_image(300, 200);
+    boxing_image8 * third = create_random_image(90, 400);
+    boxing_integral_image * integral_image = boxing_integral_image_create(first);
+
+    BOXING_ASSERT(sums_match_reference(integral_image, 100) == DTRUE);
+    boxing_integral_image_reset(integral_image, second);
+    BOXING_ASSERT(sums_match_reference(integral_image, 100) == DTRUE);
+    boxing_integral_image_reset(integral_image, third);
+    BOXING_ASSERT(sums_match_reference(integral_image, 100) == DTRUE);
+
+    boxing_integral_image_free(integral_image);
+    boxing_image8_free(first);
+    boxing_image8_free(second);
+    boxing_image8_free(third);
+}
+END_TEST
+
+
+// The average divides by the area of the whole rectangle
+BOXING_START_TEST(boxing_integral_image_average_test1)
+{
+    boxing_image8 * image = boxing_image8_create(20, 10);
+    for (int i = 0; i < 20 * 10; i++)
+    {
+        image->data[i] = 100;
+    }
+    boxing_integral_image * integral_image = boxing_integral_image_create(image);
+
+    boxing_pointi point = { 2, 3 };
+    boxing_pointi dimension = { 4, 5 };
+    BOXING_ASSERT(boxing_integral_image_average(integral_image, &point, &dimension) == 100.0f);
+
+    point.x = 18;
+    BOXING_ASSERT(boxing_integral_image_average(integral_image, &point, &dimension) == 50.0f);
+
+    boxing_integral_image_free(integral_image);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+Suite * integralimage_test(void)
+{
+    TCase * tc_integral_image_functions_tests = tcase_create("integral_image_functions_tests");
+    tcase_add_test(tc_integral_image_functions_tests, boxing_integral_image_sums_test1);
+    tcase_add_test(tc_integral_image_functions_tests, boxing_integral_image_sums_test2);
+    tcase_add_test(tc_integral_image_functions_tests, boxing_integral_image_sums_test3);
+    tcase_add_test(tc_integral_image_functions_tests, boxing_integral_image_reset_test1);
+    tcase_add_test(tc_integral_image_functions_tests, boxing_integral_image_average_test1);
+
+    Suite * s = suite_create("integralimage_test_util");
+    suite_add_tcase(s, tc_integral_image_functions_tests);
+    return s;
+}
@@ -0,0 +1,219 @@
+/*****************************************************************************
+**
+**  sample and quantize unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/unboxer.h"
+#include "boxing/image8.h"
+#include "boxing/matrix.h"
+#include "boxing/platform/cpu.h"
+#include <stdlib.h>
+
+#define SYMBOL_SIZE   3
+#define SYMBOL_BORDER 4
+
+
+// Synthetic frame with the symbol of each datapoint and its location
+typedef struct symbol_frame_s
+{
+    boxing_image8 *  image;
+    boxing_matrixf * locations;
+    int *            symbols;
+} symbol_frame;
+
+
+// Draws every symbol as a SYMBOL_SIZE x SYMBOL_SIZE square, the levels are evenly
+// spread and the gain falls off by gain_drift from the left to the right edge
+static void create_symbol_frame(symbol_frame * frame, int width, int height, int bins, int noise, boxing_float gain_drift)
+{
+    frame->image = boxing_image8_create(2 * SYMBOL_BORDER + width * SYMBOL_SIZE, 2 * SYMBOL_BORDER + height * SYMBOL_SIZE);
+    for (unsigned int i = 0; i < frame->image->width * frame->image->height; i++)
+    {
+        frame->image->data[i] = 0;
+    }
+
+    frame->locations = boxing_matrixf_create(width, height);
+    frame->symbols = (int *)malloc(width * height * sizeof(int));
+
+    const int level_spacing = 200 / (bins - 1);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const int symbol = rand() % bins;
+            const boxing_float gain = 1.0f - gain_drift * x / width;
+            const int level = (int)((20 + symbol * level_spacing) * gain) + rand() % (noise + 1);
+            const int left = SYMBOL_BORDER + x * SYMBOL_SIZE;
+            const int top = SYMBOL_BORDER + y * SYMBOL_SIZE;
+            for (int j = 0; j < SYMBOL_SIZE; j++)
+            {
+                for (int i = 0; i < SYMBOL_SIZE; i++)
+                {
+                    IMAGE8_PIXEL(frame->image, left + i, top + j) = (boxing_image8_pixel)level;
+                }
+            }
+
+            // Off the pixel grid, the square is flat around the location
+            MATRIX_ELEMENT(frame->locations, y, x).x = (boxing_float)(left + 1) + 0.25f;
+            MATRIX_ELEMENT(frame->locations, y, x).y = (boxing_float)(top + 1) + 0.5f;
+            frame->symbols[y * width + x] = symbol;
+        }
+    }
+}
+
+
+static void free_symbol_frame(symbol_frame * frame)
+{
+    boxing_image8_free(frame->image);
+    boxing_matrixf_free(frame->locations);
+    free(frame->symbols);
+}
+
+
+// Count the datapoints quantized to another bin than the symbol drawn
+static int symbol_errors(const symbol_frame * frame, const gvector * data)
+{
+    const unsigned char * bins = (const unsigned char *)data->buffer;
+    int errors = 0;
+    for (unsigned int i = 0; i < frame->locations->width * frame->locations->height; i++)
+    {
+        if (bins[i] != frame->symbols[i])
+        {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+
+// Tests for function boxing_unboxer_sample_quantize in boxing/unboxer.h
+
+//
+//  FUNCTIONS Sample Quantize Tests
+//
+
+// Four level symbols with a gain drift are mapped straight to their bins
+BOXING_START_TEST(boxing_unboxer_sample_quantize_test1)
+{
+    srand(1);
+    symbol_frame frame;
+    create_symbol_frame(&frame, 160, 96, 4, 8, 0.2f);
+
+    gvector * erasures = gvector_create(1, 0);
+    gvector * data = boxing_unboxer_sample_quantize(NULL, frame.image, frame.locations, 32, 32, 4, erasures);
+
+    BOXING_ASSERT(data->size == 160 * 96);
+    BOXING_ASSERT(erasures->size == 160 * 96);
+    BOXING_ASSERT(symbol_errors(&frame, data) == 0);
+
+    gvector_free(data);
+    gvector_free(erasures);
+    free_symbol_frame(&frame);
+}
+END_TEST
+
+
+// Two level symbols on a grid that is not a multiple of the block size, without erasures
+BOXING_START_TEST(boxing_unboxer_sample_quantize_test2)
+{
+    srand(2);
+    symbol_frame frame;
+    create_symbol_frame(&frame, 77, 45, 2, 20, 0.1f);
+
+    gvector * data = boxing_unboxer_sample_quantize(NULL, frame.image, frame.locations, 32, 32, 2, NULL);
+
+    BOXING_ASSERT(data->size == 77 * 45);
+    BOXING_ASSERT(symbol_errors(&frame, data) == 0);
+
+    gvector_free(data);
+    free_symbol_frame(&frame);
+}
+END_TEST
+
+
+// Datapoints midway between two levels are marked unreliable, clean ones are not
+BOXING_START_TEST(boxing_unboxer_sample_quantize_test3)
+{
+    srand(3);
+    symbol_frame frame;
+    create_symbol_frame(&frame, 64, 64, 2, 0, 0.0f);
+
+    // Level 120 is the threshold between the levels 20 and 220
+    const int left = SYMBOL_BORDER + 10 * SYMBOL_SIZE;
+    const int top = SYMBOL_BORDER + 10 * SYMBOL_SIZE;
+    for (int j = 0; j < SYMBOL_SIZE; j++)
+    {
+        for (int i = 0; i < SYMBOL_SIZE; i++)
+        {
+            IMAGE8_PIXEL(frame.image, left + i, top + j) = 120;
+        }
+    }
+
+    gvector * erasures = gvector_create(1, 0);
+    gvector * data = boxing_unboxer_sample_quantize(NULL, frame.image, frame.locations, 32, 32, 2, erasures);
+
+    const unsigned char * unreliability = (const unsigned char *)erasures->buffer;
+    BOXING_ASSERT(unreliability[10 * 64 + 10] > 200);
+    BOXING_ASSERT(unreliability[0] == 0);
+    BOXING_ASSERT(unreliability[63 * 64 + 63] == 0);
+
+    gvector_free(data);
+    gvector_free(erasures);
+    free_symbol_frame(&frame);
+}
+END_TEST
+
+
+// The SIMD lookup gives the same bins and unreliability as the portable lookup
+BOXING_START_TEST(boxing_unboxer_sample_quantize_test4)
+{
+    srand(4);
+    symbol_frame frame;
+    create_symbol_frame(&frame, 203, 70, 4, 40, 0.3f);
+
+    gvector * expected_erasures = gvector_create(1, 0);
+    gvector * erasures = gvector_create(1, 0);
+    boxing_cpu_set_feature_mask(0);
+    gvector * expected = boxing_unboxer_sample_quantize(NULL, frame.image, frame.locations, 32, 32, 4, expected_erasures);
+    boxing_cpu_set_feature_mask(~0u);
+    gvector * data = boxing_unboxer_sample_quantize(NULL, frame.image, frame.locations, 32, 32, 4, erasures);
+
+    BOXING_ASSERT(data->size == expected->size);
+    BOXING_ASSERT(erasures->size == expected_erasures->size);
+    for (unsigned int i = 0; i < data->size; i++)
+    {
+        BOXING_ASSERT(((unsigned char *)data->buffer)[i] == ((unsigned char *)expected->buffer)[i]);
+        BOXING_ASSERT(((unsigned char *)erasures->buffer)[i] == ((unsigned char *)expected_erasures->buffer)[i]);
+    }
+
+    gvector_free(expected);
+    gvector_free(data);
+    gvector_free(expected_erasures);
+    gvector_free(erasures);
+    free_symbol_frame(&frame);
+}
+END_TEST
+
+
+Suite * samplequantize_test(void)
+{
+    TCase * tc_samplequantize_functions_tests = tcase_create("samplequantize_functions_tests");
+    tcase_add_test(tc_samplequantize_functions_tests, boxing_unboxer_sample_quantize_test1);
+    tcase_add_test(tc_samplequantize_functions_tests, boxing_unboxer_sample_quantize_test2);
+    tcase_add_test(tc_samplequantize_functions_tests, boxing_unboxer_sample_quantize_test3);
+    tcase_add_test(tc_samplequantize_functions_tests, boxing_unboxer_sample_quantize_test4);
+
+    Suite * s = suite_create("samplequantize_test_util");
+    suite_add_tcase(s, tc_samplequantize_functions_tests);
+    return s;
+}
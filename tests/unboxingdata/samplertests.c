@@ -0,0 +1,183 @@
+/*****************************************************************************
+**
+**  2 polinomial sampler unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/frame/2polinomialsampler.h"
+#include "boxing/image8.h"
+#include "boxing/matrix.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/utils.h"
+#include <stdlib.h>
+
+#define IMAGE_WIDTH  157
+#define IMAGE_HEIGHT 101
+
+
+static boxing_image8 * create_random_image(void)
+{
+    boxing_image8 * image = boxing_image8_create(IMAGE_WIDTH, IMAGE_HEIGHT);
+    for (int i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT; i++)
+    {
+        image->data[i] = (boxing_image8_pixel)(rand() % 256);
+    }
+    return image;
+}
+
+
+// Random sub-pixel locations covering the whole image, including the last
+// row and column a 3x3 neighbourhood fits in
+static boxing_sampler * create_random_sampler(int width, int height)
+{
+    boxing_sampler * sampler = boxing_2polinomialsampler_create(width, height);
+    for (int i = 0; i < width * height; i++)
+    {
+        sampler->location_matrix.data[i].x = 1.0f + (IMAGE_WIDTH - 2.001f) * (boxing_float)rand() / RAND_MAX;
+        sampler->location_matrix.data[i].y = 1.0f + (IMAGE_HEIGHT - 2.001f) * (boxing_float)rand() / RAND_MAX;
+    }
+    MATRIX_ELEMENT(&sampler->location_matrix, height - 1, width - 1).x = IMAGE_WIDTH - 1.5f;
+    MATRIX_ELEMENT(&sampler->location_matrix, height - 1, width - 1).y = IMAGE_HEIGHT - 1.5f;
+    return sampler;
+}
+
+
+static DBOOL images_equal(const boxing_image8 * a, const boxing_image8 * b)
+{
+    if (a->width != b->width || a->height != b->height)
+    {
+        return DFALSE;
+    }
+    for (unsigned int i = 0; i < a->width * a->height; i++)
+    {
+        if (a->data[i] != b->data[i])
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+// SIMD and multithreaded sampling gives exactly the same pixels as the
+// portable single threaded sampling
+static DBOOL sampled_image_matches_portable(int width, int height, int thread_count)
+{
+    boxing_image8 * image = create_random_image();
+    boxing_sampler * sampler = create_random_sampler(width, height);
+
+    boxing_cpu_set_feature_mask(0);
+    sampler->thread_count = 1;
+    boxing_image8 * expected = sampler->sample(sampler, image);
+    boxing_cpu_set_feature_mask(~0u);
+    sampler->thread_count = thread_count;
+    boxing_image8 * sampled = sampler->sample(sampler, image);
+
+    DBOOL equal = images_equal(expected, sampled);
+
+    boxing_image8_free(expected);
+    boxing_image8_free(sampled);
+    boxing_sampler_destroy(sampler);
+    boxing_image8_free(image);
+    return equal;
+}
+
+
+// Tests for file boxing/frame/2polinomialsampler.h
+
+//
+//  FUNCTIONS 2 Polinomial Sampler Tests
+//
+
+// Sampled images are identical for all kernels and thread counts
+BOXING_START_TEST(boxing_2polinomialsampler_sample_test1)
+{
+    srand(1);
+    BOXING_ASSERT(sampled_image_matches_portable(64, 48, 1) == DTRUE);
+    BOXING_ASSERT(sampled_image_matches_portable(64, 48, 3) == DTRUE);
+    BOXING_ASSERT(sampled_image_matches_portable(61, 37, 16) == DTRUE);
+    BOXING_ASSERT(sampled_image_matches_portable(5, 3, 2) == DTRUE);
+}
+END_TEST
+
+
+// Sampling a line with a step is identical for all kernels
+BOXING_START_TEST(boxing_2polinomialsampler_sample_line_test1)
+{
+    srand(2);
+    boxing_image8 * image = create_random_image();
+    boxing_sampler * sampler = create_random_sampler(200, 1);
+    boxing_image8_pixel expected[100];
+    boxing_image8_pixel sampled[100];
+
+    for (int step = 1; step <= 2; step++)
+    {
+        boxing_cpu_set_feature_mask(0);
+        boxing_2polinomialsampler_sample_line(image, sampler->location_matrix.data, 99, step, expected);
+        boxing_cpu_set_feature_mask(~0u);
+        boxing_2polinomialsampler_sample_line(image, sampler->location_matrix.data, 99, step, sampled);
+
+        for (int i = 0; i < 99; i++)
+        {
+            BOXING_ASSERT(expected[i] == sampled[i]);
+        }
+    }
+
+    boxing_sampler_destroy(sampler);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+// Integer locations sample the pixel itself
+BOXING_START_TEST(boxing_2polinomialsampler_sample_test2)
+{
+    srand(3);
+    boxing_image8 * image = create_random_image();
+    boxing_sampler * sampler = boxing_2polinomialsampler_create(IMAGE_WIDTH - 2, IMAGE_HEIGHT - 2);
+    for (int y = 0; y < IMAGE_HEIGHT - 2; y++)
+    {
+        for (int x = 0; x < IMAGE_WIDTH - 2; x++)
+        {
+            MATRIX_ELEMENT(&sampler->location_matrix, y, x).x = (boxing_float)(x + 1);
+            MATRIX_ELEMENT(&sampler->location_matrix, y, x).y = (boxing_float)(y + 1);
+        }
+    }
+    sampler->thread_count = 2;
+
+    boxing_image8 * sampled = sampler->sample(sampler, image);
+    for (int y = 0; y < IMAGE_HEIGHT - 2; y++)
+    {
+        for (int x = 0; x < IMAGE_WIDTH - 2; x++)
+        {
+            BOXING_ASSERT(IMAGE8_PIXEL(sampled, x, y) == IMAGE8_PIXEL(image, x + 1, y + 1));
+        }
+    }
+
+    boxing_image8_free(sampled);
+    boxing_sampler_destroy(sampler);
+    boxing_image8_free(image);
+}
+END_TEST
+
+
+Suite * sampler_test(void)
+{
+    TCase * tc_sampler_functions_tests = tcase_create("sampler_functions_tests");
+    tcase_add_test(tc_sampler_functions_tests, boxing_2polinomialsampler_sample_test1);
+    tcase_add_test(tc_sampler_functions_tests, boxing_2polinomialsampler_sample_line_test1);
+    tcase_add_test(tc_sampler_functions_tests, boxing_2polinomialsampler_sample_test2);
+
+    Suite * s = suite_create("sampler_test_util");
+    suite_add_tcase(s, tc_sampler_functions_tests);
+    return s;
+}
@@ -0,0 +1,210 @@
+/*****************************************************************************
+**
+**  sync points unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/unboxer/syncpoints.h"
+#include "boxing/image8.h"
+#include "boxing/matrix.h"
+#include "boxing/platform/cpu.h"
+#include "boxing/utils.h"
+#include <stdlib.h>
+#include <math.h>
+
+#define SYMBOLS_H          48
+#define SYMBOLS_V          36
+#define SYMBOL_SPACING     8
+#define SYMBOL_BORDER      20
+#define SYNC_POINT_SPACING 6
+
+
+// Synthetic frame with the symbol locations and the sync point index
+typedef struct sync_point_frame_s
+{
+    boxing_image8 *  image;
+    boxing_matrixf * locations;
+    boxing_matrixi * sync_point_index;
+} sync_point_frame;
+
+
+// Symbol grid with a sync point on every SYNC_POINT_SPACING symbol, the sync
+// points are drawn as 3x3 blobs shifted by (shift_x, shift_y) or a random
+// shift when random_shift is set
+static void create_sync_point_frame(sync_point_frame * frame, int noise, DBOOL is_center_point_bright, int shift_x, int shift_y, DBOOL random_shift)
+{
+    const int width = 2 * SYMBOL_BORDER + (SYMBOLS_H - 1) * SYMBOL_SPACING;
+    const int height = 2 * SYMBOL_BORDER + (SYMBOLS_V - 1) * SYMBOL_SPACING;
+    const int background = is_center_point_bright ? 40 : 200;
+    const int center = is_center_point_bright ? 200 : 40;
+
+    frame->image = boxing_image8_create(width, height);
+    for (int i = 0; i < width * height; i++)
+    {
+        frame->image->data[i] = (boxing_image8_pixel)(background + rand() % (noise + 1));
+    }
+
+    frame->locations = boxing_matrixf_create(SYMBOLS_H, SYMBOLS_V);
+    for (int y = 0; y < SYMBOLS_V; y++)
+    {
+        for (int x = 0; x < SYMBOLS_H; x++)
+        {
+            MATRIX_ELEMENT(frame->locations, y, x).x = (boxing_float)(SYMBOL_BORDER + x * SYMBOL_SPACING);
+            MATRIX_ELEMENT(frame->locations, y, x).y = (boxing_float)(SYMBOL_BORDER + y * SYMBOL_SPACING);
+        }
+    }
+
+    const int sync_points_h = (SYMBOLS_H + SYNC_POINT_SPACING - 1) / SYNC_POINT_SPACING;
+    const int sync_points_v = (SYMBOLS_V + SYNC_POINT_SPACING - 1) / SYNC_POINT_SPACING;
+    frame->sync_point_index = boxing_matrixi_create(sync_points_h, sync_points_v);
+    for (int y = 0; y < sync_points_v; y++)
+    {
+        for (int x = 0; x < sync_points_h; x++)
+        {
+            boxing_pointi * index = MATRIX_PELEMENT(frame->sync_point_index, y, x);
+            index->x = x * SYNC_POINT_SPACING;
+            index->y = y * SYNC_POINT_SPACING;
+
+            const int center_x = SYMBOL_BORDER + index->x * SYMBOL_SPACING + (random_shift ? rand() % 3 - 1 : shift_x);
+            const int center_y = SYMBOL_BORDER + index->y * SYMBOL_SPACING + (random_shift ? rand() % 3 - 1 : shift_y);
+            for (int j = -1; j <= 1; j++)
+            {
+                for (int i = -1; i <= 1; i++)
+                {
+                    IMAGE8_PIXEL(frame->image, center_x + i, center_y + j) = (boxing_image8_pixel)center;
+                }
+            }
+        }
+    }
+}
+
+
+static void free_sync_point_frame(sync_point_frame * frame)
+{
+    boxing_image8_free(frame->image);
+    boxing_matrixf_free(frame->locations);
+    boxing_matrixi_free(frame->sync_point_index);
+}
+
+
+static boxing_matrixf * correct_frame_geometry(const sync_point_frame * frame, DBOOL is_center_point_bright, int thread_count)
+{
+    correct_frame_geometry_properties properties;
+    properties.sync_point_search_radius = 4.5f;
+    properties.sync_point_center_is_bright = is_center_point_bright;
+    properties.sync_point_max_allowed_variation = 0.1f;
+    properties.thread_count = thread_count;
+
+    boxing_matrixf * locations = boxing_matrixf_copy(frame->locations);
+    boxing_syncpoints_correct_frame_geometry(NULL, frame->image, locations, frame->sync_point_index, &properties);
+    return locations;
+}
+
+
+static DBOOL locations_equal(const boxing_matrixf * a, const boxing_matrixf * b)
+{
+    for (unsigned int i = 0; i < a->width * a->height; i++)
+    {
+        if (a->data[i].x != b->data[i].x || a->data[i].y != b->data[i].y)
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+// Batched and multithreaded location of the sync points gives exactly the
+// same result as the portable single threaded search
+static DBOOL corrected_locations_match_portable(DBOOL is_center_point_bright, int thread_count)
+{
+    sync_point_frame frame;
+    create_sync_point_frame(&frame, 255, is_center_point_bright, 0, 0, DTRUE);
+
+    boxing_cpu_set_feature_mask(0);
+    boxing_matrixf * expected = correct_frame_geometry(&frame, is_center_point_bright, 1);
+    boxing_cpu_set_feature_mask(~0u);
+    boxing_matrixf * locations = correct_frame_geometry(&frame, is_center_point_bright, thread_count);
+
+    DBOOL equal = locations_equal(expected, locations);
+
+    boxing_matrixf_free(expected);
+    boxing_matrixf_free(locations);
+    free_sync_point_frame(&frame);
+    return equal;
+}
+
+
+// Tests for file boxing/unboxer/syncpoints.h
+
+//
+//  FUNCTIONS Sync Points Tests
+//
+
+// Sync points with a bright center are located identically by all kernels and thread counts
+BOXING_START_TEST(boxing_syncpoints_correct_frame_geometry_test1)
+{
+    srand(1);
+    BOXING_ASSERT(corrected_locations_match_portable(DTRUE, 1) == DTRUE);
+    BOXING_ASSERT(corrected_locations_match_portable(DTRUE, 3) == DTRUE);
+    BOXING_ASSERT(corrected_locations_match_portable(DTRUE, 16) == DTRUE);
+}
+END_TEST
+
+
+// Sync points with a dark center are located identically by all kernels and thread counts
+BOXING_START_TEST(boxing_syncpoints_correct_frame_geometry_test2)
+{
+    srand(2);
+    BOXING_ASSERT(corrected_locations_match_portable(DFALSE, 1) == DTRUE);
+    BOXING_ASSERT(corrected_locations_match_portable(DFALSE, 4) == DTRUE);
+}
+END_TEST
+
+
+// Shifted sync points move the symbol locations
+BOXING_START_TEST(boxing_syncpoints_correct_frame_geometry_test3)
+{
+    srand(3);
+    sync_point_frame frame;
+    create_sync_point_frame(&frame, 2, DTRUE, 1, -1, DFALSE);
+
+    boxing_matrixf * locations = correct_frame_geometry(&frame, DTRUE, 2);
+    for (unsigned int y = 0; y < frame.sync_point_index->height; y++)
+    {
+        for (unsigned int x = 0; x < frame.sync_point_index->width; x++)
+        {
+            boxing_pointi index = MATRIX_ELEMENT(frame.sync_point_index, y, x);
+            boxing_pointf expected = MATRIX_ELEMENT(frame.locations, index.y, index.x);
+            boxing_pointf location = MATRIX_ELEMENT(locations, index.y, index.x);
+            BOXING_ASSERT(fabs(location.x - (expected.x + 1.0f)) < 0.25f);
+            BOXING_ASSERT(fabs(location.y - (expected.y - 1.0f)) < 0.25f);
+        }
+    }
+
+    boxing_matrixf_free(locations);
+    free_sync_point_frame(&frame);
+}
+END_TEST
+
+
+Suite * syncpoints_test(void)
+{
+    TCase * tc_syncpoints_functions_tests = tcase_create("syncpoints_functions_tests");
+    tcase_add_test(tc_syncpoints_functions_tests, boxing_syncpoints_correct_frame_geometry_test1);
+    tcase_add_test(tc_syncpoints_functions_tests, boxing_syncpoints_correct_frame_geometry_test2);
+    tcase_add_test(tc_syncpoints_functions_tests, boxing_syncpoints_correct_frame_geometry_test3);
+
+    Suite * s = suite_create("syncpoints_test_util");
+    suite_add_tcase(s, tc_syncpoints_functions_tests);
+    return s;
+}
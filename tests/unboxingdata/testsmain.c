@@ -10,6 +10,13 @@
 
 extern Suite * config_test();
 extern Suite * frametrackerutil_test();
+extern Suite * integralimage_test();
+extern Suite * syncpoints_test();
+extern Suite * sampler_test();
+extern Suite * samplequantize_test();
+extern Suite * horizontalmeasures_test();
+extern Suite * datapoints_test();
+extern Suite * unboxer_test();
 extern Suite * math_tests();
 extern Suite * metadata_tests();
 extern Suite * image8_tests();
@@ -17,6 +24,8 @@ extern Suite * matrix_tests();
 extern Suite * string_tests();
 extern Suite * boxer_tests();
 extern Suite * crc32_tests();
+extern Suite * filter_tests();
+extern Suite * codec_tests();
 
 void boxing_log(int log_level, const char * message) 
 {
@@ -52,7 +61,14 @@ int main(int argc, char ** argv)
 
     // Add all test suites here
     srunner_add_suite(sr, config_test());
-    //srunner_add_suite(sr, frametrackerutil_test());
+    srunner_add_suite(sr, frametrackerutil_test());
+    srunner_add_suite(sr, integralimage_test());
+    srunner_add_suite(sr, syncpoints_test());
+    srunner_add_suite(sr, sampler_test());
+    srunner_add_suite(sr, samplequantize_test());
+    srunner_add_suite(sr, horizontalmeasures_test());
+    srunner_add_suite(sr, datapoints_test());
+    srunner_add_suite(sr, unboxer_test());
     srunner_add_suite(sr, math_tests());
     srunner_add_suite(sr, metadata_tests());
     srunner_add_suite(sr, image8_tests());
@@ -60,6 +76,8 @@ int main(int argc, char ** argv)
     srunner_add_suite(sr, string_tests());
     //srunner_add_suite(sr, boxer_tests());
     srunner_add_suite(sr, crc32_tests());
+    srunner_add_suite(sr, filter_tests());
+    srunner_add_suite(sr, codec_tests());
  
     srunner_run_all(sr, CK_NORMAL);
     number_failed = srunner_ntests_failed(sr);
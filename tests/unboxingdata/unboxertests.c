@@ -0,0 +1,402 @@
+/*****************************************************************************
+**
+**  unboxer unittests
+**
+**  Creation date:  2026/10/17
+**  Created by:     Piql AS
+**
+**
+**  Copyright (c) 2026 Piql AS. All rights reserved.
+**
+**  This file is part of the boxing library
+**
+*****************************************************************************/
+
+#include "unittests.h"
+#include "boxing/unboxer.h"
+#include "boxing/config.h"
+#include "boxing/metadata.h"
+#include "boxing/codecs/cipher.h"
+#include "boxing/codecs/codecdispatcher.h"
+#include "boxing/graphics/genericframe.h"
+#include "boxing/graphics/genericframefactory.h"
+#include "boxing/graphics/image8paintdevice.h"
+#include "boxing/graphics/painter.h"
+#include "boxing/math/crc32.h"
+#include "boxing/math/crc64.h"
+#include "boxing/platform/memory.h"
+#include "boxing/string.h"
+#include "boxing/utils.h"
+#include "boxing_config.h"
+#include <stdlib.h>
+
+#define UNBOXER_FORMAT      "4kv10"
+#define UNBOXER_FRAME_COUNT 3
+
+
+// Decoded output of one frame and the statistics reported for it
+typedef struct unboxed_frame_s
+{
+    gvector *              data;
+    boxing_metadata_list * metadata;
+    int                    extract_result;
+    int                    result;
+    boxing_stats_decode    stats;
+} unboxed_frame;
+
+
+static void append_metadata_u32(boxing_metadata_list * list, boxing_metadata_type type, boxing_uint32 value)
+{
+    boxing_metadata_item * item = boxing_metadata_item_create(type);
+    ((boxing_metadata_item_u32 *)item)->value = value;
+    boxing_metadata_list_append_item(list, item);
+}
+
+
+static void set_frame_metadata(boxing_frame * frame, boxing_codecdispatcher * codec, boxing_metadata_list * metadata)
+{
+    gvector * data = boxing_metadata_list_serialize(metadata);
+
+    if (boxing_codecdispatcher_version_cmp(&codec->version, &BOXING_CODEC_DISPATCHER_1_0) < 0)
+    {
+        // Older dispatchers expect a padded packet terminated by a CRC32
+        const size_t packet_size = boxing_codecdispatcher_get_decoded_packet_size(codec);
+        const size_t used_size = data->size;
+        gvector_resize(data, packet_size);
+        boxing_memory_clear((char *)data->buffer + used_size, packet_size - used_size);
+
+        dcrc32 * crc = boxing_math_crc32_create_def();
+        boxing_uint32 crc_value = boxing_math_crc32_calc_crc(crc, (char *)data->buffer, (unsigned int)(packet_size - 4));
+        boxing_math_crc32_free(crc);
+
+        unsigned char * crc_bytes = (unsigned char *)data->buffer + packet_size - 4;
+        crc_bytes[0] = (unsigned char)(crc_value >> 24);
+        crc_bytes[1] = (unsigned char)(crc_value >> 16);
+        crc_bytes[2] = (unsigned char)(crc_value >> 8);
+        crc_bytes[3] = (unsigned char)crc_value;
+    }
+
+    boxing_codecdispatcher_encode(codec, data);
+
+    if (codec->symbol_alignment == BOXING_CODEC_SYMBOL_ALIGNMENT_BIT)
+    {
+        gvector * bits = gvector_create_char(data->size * 8, 0);
+        for (size_t i = 0; i < bits->size; i++)
+        {
+            ((char *)bits->buffer)[i] = (((unsigned char *)data->buffer)[i / 8] >> (7 - i % 8)) & 1;
+        }
+        gvector_free(data);
+        data = bits;
+    }
+
+    BOXING_VIRTUAL2p2(frame, metadata_container, set_data, (char *)data->buffer, (int)data->size);
+    gvector_free(data);
+}
+
+
+// Renders a frame of random data encoded with the data coding scheme of the
+// format, the frame is unboxed as raw input
+static boxing_image8 * render_frame(boxing_config * config, unsigned int frame_number, boxing_uint32 cipher_key, gvector ** source)
+{
+    boxing_frame * frame = boxing_generic_frame_factory_create(config);
+    const int levels = frame->levels_per_symbol(frame);
+    boxing_codecdispatcher * data_codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(frame, container, capasity), levels, config, "DataCodingScheme");
+    boxing_codecdispatcher * metadata_codec = boxing_codecdispatcher_create(BOXING_VIRTUAL2(frame, metadata_container, capasity), BOXING_CODEC_MODULATION_PAM2, config, "MetadataCodingScheme");
+
+    const int size = boxing_codecdispatcher_get_decoded_packet_size(data_codec);
+    *source = gvector_create_char(size, 0);
+    for (int i = 0; i < size; i++)
+    {
+        ((unsigned char *)(*source)->buffer)[i] = (unsigned char)(rand() % 256);
+    }
+
+    boxing_metadata_list * metadata = boxing_metadata_list_create();
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_JOBID, 1);
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_FRAMENUMBER, frame_number);
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_CIPHERKEY, cipher_key);
+    append_metadata_u32(metadata, BOXING_METADATA_TYPE_DATASIZE, size);
+
+    boxing_metadata_item * content_type = boxing_metadata_item_create(BOXING_METADATA_TYPE_CONTENTTYPE);
+    ((boxing_metadata_item_content_type *)content_type)->value = BOXING_METADATA_CONTENT_TYPES_DATA;
+    boxing_metadata_list_append_item(metadata, content_type);
+
+    dcrc64 * crc = boxing_math_crc64_create_def();
+    boxing_metadata_item * data_crc = boxing_metadata_item_create(BOXING_METADATA_TYPE_DATACRC);
+    ((boxing_metadata_item_data_crc *)data_crc)->value = boxing_math_crc64_calc_crc(crc, (*source)->buffer, size);
+    boxing_metadata_list_append_item(metadata, data_crc);
+    boxing_math_crc64_free(crc);
+
+    for (unsigned int i = 0; i < data_codec->encode_codecs.size; i++)
+    {
+        boxing_codec * codec = GVECTORN(&data_codec->encode_codecs, boxing_codec *, i);
+        if (boxing_string_equal(codec->name, "Cipher"))
+        {
+            ((boxing_codec_cipher *)codec)->key = cipher_key;
+        }
+    }
+
+    gvector * data = gvector_create_char(size, 0);
+    boxing_memory_copy(data->buffer, (*source)->buffer, size);
+    boxing_codecdispatcher_encode(data_codec, data);
+    BOXING_VIRTUAL2p2(frame, container, set_data, (char *)data->buffer, (int)data->size);
+    set_frame_metadata(frame, metadata_codec, metadata);
+
+    boxing_pointi frame_size = frame->size(frame);
+    boxing_image8 * image = boxing_image8_create(frame_size.x, frame_size.y);
+    boxing_paintdevice * device = boxing_image8paintdevice_create(image);
+    boxing_painter painter;
+    boxing_painter_init(&painter, device);
+    frame->render(frame, &painter);
+    device->free(device);
+
+    // The frame is painted with symbol levels, map them to gray levels
+    for (size_t i = 0; i < (size_t)image->width * image->height; i++)
+    {
+        image->data[i] = (boxing_image8_pixel)(image->data[i] * 255 / (levels - 1));
+    }
+
+    gvector_free(data);
+    boxing_metadata_list_free(metadata);
+    boxing_codecdispatcher_free(metadata_codec);
+    boxing_codecdispatcher_free(data_codec);
+    boxing_generic_frame_factory_free(frame);
+    return image;
+}
+
+
+static int on_all_complete(void * user, int * res, boxing_stats_decode * stats)
+{
+    BOXING_UNUSED_PARAMETER(res);
+    ((unboxed_frame *)user)->stats = *stats;
+    return BOXING_PROCESS_CALLBACK_OK;
+}
+
+
+static boxing_unboxer * create_unboxer(boxing_unboxer_parameters * parameters, boxing_config * config, int pipeline_queue_depth)
+{
+    boxing_unboxer_parameters_init(parameters);
+    parameters->format = config;
+    parameters->is_raw = DTRUE;
+    parameters->pipeline_queue_depth = pipeline_queue_depth;
+    parameters->on_all_complete = on_all_complete;
+    return boxing_unboxer_create(parameters);
+}
+
+
+static void init_unboxed_frames(unboxed_frame * unboxed, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        unboxed[i].data = gvector_create_char(0, 0);
+        unboxed[i].metadata = boxing_metadata_list_create();
+        unboxed[i].extract_result = -1;
+        unboxed[i].result = -1;
+        boxing_memory_clear(&unboxed[i].stats, sizeof(boxing_stats_decode));
+    }
+}
+
+
+static void free_unboxed_frames(unboxed_frame * unboxed, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        gvector_free(unboxed[i].data);
+        boxing_metadata_list_free(unboxed[i].metadata);
+    }
+}
+
+
+// Unboxes the frames one by one, the unboxer sharpens the image in place so
+// every run gets a copy
+static void unbox_frames(boxing_unboxer * unboxer, boxing_image8 ** images, unboxed_frame * unboxed, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        boxing_image8 * image = boxing_image8_copy(images[i]);
+        unboxed[i].result = boxing_unboxer_unbox(unboxed[i].data, unboxed[i].metadata, image, unboxer, &unboxed[i].extract_result, &unboxed[i]);
+        boxing_image8_free(image);
+    }
+}
+
+
+static int unbox_frames_batch(boxing_unboxer * unboxer, boxing_image8 ** images, unboxed_frame * unboxed, int count, int worker_count)
+{
+    boxing_unboxer_frame * frames = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(boxing_unboxer_frame, count);
+    for (int i = 0; i < count; i++)
+    {
+        frames[i].image = boxing_image8_copy(images[i]);
+        frames[i].data = unboxed[i].data;
+        frames[i].metadata = unboxed[i].metadata;
+        frames[i].user_data = &unboxed[i];
+    }
+
+    const int result = boxing_unboxer_unbox_batch(frames, count, unboxer, worker_count);
+
+    for (int i = 0; i < count; i++)
+    {
+        unboxed[i].extract_result = frames[i].extract_result;
+        unboxed[i].result = frames[i].result;
+        boxing_image8_free(frames[i].image);
+    }
+    boxing_memory_free(frames);
+    return result;
+}
+
+
+static DBOOL data_equal(const gvector * a, const gvector * b)
+{
+    if (a->size != b->size)
+    {
+        return DFALSE;
+    }
+    for (unsigned int i = 0; i < a->size; i++)
+    {
+        if (GVECTORN8(a, i) != GVECTORN8(b, i))
+        {
+            return DFALSE;
+        }
+    }
+    return DTRUE;
+}
+
+
+static DBOOL unboxed_equal(const unboxed_frame * a, const unboxed_frame * b)
+{
+    return a->result == b->result &&
+        a->extract_result == b->extract_result &&
+        data_equal(a->data, b->data) &&
+        g_hash_table_size(a->metadata) == g_hash_table_size(b->metadata) &&
+        a->stats.resolved_errors == b->stats.resolved_errors &&
+        a->stats.unresolved_errors == b->stats.unresolved_errors &&
+        a->stats.fec_accumulated_amount == b->stats.fec_accumulated_amount &&
+        a->stats.fec_accumulated_weight == b->stats.fec_accumulated_weight &&
+        a->stats.decoded_codewords == b->stats.decoded_codewords &&
+        a->stats.decode_iterations == b->stats.decode_iterations &&
+        a->stats.max_decode_iterations == b->stats.max_decode_iterations;
+}
+
+
+// Tests for file boxing/unboxer.h
+
+//
+//  FUNCTIONS Unboxer Tests
+//
+
+// Batch unboxing, with and without pipelined decoding, gives the same data,
+// metadata and statistics as unboxing the frames one by one
+BOXING_START_TEST(boxing_unboxer_unbox_batch_test1)
+{
+    srand(1);
+    boxing_config * config = boxing_get_boxing_config(UNBOXER_FORMAT);
+    BOXING_ASSERT(config != NULL);
+    // Every frame decodes on its own
+    boxing_config_set_property_uint(config, "MultiFrameFormat", "DataStripeSize", 1);
+
+    boxing_image8 * images[UNBOXER_FRAME_COUNT];
+    gvector * sources[UNBOXER_FRAME_COUNT];
+    for (int i = 0; i < UNBOXER_FRAME_COUNT; i++)
+    {
+        images[i] = render_frame(config, i, 1234 + i, &sources[i]);
+        // A few damaged pixels give the error correction some work
+        for (int j = 0; j < 200; j++)
+        {
+            images[i]->data[rand() % (images[i]->width * images[i]->height)] ^= 0xff;
+        }
+    }
+
+    boxing_unboxer_parameters parameters;
+    boxing_unboxer * unboxer = create_unboxer(&parameters, config, 0);
+    boxing_unboxer_parameters pipelined_parameters;
+    boxing_unboxer * pipelined_unboxer = create_unboxer(&pipelined_parameters, config, 2);
+
+    unboxed_frame expected[UNBOXER_FRAME_COUNT];
+    unboxed_frame batch[UNBOXER_FRAME_COUNT];
+    unboxed_frame pipelined[UNBOXER_FRAME_COUNT];
+    init_unboxed_frames(expected, UNBOXER_FRAME_COUNT);
+    init_unboxed_frames(batch, UNBOXER_FRAME_COUNT);
+    init_unboxed_frames(pipelined, UNBOXER_FRAME_COUNT);
+
+    unbox_frames(unboxer, images, expected, UNBOXER_FRAME_COUNT);
+    BOXING_ASSERT(unbox_frames_batch(unboxer, images, batch, UNBOXER_FRAME_COUNT, 2) == BOXING_UNBOXER_OK);
+    BOXING_ASSERT(unbox_frames_batch(pipelined_unboxer, images, pipelined, UNBOXER_FRAME_COUNT, 2) == BOXING_UNBOXER_OK);
+
+    for (int i = 0; i < UNBOXER_FRAME_COUNT; i++)
+    {
+        BOXING_ASSERT(expected[i].result == BOXING_UNBOXER_OK);
+        BOXING_ASSERT(data_equal(expected[i].data, sources[i]) == DTRUE);
+        BOXING_ASSERT(expected[i].stats.resolved_errors > 0);
+        BOXING_ASSERT(unboxed_equal(&batch[i], &expected[i]) == DTRUE);
+        BOXING_ASSERT(unboxed_equal(&pipelined[i], &expected[i]) == DTRUE);
+    }
+
+    free_unboxed_frames(expected, UNBOXER_FRAME_COUNT);
+    free_unboxed_frames(batch, UNBOXER_FRAME_COUNT);
+    free_unboxed_frames(pipelined, UNBOXER_FRAME_COUNT);
+    boxing_unboxer_free(pipelined_unboxer);
+    boxing_unboxer_parameters_free(&pipelined_parameters);
+    boxing_unboxer_free(unboxer);
+    boxing_unboxer_parameters_free(&parameters);
+    for (int i = 0; i < UNBOXER_FRAME_COUNT; i++)
+    {
+        boxing_image8_free(images[i]);
+        gvector_free(sources[i]);
+    }
+    boxing_config_free(config);
+}
+END_TEST
+
+
+// The unboxer decodes every frame with a copy of the cipher codec keyed from
+// the frame metadata, the cached keystream must follow the key of each frame
+BOXING_START_TEST(boxing_unboxer_unbox_cipher_key_test1)
+{
+    srand(2);
+    boxing_config * config = boxing_get_boxing_config(UNBOXER_FORMAT);
+    BOXING_ASSERT(config != NULL);
+    boxing_config_set_property_uint(config, "MultiFrameFormat", "DataStripeSize", 1);
+
+    const boxing_uint32 keys[UNBOXER_FRAME_COUNT] = { 1234, 0, 1234 };
+    boxing_image8 * images[UNBOXER_FRAME_COUNT];
+    gvector * sources[UNBOXER_FRAME_COUNT];
+    for (int i = 0; i < UNBOXER_FRAME_COUNT; i++)
+    {
+        images[i] = render_frame(config, i, keys[i], &sources[i]);
+    }
+
+    boxing_unboxer_parameters parameters;
+    boxing_unboxer * unboxer = create_unboxer(&parameters, config, 0);
+
+    unboxed_frame unboxed[UNBOXER_FRAME_COUNT];
+    init_unboxed_frames(unboxed, UNBOXER_FRAME_COUNT);
+    unbox_frames(unboxer, images, unboxed, UNBOXER_FRAME_COUNT);
+
+    for (int i = 0; i < UNBOXER_FRAME_COUNT; i++)
+    {
+        BOXING_ASSERT(unboxed[i].result == BOXING_UNBOXER_OK);
+        BOXING_ASSERT(data_equal(unboxed[i].data, sources[i]) == DTRUE);
+    }
+
+    free_unboxed_frames(unboxed, UNBOXER_FRAME_COUNT);
+    boxing_unboxer_free(unboxer);
+    boxing_unboxer_parameters_free(&parameters);
+    for (int i = 0; i < UNBOXER_FRAME_COUNT; i++)
+    {
+        boxing_image8_free(images[i]);
+        gvector_free(sources[i]);
+    }
+    boxing_config_free(config);
+}
+END_TEST
+
+
+Suite * unboxer_test(void)
+{
+    TCase * tc_unboxer_functions_tests = tcase_create("unboxer_functions_tests");
+    tcase_set_timeout(tc_unboxer_functions_tests, 60);
+    tcase_add_test(tc_unboxer_functions_tests, boxing_unboxer_unbox_batch_test1);
+    tcase_add_test(tc_unboxer_functions_tests, boxing_unboxer_unbox_cipher_key_test1);
+
+    Suite * s = suite_create("unboxer_test_util");
+    suite_add_tcase(s, tc_unboxer_functions_tests);
+    return s;
+}
@@ -1,17 +1,18 @@
 #include "gvector.h"
 #include <string.h> // memcpy
 #include "boxing/log.h"
+#include "boxing/platform/memory.h"
 
 gvector * gvector_create(size_t item_size, size_t items_num)
 {
-    gvector * new_vector = malloc(sizeof(gvector));
+    gvector * new_vector = boxing_memory_allocate(sizeof(gvector));
     gvector_create_inplace(new_vector, item_size, items_num);
     return new_vector;
 }
 
 gvector * gvector_create_char(size_t items_num, char value)
 {
-    gvector * new_vector = malloc(sizeof(gvector));
+    gvector * new_vector = boxing_memory_allocate(sizeof(gvector));
     gvector_create_inplace(new_vector, 1, items_num);
     memset(new_vector->buffer, value, new_vector->size);
     return new_vector;
@@ -19,14 +20,14 @@ gvector * gvector_create_char(size_t items_num, char value)
 
 gvector * gvector_create_char_no_init(size_t items_num)
 {
-    gvector * new_vector = malloc(sizeof(gvector));
+    gvector * new_vector = boxing_memory_allocate(sizeof(gvector));
     gvector_create_inplace(new_vector, 1, items_num);
     return new_vector;
 }
 
 gvector * gvector_create_pointers(size_t items_num)
 {
-    gvector * new_vector = malloc(sizeof(gvector));
+    gvector * new_vector = boxing_memory_allocate(sizeof(gvector));
     gvector_create_inplace(new_vector, sizeof(void *), items_num);
     new_vector->element_free = free;
     return new_vector;
@@ -43,8 +44,8 @@ void gvector_free(gvector * vector)
                 vector->element_free(GVECTORN(vector, void*, i));
             }
         }
-        free(vector->buffer);
-        free(vector);
+        boxing_memory_free(vector->buffer);
+        boxing_memory_free(vector);
     }
 }
 
@@ -57,14 +58,14 @@ void gvector_create_inplace(gvector * vector, size_t item_size, size_t items_num
     vector->element_free = NULL;
     vector->size = items_num;
     vector->item_size  = item_size;
-    vector->buffer = malloc(items_num * item_size);
+    vector->buffer = boxing_memory_allocate(items_num * item_size);
     DFATAL(vector->buffer, "Out of memory");
 }
 
 void gvector_append(gvector * vector, unsigned int items_num)
 {
     size_t new_size = vector->item_size * (vector->size + items_num);
-	vector->buffer = realloc(vector->buffer, new_size);
+	vector->buffer = boxing_memory_reallocate(vector->buffer, new_size);
     DFATAL(vector->buffer || items_num == 0, "Out of memory");
     vector->size += items_num;
 }
@@ -91,7 +92,7 @@ void gvector_append_data_at(gvector * vector, unsigned int items_num, void * new
 
 void gvector_resize(gvector * vector, unsigned int items_num)
 {
-    vector->buffer = realloc(vector->buffer, vector->item_size * items_num);
+    vector->buffer = boxing_memory_reallocate(vector->buffer, vector->item_size * items_num);
     if(items_num)
     {
 	DFATAL(vector->buffer, "Out of memory");
@@ -116,9 +117,9 @@ void gvector_swap(gvector * a, gvector * b)
 
 void gvector_replace(gvector * to, gvector * from)
 {
-    free(to->buffer);
+    boxing_memory_free(to->buffer);
     to->buffer = from->buffer;
     to->size = from->size;
     from->buffer = NULL;
-    free(from);
+    boxing_memory_free(from);
 }
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Copyright (c) 2026 Piql AS
+#
+# Writes the C source of the tables of real random numbers used by rand.c
+# with RAND_TABLE defined. The words are read big endian, like the original
+# RAND_FILE reader of rand.c, so the codes are those of the LDPC package.
+#
+# Usage: mkrandtable.sh randfile > randtable.c
+
+set -e
+
+if [ $# -ne 1 ] || [ ! -r "$1" ]; then
+    echo "Usage: $0 randfile" >&2
+    exit 1
+fi
+
+echo "/* Generated by mkrandtable.sh from $(basename "$1"), do not edit. */"
+echo
+echo '#include "rand.h"'
+echo
+echo "const unsigned int rand_table[N_tables][Table_size] ="
+echo "{"
+od -An -v -tx1 "$1" | awk '
+    BEGIN { tables = 5; table_size = 5000; words = 0; bytes = 0; word = "" }
+    {
+        for (i = 1; i <= NF && words < tables * table_size; i++)
+        {
+            word = word $i
+            if (++bytes % 4 != 0)
+            {
+                continue
+            }
+            if (words % table_size == 0)
+            {
+                printf "    {\n"
+            }
+            line = line (words % 8 == 0 ? "        " : " ") "0x" word "u,"
+            word = ""
+            words++
+            if (words % 8 == 0 || words % table_size == 0)
+            {
+                print line
+                line = ""
+            }
+            if (words % table_size == 0)
+            {
+                printf "    },\n"
+            }
+        }
+    }
+    END {
+        if (words < tables * table_size)
+        {
+            print "Too few random numbers, " tables * table_size " words are needed" > "/dev/stderr"
+            exit 1
+        }
+    }'
+echo "};"
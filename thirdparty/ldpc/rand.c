@@ -60,12 +60,21 @@ static long int this_nrand48(unsigned short int[3]);
    for extra insurance.  These are employed in the form of five tables
    of 5000 32-bit integers.
 
-   The file must be located at the path given by RAND_FILE, which should
-   be defined on the "cc" command line. */
-
-#define Table_size 5000			/* Number of words in each table */
+   With RAND_TABLE defined the tables are the array rand_table, generated
+   from the file by mkrandtable.sh and linked into the library.  Without
+   it there are no tables, rand_tables returns NULL and no codes can be
+   constructed.  The file is no longer read at run time, so the library
+   does not depend on the working directory.  rand_use_tables replaces
+   the tables, for testing only.  (Modified for the boxing library.) */
+
+#if defined(RAND_TABLE)
+extern const unsigned int rand_table[N_tables][Table_size];
+#define BUILT_IN_TABLES rand_table
+#else
+#define BUILT_IN_TABLES NULL
+#endif
 
-static int rn[N_tables][Table_size];	/* Random number tables */
+static const unsigned int (*rn)[Table_size];	/* Random number tables */
 
 
 /* STATE OF RANDOM NUMBER GENERATOR. */
@@ -84,48 +93,49 @@ static rand_state *state;		/* Pointer to current state */
 
 static void initialize(void)
 {
-    int i, j, k, w;
-    char b;
-    FILE *f;
-
     if (!initialized)
     {
-        f = fopen(RAND_FILE, "rb");
-
-        if (f == NULL)
-        {
-            fprintf(stderr, "Can't open file of random numbers (%s)\n", RAND_FILE);
-            exit(1);
-        }
-
-        for (i = 0; i < N_tables; i++)
-        {
-            for (j = 0; j < Table_size; j++)
-            {
-                w = 0;
-                for (k = 0; k < 4; k++)
-                {
-                    if (fread(&b, 1, 1, f) != 1)
-                    {
-                        fprintf(stderr, "Error reading file of random numbers (%s)\n",
-                            RAND_FILE);
-                        exit(1);
-                    }
-                    w = (w << 8) | (b & 0xff);
-                }
-                rn[i][j] = w;
-            }
-        }
+        rn = BUILT_IN_TABLES;
 
         state = &state0;
 
         initialized = 1;
 
-        rand_seed(1);
+        if (rn != NULL) rand_seed(1);
     }
 }
 
 
+/**
+ * @brief RETURN THE TABLES OF REAL RANDOM NUMBERS IN USE.  The generators
+ * below must not be used when there are none.
+ *
+ * @return N_tables tables of Table_size words, one after the other, or NULL
+ */
+
+const unsigned int *rand_tables(void)
+{
+    if (!initialized) initialize();
+
+    return rn != NULL ? rn[0] : NULL;
+}
+
+
+/**
+ * @brief REPLACE THE TABLES OF REAL RANDOM NUMBERS.  For testing only, the
+ * tables change every constructed code.  Takes effect at the next rand_seed.
+ *
+ * @param tables    N_tables tables of Table_size words, NULL for the built in tables
+ */
+
+void rand_use_tables(const unsigned int *tables)
+{
+    if (!initialized) initialize();
+
+    rn = tables != NULL ? (const unsigned int (*)[Table_size])tables : BUILT_IN_TABLES;
+}
+
+
 /**
  * @brief SET CURRENT STATE ACCORDING TO SEED.
  *
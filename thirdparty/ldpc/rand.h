@@ -19,6 +19,7 @@
 /* STATE OF RANDOM NUMBER GENERATOR. */
 
 #define N_tables 5		/* Number of tables of real random numbers */
+#define Table_size 5000		/* Number of words in each table */
 
 typedef struct
 {
@@ -37,6 +38,9 @@ rand_state *rand_get_state(void);  /* Return pointer to current state */
 
 int rand_word(void);		/* Generate random 31-bit positive integer */
 
+const unsigned int *rand_tables(void); /* Tables of real random numbers in use */
+void rand_use_tables(const unsigned int *tables); /* Replace the tables, for testing */
+
 
 /* GENERATORS FOR VARIOUS DISTRIBUTIONS. */
 
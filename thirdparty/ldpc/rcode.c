@@ -647,12 +647,20 @@ generator_matrix * ldpc_generator_make_dense_mixed(mod2sparse * H, gen_make_meth
     if (method == gen_dense)
     {
         mod2dense_multiply(AI, B, gen_matrix->G);
+        mod2dense_free(AI);
     }
     else if (method == gen_mixed)
     {
+        mod2dense_free(gen_matrix->G);
         gen_matrix->G = AI;
     }
 
+    mod2dense_free(DH);
+    mod2dense_free(A);
+    mod2dense_free(A2);
+    mod2dense_free(B);
+    boxing_memory_free(rows_inv);
+
     /* Compute and print number of 1s. */
 
     print_generator_check_info(gen_matrix);
@@ -41,12 +41,23 @@
 #include "galois_field.h"
 #include "boxing/platform/types.h"
 #include "boxing/platform/memory.h"
+#include "boxing/platform/cpu.h"
+
+#if defined (BOXING_CPU_X86)
+#   include <immintrin.h>
+#elif defined (BOXING_CPU_ARM)
+#   include <arm_neon.h>
+#endif
 
 //  DEFINES
 //
 
+// Maximum number of codewords processed together by a syndrome kernel
+#define RS_SYNDROME_MAX_LANES 32
+
 typedef void (*rs_encode_impl)(rs_codec *rs, gvector * data, gvector * data_encode);
-typedef void(*rs_decode_impl)(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+typedef void(*rs_decode_impl)(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+typedef void (*rs_syndrome_kernel)(const uint8_t *tables, uint32_t parity_size, const uint8_t *symbols, uint32_t codeword_size, uint8_t *syndromes);
 
 struct rs_codec_s
 {
@@ -56,6 +67,23 @@ struct rs_codec_s
     int parity_size;
     rs_encode_impl encode;
     rs_decode_impl decode;
+    uint8_t * syndrome_tables;
+    rs_syndrome_kernel syndrome_kernel;
+    uint32_t syndrome_lanes;
+};
+
+// Buffers used while decoding, allocated once and reused for all blocks
+struct rs_decode_context_s
+{
+    uint32_t * codeword;
+    uint32_t * syndrome_bytes;
+    uint32_t * decoded_codeword;
+    uint32_t * erased_codeword;
+    uint32_t * erasure_locations;
+    uint8_t *  symbols;
+    uint8_t *  syndromes;
+    uint32_t   block_size;
+    uint32_t   parity_size;
 };
 
 //  CONSTANTS
@@ -65,15 +93,23 @@ struct rs_codec_s
 //
 
 static void encode_8(rs_codec *rs, gvector * data, gvector * data_encode);
-static void decode_8(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+static void decode_8(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
 static void encode_16(rs_codec *rs, gvector * data, gvector * data_encode);
-static void decode_16(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+static void decode_16(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
 
 static void rs_generate_polynomial(rs_codec * rs);
+static void rs_generate_syndrome_tables(rs_codec * rs);
+static void rs_select_syndrome_kernel(rs_codec * rs);
 static void compute_modified_omega(rs_codec * rs, uint32_t *error_locator_polynomial, uint32_t *error_evaluator_polynomial, uint32_t *syndrome_bytes);
-static void modified_berlekamp_massey(rs_codec *rs, uint32_t *error_locator_polynomial, uint32_t *error_evaluator_polynomial, uint32_t *syndrome_bytes);
+static void modified_berlekamp_massey(rs_codec *rs, uint32_t *error_locator_polynomial, uint32_t *error_evaluator_polynomial, uint32_t *syndrome_bytes,
+                                      const uint32_t *erasure_locations, uint32_t erasures_number);
 static uint32_t find_roots(rs_codec *rs, uint32_t *error_locator_polynomial, uint32_t *error_locations);
-static uint32_t correct_errors_erasures(rs_codec *rs, uint32_t *codeword, uint32_t codeword_size, uint32_t *syndrome_bytes, unsigned int *fatal_errors, unsigned int *resolved_errors);
+static uint32_t correct_errors_erasures(rs_codec *rs, uint32_t *codeword, uint32_t codeword_size, uint32_t *syndrome_bytes,
+                                        const uint32_t *erasure_locations, uint32_t erasures_number, unsigned int *fatal_errors, unsigned int *resolved_errors);
+static DBOOL calculate_syndrome(rs_codec *rs, const uint32_t *codeword, uint32_t codeword_size, uint32_t *syndrome_bytes);
+static uint32_t decode_block(rs_codec *rs, rs_decode_context *context, uint32_t *codeword, uint32_t *syndrome_bytes, const uint8_t *erasures,
+                             unsigned int *resolved_errors, unsigned int *fatal_errors, DBOOL *uncorrectable);
+static void syndrome_scalar(const uint8_t *tables, uint32_t parity_size, const uint8_t *symbols, uint32_t codeword_size, uint8_t *syndromes);
 
 // PUBLIC RS FUNCTIONS
 //
@@ -82,6 +118,8 @@ rs_codec* rs_create(int message_size, int parity_size, uint32_t prime_plonomial)
 {
     rs_codec* rs = BOXING_MEMORY_ALLOCATE_TYPE(rs_codec);
     
+    rs->generator_polynomial = NULL;
+    rs->syndrome_tables = NULL;
     rs->galois_field = gf_create(prime_plonomial);
     if (rs->galois_field->alphabet_size < (1 << 9))
     {
@@ -102,6 +140,8 @@ rs_codec* rs_create(int message_size, int parity_size, uint32_t prime_plonomial)
     rs->parity_size = parity_size;
 
     rs_generate_polynomial(rs);
+    rs_generate_syndrome_tables(rs);
+    rs_select_syndrome_kernel(rs);
     return rs;
 }
 
@@ -109,9 +149,47 @@ void rs_free(rs_codec *rs)
 {
     gf_free(rs->galois_field);
     boxing_memory_free(rs->generator_polynomial);
+    boxing_memory_free(rs->syndrome_tables);
     boxing_memory_free(rs);
 }
 
+/*
+* @brief creates the buffers used to decode data with the given codec
+* A context can be reused for any number of decode calls, but only by one thread at a time.
+*/
+rs_decode_context* rs_decode_context_create(rs_codec *rs)
+{
+    uint32_t block_size = rs->message_size + rs->parity_size;
+    rs_decode_context* context = BOXING_MEMORY_ALLOCATE_TYPE(rs_decode_context);
+
+    context->block_size = block_size;
+    context->parity_size = rs->parity_size;
+    context->codeword = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, block_size);
+    context->syndrome_bytes = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, rs->parity_size);
+    context->decoded_codeword = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, block_size);
+    context->erased_codeword = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, block_size);
+    context->erasure_locations = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, block_size + 1);
+    context->symbols = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint8_t, block_size * RS_SYNDROME_MAX_LANES);
+    context->syndromes = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint8_t, rs->parity_size * RS_SYNDROME_MAX_LANES);
+    memset(context->symbols, 0, block_size * RS_SYNDROME_MAX_LANES);
+    return context;
+}
+
+void rs_decode_context_free(rs_decode_context *context)
+{
+    if (!context)
+        return;
+
+    boxing_memory_free(context->codeword);
+    boxing_memory_free(context->syndrome_bytes);
+    boxing_memory_free(context->decoded_codeword);
+    boxing_memory_free(context->erased_codeword);
+    boxing_memory_free(context->erasure_locations);
+    boxing_memory_free(context->symbols);
+    boxing_memory_free(context->syndromes);
+    boxing_memory_free(context);
+}
+
 void rs_encode(rs_codec *rs, gvector * data, gvector * data_encode)
 {
     rs->encode(rs, data, data_encode);
@@ -183,97 +261,149 @@ static void encode_16(rs_codec *rs, gvector * data, gvector * data_encode)
     }
 }
 
-void rs_decode(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
+/*
+* @brief decodes data
+* @param context  decode buffers created with rs_decode_context_create, when NULL temporary buffers are used
+*/
+void rs_decode(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
 {
-    rs->decode(rs, data, data_decode, resolved_errors, fatal_errors, max_errors_per_block);
+    rs_decode_erasures(rs, context, data, data_decode, NULL, NULL, resolved_errors, fatal_errors, max_errors_per_block);
 }
 
-static void decode_8(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
+/*
+* @brief decodes data using erasure information
+* @param erasures         one byte per input symbol, 0 for reliable symbols and higher values for
+*                         less reliable symbols. The least reliable symbols of a block that can not be
+*                         corrected from errors alone are decoded as erasures.
+* @param erasures_decode  one byte per decoded symbol, set to 0xff for symbols of blocks that could not
+*                         be corrected and 0 otherwise. May be NULL.
+*/
+void rs_decode_erasures(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
 {
-    int parity_size = rs->parity_size;
-    int message_size = rs->message_size;
+    if (context)
+    {
+        rs->decode(rs, context, data, data_decode, erasures, erasures_decode, resolved_errors, fatal_errors, max_errors_per_block);
+        return;
+    }
+
+    context = rs_decode_context_create(rs);
+    rs->decode(rs, context, data, data_decode, erasures, erasures_decode, resolved_errors, fatal_errors, max_errors_per_block);
+    rs_decode_context_free(context);
+}
+
+static void decode_8(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
+{
+    uint32_t parity_size = rs->parity_size;
+    uint32_t message_size = rs->message_size;
     uint32_t block_size = message_size + parity_size;
+    uint32_t block_count = (uint32_t)data->size / block_size;
+    uint32_t lanes = rs->syndrome_lanes;
     uint8_t * data_pointer = (uint8_t *)data->buffer;
     uint8_t * data_decode_pointer = (uint8_t *)data_decode->buffer;
-    galois_field *gf = rs->galois_field;
+    const uint8_t * erasures_pointer = (erasures && erasures->size >= data->size) ? (const uint8_t *)erasures->buffer : NULL;
+    uint8_t * erasures_decode_pointer = erasures_decode ? (uint8_t *)erasures_decode->buffer : NULL;
+    uint32_t * codeword = context->codeword;
+    uint32_t * syndrome_bytes = context->syndrome_bytes;
 
-    for (int position = 0, position_next = 0; position < (int)data->size; position += (block_size), position_next += message_size)
+    for (uint32_t first_block = 0; first_block < block_count; first_block += lanes)
     {
-        uint32_t * codeword = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, block_size);
-        uint32_t * syndrome_bytes = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, parity_size);
-        for (uint32_t i = 0; i < (block_size); i++)
-        {
-            codeword[i] = (uint32_t)data_pointer[i + position];
-        }
+        uint32_t group_size = (block_count - first_block < lanes) ? block_count - first_block : lanes;
 
-        DBOOL has_errors = DFALSE;
-        for (uint32_t j = 1; j <= (uint32_t)parity_size; j++)
+        // The syndromes of a group of codewords are calculated together, one codeword in each lane
+        const uint8_t * symbols = data_pointer + first_block * block_size;
+        if (lanes > 1)
         {
-            uint32_t sum = 0;
-            for (uint32_t i = 0; i < (uint32_t)(block_size); i++)
+            for (uint32_t lane = 0; lane < group_size; lane++)
             {
-                sum = codeword[i] ^ gf_roots_summ(gf, j, sum);
+                const uint8_t * block = symbols + lane * block_size;
+                for (uint32_t i = 0; i < block_size; i++)
+                {
+                    context->symbols[i * lanes + lane] = block[i];
+                }
             }
-            syndrome_bytes[j - 1] = sum;
-            has_errors = has_errors || sum != 0;
+            symbols = context->symbols;
         }
+        rs->syndrome_kernel(rs->syndrome_tables, parity_size, symbols, block_size, context->syndromes);
 
-        if (has_errors)
+        for (uint32_t lane = 0; lane < group_size; lane++)
         {
-            uint32_t errors_number = correct_errors_erasures(rs, codeword, block_size, syndrome_bytes, fatal_errors, resolved_errors);
+            uint32_t position = (first_block + lane) * block_size;
+            uint32_t position_next = (first_block + lane) * message_size;
+
+            DBOOL has_errors = DFALSE;
+            for (uint32_t j = 0; j < parity_size; j++)
+            {
+                syndrome_bytes[j] = context->syndromes[j * lanes + lane];
+                has_errors |= syndrome_bytes[j] != 0;
+            }
+
+            // Error free codewords are by far the most common, they are copied without decoding
+            if (!has_errors)
+            {
+                memcpy(data_decode_pointer + position_next, data_pointer + position, message_size);
+                if (erasures_decode_pointer)
+                {
+                    memset(erasures_decode_pointer + position_next, 0, message_size);
+                }
+                continue;
+            }
+
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                codeword[i] = (uint32_t)data_pointer[i + position];
+            }
+
+            DBOOL uncorrectable;
+            uint32_t errors_number = decode_block(rs, context, codeword, syndrome_bytes, erasures_pointer ? erasures_pointer + position : NULL,
+                                                  resolved_errors, fatal_errors, &uncorrectable);
             if (*max_errors_per_block < (int)errors_number)
             {
                 *max_errors_per_block = errors_number;
             }
-        }
 
-        for (int32_t i = 0; i < message_size; i++)
-        {
-            data_decode_pointer[i + position_next] = (uint8_t)codeword[i];
-        }
+            for (uint32_t i = 0; i < message_size; i++)
+            {
+                data_decode_pointer[i + position_next] = (uint8_t)codeword[i];
+            }
 
-        boxing_memory_free(codeword);
-        boxing_memory_free(syndrome_bytes);
+            if (erasures_decode_pointer)
+            {
+                memset(erasures_decode_pointer + position_next, uncorrectable ? 0xff : 0, message_size);
+            }
+        }
     }
 }
 
-static void decode_16(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
+static void decode_16(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block)
 {
     int parity_size = rs->parity_size;
     int message_size = rs->message_size;
     uint32_t block_size = message_size + parity_size;
     uint16_t * data_pointer = (uint16_t *)data->buffer;
     uint16_t * data_decode_pointer = (uint16_t *)data_decode->buffer;
-    galois_field *gf = rs->galois_field;
+    const uint8_t * erasures_pointer = (erasures && erasures->size >= data->size) ? (const uint8_t *)erasures->buffer : NULL;
+    uint8_t * erasures_decode_pointer = erasures_decode ? (uint8_t *)erasures_decode->buffer : NULL;
+
+    uint32_t * codeword = context->codeword;
+    uint32_t * syndrome_bytes = context->syndrome_bytes;
 
     for (int position = 0, position_next = 0; position < (int)data->size; position += (block_size), position_next += message_size)
     {
-        uint32_t * codeword = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, block_size);
-        uint32_t * syndrome_bytes = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint32_t, parity_size);
         for (uint32_t i = 0; i < (block_size); i++)
         {
             codeword[i] = (uint32_t)data_pointer[i + position];
         }
 
-        DBOOL has_errors = DFALSE;
-        for (uint32_t j = 1; j <= (uint32_t)parity_size; j++)
+        DBOOL uncorrectable = DFALSE;
+        uint32_t errors_number = 0;
+        if (calculate_syndrome(rs, codeword, block_size, syndrome_bytes))
         {
-            uint32_t sum = 0;
-            for (uint32_t i = 0; i < (uint32_t)(block_size); i++)
-            {
-                sum = codeword[i] ^ gf_roots_summ(gf, j, sum);
-            }
-            syndrome_bytes[j - 1] = sum;
-            has_errors = has_errors || sum != 0;
+            errors_number = decode_block(rs, context, codeword, syndrome_bytes, erasures_pointer ? erasures_pointer + position : NULL,
+                                         resolved_errors, fatal_errors, &uncorrectable);
         }
-
-        if (has_errors)
+        if (*max_errors_per_block < (int)errors_number)
         {
-            uint32_t errors_number = correct_errors_erasures(rs, codeword, block_size, syndrome_bytes, fatal_errors, resolved_errors);
-            if (*max_errors_per_block < (int)errors_number)
-            {
-                *max_errors_per_block = errors_number;
-            }
+            *max_errors_per_block = errors_number;
         }
 
         for (int32_t i = 0; i < message_size; i++)
@@ -281,14 +411,143 @@ static void decode_16(rs_codec *rs, gvector * data, gvector * data_decode, unsig
             data_decode_pointer[i + position_next] = (uint16_t)codeword[i];
         }
 
-        boxing_memory_free(codeword);
-        boxing_memory_free(syndrome_bytes);
+        if (erasures_decode_pointer)
+        {
+            memset(erasures_decode_pointer + position_next, uncorrectable ? 0xff : 0, message_size);
+        }
     }
 }
 
 // PRIVATE RS FUNCTIONS
 //
 
+static DBOOL calculate_syndrome(rs_codec *rs, const uint32_t *codeword, uint32_t codeword_size, uint32_t *syndrome_bytes)
+{
+    galois_field *gf = rs->galois_field;
+    DBOOL has_errors = DFALSE;
+    if (rs->syndrome_tables)
+    {
+        for (uint32_t j = 0; j < (uint32_t)rs->parity_size; j++)
+        {
+            const uint8_t * low = rs->syndrome_tables + j * 32;
+            const uint8_t * high = low + 16;
+            uint8_t sum = 0;
+            for (uint32_t i = 0; i < codeword_size; i++)
+            {
+                sum = low[sum & 0x0f] ^ high[sum >> 4] ^ (uint8_t)codeword[i];
+            }
+            syndrome_bytes[j] = sum;
+            has_errors = has_errors || sum != 0;
+        }
+        return has_errors;
+    }
+
+    for (uint32_t j = 1; j <= (uint32_t)rs->parity_size; j++)
+    {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < codeword_size; i++)
+        {
+            sum = codeword[i] ^ gf_roots_summ(gf, j, sum);
+        }
+        syndrome_bytes[j - 1] = sum;
+        has_errors = has_errors || sum != 0;
+    }
+    return has_errors;
+}
+
+/*
+* @brief decodes a single codeword
+* The codeword is first decoded from errors alone. If that fails and erasure information is available,
+* decoding is retried with the least reliable symbols marked as erasures. Each erasure costs one parity
+* symbol instead of two, so several attempts are made with a decreasing number of erasures. When erasures
+* are given a decoded codeword is only accepted if its syndrome is zero.
+* @param syndrome_bytes  syndrome of the codeword, at least one of them is not zero
+* returns the number of corrected or detected errors
+*/
+static uint32_t decode_block(rs_codec *rs, rs_decode_context *context, uint32_t *codeword, uint32_t *syndrome_bytes, const uint8_t *erasures,
+                             unsigned int *resolved_errors, unsigned int *fatal_errors, DBOOL *uncorrectable)
+{
+    uint32_t parity_size = rs->parity_size;
+    uint32_t block_size = rs->message_size + parity_size;
+
+    *uncorrectable = DFALSE;
+    unsigned int block_fatal_errors = 0;
+    if (erasures == NULL)
+    {
+        uint32_t errors_number = correct_errors_erasures(rs, codeword, block_size, syndrome_bytes, NULL, 0, &block_fatal_errors, resolved_errors);
+        *fatal_errors += block_fatal_errors;
+        *uncorrectable = block_fatal_errors != 0 || errors_number == 0;
+        return errors_number;
+    }
+
+    // Errors only decoding, the result is checked as the locator may find a wrong codeword
+    uint32_t * decoded_codeword = context->decoded_codeword;
+    memcpy(decoded_codeword, codeword, block_size * sizeof(uint32_t));
+    unsigned int block_resolved_errors = 0;
+    uint32_t errors_number = correct_errors_erasures(rs, decoded_codeword, block_size, syndrome_bytes, NULL, 0, &block_fatal_errors, &block_resolved_errors);
+    if (block_fatal_errors == 0 && errors_number != 0 && !calculate_syndrome(rs, decoded_codeword, block_size, syndrome_bytes))
+    {
+        memcpy(codeword, decoded_codeword, block_size * sizeof(uint32_t));
+        *resolved_errors += block_resolved_errors;
+        return errors_number;
+    }
+
+    // Select the least reliable symbols, ordered by decreasing unreliability
+    uint32_t levels[256] = { 0 };
+    for (uint32_t i = 0; i < block_size; i++)
+    {
+        levels[erasures[i]]++;
+    }
+    uint32_t offsets[256];
+    uint32_t candidates = 0;
+    for (int level = 0xff; level > 0; level--)
+    {
+        offsets[level] = candidates;
+        candidates += levels[level];
+    }
+    uint32_t * erasure_locations = context->erasure_locations;
+    for (uint32_t i = 0; i < block_size; i++)
+    {
+        if (erasures[i])
+        {
+            erasure_locations[offsets[erasures[i]]++] = i;
+        }
+    }
+    // Keep some parity to detect decoding to a wrong codeword
+    uint32_t max_erasures = parity_size - (parity_size + 3) / 4;
+    if (candidates > max_erasures)
+    {
+        candidates = max_erasures;
+    }
+
+    uint32_t * erased_codeword = context->erased_codeword;
+    for (uint32_t erasures_number = candidates; erasures_number > 0; erasures_number /= 2)
+    {
+        unsigned int attempt_fatal_errors = 0;
+        unsigned int attempt_resolved_errors = 0;
+        memcpy(erased_codeword, codeword, block_size * sizeof(uint32_t));
+
+        calculate_syndrome(rs, erased_codeword, block_size, syndrome_bytes);
+        uint32_t attempt_errors = correct_errors_erasures(rs, erased_codeword, block_size, syndrome_bytes, erasure_locations, erasures_number,
+                                                          &attempt_fatal_errors, &attempt_resolved_errors);
+
+        // The locator may still find a wrong codeword, only accept a valid one
+        if (attempt_fatal_errors == 0 && !calculate_syndrome(rs, erased_codeword, block_size, syndrome_bytes))
+        {
+            memcpy(codeword, erased_codeword, block_size * sizeof(uint32_t));
+            *resolved_errors += attempt_resolved_errors;
+            return attempt_errors;
+        }
+    }
+
+    // Keep the result of the errors only decoding, as when no erasures are given
+    memcpy(codeword, decoded_codeword, block_size * sizeof(uint32_t));
+    *resolved_errors += block_resolved_errors;
+    *fatal_errors += block_fatal_errors;
+    *uncorrectable = DTRUE;
+    return errors_number;
+}
+
 static void rs_generate_polynomial(rs_codec * rs)
 {
     uint32_t parity_size = rs->parity_size;
@@ -315,6 +574,167 @@ static void rs_generate_polynomial(rs_codec * rs)
     rs->generator_polynomial = polynomial;
 }
 
+/*
+* @brief creates the tables used to calculate the syndromes of codewords in GF(2^8)
+* The syndrome j is evaluated with Horner's method, multiplying by alpha^j for each symbol. The product
+* of a symbol and alpha^j is split in the products of its low and high nibble, which are looked up in two
+* 16 entry tables. The tables of each syndrome are stored after each other, 32 bytes per syndrome.
+*/
+static void rs_generate_syndrome_tables(rs_codec * rs)
+{
+    galois_field *gf = rs->galois_field;
+    if (gf->alphabet_size > 256)
+    {
+        return;
+    }
+
+    rs->syndrome_tables = BOXING_MEMORY_ALLOCATE_TYPE_ARRAY(uint8_t, rs->parity_size * 32);
+    for (int j = 0; j < rs->parity_size; j++)
+    {
+        uint32_t root = gf->exp[j + 1];
+        uint8_t * low = rs->syndrome_tables + j * 32;
+        uint8_t * high = low + 16;
+        for (uint32_t x = 0; x < 16; x++)
+        {
+            low[x] = (x < gf->alphabet_size) ? (uint8_t)gf_multiply(gf, root, x) : 0;
+            high[x] = ((x << 4) < gf->alphabet_size) ? (uint8_t)gf_multiply(gf, root, x << 4) : 0;
+        }
+    }
+}
+
+/*
+* @brief calculates the syndromes of one codeword
+* @param syndromes  parity_size syndromes
+*/
+static void syndrome_scalar(const uint8_t *tables, uint32_t parity_size, const uint8_t *symbols, uint32_t codeword_size, uint8_t *syndromes)
+{
+    for (uint32_t j = 0; j < parity_size; j++)
+    {
+        const uint8_t * low = tables + j * 32;
+        const uint8_t * high = low + 16;
+        uint8_t sum = 0;
+        for (uint32_t i = 0; i < codeword_size; i++)
+        {
+            sum = low[sum & 0x0f] ^ high[sum >> 4] ^ symbols[i];
+        }
+        syndromes[j] = sum;
+    }
+}
+
+// The SIMD kernels calculate the syndromes of one codeword in each byte lane, symbol i of the codeword
+// in lane k is found at symbols[i * lanes + k] and syndrome j is stored at syndromes[j * lanes + k].
+// Two syndromes are calculated at a time to hide the latency of the multiplication.
+
+#if defined (BOXING_CPU_X86)
+
+BOXING_CPU_TARGET("ssse3")
+static void syndrome_ssse3(const uint8_t *tables, uint32_t parity_size, const uint8_t *symbols, uint32_t codeword_size, uint8_t *syndromes)
+{
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    for (uint32_t j = 0; j < parity_size; j += 2)
+    {
+        uint32_t k = (j + 1 < parity_size) ? j + 1 : j;
+        const __m128i low0 = _mm_loadu_si128((const __m128i *)(tables + j * 32));
+        const __m128i high0 = _mm_loadu_si128((const __m128i *)(tables + j * 32 + 16));
+        const __m128i low1 = _mm_loadu_si128((const __m128i *)(tables + k * 32));
+        const __m128i high1 = _mm_loadu_si128((const __m128i *)(tables + k * 32 + 16));
+        __m128i sum0 = _mm_setzero_si128();
+        __m128i sum1 = _mm_setzero_si128();
+        for (uint32_t i = 0; i < codeword_size; i++)
+        {
+            const __m128i symbol = _mm_loadu_si128((const __m128i *)(symbols + i * 16));
+            sum0 = _mm_xor_si128(_mm_xor_si128(_mm_shuffle_epi8(low0, _mm_and_si128(sum0, mask)),
+                                               _mm_shuffle_epi8(high0, _mm_and_si128(_mm_srli_epi16(sum0, 4), mask))), symbol);
+            sum1 = _mm_xor_si128(_mm_xor_si128(_mm_shuffle_epi8(low1, _mm_and_si128(sum1, mask)),
+                                               _mm_shuffle_epi8(high1, _mm_and_si128(_mm_srli_epi16(sum1, 4), mask))), symbol);
+        }
+        _mm_storeu_si128((__m128i *)(syndromes + k * 16), sum1);
+        _mm_storeu_si128((__m128i *)(syndromes + j * 16), sum0);
+    }
+}
+
+BOXING_CPU_TARGET("avx2")
+static void syndrome_avx2(const uint8_t *tables, uint32_t parity_size, const uint8_t *symbols, uint32_t codeword_size, uint8_t *syndromes)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    for (uint32_t j = 0; j < parity_size; j += 2)
+    {
+        uint32_t k = (j + 1 < parity_size) ? j + 1 : j;
+        const __m256i low0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(tables + j * 32)));
+        const __m256i high0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(tables + j * 32 + 16)));
+        const __m256i low1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(tables + k * 32)));
+        const __m256i high1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(tables + k * 32 + 16)));
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        for (uint32_t i = 0; i < codeword_size; i++)
+        {
+            const __m256i symbol = _mm256_loadu_si256((const __m256i *)(symbols + i * 32));
+            sum0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_shuffle_epi8(low0, _mm256_and_si256(sum0, mask)),
+                                                     _mm256_shuffle_epi8(high0, _mm256_and_si256(_mm256_srli_epi16(sum0, 4), mask))), symbol);
+            sum1 = _mm256_xor_si256(_mm256_xor_si256(_mm256_shuffle_epi8(low1, _mm256_and_si256(sum1, mask)),
+                                                     _mm256_shuffle_epi8(high1, _mm256_and_si256(_mm256_srli_epi16(sum1, 4), mask))), symbol);
+        }
+        _mm256_storeu_si256((__m256i *)(syndromes + k * 32), sum1);
+        _mm256_storeu_si256((__m256i *)(syndromes + j * 32), sum0);
+    }
+}
+
+#elif defined (BOXING_CPU_ARM)
+
+static void syndrome_neon(const uint8_t *tables, uint32_t parity_size, const uint8_t *symbols, uint32_t codeword_size, uint8_t *syndromes)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    for (uint32_t j = 0; j < parity_size; j += 2)
+    {
+        uint32_t k = (j + 1 < parity_size) ? j + 1 : j;
+        const uint8x16_t low0 = vld1q_u8(tables + j * 32);
+        const uint8x16_t high0 = vld1q_u8(tables + j * 32 + 16);
+        const uint8x16_t low1 = vld1q_u8(tables + k * 32);
+        const uint8x16_t high1 = vld1q_u8(tables + k * 32 + 16);
+        uint8x16_t sum0 = vdupq_n_u8(0);
+        uint8x16_t sum1 = vdupq_n_u8(0);
+        for (uint32_t i = 0; i < codeword_size; i++)
+        {
+            const uint8x16_t symbol = vld1q_u8(symbols + i * 16);
+            sum0 = veorq_u8(veorq_u8(vqtbl1q_u8(low0, vandq_u8(sum0, mask)), vqtbl1q_u8(high0, vshrq_n_u8(sum0, 4))), symbol);
+            sum1 = veorq_u8(veorq_u8(vqtbl1q_u8(low1, vandq_u8(sum1, mask)), vqtbl1q_u8(high1, vshrq_n_u8(sum1, 4))), symbol);
+        }
+        vst1q_u8(syndromes + k * 16, sum1);
+        vst1q_u8(syndromes + j * 16, sum0);
+    }
+}
+
+#endif
+
+static void rs_select_syndrome_kernel(rs_codec * rs)
+{
+    rs->syndrome_kernel = syndrome_scalar;
+    rs->syndrome_lanes = 1;
+    if (!rs->syndrome_tables)
+    {
+        return;
+    }
+
+#if defined (BOXING_CPU_X86)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_AVX2))
+    {
+        rs->syndrome_kernel = syndrome_avx2;
+        rs->syndrome_lanes = 32;
+    }
+    else if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_SSSE3))
+    {
+        rs->syndrome_kernel = syndrome_ssse3;
+        rs->syndrome_lanes = 16;
+    }
+#elif defined (BOXING_CPU_ARM)
+    if (boxing_cpu_has_feature(BOXING_CPU_FEATURE_NEON))
+    {
+        rs->syndrome_kernel = syndrome_neon;
+        rs->syndrome_lanes = 16;
+    }
+#endif
+}
+
 static void compute_modified_omega(
     rs_codec * rs,
     uint32_t *error_locator_polynomial,
@@ -342,7 +762,9 @@ static void modified_berlekamp_massey(
     rs_codec *rs,
     uint32_t *error_locator_polynomial,
     uint32_t *error_evaluator_polynomial,
-    uint32_t *syndrome_bytes)
+    uint32_t *syndrome_bytes,
+    const uint32_t *erasure_locations,
+    uint32_t erasures_number)
 {
     uint32_t L, L2, k, d;
     uint32_t n;
@@ -356,12 +778,28 @@ static void modified_berlekamp_massey(
 
     memset(D, 0, sizeof(uint32_t) * parity_size * 2);
     memset(psi, 0, sizeof(uint32_t) * parity_size * 2);
-    psi[0] = D[1] = 1;
+    psi[0] = 1;
+
+    /* initialize psi to the erasure locator polynomial, the product of (1 + alpha^i z) over all erasure locations i */
+    for (uint32_t e = 0; e < erasures_number; e++)
+    {
+        uint32_t root = gf->exp[erasure_locations[e] % gf->mask];
+        for (uint32_t i = e + 1; i > 0; i--)
+        {
+            psi[i] ^= gf_multiply(gf, root, psi[i - 1]);
+        }
+    }
+
+    /* D = z * psi */
+    for (uint32_t i = 0; i <= erasures_number; i++)
+    {
+        D[i + 1] = psi[i];
+    }
 
     k = -1;
-    L = 0;
+    L = erasures_number;
 
-    for (n = 0; n < parity_size; n++)
+    for (n = erasures_number; n < parity_size; n++)
     {
         uint32_t sum = 0;
         for (uint32_t i = 0; i <= L; i++)
@@ -444,6 +882,8 @@ static uint32_t correct_errors_erasures(
     uint32_t *codeword,
     uint32_t codeword_size,
     uint32_t *syndrome_bytes,
+    const uint32_t *erasure_locations,
+    uint32_t erasures_number,
     unsigned int *fatal_errors,
     unsigned int *resolved_errors)
 {
@@ -457,7 +897,33 @@ static uint32_t correct_errors_erasures(
     uint32_t *error_evaluator_polynomial = BOXING_STACK_ALLOCATE_TYPE_ARRAY(uint32_t, parity_size * 2); // may be optimized to parity_size
     uint32_t *error_locations = BOXING_STACK_ALLOCATE_TYPE_ARRAY(uint32_t, parity_size);
 
-    modified_berlekamp_massey(rs, error_locator_polynomial, error_evaluator_polynomial, syndrome_bytes);
+    /* erasure locations are counted from the end of the codeword, as the error locations */
+    uint32_t *erasure_powers = BOXING_STACK_ALLOCATE_TYPE_ARRAY(uint32_t, erasures_number + 1);
+    for (r = 0; r < erasures_number; r++)
+    {
+        erasure_powers[r] = codeword_size - erasure_locations[r] - 1;
+    }
+    /* the extra entry keeps the array valid without erasures, it is never read */
+    erasure_powers[erasures_number] = 0;
+
+    modified_berlekamp_massey(rs, error_locator_polynomial, error_evaluator_polynomial, syndrome_bytes, erasure_powers, erasures_number);
+
+    /* with erasures each error costs two parity symbols and each erasure one,
+     * a locator of higher degree can not be solved and the root search is skipped */
+    if (erasures_number)
+    {
+        uint32_t degree = parity_size * 2 - 1;
+        while (degree > 0 && error_locator_polynomial[degree] == 0)
+        {
+            degree--;
+        }
+        if (degree * 2 > parity_size + erasures_number)
+        {
+            *fatal_errors += degree;
+            return degree;
+        }
+    }
+
     uint32_t errors_number = find_roots(rs, error_locator_polynomial, error_locations);
 
     if ((errors_number <= parity_size) && errors_number > 0) {
@@ -50,11 +50,16 @@ extern "C" {
 #define RS_PRIM_POLY_1033 0x00000409
 
 typedef struct rs_codec_s rs_codec;
+typedef struct rs_decode_context_s rs_decode_context;
 
 rs_codec* rs_create(int message_size, int parity_size, uint32_t prime_plonomial);
 void rs_free(rs_codec *codec);
 void rs_encode(rs_codec *rs, gvector * data, gvector * data_encode);
-void rs_decode(rs_codec *rs, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+void rs_decode(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+void rs_decode_erasures(rs_codec *rs, rs_decode_context *context, gvector * data, gvector * data_decode, const gvector * erasures, gvector * erasures_decode, unsigned int *resolved_errors, unsigned int *fatal_errors, int *max_errors_per_block);
+
+rs_decode_context* rs_decode_context_create(rs_codec *rs);
+void rs_decode_context_free(rs_decode_context *context);
 
 #ifdef __cplusplus
 } /* extern "C" */